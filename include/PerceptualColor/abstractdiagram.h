@@ -29,12 +29,15 @@
 
 #include "PerceptualColor/perceptualcolorglobal.h"
 
+#include <QSharedPointer>
 #include <QWidget>
 
 #include "PerceptualColor/constpropagatinguniquepointer.h"
 
 namespace PerceptualColor
 {
+class RgbColorSpace;
+
 /** @brief Base class for LCh diagrams.
  *
  * Provides some elements that are common for all LCh diagrams in this
@@ -68,12 +71,68 @@ class PERCEPTUALCOLOR_IMPORTEXPORT AbstractDiagram : public QWidget
 {
     Q_OBJECT
 
+    /** @brief Simulation of a color vision deficiency.
+     *
+     * When set to a value other than
+     * <tt>ColorVisionDeficiency::none</tt>, the colors of the diagram
+     * are rendered as they are perceived by people with the given
+     * color vision deficiency. This allows to check palettes and
+     * designs for accessibility.
+     *
+     * Default value: <tt>ColorVisionDeficiency::none</tt>
+     *
+     * @sa @ref ColorVisionDeficiency
+     * @sa READ @ref colorVisionDeficiency() const
+     * @sa WRITE @ref setColorVisionDeficiency()
+     * @sa NOTIFY @ref colorVisionDeficiencyChanged() */
+    Q_PROPERTY(PerceptualColor::AbstractDiagram::ColorVisionDeficiency colorVisionDeficiency READ colorVisionDeficiency WRITE setColorVisionDeficiency NOTIFY
+                   colorVisionDeficiencyChanged)
+
 public:
+    /** @brief Color vision deficiencies that can be simulated.
+     *
+     * This enum is declared to the meta-object system. This happens
+     * automatically. You do not need to make any manual calls.
+     *
+     * This type is declared as type to Qt’s type system via
+     * <tt>Q_DECLARE_METATYPE</tt>. Depending on your use case (for
+     * example if you want to use for <em>queued</em> signal-slot connections),
+     * you might consider calling <tt>qRegisterMetaType()</tt> for
+     * this type, once you have a QApplication object.
+     *
+     * @sa @ref colorVisionDeficiency */
+    enum class ColorVisionDeficiency {
+        none,         /**< No simulation. Colors are rendered normally. */
+        protanopia,   /**< Simulate protanopia (no L cones, red-blind). */
+        deuteranopia, /**< Simulate deuteranopia (no M cones, green-blind). */
+        tritanopia    /**< Simulate tritanopia (no S cones, blue-blind). */
+    };
+    Q_ENUM(ColorVisionDeficiency)
     Q_INVOKABLE AbstractDiagram(QWidget *parent = nullptr);
     /** @brief Default destructor */
     virtual ~AbstractDiagram() noexcept override;
+    /** @brief Getter for property @ref colorVisionDeficiency
+     *  @returns the property @ref colorVisionDeficiency */
+    AbstractDiagram::ColorVisionDeficiency colorVisionDeficiency() const;
+    QSharedPointer<PerceptualColor::RgbColorSpace> displayColorSpace() const;
+    Q_INVOKABLE qreal inputLatencyPercentile(qreal percentile) const;
+    Q_INVOKABLE int inputLatencySampleCount() const;
+    void setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace);
+
+public Q_SLOTS:
+    void resetInputLatency();
+    void setColorVisionDeficiency(const PerceptualColor::AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency);
+
+Q_SIGNALS:
+    /** @brief Notify signal for property @ref colorVisionDeficiency.
+     * @param newColorVisionDeficiency the new color vision deficiency */
+    void colorVisionDeficiencyChanged(const PerceptualColor::AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency);
+    /** @brief Notify signal for @ref displayColorSpace().
+     * @param newDisplayColorSpace the new display color space */
+    void displayColorSpaceChanged(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace);
 
 protected:
+    virtual bool event(QEvent *event) override;
     QColor focusIndicatorColor() const;
     int gradientMinimumLength() const;
     int gradientThickness() const;
@@ -83,6 +142,7 @@ protected:
     QColor handleColorFromBackgroundLightness(qreal lightness) const;
     int handleOutlineThickness() const;
     qreal handleRadius() const;
+    void scheduleRepaint();
     int spaceForFocusIndicator() const;
     QImage transparencyBackground() const;
 
@@ -106,4 +166,6 @@ private:
 
 } // namespace PerceptualColor
 
+Q_DECLARE_METATYPE(PerceptualColor::AbstractDiagram::ColorVisionDeficiency)
+
 #endif // ABSTRACTDIAGRAM_H
@@ -69,6 +69,12 @@ class RgbColorSpace;
  *
  * @snippet test/testcolordialog.cpp ColorDialog Get color with alpha channel
  *
+ * The dialogs of the static functions are kept hidden after use and are
+ * reused by the next call with the same color space and the same
+ * options. So only the first call has to build the dialog and render
+ * its diagrams. Only the few most recently used dialogs are kept. Use
+ * @ref clearDialogPool() to free the memory.
+ *
  * @image html ColorDialogAlpha.png "ColorDialog with alpha channel" width=500
  *
  * For non-modal dialogs, use the normal constructors of this class.
@@ -374,9 +380,11 @@ public:
     Q_INVOKABLE explicit ColorDialog(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, QWidget *parent = nullptr);
     Q_INVOKABLE explicit ColorDialog(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QColor &initial, QWidget *parent = nullptr);
     virtual ~ColorDialog() noexcept override;
+    static void clearDialogPool();
     /** @brief Getter for property @ref currentColor
      *  @returns the property @ref currentColor */
     QColor currentColor() const;
+    QSharedPointer<PerceptualColor::RgbColorSpace> displayColorSpace() const;
     static QColor getColor(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QColor &initial = Qt::white, QWidget *parent = nullptr, const QString &title = QString(), ColorDialogOptions options = ColorDialogOptions());
     /** @brief Getter for property @ref layoutDimensions
      *  @returns the property @ref layoutDimensions */
@@ -388,6 +396,7 @@ public:
      * @returns the current @ref options */
     ColorDialogOptions options() const;
     Q_INVOKABLE QColor selectedColor() const;
+    void setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace);
     virtual void setVisible(bool visible) override;
     Q_INVOKABLE bool testOption(PerceptualColor::ColorDialog::ColorDialogOption option) const;
 
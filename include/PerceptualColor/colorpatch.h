@@ -30,11 +30,15 @@
 #include "PerceptualColor/perceptualcolorglobal.h"
 
 #include <QFrame>
+#include <QSharedPointer>
 
+#include "PerceptualColor/abstractdiagram.h"
 #include "PerceptualColor/constpropagatinguniquepointer.h"
 
 namespace PerceptualColor
 {
+class RgbColorSpace;
+
 /** @brief A color display widget.
  *
  * This widget simply displays a color. Useful for showing a given
@@ -87,31 +91,62 @@ class PERCEPTUALCOLOR_IMPORTEXPORT ColorPatch : public QFrame
      *   will be a special background pattern (and <em>not</em> the default
      *   widget background).
      *
-     * @note No color management is applied. The color is used as-is to
-     * paint on the canvas provided by the operation system.
+     * @note The color is interpreted as color of the working color space
+     * (see constructor). By default, no color management is applied: The
+     * color is used as-is to paint on the canvas provided by the
+     * operation system. See @ref setDisplayColorSpace() to change this.
      *
      * @sa @ref color() const
      * @sa @ref setColor()
      * @sa @ref colorChanged() */
     Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
 
+    /** @brief Simulated color vision deficiency.
+     *
+     * If not <tt>AbstractDiagram::ColorVisionDeficiency::none</tt>, the
+     * patch shows the @ref color as it is perceived by people with the
+     * given color vision deficiency. The value of @ref color itself is
+     * not changed.
+     *
+     * Default value: <tt>AbstractDiagram::ColorVisionDeficiency::none</tt>
+     *
+     * @sa @ref AbstractDiagram::colorVisionDeficiency
+     * @sa READ @ref colorVisionDeficiency() const
+     * @sa WRITE @ref setColorVisionDeficiency()
+     * @sa NOTIFY @ref colorVisionDeficiencyChanged() */
+    Q_PROPERTY(PerceptualColor::AbstractDiagram::ColorVisionDeficiency colorVisionDeficiency READ colorVisionDeficiency WRITE setColorVisionDeficiency NOTIFY
+                   colorVisionDeficiencyChanged)
+
 public:
     Q_INVOKABLE explicit ColorPatch(QWidget *parent = nullptr);
+    Q_INVOKABLE explicit ColorPatch(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, QWidget *parent = nullptr);
     virtual ~ColorPatch() noexcept override;
     /** @brief Getter for property @ref color
      *  @returns the property @ref color */
     QColor color() const;
+    /** @brief Getter for property @ref colorVisionDeficiency
+     *  @returns the property @ref colorVisionDeficiency */
+    AbstractDiagram::ColorVisionDeficiency colorVisionDeficiency() const;
+    QSharedPointer<PerceptualColor::RgbColorSpace> displayColorSpace() const;
     virtual QSize minimumSizeHint() const override;
+    void setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace);
     virtual QSize sizeHint() const override;
 
 public Q_SLOTS:
     void setColor(const QColor &newColor);
+    void setColorVisionDeficiency(const PerceptualColor::AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency);
 
 Q_SIGNALS:
     /** @brief Notify signal for property @ref color.
      *
      * @param color the new color */
     void colorChanged(const QColor &color);
+    /** @brief Notify signal for property @ref colorVisionDeficiency.
+     * @param newColorVisionDeficiency the new color vision deficiency */
+    void colorVisionDeficiencyChanged(const PerceptualColor::AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency);
+    /** @brief Notify signal for @ref displayColorSpace().
+     * @param newDisplayColorSpace the new display color space */
+    void displayColorSpaceChanged(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace);
 
 protected:
     virtual void paintEvent(QPaintEvent *event) override;
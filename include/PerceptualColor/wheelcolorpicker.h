@@ -88,6 +88,7 @@ Q_SIGNALS:
     void currentColorChanged(const PerceptualColor::LchDouble &newCurrentColor);
 
 protected:
+    virtual bool event(QEvent *event) override;
     virtual void resizeEvent(QResizeEvent *event) override;
 
 private:
@@ -41,6 +41,7 @@
 #include <QStyleOption>
 
 #include "helper.h"
+#include "latencyhistogram.h"
 
 namespace PerceptualColor
 {
@@ -49,6 +50,7 @@ namespace PerceptualColor
  * to the base class’s constructor. */
 AbstractDiagram::AbstractDiagram(QWidget *parent)
     : QWidget(parent)
+    , d_pointer(new AbstractDiagramPrivate())
 {
 }
 
@@ -57,6 +59,239 @@ AbstractDiagram::~AbstractDiagram() noexcept
 {
 }
 
+/** @brief Constructor */
+AbstractDiagram::AbstractDiagramPrivate::AbstractDiagramPrivate()
+{
+    m_latencyClock.start();
+}
+
+/** @brief If an event type is measured for the input-to-paint latency.
+ *
+ * @param type The event type
+ *
+ * @returns <tt>true</tt> for pointer and key events, <tt>false</tt>
+ * otherwise. */
+bool AbstractDiagram::AbstractDiagramPrivate::isLatencyRelevant(QEvent::Type type)
+{
+    switch (type) {
+    case QEvent::Type::KeyPress:
+    case QEvent::Type::MouseButtonDblClick:
+    case QEvent::Type::MouseButtonPress:
+    case QEvent::Type::MouseButtonRelease:
+    case QEvent::Type::MouseMove:
+    case QEvent::Type::Wheel:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/** @brief If an event type might change the style metrics.
+ *
+ * @param type The event type
+ *
+ * @returns <tt>true</tt> for events after which the cached style
+ * metrics, like @ref AbstractDiagram::gradientThickness(), have to be
+ * calculated again. <tt>false</tt> otherwise. */
+bool AbstractDiagram::AbstractDiagramPrivate::isMetricsRelevant(QEvent::Type type)
+{
+    switch (type) {
+    case QEvent::Type::FontChange:
+    case QEvent::Type::Polish:
+    case QEvent::Type::StyleChange:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/** @brief The main event handler.
+ *
+ * Reimplemented from base class.
+ *
+ * Measures the input-to-paint latency: For each pointer or key event that
+ * has been accepted and that has scheduled a paint event by calling
+ * @ref scheduleRepaint(), the time from receiving the event to the end of
+ * the next paint event is recorded. Events that do not change the widget
+ * (for example a key press at the boundary of the value range) are not
+ * recorded, because otherwise the idle time up to an unrelated later
+ * paint event would be counted as latency. Discards the cached style metrics when
+ * the style or the font changes. Apart from that, it calls the
+ * implementation in the parent class.
+ *
+ * @param event the event to be handled.
+ *
+ * @returns The return value of the implementation in the parent class.
+ *
+ * @sa @ref inputLatencyPercentile() */
+bool AbstractDiagram::event(QEvent *event)
+{
+    const QEvent::Type type = event->type();
+    const bool isLatencyRelevant = AbstractDiagramPrivate::isLatencyRelevant(type);
+    // QInputEvent::timestamp() uses a platform-dependent clock that cannot
+    // be compared with QElapsedTimer, so the measurement starts when the
+    // event is delivered to this widget.
+    const qint64 receptionTime = isLatencyRelevant //
+        ? d_pointer->m_latencyClock.nsecsElapsed()
+        : 0;
+    if (AbstractDiagramPrivate::isMetricsRelevant(type)) {
+        // Discard the cache before the event is handled, so that
+        // the event handlers get yet the new values.
+        d_pointer->m_gradientThickness = -1;
+        d_pointer->m_gradientMinimumLength = -1;
+    }
+    if (isLatencyRelevant) {
+        d_pointer->m_isRepaintScheduled = false;
+    }
+    const bool result = QWidget::event(event);
+    if (isLatencyRelevant && event->isAccepted() && d_pointer->m_isRepaintScheduled //
+        && d_pointer->m_unpaintedInputTimes.count() < AbstractDiagramPrivate::maximumUnpaintedInputCount) {
+        d_pointer->m_unpaintedInputTimes.append(receptionTime);
+    }
+    if ((type == QEvent::Type::Paint) && !d_pointer->m_unpaintedInputTimes.isEmpty()) {
+        const qint64 paintEndTime = d_pointer->m_latencyClock.nsecsElapsed();
+        for (const qint64 inputTime : qAsConst(d_pointer->m_unpaintedInputTimes)) {
+            const qint64 latency = (paintEndTime - inputTime) / 1000;
+            d_pointer->m_inputLatencyHistogram.addSample(latency);
+            qCDebug(latencyLoggingCategory).nospace() //
+                << metaObject()->className() << ": input-to-paint latency " //
+                << latency / 1000.0 << " ms (p50 " //
+                << inputLatencyPercentile(50) << " ms, p95 " //
+                << inputLatencyPercentile(95) << " ms, p99 " //
+                << inputLatencyPercentile(99) << " ms)";
+        }
+        d_pointer->m_unpaintedInputTimes.clear();
+    }
+    return result;
+}
+
+/** @brief Schedules a paint event.
+ *
+ * Like <tt>QWidget::update()</tt>. Additionally, if this function is called
+ * while a pointer or key event is handled, the event is recorded for the
+ * input-to-paint latency. Subclasses call this function instead of
+ * <tt>QWidget::update()</tt> whenever they change in response to input.
+ *
+ * @sa @ref inputLatencyPercentile() */
+void AbstractDiagram::scheduleRepaint()
+{
+    d_pointer->m_isRepaintScheduled = true;
+    update();
+}
+
+/** @brief A percentile of the input-to-paint latency.
+ *
+ * For each pointer and key event that this widget has handled and that
+ * has scheduled a paint event, the time from receiving the event to the
+ * end of the paint event that reflects it is recorded. Events that are handled within the same event loop
+ * iteration share the same paint event, and each of them is recorded.
+ *
+ * The samples are counted in a histogram with logarithmic buckets.
+ * The result is the upper bound of the bucket, so it might be up to
+ * 12.5 % bigger than the exact value, but it is never smaller. This
+ * makes it suitable to check latency budgets.
+ *
+ * Each sample is also logged with debug level to the logging category
+ * <tt>perceptualcolor.latency</tt>, which is disabled by default.
+ *
+ * @param percentile The percentile. Range: <tt>[0, 100]</tt>. For
+ * example, <tt>50</tt> for the median or <tt>99</tt> for the latency that
+ * 99 % of the events do not exceed.
+ *
+ * @returns The percentile, measured in milliseconds, or 0 if there
+ * are no samples.
+ *
+ * @sa @ref inputLatencySampleCount()
+ * @sa @ref resetInputLatency() */
+qreal AbstractDiagram::inputLatencyPercentile(qreal percentile) const
+{
+    return d_pointer->m_inputLatencyHistogram.percentile(percentile) / 1000.0;
+}
+
+/** @brief The number of input-to-paint latency samples.
+ *
+ * @returns The number of samples since the widget was created or
+ * since the last call of @ref resetInputLatency().
+ *
+ * @sa @ref inputLatencyPercentile() */
+int AbstractDiagram::inputLatencySampleCount() const
+{
+    return d_pointer->m_inputLatencyHistogram.count();
+}
+
+/** @brief Removes all input-to-paint latency samples.
+ *
+ * @sa @ref inputLatencyPercentile() */
+void AbstractDiagram::resetInputLatency()
+{
+    d_pointer->m_inputLatencyHistogram.clear();
+    d_pointer->m_unpaintedInputTimes.clear();
+}
+
+// No documentation here (documentation of properties
+// and its getters are in the header)
+AbstractDiagram::ColorVisionDeficiency AbstractDiagram::colorVisionDeficiency() const
+{
+    return d_pointer->m_colorVisionDeficiency;
+}
+
+/** @brief Setter for the @ref colorVisionDeficiency property.
+ *
+ * @param newColorVisionDeficiency the new color vision deficiency */
+void AbstractDiagram::setColorVisionDeficiency(const PerceptualColor::AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency)
+{
+    if (newColorVisionDeficiency == d_pointer->m_colorVisionDeficiency) {
+        return;
+    }
+    d_pointer->m_colorVisionDeficiency = newColorVisionDeficiency;
+    Q_EMIT colorVisionDeficiencyChanged(newColorVisionDeficiency);
+    // Schedule a paint event. The subclasses apply the new value
+    // to their images within their paint event.
+    update();
+}
+
+/** @brief The color space of the display.
+ *
+ * @returns The color space of the display, or <tt>nullptr</tt> (default)
+ * if the diagram writes the RGB values of its own color space directly
+ * to the screen.
+ *
+ * @sa @ref setDisplayColorSpace() */
+QSharedPointer<PerceptualColor::RgbColorSpace> AbstractDiagram::displayColorSpace() const
+{
+    return d_pointer->m_displayColorSpace;
+}
+
+/** @brief Setter for @ref displayColorSpace().
+ *
+ * The color space that is passed to the constructor of a diagram is its
+ * <em>working</em> color space. It decides which colors are in-gamut.
+ * By default, the RGB values of the working color space are painted
+ * directly on the screen. That is correct only if the screen uses the
+ * same color space, which is typically sRGB. If you use another working
+ * color space (for example WideGamutRGB), set the display color space
+ * (for example to sRGB) to get correct colors on the screen. The gamut
+ * decisions stay in the working color space. The diagrams use a single
+ * transform from Lab to the display color space, so this does not
+ * need an additional pass over the image.
+ *
+ * @param newDisplayColorSpace The new display color space, or
+ * <tt>nullptr</tt> to paint the RGB values of the working color space
+ * directly.
+ *
+ * @sa @ref displayColorSpaceChanged() */
+void AbstractDiagram::setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace)
+{
+    if (newDisplayColorSpace == d_pointer->m_displayColorSpace) {
+        return;
+    }
+    d_pointer->m_displayColorSpace = newDisplayColorSpace;
+    Q_EMIT displayColorSpaceChanged(newDisplayColorSpace);
+    // Schedule a paint event. The subclasses apply the new value
+    // to their images within their paint event.
+    update();
+}
+
 /** @brief The color for painting focus indicators
  * @returns The color for painting focus indicators. This color is based on
  * the current widget style at the moment this function is called. The value
@@ -205,10 +440,17 @@ qreal AbstractDiagram::handleRadius() const
  * @returns The thickness of a slider or a color wheel, measured in
  * <em>device-independant pixels</em>.
  *
+ * The value is cached, because layout code and paint events call this
+ * function often. The cache is discarded when the style or the font
+ * changes.
+ *
  * @sa @ref gradientMinimumLength() */
 int AbstractDiagram::gradientThickness() const
 {
     ensurePolished();
+    if (d_pointer->m_gradientThickness >= 0) {
+        return d_pointer->m_gradientThickness;
+    }
     int result = 0;
     QStyleOptionSlider styleOption;
     styleOption.initFrom(this); // Sets also QStyle::State_MouseOver
@@ -222,6 +464,7 @@ int AbstractDiagram::gradientThickness() const
     result = qMax(result, QApplication::globalStrut().width());
     result = qMax(result, QApplication::globalStrut().height());
     // No supplementary space for ticks is added.
+    d_pointer->m_gradientThickness = result;
     return result;
 }
 
@@ -234,13 +477,18 @@ int AbstractDiagram::gradientThickness() const
  * @returns The length of a gradient, measured in
  * <em>device-independant pixels</em>.
  *
+ * The value is cached like @ref gradientThickness().
+ *
  * @sa @ref gradientThickness() */
 int AbstractDiagram::gradientMinimumLength() const
 {
     ensurePolished();
+    if (d_pointer->m_gradientMinimumLength >= 0) {
+        return d_pointer->m_gradientMinimumLength;
+    }
     QStyleOptionSlider option;
     option.initFrom(this);
-    return qMax(
+    d_pointer->m_gradientMinimumLength = qMax(
         // Parameter: style-based value:
         qMax(
             // Similar to QSlider sizeHint():
@@ -249,6 +497,7 @@ int AbstractDiagram::gradientMinimumLength() const
             style()->pixelMetric(QStyle::PM_SliderLength, &option, this)),
         // Parameter: (Considers implicitly QApplication::globalStrut)
         gradientThickness());
+    return d_pointer->m_gradientMinimumLength;
 }
 
 /** @brief The empty space around diagrams reserverd for the focus indicator.
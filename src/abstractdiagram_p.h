@@ -33,6 +33,12 @@
 // Include the header of the public class of this private implementation.
 #include "PerceptualColor/abstractdiagram.h"
 
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QVector>
+
+#include "latencyhistogram.h"
+
 namespace PerceptualColor
 {
 /** @internal
@@ -43,13 +49,55 @@ class AbstractDiagram::AbstractDiagramPrivate final
 {
 public:
     /** @brief Constructor */
-    AbstractDiagramPrivate() = default;
+    AbstractDiagramPrivate();
     /** @brief Default destructor
      *
      * The destructor is non-<tt>virtual</tt> because
      * the class as a whole is <tt>final</tt>. */
     ~AbstractDiagramPrivate() noexcept = default;
 
+    /** @brief Internal storage of the @ref colorVisionDeficiency property */
+    ColorVisionDeficiency m_colorVisionDeficiency = ColorVisionDeficiency::none;
+    /** @brief Internal storage for @ref AbstractDiagram::displayColorSpace() */
+    QSharedPointer<RgbColorSpace> m_displayColorSpace;
+    /** @brief Input-to-paint latencies
+     *
+     * @sa @ref AbstractDiagram::inputLatencyPercentile() */
+    LatencyHistogram m_inputLatencyHistogram;
+    /** @brief Monotonic clock for @ref m_unpaintedInputTimes */
+    QElapsedTimer m_latencyClock;
+    /** @brief Reception times of handled input events that are not yet
+     * reflected by a paint event.
+     *
+     * Measured in nanoseconds of @ref m_latencyClock. */
+    QVector<qint64> m_unpaintedInputTimes;
+    /** @brief If the input event that is currently handled has scheduled
+     * a paint event.
+     *
+     * @sa @ref AbstractDiagram::scheduleRepaint() */
+    bool m_isRepaintScheduled = false;
+    /** @brief Maximum number of entries in @ref m_unpaintedInputTimes.
+     *
+     * Protects against unlimited growth when input events are handled
+     * while no paint events happen (for example for hidden widgets). */
+    static constexpr int maximumUnpaintedInputCount = 1024;
+
+    /** @brief Cache for @ref AbstractDiagram::gradientThickness()
+     *
+     * <tt>-1</tt> if there is no cached value.
+     *
+     * @sa @ref isMetricsRelevant() */
+    mutable int m_gradientThickness = -1;
+    /** @brief Cache for @ref AbstractDiagram::gradientMinimumLength()
+     *
+     * <tt>-1</tt> if there is no cached value.
+     *
+     * @sa @ref isMetricsRelevant() */
+    mutable int m_gradientMinimumLength = -1;
+
+    static bool isLatencyRelevant(QEvent::Type type);
+    static bool isMetricsRelevant(QEvent::Type type);
+
 private:
     Q_DISABLE_COPY(AbstractDiagramPrivate)
 };
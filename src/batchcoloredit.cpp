@@ -0,0 +1,419 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own header
+#include "batchcoloredit.h"
+
+#include "helper.h"
+#include "labbuffer.h"
+#include "rgbcolorspace.h"
+
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace PerceptualColor
+{
+/** @brief Constructor
+ *
+ * @param colorSpace The color space of the colors
+ * @param colors The original colors */
+BatchColorEdit::BatchColorEdit(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QVector<PerceptualColor::LchDouble> &colors)
+    : m_colorSpace(colorSpace)
+    , m_colors(LchBuffer::fromVector(colors))
+{
+}
+
+/** @brief The original colors.
+ *
+ * @returns The original colors, as passed to the constructor. */
+QVector<LchDouble> BatchColorEdit::colors() const
+{
+    return m_colors.toVector();
+}
+
+/** @brief Number of colors.
+ *
+ * @returns Number of colors */
+int BatchColorEdit::count() const
+{
+    return m_colors.count();
+}
+
+/** @brief Applies an adjustment to the original colors.
+ *
+ * Lightness is bound to <tt>[0, 100]</tt>, chroma to values
+ * ≥ <tt>0</tt>. Hue is normalized to <tt>[0, 360[</tt>. The colors
+ * are <em>not</em> mapped into the gamut.
+ *
+ * @param adjustment The adjustment
+ * @param target Receives the adjusted colors. */
+void BatchColorEdit::adjust(const Adjustment &adjustment, LchBuffer *target) const
+{
+    const int colorCount = m_colors.count();
+    target->resize(colorCount);
+    const double *const sourceL = m_colors.l();
+    const double *const sourceC = m_colors.c();
+    const double *const sourceH = m_colors.h();
+    double *const l = target->l();
+    double *const c = target->c();
+    double *const h = target->h();
+    // Separate loops for each plane, so that the compiler
+    // can vectorize them.
+    for (int i = 0; i < colorCount; ++i) {
+        l[i] = qBound(0.0, sourceL[i] * adjustment.lightnessScale + adjustment.lightnessOffset, 100.0);
+    }
+    for (int i = 0; i < colorCount; ++i) {
+        c[i] = qMax(0.0, sourceC[i] * adjustment.chromaScale + adjustment.chromaOffset);
+    }
+    for (int i = 0; i < colorCount; ++i) {
+        const double hue = sourceH[i] + adjustment.hueOffset;
+        h[i] = hue - 360 * std::floor(hue / 360);
+    }
+}
+
+/** @brief Maps colors approximately into the gamut.
+ *
+ * Uses only the precomputed gamut boundary and cusp table of the color
+ * space, mostly through their batch functions; LittleCMS is not called.
+ * The results are the estimates for @ref mapIntoGamut().
+ *
+ * @param gamutMapping The gamut mapping strategy
+ * @param lch The colors. They are mapped in place. */
+void BatchColorEdit::mapIntoGamutApproximately(GamutMapping gamutMapping, LchBuffer *lch) const
+{
+    const int colorCount = lch->count();
+    m_scratchBuffer.resize(colorCount);
+    m_minimumLightness.resize(colorCount);
+    m_maximumLightness.resize(colorCount);
+    double *const l = lch->l();
+    double *const c = lch->c();
+    double *const h = lch->h();
+    double *const scratchL = m_scratchBuffer.l();
+    double *const scratchC = m_scratchBuffer.c();
+    double *const scratchH = m_scratchBuffer.h();
+
+    // The lightness must be within the range of the gray axis.
+    std::fill(scratchC, scratchC + colorCount, 0.0);
+    std::copy(h, h + colorCount, scratchH);
+    m_colorSpace->lightnessRange(m_scratchBuffer.view(), //
+                                 m_minimumLightness.data(),
+                                 m_maximumLightness.data());
+    for (int i = 0; i < colorCount; ++i) {
+        l[i] = qBound(m_minimumLightness.at(i), l[i], m_maximumLightness.at(i));
+    }
+
+    if (gamutMapping == GamutMapping::CuspMapping) {
+        m_anchorLightness.resize(colorCount);
+        // The cusp for each hue. (The hue plane of the scratch buffer
+        // still contains the hues.)
+        m_colorSpace->cusp(m_scratchBuffer.view());
+        for (int i = 0; i < colorCount; ++i) {
+            m_anchorLightness[i] = qBound(m_minimumLightness.at(i), //
+                                          scratchL[i],
+                                          m_maximumLightness.at(i));
+        }
+    }
+
+    // The maximum chroma for each color.
+    std::copy(l, l + colorCount, scratchL);
+    std::copy(h, h + colorCount, scratchH);
+    m_colorSpace->maximumInGamutChroma(m_scratchBuffer.view());
+
+    if (gamutMapping == GamutMapping::AdjustChroma) {
+        for (int i = 0; i < colorCount; ++i) {
+            c[i] = qMin(c[i], scratchC[i]);
+        }
+        return;
+    }
+
+    // Cusp mapping: Out-of-gamut colors are moved along the line to
+    // the anchor on the gray axis. Bisection on the gamut boundary table.
+    for (int i = 0; i < colorCount; ++i) {
+        if (c[i] <= scratchC[i]) {
+            continue;
+        }
+        const double anchor = m_anchorLightness.at(i);
+        const double deltaL = l[i] - anchor;
+        const double lineLength = qSqrt(deltaL * deltaL + c[i] * c[i]);
+        double lower = 0; // in-gamut
+        double upper = 1; // out-of-gamut
+        while ((upper - lower) * lineLength > interactiveGamutPrecision) {
+            const double candidate = (lower + upper) / 2;
+            const double candidateL = anchor + candidate * deltaL;
+            const double candidateC = candidate * c[i];
+            if (candidateC <= m_colorSpace->maximumInGamutChroma(candidateL, h[i])) {
+                lower = candidate;
+            } else {
+                upper = candidate;
+            }
+        }
+        l[i] = anchor + lower * deltaL;
+        c[i] = lower * c[i];
+    }
+}
+
+/** @brief Checks which colors are in-gamut.
+ *
+ * All colors are converted within a single batch call.
+ *
+ * @param lch The colors. At most @ref count() colors.
+ *
+ * @post The first <tt>lch.count()</tt> values of @ref m_isInGamut
+ * contain the result. */
+void BatchColorEdit::classify(PlanarView<const double> lch) const
+{
+    const PlanarView<double> lab = m_labBuffer.view().slice(0, lch.count());
+    LabBuffer::fromLch(lch, lab);
+    m_colorSpace->toRgbDoubleUnbound(lab, m_rgbBuffer.data());
+    m_colorSpace->isInGamut(lab, m_rgbBuffer.constData(), m_isInGamut.data());
+}
+
+/** @brief Maps colors into the gamut.
+ *
+ * Each out-of-gamut color is moved on a line within the
+ * chroma-lightness plane of its hue, towards an anchor on the gray
+ * axis, until it hits the gamut boundary:
+ * - For @ref GamutMapping::AdjustChroma, the anchor has the lightness
+ *   of the color, like in
+ *   @ref RgbColorSpace::nearestInGamutColorByAdjustingChroma().
+ * - For @ref GamutMapping::CuspMapping, the anchor has the lightness of
+ *   the cusp, like in
+ *   @ref RgbColorSpace::nearestInGamutColorByCuspMapping().
+ *
+ * The search starts with the estimate of
+ * @ref mapIntoGamutApproximately() and with a point at
+ * @ref estimateMargin from this estimate. Then, a bisection follows. All
+ * colors are searched at the same time: Each step converts the
+ * candidates of all unfinished searches within a single batch call.
+ *
+ * Colors beyond the lightness range of the gray axis (for example below
+ * the black point of a profile with lifted black) have no in-gamut
+ * anchor. Their lightness is clamped to this range first, so that they
+ * stay in the batch search. Colors whose anchor is nevertheless
+ * out-of-gamut are mapped with the corresponding function of
+ * @ref RgbColorSpace.
+ *
+ * @param gamutMapping The gamut mapping strategy
+ * @param precision Precision of the gamut boundary search
+ * @param lch The colors. They are mapped in place. Lightness must be
+ * within <tt>[0, 100]</tt>, chroma ≥ <tt>0</tt> and hue normalized,
+ * as provided by @ref adjust(). */
+void BatchColorEdit::mapIntoGamut(GamutMapping gamutMapping, qreal precision, LchBuffer *lch) const
+{
+    const int colorCount = lch->count();
+    if (colorCount < 1) {
+        return;
+    }
+    m_labBuffer.resize(colorCount);
+    m_rgbBuffer.resize(colorCount);
+    m_isInGamut.resize(colorCount);
+    m_pointBuffer.resize(colorCount);
+    double *const l = lch->l();
+    double *const c = lch->c();
+    double *const h = lch->h();
+    double *const pointL = m_pointBuffer.l();
+    double *const pointC = m_pointBuffer.c();
+    double *const pointH = m_pointBuffer.h();
+    BoundarySearch &search = m_search;
+
+    // Colors that are yet in-gamut stay unchanged.
+    classify(lch->view());
+    search.color.clear();
+    search.fallback.clear();
+    for (int i = 0; i < colorCount; ++i) {
+        if (!m_isInGamut.at(i)) {
+            search.color.append(i);
+        }
+    }
+    if (search.color.isEmpty()) {
+        return;
+    }
+
+    // Estimates from the gamut boundary table
+    m_estimateBuffer.resize(colorCount);
+    std::copy(l, l + colorCount, m_estimateBuffer.l());
+    std::copy(c, c + colorCount, m_estimateBuffer.c());
+    std::copy(h, h + colorCount, m_estimateBuffer.h());
+    mapIntoGamutApproximately(gamutMapping, &m_estimateBuffer);
+
+    // The anchors must be in-gamut. The lightness range of the gray
+    // axis has yet been calculated by mapIntoGamutApproximately().
+    for (const int i : qAsConst(search.color)) {
+        l[i] = qBound(m_minimumLightness.at(i), l[i], m_maximumLightness.at(i));
+    }
+    int searchCount = search.color.count();
+    search.anchor.resize(searchCount);
+    for (int k = 0; k < searchCount; ++k) {
+        const int i = search.color.at(k);
+        search.anchor[k] = (gamutMapping == GamutMapping::CuspMapping) //
+            ? m_anchorLightness.at(i)
+            : l[i];
+        pointL[k] = search.anchor.at(k);
+        pointC[k] = 0;
+        pointH[k] = h[i];
+    }
+    classify(m_pointBuffer.view().slice(0, searchCount));
+    int kept = 0;
+    for (int k = 0; k < searchCount; ++k) {
+        if (m_isInGamut.at(k)) {
+            search.color[kept] = search.color.at(k);
+            search.anchor[kept] = search.anchor.at(k);
+            ++kept;
+        } else {
+            search.fallback.append(search.color.at(k));
+        }
+    }
+    searchCount = kept;
+    search.color.resize(searchCount);
+    search.anchor.resize(searchCount);
+
+    search.length.resize(searchCount);
+    search.estimate.resize(searchCount);
+    search.lower.resize(searchCount);
+    search.upper.resize(searchCount);
+    search.candidate.resize(searchCount);
+    for (int k = 0; k < searchCount; ++k) {
+        const int i = search.color.at(k);
+        const double deltaL = l[i] - search.anchor.at(k);
+        const double squaredLength = deltaL * deltaL + c[i] * c[i];
+        // Projection of the estimate onto the line
+        const double estimateDeltaL = m_estimateBuffer.l()[i] - search.anchor.at(k);
+        search.estimate[k] = (squaredLength > 0) //
+            ? qBound(0.0, (estimateDeltaL * deltaL + m_estimateBuffer.c()[i] * c[i]) / squaredLength, 1.0)
+            : 0;
+        search.length[k] = qSqrt(squaredLength);
+        search.lower[k] = 0; // in-gamut
+        search.upper[k] = 1; // out-of-gamut
+    }
+
+    for (int step = 0;; ++step) {
+        search.pending.clear();
+        for (int k = 0; k < searchCount; ++k) {
+            const double lower = search.lower.at(k);
+            const double upper = search.upper.at(k);
+            if ((upper - lower) * search.length.at(k) <= precision) {
+                continue;
+            }
+            const double estimate = search.estimate.at(k);
+            double candidate = (lower + upper) / 2;
+            if (step == 0) {
+                candidate = estimate;
+            } else if (step == 1) {
+                const double margin = estimateMargin / search.length.at(k);
+                candidate = (lower == estimate) ? estimate + margin : estimate - margin;
+            }
+            if ((candidate <= lower) || (candidate >= upper)) {
+                candidate = (lower + upper) / 2;
+            }
+            search.candidate[k] = candidate;
+            const int position = search.pending.count();
+            const int i = search.color.at(k);
+            pointL[position] = search.anchor.at(k) + candidate * (l[i] - search.anchor.at(k));
+            pointC[position] = candidate * c[i];
+            pointH[position] = h[i];
+            search.pending.append(k);
+        }
+        if (search.pending.isEmpty()) {
+            break;
+        }
+        classify(m_pointBuffer.view().slice(0, search.pending.count()));
+        for (int position = 0; position < search.pending.count(); ++position) {
+            const int k = search.pending.at(position);
+            if (m_isInGamut.at(position)) {
+                search.lower[k] = search.candidate.at(k);
+            } else {
+                search.upper[k] = search.candidate.at(k);
+            }
+        }
+    }
+
+    for (int k = 0; k < searchCount; ++k) {
+        const int i = search.color.at(k);
+        const double position = search.lower.at(k);
+        l[i] = search.anchor.at(k) + position * (l[i] - search.anchor.at(k));
+        c[i] = position * c[i];
+    }
+    for (const int i : qAsConst(search.fallback)) {
+        const LchDouble color {l[i], c[i], h[i]};
+        const LchDouble mapped = (gamutMapping == GamutMapping::CuspMapping) //
+            ? m_colorSpace->nearestInGamutColorByCuspMapping(color, precision)
+            : m_colorSpace->nearestInGamutColorByAdjustingChroma(color, precision);
+        l[i] = mapped.l;
+        c[i] = mapped.c;
+        h[i] = mapped.h;
+    }
+}
+
+/** @brief Fast preview of an adjustment.
+ *
+ * This function is fast enough to be called for thousands of colors
+ * during a mouse drag. See the class description for details.
+ *
+ * @param adjustment The adjustment
+ * @param gamutMapping The gamut mapping strategy
+ * @param rgb Buffer that will receive @ref count() values: The opaque
+ * RGB values of the edited colors. */
+void BatchColorEdit::preview(const Adjustment &adjustment, GamutMapping gamutMapping, QRgb *rgb) const
+{
+    const int colorCount = m_colors.count();
+    if (colorCount < 1) {
+        return;
+    }
+    adjust(adjustment, &m_previewBuffer);
+    mapIntoGamut(gamutMapping, interactiveGamutPrecision, &m_previewBuffer);
+    m_labBuffer.resize(colorCount);
+    LabBuffer::fromLch(m_previewBuffer.view(), m_labBuffer.view());
+    m_rgbBuffer.resize(colorCount);
+    m_colorSpace->toRgbDoubleUnbound(m_labBuffer.view(), m_rgbBuffer.data());
+    const auto toByte = [](double value) {
+        return qRound(qBound(0.0, value, 1.0) * 255);
+    };
+    for (int i = 0; i < colorCount; ++i) {
+        const RgbDouble &value = m_rgbBuffer.at(i);
+        rgb[i] = qRgb(toByte(value.red), toByte(value.green), toByte(value.blue));
+    }
+}
+
+/** @brief Result of an adjustment.
+ *
+ * @param adjustment The adjustment
+ * @param gamutMapping The gamut mapping strategy
+ * @returns The edited colors, in the same order as the original colors.
+ * They are in-gamut. */
+QVector<LchDouble> BatchColorEdit::result(const Adjustment &adjustment, GamutMapping gamutMapping) const
+{
+    LchBuffer adjusted;
+    adjust(adjustment, &adjusted);
+    mapIntoGamut(gamutMapping, gamutPrecision, &adjusted);
+    return adjusted.toVector();
+}
+
+} // namespace PerceptualColor
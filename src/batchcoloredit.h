@@ -0,0 +1,199 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BATCHCOLOREDIT_H
+#define BATCHCOLOREDIT_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QRgb>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "PerceptualColor/lchdouble.h"
+#include "labbuffer.h"
+#include "lchbuffer.h"
+#include "rgbdouble.h"
+
+namespace PerceptualColor
+{
+class RgbColorSpace;
+
+/** @internal
+ *
+ * @brief Applies the same relative LCh edit to many colors at once.
+ *
+ * Example: “Make these 500 swatches 5 units lighter, keep hue.”
+ *
+ * Each component is scaled first, then the offset is added:
+ * <tt>lightness × lightnessScale + lightnessOffset</tt>, and so on. Hue
+ * has only an offset. Afterwards, each color is mapped back into the
+ * gamut with the selected @ref GamutMapping.
+ *
+ * Everything happens in batch over the planes of a @ref LchBuffer. The
+ * gamut mapping starts with an estimate from the precomputed gamut
+ * boundary (see @ref RgbColorSpace::maximumInGamutChroma(PlanarView<double>) const),
+ * which is then refined by a bisection that runs for all colors at the
+ * same time, with one batch call to LittleCMS per step. There are two
+ * ways to get the results:
+ * - @ref preview() is fast enough to be called for thousands of colors
+ *   while the user drags a slider. It searches the gamut boundary with
+ *   @ref interactiveGamutPrecision.
+ * - @ref result() provides the in-gamut colors with the full
+ *   @ref gamutPrecision.
+ *
+ * @note This class reuses internal buffers to avoid allocations while
+ * dragging. Therefore, an object of this class must not be used by more
+ * than one thread at the same time.
+ *
+ * Example:
+ * @snippet test/testbatchcoloredit.cpp Use BatchColorEdit
+ *
+ * @sa @ref BatchColorEditDialog */
+class BatchColorEdit final
+{
+public:
+    /** @brief Strategies to map out-of-gamut colors into the gamut. */
+    enum class GamutMapping {
+        /** @brief Reduce the chroma, keep lightness and hue.
+         *
+         * Like @ref RgbColorSpace::nearestInGamutColorByAdjustingChroma() */
+        AdjustChroma,
+        /** @brief Move towards the gray of the lightness of the cusp,
+         * keep hue.
+         *
+         * Like @ref RgbColorSpace::nearestInGamutColorByCuspMapping() */
+        CuspMapping
+    };
+
+    /** @brief A relative edit of LCh colors. */
+    struct Adjustment {
+        /** @brief Factor for the lightness */
+        qreal lightnessScale = 1;
+        /** @brief Offset for the lightness */
+        qreal lightnessOffset = 0;
+        /** @brief Factor for the chroma */
+        qreal chromaScale = 1;
+        /** @brief Offset for the chroma */
+        qreal chromaOffset = 0;
+        /** @brief Offset for the hue, measured in degree */
+        qreal hueOffset = 0;
+    };
+
+    explicit BatchColorEdit(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QVector<PerceptualColor::LchDouble> &colors);
+    /** @brief Default destructor */
+    ~BatchColorEdit() noexcept = default;
+    QVector<LchDouble> colors() const;
+    int count() const;
+    void preview(const Adjustment &adjustment, GamutMapping gamutMapping, QRgb *rgb) const;
+    QVector<LchDouble> result(const Adjustment &adjustment, GamutMapping gamutMapping) const;
+
+private:
+    Q_DISABLE_COPY(BatchColorEdit)
+
+    /** @brief State of the gamut boundary search of
+     * @ref mapIntoGamut().
+     *
+     * Each color is searched on a line from an anchor on the gray axis
+     * (position <tt>0</tt>) to the color itself (position <tt>1</tt>).
+     * The vectors have one entry for each color whose search is
+     * running. */
+    struct BoundarySearch {
+        /** @brief Index of the color */
+        QVector<int> color;
+        /** @brief Lightness of the anchor */
+        QVector<double> anchor;
+        /** @brief Length of the line, measured in LCh units */
+        QVector<double> length;
+        /** @brief Position of the estimate from the gamut boundary table */
+        QVector<double> estimate;
+        /** @brief Largest position that is known to be in-gamut */
+        QVector<double> lower;
+        /** @brief Smallest position that is known to be out-of-gamut */
+        QVector<double> upper;
+        /** @brief Position of the candidate of the current step */
+        QVector<double> candidate;
+        /** @brief Searches that are not yet finished */
+        QVector<int> pending;
+        /** @brief Colors whose anchor is out-of-gamut. */
+        QVector<int> fallback;
+    };
+
+    /** @brief Tolerance of the gamut boundary table, measured in LCh
+     * units.
+     *
+     * The boundary search first tests the estimate from the table, and
+     * then a point at this distance from the estimate. If the table is
+     * as precise as expected, the bisection starts with an interval of
+     * this size instead of the whole line. */
+    static constexpr double estimateMargin = 0.5;
+
+    void adjust(const Adjustment &adjustment, LchBuffer *target) const;
+    void classify(PlanarView<const double> lch) const;
+    void mapIntoGamut(GamutMapping gamutMapping, qreal precision, LchBuffer *lch) const;
+    void mapIntoGamutApproximately(GamutMapping gamutMapping, LchBuffer *lch) const;
+
+    /** @brief The color space */
+    QSharedPointer<RgbColorSpace> m_colorSpace;
+    /** @brief The original colors */
+    LchBuffer m_colors;
+    /** @brief Buffer for the adjusted colors in @ref preview(). */
+    mutable LchBuffer m_previewBuffer;
+    /** @brief Buffer for the estimates in @ref mapIntoGamut(). */
+    mutable LchBuffer m_estimateBuffer;
+    /** @brief Buffer for the colors to test in @ref mapIntoGamut(). */
+    mutable LchBuffer m_pointBuffer;
+    /** @brief Buffer for the Lab values in @ref classify() and
+     * @ref preview(). */
+    mutable LabBuffer m_labBuffer;
+    /** @brief Buffer for the results of @ref classify(). */
+    mutable QVector<bool> m_isInGamut;
+    /** @brief State of the boundary search in @ref mapIntoGamut(). */
+    mutable BoundarySearch m_search;
+    /** @brief Buffer for intermediate values in
+     * @ref mapIntoGamutApproximately(). */
+    mutable LchBuffer m_scratchBuffer;
+    /** @brief Buffer for the minimum lightness in
+     * @ref mapIntoGamutApproximately(). */
+    mutable QVector<double> m_minimumLightness;
+    /** @brief Buffer for the maximum lightness in
+     * @ref mapIntoGamutApproximately(). */
+    mutable QVector<double> m_maximumLightness;
+    /** @brief Buffer for the lightness of the anchors of the cusp
+     * mapping in @ref mapIntoGamutApproximately(). */
+    mutable QVector<double> m_anchorLightness;
+    /** @brief Buffer for the RGB values in @ref classify() and
+     * @ref preview(). */
+    mutable QVector<RgbDouble> m_rgbBuffer;
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestBatchColorEdit;
+};
+
+} // namespace PerceptualColor
+
+#endif // BATCHCOLOREDIT_H
@@ -0,0 +1,204 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "batchcoloreditdialog.h"
+// Second, the private implementation.
+#include "batchcoloreditdialog_p.h"
+
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QPixmap>
+#include <QVBoxLayout>
+#include <QtMath>
+
+namespace PerceptualColor
+{
+/** @brief Constructor
+ *
+ * @param colorSpace The color space of the colors
+ * @param colors The colors to edit
+ * @param parent Pointer to the parent widget, if any */
+BatchColorEditDialog::BatchColorEditDialog(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QVector<PerceptualColor::LchDouble> &colors, QWidget *parent)
+    : QDialog(parent)
+    , d_pointer(new BatchColorEditDialogPrivate(this, colorSpace, colors))
+{
+    d_pointer->initialize();
+}
+
+/** @brief Default destructor */
+BatchColorEditDialog::~BatchColorEditDialog() noexcept
+{
+}
+
+/** @brief Constructor
+ *
+ * @param backLink Pointer to the object from which <em>this</em> object
+ * is the private implementation.
+ * @param colorSpace The color space of the colors
+ * @param colors The colors to edit */
+BatchColorEditDialog::BatchColorEditDialogPrivate::BatchColorEditDialogPrivate(BatchColorEditDialog *backLink, const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QVector<PerceptualColor::LchDouble> &colors)
+    : m_batchColorEdit(colorSpace, colors)
+    , q_pointer(backLink)
+{
+}
+
+/** @brief Basic initialization.
+ *
+ * Creates the child widgets and the layout. */
+void BatchColorEditDialog::BatchColorEditDialogPrivate::initialize()
+{
+    const auto createSlider = [this](int minimum, int maximum, int value) {
+        QSlider *slider = new QSlider(Qt::Orientation::Horizontal);
+        slider->setRange(minimum, maximum);
+        slider->setValue(value);
+        // The preview is fast enough to follow each single step
+        // of a drag.
+        slider->setTracking(true);
+        QObject::connect(slider, &QSlider::valueChanged, q_pointer, [this]() {
+            updatePreview();
+        });
+        return slider;
+    };
+    m_lightnessOffsetSlider = createSlider(-50, 50, 0);
+    m_chromaScaleSlider = createSlider(0, 200, 100);
+    m_hueOffsetSlider = createSlider(-180, 180, 0);
+
+    m_gamutMappingComboBox = new QComboBox();
+    m_gamutMappingComboBox->addItem( //
+        BatchColorEditDialog::tr("Reduce chroma"),
+        static_cast<int>(BatchColorEdit::GamutMapping::AdjustChroma));
+    m_gamutMappingComboBox->addItem( //
+        BatchColorEditDialog::tr("Map towards cusp"),
+        static_cast<int>(BatchColorEdit::GamutMapping::CuspMapping));
+    QObject::connect(m_gamutMappingComboBox, //
+                     QOverload<int>::of(&QComboBox::currentIndexChanged),
+                     q_pointer,
+                     [this]() {
+                         updatePreview();
+                     });
+
+    m_previewLabel = new QLabel();
+    m_previewLabel->setScaledContents(true);
+    m_previewLabel->setMinimumSize(200, 200);
+    m_previewLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    QFormLayout *formLayout = new QFormLayout();
+    formLayout->addRow(BatchColorEditDialog::tr("&Lightness offset:"), m_lightnessOffsetSlider);
+    formLayout->addRow(BatchColorEditDialog::tr("&Chroma (%):"), m_chromaScaleSlider);
+    formLayout->addRow(BatchColorEditDialog::tr("&Hue offset:"), m_hueOffsetSlider);
+    formLayout->addRow(BatchColorEditDialog::tr("&Gamut mapping:"), m_gamutMappingComboBox);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox( //
+        QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    QObject::connect(buttonBox, &QDialogButtonBox::accepted, q_pointer, &QDialog::accept);
+    QObject::connect(buttonBox, &QDialogButtonBox::rejected, q_pointer, &QDialog::reject);
+
+    QVBoxLayout *layout = new QVBoxLayout(q_pointer);
+    layout->addWidget(m_previewLabel);
+    layout->addLayout(formLayout);
+    layout->addWidget(buttonBox);
+
+    q_pointer->setWindowTitle(BatchColorEditDialog::tr("Edit Colors"));
+    updatePreview();
+}
+
+/** @brief Updates the preview for the current values of the widgets. */
+void BatchColorEditDialog::BatchColorEditDialogPrivate::updatePreview()
+{
+    const int colorCount = m_batchColorEdit.count();
+    const int columns = qMax(1, qCeil(qSqrt(colorCount)));
+    const int rows = qMax(1, (colorCount + columns - 1) / columns);
+    if (m_previewImage.size() != QSize(columns, rows)) {
+        m_previewImage = QImage(columns, rows, QImage::Format_ARGB32_Premultiplied);
+        m_previewImage.fill(Qt::transparent);
+    }
+    // The image has no padding at the end of the scan lines for
+    // 32-bit formats, so the preview can be written directly.
+    m_batchColorEdit.preview( //
+        q_pointer->adjustment(),
+        q_pointer->gamutMapping(),
+        reinterpret_cast<QRgb *>(m_previewImage.bits()));
+    m_previewLabel->setPixmap(QPixmap::fromImage(m_previewImage));
+}
+
+/** @brief The adjustment that is currently selected by the user.
+ *
+ * @returns The adjustment that is currently selected by the user. */
+BatchColorEdit::Adjustment BatchColorEditDialog::adjustment() const
+{
+    BatchColorEdit::Adjustment result;
+    result.lightnessOffset = d_pointer->m_lightnessOffsetSlider->value();
+    result.chromaScale = d_pointer->m_chromaScaleSlider->value() / 100.0;
+    result.hueOffset = d_pointer->m_hueOffsetSlider->value();
+    return result;
+}
+
+/** @brief The gamut mapping that is currently selected by the user.
+ *
+ * @returns The gamut mapping that is currently selected by the user. */
+BatchColorEdit::GamutMapping BatchColorEditDialog::gamutMapping() const
+{
+    return static_cast<BatchColorEdit::GamutMapping>( //
+        d_pointer->m_gamutMappingComboBox->currentData().toInt());
+}
+
+/** @brief The edited colors.
+ *
+ * @returns The exact in-gamut result of the current @ref adjustment()
+ * and @ref gamutMapping(), in the same order as the original colors. */
+QVector<LchDouble> BatchColorEditDialog::editedColors() const
+{
+    return d_pointer->m_batchColorEdit.result(adjustment(), gamutMapping());
+}
+
+/** @brief Pops up a modal dialog, lets the user edit the colors, and
+ *  returns the edited colors.
+ *
+ * @param colorSpace The color space of the colors
+ * @param colors The colors to edit
+ * @param parent Parent widget of the dialog (or 0 for no parent)
+ * @param title Window title (or an empty string for the default window
+ *              title)
+ * @returns The edited colors, in the same order as the original colors.
+ * An empty vector if the user has canceled the dialog. */
+QVector<LchDouble> BatchColorEditDialog::getColors(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QVector<PerceptualColor::LchDouble> &colors, QWidget *parent, const QString &title)
+{
+    BatchColorEditDialog temp(colorSpace, colors, parent);
+    if (!title.isEmpty()) {
+        temp.setWindowTitle(title);
+    }
+    if (temp.exec() != QDialog::Accepted) {
+        return QVector<LchDouble>();
+    }
+    return temp.editedColors();
+}
+
+} // namespace PerceptualColor
@@ -0,0 +1,89 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BATCHCOLOREDITDIALOG_H
+#define BATCHCOLOREDITDIALOG_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QDialog>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "PerceptualColor/constpropagatinguniquepointer.h"
+#include "PerceptualColor/lchdouble.h"
+#include "batchcoloredit.h"
+
+namespace PerceptualColor
+{
+class RgbColorSpace;
+
+/** @internal
+ *
+ * @brief A dialog to edit many colors at once.
+ *
+ * The user can shift the lightness, scale the chroma and rotate the hue
+ * of all colors together, and choose the gamut mapping. The preview of
+ * all edited colors is updated live while a slider is dragged; it uses
+ * @ref BatchColorEdit::preview(), which stays interactive for thousands
+ * of colors. The exact result is calculated only once, when it is
+ * requested by @ref editedColors().
+ *
+ * The easiest way to use this dialog is @ref getColors(). */
+class BatchColorEditDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    Q_INVOKABLE explicit BatchColorEditDialog(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QVector<PerceptualColor::LchDouble> &colors, QWidget *parent = nullptr);
+    virtual ~BatchColorEditDialog() noexcept override;
+    BatchColorEdit::Adjustment adjustment() const;
+    QVector<LchDouble> editedColors() const;
+    BatchColorEdit::GamutMapping gamutMapping() const;
+    static QVector<LchDouble> getColors(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QVector<PerceptualColor::LchDouble> &colors, QWidget *parent = nullptr, const QString &title = QString());
+
+private:
+    Q_DISABLE_COPY(BatchColorEditDialog)
+
+    class BatchColorEditDialogPrivate;
+    /** @internal
+     *
+     * @brief Declare the private implementation as friend class.
+     *
+     * This allows the private class to access the protected members and
+     * functions of instances of <em>this</em> class. */
+    friend class BatchColorEditDialogPrivate;
+    /** @brief Pointer to implementation (pimpl) */
+    ConstPropagatingUniquePointer<BatchColorEditDialogPrivate> d_pointer;
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestBatchColorEditDialog;
+};
+
+} // namespace PerceptualColor
+
+#endif // BATCHCOLOREDITDIALOG_H
@@ -0,0 +1,94 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BATCHCOLOREDITDIALOG_P_H
+#define BATCHCOLOREDITDIALOG_P_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Include the header of the public class of this private implementation.
+#include "batchcoloreditdialog.h"
+
+#include "batchcoloredit.h"
+#include "constpropagatingrawpointer.h"
+
+#include <QComboBox>
+#include <QImage>
+#include <QLabel>
+#include <QPointer>
+#include <QSlider>
+
+namespace PerceptualColor
+{
+/** @internal
+ *
+ *  @brief Private implementation within the <em>Pointer to
+ *  implementation</em> idiom */
+class BatchColorEditDialog::BatchColorEditDialogPrivate final
+{
+public:
+    BatchColorEditDialogPrivate(BatchColorEditDialog *backLink, const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QVector<PerceptualColor::LchDouble> &colors);
+    /** @brief Default destructor
+     *
+     * The destructor is non-<tt>virtual</tt> because
+     * the class as a whole is <tt>final</tt>. */
+    ~BatchColorEditDialogPrivate() noexcept = default;
+
+    /** @brief The colors and their edit */
+    BatchColorEdit m_batchColorEdit;
+    /** @brief Slider for @ref BatchColorEdit::Adjustment::chromaScale,
+     * measured in percent */
+    QPointer<QSlider> m_chromaScaleSlider;
+    /** @brief Combo box for the @ref BatchColorEdit::GamutMapping */
+    QPointer<QComboBox> m_gamutMappingComboBox;
+    /** @brief Slider for @ref BatchColorEdit::Adjustment::hueOffset */
+    QPointer<QSlider> m_hueOffsetSlider;
+    /** @brief Slider for
+     * @ref BatchColorEdit::Adjustment::lightnessOffset */
+    QPointer<QSlider> m_lightnessOffsetSlider;
+    /** @brief Displays @ref m_previewImage */
+    QPointer<QLabel> m_previewLabel;
+    /** @brief Image with one pixel for each edited color.
+     *
+     * The colors are ordered in rows. Unused pixels at the end are
+     * transparent. The image is reused for each update. */
+    QImage m_previewImage;
+
+    void initialize();
+    void updatePreview();
+
+private:
+    Q_DISABLE_COPY(BatchColorEditDialogPrivate)
+
+    /** @brief Pointer to the object from which <em>this</em> object
+     *  is the private implementation. */
+    ConstPropagatingRawPointer<BatchColorEditDialog> q_pointer;
+};
+
+} // namespace PerceptualColor
+
+#endif // BATCHCOLOREDITDIALOG_P_H
@@ -34,6 +34,7 @@
 #include "chromahuediagram_p.h"
 
 #include "helper.h"
+#include "lchbuffer.h"
 #include "lchvalues.h"
 #include "polarpointf.h"
 
@@ -41,6 +42,8 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QStyle>
+#include <QTimer>
+#include <QtMath>
 
 namespace PerceptualColor
 {
@@ -72,6 +75,12 @@ ChromaHueDiagram::ChromaHueDiagram(const QSharedPointer<PerceptualColor::RgbColo
     // Qt::FocusPolicy::TabFocus for QWidget::focusPolicy().
     setFocusPolicy(Qt::FocusPolicy::TabFocus);
 
+    // After geometry changes, the gamut is rendered deferred.
+    connect(&d_pointer->m_fillTimer, &QTimer::timeout, this, [this]() {
+        d_pointer->m_chromaHueImage.getImage();
+        update();
+    });
+
     // Initialize the color
     setCurrentColor(LchValues::srgbVersatileInitialColor());
 }
@@ -91,6 +100,8 @@ ChromaHueDiagram::ChromaHueDiagramPrivate::ChromaHueDiagramPrivate(ChromaHueDiag
     , m_wheelImage(colorSpace)
     , q_pointer(backLink)
 {
+    m_fillTimer.setSingleShot(true);
+    m_fillTimer.setInterval(fillDelay);
 }
 
 /** @brief React on a mouse press event.
@@ -129,14 +140,10 @@ void ChromaHueDiagram::mousePressEvent(QMouseEvent *event)
         // cursor is made invisible. Its function is taken over by the
         // handle itself within the displayed gamut.
         setCursor(Qt::BlankCursor);
-        // Set the color property
-        d_pointer->setColorFromWidgetPixelPosition(event->pos());
-        // Schedule a paint event, so that the wheel handle will show. It’s
-        // not enough to hope setColorFromWidgetCoordinates() would do this,
-        // because setColorFromWidgetCoordinates() would not update the
-        // widget if the mouse click was done at the same position as the
-        // current color handle.
-        update();
+        // Move the handle immediately; the color property is set as soon
+        // as the gamut resolution has been done. This also schedules a
+        // paint event, so that the wheel handle will show.
+        d_pointer->setPendingColorFromWidgetPixelPosition(event->pos());
     } else {
         // Make sure default behavior like drag-window in KDE’s
         // “Breeze” widget style works if this widget does not
@@ -160,6 +167,9 @@ void ChromaHueDiagram::mousePressEvent(QMouseEvent *event)
  *   value is the highest possible chroma within the gamut at this hue.
  *   Both, the diagram’s handle <em>and</em> the mouse cursor are
  *   visible.
+ * - The handle follows the mouse immediately. The gamut resolution and
+ *   therefore the change of @ref currentColor happens in the next event
+ *   loop iteration. See @ref ChromaHueDiagramPrivate::m_pendingColor.
  * @endinternal
  *
  * @param event The corresponding mouse event */
@@ -173,7 +183,7 @@ void ChromaHueDiagram::mouseMoveEvent(QMouseEvent *event)
         } else {
             unsetCursor();
         }
-        d_pointer->setColorFromWidgetPixelPosition(event->pos());
+        d_pointer->setPendingColorFromWidgetPixelPosition(event->pos());
     } else {
         // Make sure default behavior like drag-window in KDE’s
         // Breeze widget style works.
@@ -216,7 +226,7 @@ void ChromaHueDiagram::mouseReleaseEvent(QMouseEvent *event)
         // this, because setColorFromWidgetCoordinates() would not update the
         // widget if the mouse click was done at the same position as the
         // current color handle.
-        update();
+        scheduleRepaint();
     } else {
         // Make sure default behavior like drag-window in KDE’s
         // Breeze widget style works
@@ -387,6 +397,10 @@ LchDouble ChromaHueDiagram::currentColor() const
  * @param newCurrentColor the new color */
 void ChromaHueDiagram::setCurrentColor(const LchDouble &newCurrentColor)
 {
+    // An explicitly set color takes precedence over a color that is still
+    // waiting for gamut resolution.
+    d_pointer->m_hasPendingColor = false;
+
     if (newCurrentColor.hasSameCoordinates(d_pointer->m_currentColor)) {
         return;
     }
@@ -401,7 +415,7 @@ void ChromaHueDiagram::setCurrentColor(const LchDouble &newCurrentColor)
     }
 
     // Schedule a paint event:
-    update();
+    scheduleRepaint();
 
     // Emit notify signal
     Q_EMIT currentColorChanged(newCurrentColor);
@@ -435,6 +449,100 @@ qreal ChromaHueDiagram::ChromaHueDiagramPrivate::diagramOffset() const
     return q_pointer->maximumWidgetSquareSize() / 2.0;
 }
 
+/** @brief The outline of the gamut at the current lightness.
+ *
+ * The outline is calculated from the gamut boundary of the color
+ * space, see @ref RgbColorSpace::maximumInGamutChroma(). It is cached
+ * for the lightness of @ref m_currentColor.
+ *
+ * @returns The outline of the gamut. The coordinates are Lab a and b
+ * values. It is limited to the chroma range of the diagram. */
+QPainterPath ChromaHueDiagram::ChromaHueDiagramPrivate::gamutOutline()
+{
+    const qreal lightness = m_currentColor.l;
+    if (lightness == m_gamutOutlineLightness) {
+        return m_gamutOutline;
+    }
+
+    // One point per degree, which is the resolution of the gamut boundary.
+    constexpr int hueCount = 360;
+    LchBuffer boundary(hueCount);
+    for (int i = 0; i < hueCount; ++i) {
+        boundary.l()[i] = lightness;
+        boundary.h()[i] = i;
+    }
+    m_rgbColorSpace->maximumInGamutChroma(boundary.view());
+    const qreal chromaRange = m_rgbColorSpace->maximumChroma();
+    QPainterPath outline;
+    for (int i = 0; i < hueCount; ++i) {
+        const QPointF point = PolarPointF(qMin(boundary.c()[i], chromaRange), boundary.h()[i]).toCartesian();
+        if (i == 0) {
+            outline.moveTo(point);
+        } else {
+            outline.lineTo(point);
+        }
+    }
+    outline.closeSubpath();
+
+    m_gamutOutline = outline;
+    m_gamutOutlineLightness = lightness;
+    return m_gamutOutline;
+}
+
+/** @brief Paints a provisional gamut for the current geometry.
+ *
+ * Used while @ref m_chromaHueImage has no image for the current
+ * geometry yet. The fill is @ref m_lastGamutImage, scaled to the
+ * current geometry, which is fast but might be blurry. The gamut
+ * boundary and the gray circle, however, are painted as vector
+ * shapes on top, so they stay sharp at any size and device
+ * pixel ratio.
+ *
+ * @param painter The painter. Its coordinates are widget coordinates.
+ * Nothing else must have been painted on its device yet. */
+void ChromaHueDiagram::ChromaHueDiagramPrivate::paintInterimGamut(QPainter *painter)
+{
+    const qreal radius = diagramOffset() - diagramBorder();
+    if (radius <= 0) {
+        return;
+    }
+    const QPointF center = diagramCenter();
+    const QRectF circle(center.x() - radius, center.y() - radius, 2 * radius, 2 * radius);
+    painter->save();
+
+    // The fill
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter->drawImage(circle, m_lastGamutImage, m_lastGamutImageCircle);
+
+    // Everything within the circle, but outside the gamut, gets the
+    // background color. This paints also the gamut boundary.
+    const qreal scaleFactor = radius / m_rgbColorSpace->maximumChroma();
+    QTransform transform;
+    transform.translate(center.x(), center.y());
+    transform.scale(scaleFactor, -scaleFactor);
+    QPainterPath background;
+    background.setFillRule(Qt::OddEvenFill);
+    background.addEllipse(circle);
+    background.addPath(transform.map(gamutOutline()));
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(m_rgbColorSpace->toQColorRgbBound(LchValues::neutralGray()));
+    painter->drawPath(background);
+
+    // Cut off the blurry fill outside the circle. Like in
+    // ChromaHueImage::getImage(), a thick circle outline is used for that.
+    const qreal cutOffThickness = diagramOffset() * qSqrt(2) // ½ of the diagonal
+        - radius + overlap;
+    painter->setPen(QPen(Qt::SolidPattern, cutOffThickness));
+    painter->setBrush(Qt::NoBrush);
+    painter->setCompositionMode(QPainter::CompositionMode_Clear);
+    painter->drawEllipse(center, //
+                         radius + cutOffThickness / 2,
+                         radius + cutOffThickness / 2);
+
+    painter->restore();
+}
+
 /** @brief React on a resize event.
  *
  * Reimplemented from base class.
@@ -460,14 +568,40 @@ void ChromaHueDiagram::resizeEvent(QResizeEvent *event)
  * and expressed as widget coordinate point.
  * @sa @ref ChromaHueMeasurement "Measurement details" */
 QPointF ChromaHueDiagram::ChromaHueDiagramPrivate::widgetCoordinatesFromCurrentColor() const
+{
+    return widgetCoordinatesFromColor(m_currentColor);
+}
+
+/** @brief  Widget coordinate point corresponding to a given color
+ * @param color The color. Its lightness is ignored.
+ * @returns Widget coordinate point corresponding to the given color
+ * in the gamut diagram, measured and expressed as widget coordinate point.
+ * @sa @ref ChromaHueMeasurement "Measurement details" */
+QPointF ChromaHueDiagram::ChromaHueDiagramPrivate::widgetCoordinatesFromColor(const LchDouble &color) const
 {
     const qreal scaleFactor = (q_pointer->maximumWidgetSquareSize() - 2.0 * diagramBorder()) / (2.0 * m_rgbColorSpace->maximumChroma());
-    QPointF currentColor = PolarPointF(m_currentColor.c, m_currentColor.h).toCartesian();
+    QPointF cartesian = PolarPointF(color.c, color.h).toCartesian();
     return QPointF(
         // x:
-        currentColor.x() * scaleFactor + diagramOffset(),
+        cartesian.x() * scaleFactor + diagramOffset(),
         // y:
-        diagramOffset() - currentColor.y() * scaleFactor);
+        diagramOffset() - cartesian.y() * scaleFactor);
+}
+
+/** @brief The color at which the handle is drawn.
+ *
+ * @returns @ref m_pendingColor (limited to the displayed chroma range) if
+ * there is a color that waits for gamut resolution, @ref m_currentColor
+ * otherwise. */
+LchDouble ChromaHueDiagram::ChromaHueDiagramPrivate::colorAtHandle() const
+{
+    if (!m_hasPendingColor) {
+        return m_currentColor;
+    }
+    LchDouble result = m_pendingColor;
+    // Keep the provisional handle within the gray circle:
+    result.c = qMin(result.c, m_rgbColorSpace->maximumChroma());
+    return result;
 }
 
 /** @brief Converts widget pixel positions to Lab coordinates
@@ -527,6 +661,57 @@ void ChromaHueDiagram::ChromaHueDiagramPrivate::setColorFromWidgetPixelPosition(
     q_pointer->setCurrentColor(m_rgbColorSpace->nearestInGamutColorByAdjustingChroma(m_rgbColorSpace->toLch(lab)));
 }
 
+/** @brief Moves the handle to a given widget pixel position without
+ * resolving the gamut yet.
+ *
+ * The handle is drawn at the raw position on the next paint event. The
+ * nearest in-gamut color is searched in the next event loop iteration by
+ * @ref resolvePendingColor(). Several calls within the same event loop
+ * iteration lead to a single gamut resolution for the latest position.
+ *
+ * @param position The position of a pixel of the widget coordinate
+ * system. The given value  does not necessarily need to be within the
+ * actual displayed diagram or even the gamut itself. It might even be
+ * negative.
+ *
+ * @post @ref currentColor is not changed yet. */
+void ChromaHueDiagram::ChromaHueDiagramPrivate::setPendingColorFromWidgetPixelPosition(const QPoint position)
+{
+    const bool isResolutionScheduled = m_hasPendingColor;
+    m_pendingColor = m_rgbColorSpace->toLch(fromWidgetPixelPositionToLab(position));
+    m_hasPendingColor = true;
+    if (!isResolutionScheduled) {
+        QTimer::singleShot(0, q_pointer, [this]() {
+            resolvePendingColor();
+        });
+    }
+    q_pointer->scheduleRepaint();
+}
+
+/** @brief Sets @ref currentColor to the nearest in-gamut color of
+ * @ref m_pendingColor.
+ *
+ * Does nothing if there is no pending color. While
+ * @ref m_isMouseEventActive is <tt>true</tt>, the gamut boundary is
+ * searched only with @ref interactiveGamutPrecision.
+ *
+ * @post The handle snaps to the resolved color. */
+void ChromaHueDiagram::ChromaHueDiagramPrivate::resolvePendingColor()
+{
+    if (!m_hasPendingColor) {
+        return;
+    }
+    m_hasPendingColor = false;
+    // While a mouse button is held, a coarser precision is enough. The
+    // mouse release event does the exact search.
+    const qreal precision = m_isMouseEventActive //
+        ? interactiveGamutPrecision
+        : gamutPrecision;
+    q_pointer->setCurrentColor(m_rgbColorSpace->nearestInGamutColorByAdjustingChroma(m_pendingColor, precision));
+    // Snap the handle even if the resolved color equals the old one.
+    q_pointer->scheduleRepaint();
+}
+
 /** @brief Tests if a wiget pixel positon is within the mouse sensible circle.
  *
  * The mouse sensible circle contains the inner gray circle (on which the
@@ -568,7 +753,10 @@ bool ChromaHueDiagram::ChromaHueDiagramPrivate::isWidgetPixelPositionWithinMouse
  *   @ref ChromaHueDiagramPrivate::m_chromaHueImage and
  *   @ref ChromaHueDiagramPrivate::m_wheelImage and paints them on the widget.
  *   If their cache is up-to-date, this operation is fast, otherwise
- *   considerably slower.
+ *   considerably slower. If only the geometry has changed, the gamut
+ *   is painted provisionally by
+ *   @ref ChromaHueDiagramPrivate::paintInterimGamut() and rendered
+ *   deferred.
  * - Paints the handles.
  * - If the widget has focus, it also paints the focus indicator. As the
  *   widget is round, we cannot use <tt>QStyle::PE_FrameFocusRect</tt> for
@@ -618,7 +806,10 @@ void ChromaHueDiagram::paintEvent(QPaintEvent *event)
     // Set color of the handle: Black or white, depending on the lightness of
     // the currently selected color.
     const QColor handleColor {handleColorFromBackgroundLightness(d_pointer->m_currentColor.l)};
-    const QPointF widgetCoordinatesFromCurrentColor {d_pointer->widgetCoordinatesFromCurrentColor()};
+    // While a mouse movement waits for gamut resolution, the handle is
+    // drawn at the raw mouse position.
+    const LchDouble colorAtHandle = d_pointer->colorAtHandle();
+    const QPointF widgetCoordinatesFromCurrentColor {d_pointer->widgetCoordinatesFromColor(colorAtHandle)};
 
     // Paint the gamut itself as available in the cache.
     bufferPainter.setRenderHint(QPainter::Antialiasing, false);
@@ -629,9 +820,30 @@ void ChromaHueDiagram::paintEvent(QPaintEvent *event)
     d_pointer->m_chromaHueImage.setChromaRange(d_pointer->m_rgbColorSpace->maximumChroma());
     d_pointer->m_chromaHueImage.setLightness(d_pointer->m_currentColor.l);
     d_pointer->m_chromaHueImage.setDevicePixelRatioF(devicePixelRatioF());
-    bufferPainter.drawImage(QPoint(0, 0),                          // position of the image
-                            d_pointer->m_chromaHueImage.getImage() // image
-    );
+    d_pointer->m_chromaHueImage.setColorVisionDeficiency(colorVisionDeficiency());
+    d_pointer->m_chromaHueImage.setDisplayColorSpace(displayColorSpace());
+    const bool isOnlyGeometryChanged = !d_pointer->m_lastGamutImage.isNull() //
+        && !d_pointer->m_chromaHueImage.isImageAvailable() //
+        && d_pointer->m_chromaHueImage.hasVariants();
+    if (isOnlyGeometryChanged) {
+        // Rendering the gamut for the new geometry is expensive. During
+        // resizing or while the device pixel ratio changes, this would
+        // happen many times in a row. Therefore, paint a scaled version
+        // of the most recent image now, and render deferred.
+        d_pointer->paintInterimGamut(&bufferPainter);
+        d_pointer->m_fillTimer.start();
+    } else {
+        const qreal borderPhysical = d_pointer->diagramBorder() * devicePixelRatioF();
+        const qreal circleDiameterPhysical = maximumPhysicalSquareSize() - 2 * borderPhysical;
+        d_pointer->m_lastGamutImage = d_pointer->m_chromaHueImage.getImage();
+        d_pointer->m_lastGamutImageCircle = QRectF(borderPhysical, //
+                                                   borderPhysical,
+                                                   circleDiameterPhysical,
+                                                   circleDiameterPhysical);
+        bufferPainter.drawImage(QPoint(0, 0),                // position of the image
+                                d_pointer->m_lastGamutImage // image
+        );
+    }
 
     // Paint a color wheel around
     bufferPainter.setRenderHint(QPainter::Antialiasing, false);
@@ -641,6 +853,8 @@ void ChromaHueDiagram::paintEvent(QPaintEvent *event)
     d_pointer->m_wheelImage.setDevicePixelRatioF(devicePixelRatioF());
     d_pointer->m_wheelImage.setImageSize(maximumPhysicalSquareSize());
     d_pointer->m_wheelImage.setWheelThickness(gradientThickness() * devicePixelRatioF());
+    d_pointer->m_wheelImage.setColorVisionDeficiency(colorVisionDeficiency());
+    d_pointer->m_wheelImage.setDisplayColorSpace(displayColorSpace());
     bufferPainter.drawImage(QPoint(0, 0),                      // position of the image
                             d_pointer->m_wheelImage.getImage() // the image itself
     );
@@ -651,10 +865,10 @@ void ChromaHueDiagram::paintEvent(QPaintEvent *event)
         // The radius of the outer border of the color wheel
         const qreal radius = maximumWidgetSquareSize() / static_cast<qreal>(2) - spaceForFocusIndicator();
         // Get widget coordinate point for the handle
-        QPointF myHandleInner = PolarPointF(radius - gradientThickness(), d_pointer->m_currentColor.h).toCartesian();
+        QPointF myHandleInner = PolarPointF(radius - gradientThickness(), colorAtHandle.h).toCartesian();
         myHandleInner.ry() *= -1; // Transform to Widget coordinate points
         myHandleInner += d_pointer->diagramCenter();
-        QPointF myHandleOuter = PolarPointF(radius, d_pointer->m_currentColor.h).toCartesian();
+        QPointF myHandleOuter = PolarPointF(radius, colorAtHandle.h).toCartesian();
         myHandleOuter.ry() *= -1; // Transform to Widget coordinate points
         myHandleOuter += d_pointer->diagramCenter();
         // Draw the line
@@ -38,6 +38,11 @@
 #include "constpropagatingrawpointer.h"
 #include "lchvalues.h"
 
+#include <QPainter>
+#include <QPainterPath>
+#include <QTimer>
+#include <QtNumeric>
+
 namespace PerceptualColor
 {
 /** @internal
@@ -69,6 +74,22 @@ public:
     ChromaHueImage m_chromaHueImage;
     /** @brief Internal storage of the @ref currentColor() property */
     LchDouble m_currentColor;
+    /** @brief Defers the rendering of the gamut after geometry changes.
+     *
+     * Single-shot, restarted by each paint event that uses
+     * @ref paintInterimGamut(). When it times out, @ref m_chromaHueImage
+     * is rendered for the current geometry.
+     *
+     * @sa @ref fillDelay */
+    QTimer m_fillTimer;
+    /** @brief Delay of @ref m_fillTimer, measured in milliseconds. */
+    static constexpr int fillDelay = 100;
+    /** @brief Cache for @ref gamutOutline() */
+    QPainterPath m_gamutOutline;
+    /** @brief The lightness of @ref m_gamutOutline.
+     *
+     * <tt>NaN</tt> if there is no cache yet. */
+    qreal m_gamutOutlineLightness = qQNaN();
     /** @brief Holds if currently a mouse event is active or not.
      *
      * Default value is <tt>false</tt>.
@@ -85,6 +106,26 @@ public:
      * circular widget, only reacting on mouse events within the circle;
      * this requires this custom implementation. */
     bool m_isMouseEventActive = false;
+    /** @brief The image of @ref m_chromaHueImage that has been
+     * painted most recently.
+     *
+     * @sa @ref m_lastGamutImageCircle
+     * @sa @ref paintInterimGamut() */
+    QImage m_lastGamutImage;
+    /** @brief The bounding rectangle of the gray circle within
+     * @ref m_lastGamutImage, measured in physical pixels. */
+    QRectF m_lastGamutImageCircle;
+    /** @brief If @ref m_pendingColor holds a color that still waits
+     * for gamut resolution. */
+    bool m_hasPendingColor = false;
+    /** @brief Unresolved color at the raw mouse position.
+     *
+     * Mouse press and move events store the color here and the handle is
+     * drawn immediately at this position. The search for the nearest
+     * in-gamut color is deferred to @ref resolvePendingColor(), so the
+     * perceived latency does not include the gamut search. Only
+     * meaningful while @ref m_hasPendingColor is <tt>true</tt>. */
+    LchDouble m_pendingColor;
     /** @brief Pointer to @ref RgbColorSpace object used to describe the
      * color space. */
     QSharedPointer<PerceptualColor::RgbColorSpace> m_rgbColorSpace;
@@ -92,12 +133,18 @@ public:
     ColorWheelImage m_wheelImage;
 
     // Member functions
+    LchDouble colorAtHandle() const;
     int diagramBorder() const;
     QPointF diagramCenter() const;
     qreal diagramOffset() const;
     cmsCIELab fromWidgetPixelPositionToLab(const QPoint position) const;
+    QPainterPath gamutOutline();
     bool isWidgetPixelPositionWithinMouseSensibleCircle(const QPoint widgetCoordinates) const;
+    void paintInterimGamut(QPainter *painter);
+    void resolvePendingColor();
     void setColorFromWidgetPixelPosition(const QPoint position);
+    void setPendingColorFromWidgetPixelPosition(const QPoint position);
+    QPointF widgetCoordinatesFromColor(const LchDouble &color) const;
     QPointF widgetCoordinatesFromCurrentColor() const;
 
 private:
@@ -31,10 +31,15 @@
 // First the interface, which forces the header to be self-contained.
 #include "chromahueimage.h"
 
+#include "colorvisiondeficiencysimulation.h"
+#include "gamutcache.h"
 #include "helper.h"
+#include "labbuffer.h"
 #include "lchvalues.h"
+#include "rgbdouble.h"
 
 #include <QPainter>
+#include <QVector>
 #include <QtMath>
 
 namespace PerceptualColor
@@ -133,8 +138,9 @@ void ChromaHueImage::setLightness(const qreal newLightness)
     const qreal temp = qBound(static_cast<qreal>(0), newLightness, static_cast<qreal>(100));
     if (m_lightness != temp) {
         m_lightness = temp;
-        // Free the memory used by the old image.
+        // Free the memory used by the old image and its variants.
         m_image = QImage();
+        m_variants.clear();
     }
 }
 
@@ -147,9 +153,73 @@ void ChromaHueImage::setChromaRange(const qreal newChromaRange)
     const qreal temp = qBound(static_cast<qreal>(0), static_cast<qreal>(newChromaRange), static_cast<qreal>(LchValues::humanMaximumChroma));
     if (m_chromaRange != temp) {
         m_chromaRange = temp;
-        // Free the memory used by the old image.
+        // Free the memory used by the old image and its variants.
+        m_image = QImage();
+        m_variants.clear();
+    }
+}
+
+/** @brief Setter for the simulated color vision deficiency.
+ *
+ * If not @ref AbstractDiagram::ColorVisionDeficiency::none, the image is
+ * rendered as it is perceived by people with the given color vision
+ * deficiency.
+ *
+ * @param newColorVisionDeficiency The new color vision deficiency. */
+void ChromaHueImage::setColorVisionDeficiency(const AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency)
+{
+    if (m_colorVisionDeficiency != newColorVisionDeficiency) {
+        m_colorVisionDeficiency = newColorVisionDeficiency;
+        // Free the memory used by the old image and its variants.
         m_image = QImage();
+        m_variants.clear();
+    }
+}
+
+/** @brief Setter for the display color space.
+ *
+ * The gamut decisions are always made in the color space that was
+ * passed to the constructor. But if a display color space is set, the
+ * RGB values that are written into the image are calculated for the
+ * display color space, using a single fused transform from Lab.
+ * See @ref DisplayTransform for details.
+ *
+ * @param newDisplayColorSpace The new display color space. If
+ * <tt>nullptr</tt> (default), the RGB values of the color space that
+ * was passed to the constructor are written into the image. */
+void ChromaHueImage::setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace)
+{
+    if (m_displayColorSpace != newDisplayColorSpace) {
+        m_displayColorSpace = newDisplayColorSpace;
+        m_displayTransform = DisplayTransform::create(m_rgbColorSpace, m_displayColorSpace);
+        // Free the memory used by the old image and its variants.
+        m_image = QImage();
+        m_variants.clear();
+    }
+}
+
+/** @brief If images with other geometries are available.
+ *
+ * @returns <tt>true</tt> if at least one image has been rendered with
+ * the current properties apart from the geometry (image size, border,
+ * device pixel ratio), and is still in the cache. <tt>false</tt>
+ * otherwise. */
+bool ChromaHueImage::hasVariants() const
+{
+    return m_variants.size() > 0;
+}
+
+/** @brief If @ref getImage() can deliver the image without rendering.
+ *
+ * @returns <tt>true</tt> if the image for the current properties is
+ * available in the cache, <tt>false</tt> if @ref getImage() would have
+ * to render it first. */
+bool ChromaHueImage::isImageAvailable()
+{
+    if (m_image.isNull()) {
+        m_image = m_variants.value(variantKey());
     }
+    return !m_image.isNull();
 }
 
 /** @brief Delivers an image of the chroma hue plane.
@@ -169,6 +239,12 @@ QImage ChromaHueImage::getImage()
         return m_image;
     }
 
+    // If there is a variant for the current geometry, use it.
+    m_image = m_variants.value(variantKey());
+    if (!m_image.isNull()) {
+        return m_image;
+    }
+
     // If no image is in cache, create a new one (in the cache) with
     // correct image size.
     m_image = QImage(QSize(m_imageSizePhysical, m_imageSizePhysical), QImage::Format_ARGB32_Premultiplied);
@@ -183,6 +259,7 @@ QImage ChromaHueImage::getImage()
         m_image.fill(Qt::transparent);
         // Set the correct scaling information for the image and return
         m_image.setDevicePixelRatio(m_devicePixelRatioF);
+        m_variants.insert(variantKey(), m_image, QSizeF(m_imageSizePhysical, m_imageSizePhysical) / m_devicePixelRatioF);
         return m_image;
     }
     // If we continue, the circle will at least be visible.
@@ -195,36 +272,75 @@ QImage ChromaHueImage::getImage()
     lab.L = m_lightness;
     int x;
     int y;
-    QColor tempColor;
     const qreal scaleFactor = static_cast<qreal>(2 * m_chromaRange)
         // The following line will never be 0 because we have have
         // tested above that circleRadius is > 0, so this line will
         // we > 0 also.
         / (m_imageSizePhysical - 2 * m_borderPhysical);
+    const qreal maximumRadiusSquare = qPow(m_chromaRange + overlap, 2);
+    // Buffers for a single row. The pixels of a row that are within
+    // the circle are converted with a single batch call.
+    GamutCache &gamutCache = m_rgbColorSpace->gamutCache();
+    // Calculate the needed part of the cache in parallel.
+    gamutCache.populate(m_lightness, m_lightness, m_chromaRange + overlap);
+    LabBuffer rowLab(m_imageSizePhysical);
+    QVector<QRgb> rowRgb(m_imageSizePhysical);
+    QVector<RgbDouble> rowWorkingRgb(m_imageSizePhysical);
+    for (x = 0; x < m_imageSizePhysical; ++x) {
+        rowLab.l()[x] = m_lightness;
+    }
 
     // Paint the gamut.
-    // The pixel at position QPoint(x, y) is the square with the top-left
-    // edge at coordinate point QPoint(x, y) and the botton-right edge at
-    // coordinate point QPoint(x+1, y+1). This pixel is supposed to have
-    // the color from coordinate point QPoint(x+0.5, y+0.5), which is
+    // The pixel at position QPoint(x, y) is the square with the top-left
+    // edge at coordinate point QPoint(x, y) and the botton-right edge at
+    // coordinate point QPoint(x+1, y+1). This pixel is supposed to have
+    // the color from coordinate point QPoint(x+0.5, y+0.5), which is
     // the middle of this pixel. Therefore, with an offset of 0.5 we can
     // convert from the pixel position to the point in the middle of the pixel.
     constexpr qreal pixelOffset = 0.5;
-    // TODO Could this be further optimized? For example not go from zero
-    // up to m_imageSizePhysical, but exclude the border (and add the
-    // tolerance)? Tought anyway the color transform (which is the heavy
-    // work) is only done when within a given diameter, reducing loop runs
-    // itself might also increase performance at least a little bit…
     for (y = 0; y < m_imageSizePhysical; ++y) {
         lab.b = m_chromaRange - (y + pixelOffset - m_borderPhysical) * scaleFactor;
+        // Collect the pixels of this row that are within the circle.
+        // The circle is convex, so these pixels are contiguous.
+        int firstX = -1;
+        int rowCount = 0;
         for (x = 0; x < m_imageSizePhysical; ++x) {
             lab.a = (x + pixelOffset - m_borderPhysical) * scaleFactor - m_chromaRange;
-            if ((qPow(lab.a, 2) + qPow(lab.b, 2)) <= (qPow(m_chromaRange + overlap, 2))) {
-                tempColor = m_rgbColorSpace->toQColorRgbUnbound(lab);
-                if (tempColor.isValid()) {
-                    // The pixel is within the gamut!
-                    m_image.setPixelColor(x, y, tempColor);
+            if ((qPow(lab.a, 2) + qPow(lab.b, 2)) <= maximumRadiusSquare) {
+                if (firstX < 0) {
+                    firstX = x;
                 }
+                rowLab.a()[rowCount] = lab.a;
+                rowLab.b()[rowCount] = lab.b;
+                ++rowCount;
+            }
+        }
+        if (rowCount == 0) {
+            continue;
+        }
+        // Resample from the gamut cache of the color space. Only colors
+        // close to the gamut boundary need LittleCMS.
+        gamutCache.toQRgbUnbound(rowLab.view().slice(0, rowCount), rowRgb.data());
+        if (m_colorVisionDeficiency != AbstractDiagram::ColorVisionDeficiency::none) {
+            // The simulation works on the RGB values of the batch
+            // conversion above and includes the conversion to the
+            // display color space.
+            ColorVisionDeficiencySimulation::simulateRow(m_colorVisionDeficiency,
+                                                         *m_rgbColorSpace,
+                                                         m_displayTransform.data(),
+                                                         rowRgb.data(),
+                                                         rowWorkingRgb.data(),
+                                                         rowCount);
+        } else if (!m_displayTransform.isNull()) {
+            // The gamut decision has been made in the working color space.
+            // The values that are written into the image are calculated
+            // directly from the Lab values.
+            m_displayTransform->toDisplayQRgb(rowLab.view().slice(0, rowCount), rowRgb.data());
+        }
+        for (int i = 0; i < rowCount; ++i) {
+            if (rowRgb.at(i) != 0) {
+                // The pixel is within the gamut!
+                m_image.setPixelColor(firstX + i, y, QColor(rowRgb.at(i)));
             }
         }
     }
@@ -255,7 +371,16 @@ QImage ChromaHueImage::getImage()
 
     // Set the correct scaling information for the image and return
     m_image.setDevicePixelRatio(m_devicePixelRatioF);
+    m_variants.insert(variantKey(), m_image, QSizeF(m_imageSizePhysical, m_imageSizePhysical) / m_devicePixelRatioF);
     return m_image;
 }
 
+/** @brief The key of the current geometry within @ref m_variants.
+ *
+ * @returns The key of the current geometry within @ref m_variants. */
+ChromaHueImage::VariantKey ChromaHueImage::variantKey() const
+{
+    return VariantKey(m_imageSizePhysical, m_borderPhysical, m_devicePixelRatioF);
+}
+
 } // namespace PerceptualColor
@@ -33,6 +33,11 @@
 #include <QImage>
 #include <QSharedPointer>
 
+#include <tuple>
+
+#include "PerceptualColor/abstractdiagram.h"
+#include "displaytransform.h"
+#include "imagevariantcache.h"
 #include "rgbcolorspace.h"
 
 namespace PerceptualColor
@@ -71,6 +76,12 @@ namespace PerceptualColor
  *
  * This class supports HiDPI via its @ref setDevicePixelRatioF function.
  *
+ * Images that have been rendered for a different geometry (image size,
+ * border, device pixel ratio) are retained in a small variant cache.
+ * So when a window is moved back and forth between monitors with different
+ * device pixel ratios, the image is rendered only once for each monitor.
+ * Changing the lightness or the chroma range discards all variants.
+ *
  * @note Resetting a property to its very same value does not trigger an
  * image calculation. So, if the border is 5, and you call @ref setBorder
  * <tt>(5)</tt>, than this will not trigger an image calculation, but the
@@ -89,9 +100,13 @@ class ChromaHueImage final
 public:
     explicit ChromaHueImage(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace);
     QImage getImage();
+    bool hasVariants() const;
+    bool isImageAvailable();
     void setBorder(const qreal newBorder);
     void setChromaRange(const qreal newChromaRange);
+    void setColorVisionDeficiency(const AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency);
     void setDevicePixelRatioF(const qreal newDevicePixelRatioF);
+    void setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace);
     void setImageSize(const int newImageSize);
     void setLightness(const qreal newLightness);
 
@@ -101,6 +116,12 @@ private:
     /** @internal @brief Only for unit tests. */
     friend class TestChromaHueImage;
 
+    /** @brief Key for @ref m_variants.
+     *
+     * Image size, border and device pixel ratio. */
+    using VariantKey = std::tuple<int, qreal, qreal>;
+    VariantKey variantKey() const;
+
     /** @brief Internal store for the border size, measured in physical pixels.
      *
      * @sa @ref setBorder() */
@@ -110,6 +131,20 @@ private:
      *
      * @sa @ref setDevicePixelRatioF() */
     qreal m_devicePixelRatioF = 1;
+    /** @brief Internal store for the simulated color vision deficiency.
+     *
+     * @sa @ref setColorVisionDeficiency() */
+    AbstractDiagram::ColorVisionDeficiency m_colorVisionDeficiency = AbstractDiagram::ColorVisionDeficiency::none;
+    /** @brief Internal store for the display color space.
+     *
+     * @sa @ref setDisplayColorSpace() */
+    QSharedPointer<PerceptualColor::RgbColorSpace> m_displayColorSpace;
+    /** @brief Transform to @ref m_displayColorSpace.
+     *
+     * <tt>nullptr</tt> if no transform is necessary.
+     *
+     * @sa @ref setDisplayColorSpace() */
+    QSharedPointer<DisplayTransform> m_displayTransform;
     /** @brief Internal storage of the image (cache).
      *
      * - If <tt>m_image.isNull()</tt> than either no cache is available
@@ -140,6 +175,9 @@ private:
      *
      * @sa @ref setChromaRange() */
     qreal m_chromaRange = 0;
+    /** @brief Images that have previously been rendered with the
+     * current lightness and chroma range, but another geometry. */
+    ImageVariantCache<VariantKey> m_variants;
     /** @brief Pointer to @ref RgbColorSpace object */
     QSharedPointer<PerceptualColor::RgbColorSpace> m_rgbColorSpace;
 };
@@ -34,11 +34,13 @@
 #include "chromalightnessdiagram_p.h"
 
 #include "helper.h"
+#include "lchbuffer.h"
 #include "lchvalues.h"
 
 #include <QApplication>
 #include <QDebug>
 #include <QPainter>
+#include <QTimer>
 #include <QtMath>
 
 namespace PerceptualColor
@@ -64,6 +66,12 @@ ChromaLightnessDiagram::ChromaLightnessDiagram(const QSharedPointer<PerceptualCo
     d_pointer->m_chromaLightnessImage.setImageSize(
         // Update the image size will free memory of the cache inmediatly.
         d_pointer->calculateImageSizePhysical());
+
+    // After geometry changes, the gamut is rendered deferred.
+    connect(&d_pointer->m_fillTimer, &QTimer::timeout, this, [this]() {
+        d_pointer->m_chromaLightnessImage.getImage();
+        update();
+    });
 }
 
 /** @brief Default destructor */
@@ -80,6 +88,8 @@ ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::ChromaLightnessDiagramPri
     : m_chromaLightnessImage(colorSpace)
     , q_pointer(backLink)
 {
+    m_fillTimer.setSingleShot(true);
+    m_fillTimer.setInterval(fillDelay);
 }
 
 /** Updates @ref currentColor corresponding to the given widget pixel position.
@@ -102,6 +112,80 @@ void ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::setCurrentColorFromW
         m_rgbColorSpace->nearestInGamutColorByAdjustingChromaLightness(color));
 }
 
+/** @brief Moves the handle to the given widget pixel position without
+ * resolving the gamut yet.
+ *
+ * The handle is drawn at the raw position on the next paint event. The
+ * nearest in-gamut color is searched in the next event loop iteration by
+ * @ref resolvePendingColor(). Several calls within the same event loop
+ * iteration lead to a single gamut resolution for the latest position.
+ *
+ * @param widgetPixelPosition The position of a pixel within the widget’s
+ * coordinate system. This does not necessarily need to intersect with the
+ * actually displayed diagram or the gamut. It might even be negative or
+ * outside the widget.
+ *
+ * @post @ref currentColor is not changed yet. */
+void ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::setPendingColorFromWidgetPixelPosition(const QPoint widgetPixelPosition)
+{
+    const bool isResolutionScheduled = m_hasPendingColor;
+    m_pendingColor = fromWidgetPixelPositionToColor(widgetPixelPosition);
+    m_hasPendingColor = true;
+    if (!isResolutionScheduled) {
+        QTimer::singleShot(0, q_pointer, [this]() {
+            resolvePendingColor();
+        });
+    }
+    q_pointer->scheduleRepaint();
+}
+
+/** @brief Sets @ref currentColor to the nearest in-gamut color of
+ * @ref m_pendingColor.
+ *
+ * Does nothing if there is no pending color. While
+ * @ref m_isMouseEventActive is <tt>true</tt>, only a fast approximation
+ * of the nearest in-gamut color is used.
+ *
+ * @post The handle snaps to the resolved color. */
+void ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::resolvePendingColor()
+{
+    if (!m_hasPendingColor) {
+        return;
+    }
+    m_hasPendingColor = false;
+    if (m_isMouseEventActive) {
+        // While a mouse button is held, a fast approximation is enough. It
+        // uses the cusp table and a coarse precision. The mouse release
+        // event does the exact search.
+        q_pointer->setCurrentColor(
+            // Search for a nearby color without changing the hue:
+            m_rgbColorSpace->nearestInGamutColorByCuspMapping(m_pendingColor, interactiveGamutPrecision));
+    } else {
+        q_pointer->setCurrentColor(
+            // Search for the nearest color without changing the hue:
+            m_rgbColorSpace->nearestInGamutColorByAdjustingChromaLightness(m_pendingColor));
+    }
+    // Snap the handle even if the resolved color equals the old one.
+    q_pointer->scheduleRepaint();
+}
+
+/** @brief The color at which the handle is drawn.
+ *
+ * @returns @ref m_pendingColor (limited to the displayed diagram) if
+ * there is a color that waits for gamut resolution, @ref m_currentColor
+ * otherwise. */
+LchDouble ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::colorAtHandle() const
+{
+    if (!m_hasPendingColor) {
+        return m_currentColor;
+    }
+    LchDouble result = m_pendingColor;
+    // Keep the provisional handle within the diagram:
+    result.l = qBound<qreal>(0, result.l, 100);
+    result.c = qMax<qreal>(0, result.c);
+    return result;
+}
+
 /** @brief The border between the widget outer top, right and bottom
  * border and the diagram itself.
  *
@@ -160,6 +244,92 @@ QSize ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::calculateImageSizeP
     return q_pointer->physicalPixelSize() - borderSizePhysical;
 }
 
+/** @brief The outline of the gamut at the current hue.
+ *
+ * The outline is calculated from the gamut boundary of the color
+ * space, see @ref RgbColorSpace::maximumInGamutChroma(). It is cached
+ * for the hue of @ref m_currentColor.
+ *
+ * @returns The outline of the gamut. The coordinates are chroma (x)
+ * and lightness (y) values. */
+QPainterPath ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::gamutOutline()
+{
+    const qreal hue = m_currentColor.h;
+    if (hue == m_gamutOutlineHue) {
+        return m_gamutOutline;
+    }
+
+    const QPair<qreal, qreal> grayRange = m_rgbColorSpace->lightnessRange(hue, 0);
+    QPainterPath outline;
+    if (!qIsNaN(grayRange.first)) {
+        // About one point per lightness unit, which is the resolution
+        // of the gamut boundary.
+        const int lightnessCount = qMax(2, qCeil(grayRange.second - grayRange.first) + 1);
+        LchBuffer boundary(lightnessCount);
+        for (int i = 0; i < lightnessCount; ++i) {
+            boundary.l()[i] = grayRange.first //
+                + (grayRange.second - grayRange.first) * i / (lightnessCount - 1);
+            boundary.h()[i] = hue;
+        }
+        m_rgbColorSpace->maximumInGamutChroma(boundary.view());
+        outline.moveTo(0, grayRange.first);
+        for (int i = 0; i < lightnessCount; ++i) {
+            outline.lineTo(boundary.c()[i], boundary.l()[i]);
+        }
+        outline.lineTo(0, grayRange.second);
+        outline.closeSubpath();
+    }
+
+    m_gamutOutline = outline;
+    m_gamutOutlineHue = hue;
+    return m_gamutOutline;
+}
+
+/** @brief Paints a provisional gamut for the current geometry.
+ *
+ * Used while @ref m_chromaLightnessImage has no image for the current
+ * geometry yet. The fill is @ref m_lastGamutImage, scaled to the
+ * current geometry, which is fast but might be blurry. The gamut
+ * boundary, however, is painted as vector shape on top, so it stays
+ * sharp at any size and device pixel ratio.
+ *
+ * @param painter The painter. Its coordinates are physical pixels.
+ * Nothing else must have been painted on its device yet. */
+void ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::paintInterimGamut(QPainter *painter)
+{
+    const QSize imageSize = calculateImageSizePhysical();
+    if (imageSize.isEmpty()) {
+        return;
+    }
+    const QRectF diagram(QPointF(leftBorderPhysical(), defaultBorderPhysical()), imageSize);
+    painter->save();
+    painter->setClipRect(diagram);
+
+    // The fill. The diagram uses the same scale on both axis, so the
+    // scale is given by the height.
+    const qreal scaleFactor = static_cast<qreal>(imageSize.height()) / m_lastGamutImage.height();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter->drawImage(QRectF(diagram.topLeft(), //
+                              QSizeF(m_lastGamutImage.width() * scaleFactor, imageSize.height())),
+                       m_lastGamutImage);
+
+    // Everything outside the gamut gets the background color. This
+    // paints also the gamut boundary.
+    QTransform transform;
+    transform.translate(diagram.left(), diagram.bottom());
+    transform.scale(imageSize.height() / 100.0, -imageSize.height() / 100.0);
+    QPainterPath background;
+    background.setFillRule(Qt::OddEvenFill);
+    background.addRect(diagram);
+    background.addPath(transform.map(gamutOutline()));
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(m_rgbColorSpace->toQColorRgbBound(LchValues::neutralGray()));
+    painter->drawPath(background);
+
+    painter->restore();
+}
+
 /** @brief Converts widget pixel positions to color.
  *
  * @param widgetPixelPosition The position of a pixel of the widget
@@ -216,7 +386,7 @@ LchDouble ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::fromWidgetPixel
 void ChromaLightnessDiagram::mousePressEvent(QMouseEvent *event)
 {
     d_pointer->m_isMouseEventActive = true;
-    d_pointer->setCurrentColorFromWidgetPixelPosition(event->pos());
+    d_pointer->setPendingColorFromWidgetPixelPosition(event->pos());
     if (d_pointer->isWidgetPixelPositionInGamut(event->pos())) {
         setCursor(Qt::BlankCursor);
     } else {
@@ -232,10 +402,14 @@ void ChromaLightnessDiagram::mousePressEvent(QMouseEvent *event)
  * is displaced there. If the mouse moves outside the <em>displayed</em>
  * gamut, the handle is displaced to a nearby in-gamut color.
  *
+ * The handle follows the mouse immediately. The gamut resolution and
+ * therefore the change of @ref currentColor happens in the next event
+ * loop iteration. See @ref ChromaLightnessDiagramPrivate::m_pendingColor.
+ *
  * @param event The corresponding mouse event */
 void ChromaLightnessDiagram::mouseMoveEvent(QMouseEvent *event)
 {
-    d_pointer->setCurrentColorFromWidgetPixelPosition(event->pos());
+    d_pointer->setPendingColorFromWidgetPixelPosition(event->pos());
     if (d_pointer->isWidgetPixelPositionInGamut(event->pos())) {
         setCursor(Qt::BlankCursor);
     } else {
@@ -255,7 +429,10 @@ void ChromaLightnessDiagram::mouseMoveEvent(QMouseEvent *event)
  * @param event The corresponding mouse event */
 void ChromaLightnessDiagram::mouseReleaseEvent(QMouseEvent *event)
 {
+    d_pointer->m_isMouseEventActive = false;
     d_pointer->setCurrentColorFromWidgetPixelPosition(event->pos());
+    // Snap the handle even if the resolved color equals the old one.
+    scheduleRepaint();
     unsetCursor();
 }
 
@@ -292,12 +469,28 @@ void ChromaLightnessDiagram::paintEvent(QPaintEvent *event)
 
     // Paint the diagram itself as available in the cache.
     painter.setRenderHint(QPainter::Antialiasing, false);
-    painter.drawImage(
-        // Operating in physical pixels:
-        d_pointer->leftBorderPhysical(),             // x position (top-left)
-        d_pointer->defaultBorderPhysical(),          // y position (top-left)
-        d_pointer->m_chromaLightnessImage.getImage() // image
-    );
+    d_pointer->m_chromaLightnessImage.setColorVisionDeficiency(colorVisionDeficiency());
+    d_pointer->m_chromaLightnessImage.setDevicePixelRatioF(devicePixelRatioF());
+    d_pointer->m_chromaLightnessImage.setDisplayColorSpace(displayColorSpace());
+    const bool isOnlyGeometryChanged = !d_pointer->m_lastGamutImage.isNull() //
+        && !d_pointer->m_chromaLightnessImage.isImageAvailable() //
+        && d_pointer->m_chromaLightnessImage.hasVariants();
+    if (isOnlyGeometryChanged) {
+        // Rendering the gamut for the new geometry is expensive. During
+        // resizing or while the device pixel ratio changes, this would
+        // happen many times in a row. Therefore, paint a scaled version
+        // of the most recent image now, and render deferred.
+        d_pointer->paintInterimGamut(&painter);
+        d_pointer->m_fillTimer.start();
+    } else {
+        d_pointer->m_lastGamutImage = d_pointer->m_chromaLightnessImage.getImage();
+        painter.drawImage(
+            // Operating in physical pixels:
+            d_pointer->leftBorderPhysical(),   // x position (top-left)
+            d_pointer->defaultBorderPhysical(), // y position (top-left)
+            d_pointer->m_lastGamutImage         // image
+        );
+    }
 
     // Paint a focus indicator.
     //
@@ -351,19 +544,21 @@ void ChromaLightnessDiagram::paintEvent(QPaintEvent *event)
         painter.drawLine(pointOne, pointTwo);
     }
 
-    // Paint the handle on-the-fly.
+    // Paint the handle on-the-fly. While a mouse movement waits for gamut
+    // resolution, the handle is drawn at the raw mouse position.
+    const LchDouble colorAtHandle = d_pointer->colorAtHandle();
     const int diagramHeight = d_pointer->calculateImageSizePhysical().height();
     QPointF colorCoordinatePoint = QPointF(
         // x:
-        d_pointer->m_currentColor.c * diagramHeight / 100.0,
+        colorAtHandle.c * diagramHeight / 100.0,
         // y:
-        d_pointer->m_currentColor.l * diagramHeight / 100.0 * (-1) + diagramHeight);
+        colorAtHandle.l * diagramHeight / 100.0 * (-1) + diagramHeight);
     colorCoordinatePoint += QPointF(d_pointer->leftBorderPhysical(),   // horizontal offset
                                     d_pointer->defaultBorderPhysical() // vertical offset
     );
     pen = QPen();
     pen.setWidthF(handleOutlineThickness() * devicePixelRatioF());
-    pen.setColor(handleColorFromBackgroundLightness(d_pointer->m_currentColor.l));
+    pen.setColor(handleColorFromBackgroundLightness(colorAtHandle.l));
     painter.setPen(pen);
     painter.setRenderHint(QPainter::Antialiasing, true);
     painter.drawEllipse(colorCoordinatePoint,                 // center
@@ -498,6 +693,10 @@ bool ChromaLightnessDiagram::ChromaLightnessDiagramPrivate::isWidgetPixelPositio
  * will change. Isn’t that confusing? */
 void ChromaLightnessDiagram::setCurrentColor(const PerceptualColor::LchDouble &newCurrentColor)
 {
+    // An explicitly set color takes precedence over a color that is still
+    // waiting for gamut resolution.
+    d_pointer->m_hasPendingColor = false;
+
     if (newCurrentColor.hasSameCoordinates(d_pointer->m_currentColor)) {
         return;
     }
@@ -508,7 +707,7 @@ void ChromaLightnessDiagram::setCurrentColor(const PerceptualColor::LchDouble &n
         // Update the diagram (only if the hue has changed):
         d_pointer->m_chromaLightnessImage.setHue(d_pointer->m_currentColor.h);
     }
-    update(); // Schedule a paint event
+    scheduleRepaint(); // Schedule a paint event
     Q_EMIT currentColorChanged(newCurrentColor);
 }
 
@@ -36,6 +36,11 @@
 #include "chromalightnessimage.h"
 #include "constpropagatingrawpointer.h"
 
+#include <QPainter>
+#include <QPainterPath>
+#include <QTimer>
+#include <QtNumeric>
+
 namespace PerceptualColor
 {
 /** @internal
@@ -57,6 +62,22 @@ public:
     ChromaLightnessImage m_chromaLightnessImage;
     /** @brief Internal storage of the @ref currentColor property */
     LchDouble m_currentColor;
+    /** @brief Defers the rendering of the gamut after geometry changes.
+     *
+     * Single-shot, restarted by each paint event that uses
+     * @ref paintInterimGamut(). When it times out,
+     * @ref m_chromaLightnessImage is rendered for the current geometry.
+     *
+     * @sa @ref fillDelay */
+    QTimer m_fillTimer;
+    /** @brief Delay of @ref m_fillTimer, measured in milliseconds. */
+    static constexpr int fillDelay = 100;
+    /** @brief Cache for @ref gamutOutline() */
+    QPainterPath m_gamutOutline;
+    /** @brief The hue of @ref m_gamutOutline.
+     *
+     * <tt>NaN</tt> if there is no cache yet. */
+    qreal m_gamutOutlineHue = qQNaN();
     /** @brief Holds if currently a mouse event is active or not.
      *
      * Default value is <tt>false</tt>.
@@ -68,21 +89,40 @@ public:
      *   <tt>false</tt>. Further mouse movements will not move the handle
      *   anymore.
      *
-     * This is done because Qt’s default mouse tracking reacts on all clicks
-     * within the whole widget. However, <em>this</em> widget is meant as a
-     * circular widget, only reacting on mouse events within the circle;
-     * this requires this custom implementation. */
-    bool m_isMouseEventActive = false; // TODO Remove me!
+     * While active, the gamut resolution uses a fast approximation; see
+     * @ref resolvePendingColor(). */
+    bool m_isMouseEventActive = false;
+    /** @brief The image of @ref m_chromaLightnessImage that has been
+     * painted most recently.
+     *
+     * @sa @ref paintInterimGamut() */
+    QImage m_lastGamutImage;
+    /** @brief If @ref m_pendingColor holds a color that still waits
+     * for gamut resolution. */
+    bool m_hasPendingColor = false;
+    /** @brief Unresolved color at the raw mouse position.
+     *
+     * Mouse press and move events store the color here and the handle is
+     * drawn immediately at this position. The search for the nearest
+     * in-gamut color, which is expensive in this diagram, is deferred
+     * to @ref resolvePendingColor(). Only meaningful while
+     * @ref m_hasPendingColor is <tt>true</tt>. */
+    LchDouble m_pendingColor;
     /** @brief Pointer to RgbColorSpace() object */
     QSharedPointer<RgbColorSpace> m_rgbColorSpace;
 
     // Member functions
     QSize calculateImageSizePhysical() const;
+    LchDouble colorAtHandle() const;
     int defaultBorderPhysical() const;
     LchDouble fromWidgetPixelPositionToColor(const QPoint widgetPixelPosition) const;
+    QPainterPath gamutOutline();
     bool isWidgetPixelPositionInGamut(const QPoint widgetPixelPosition) const;
     int leftBorderPhysical() const;
+    void paintInterimGamut(QPainter *painter);
+    void resolvePendingColor();
     void setCurrentColorFromWidgetPixelPosition(const QPoint widgetPixelPosition);
+    void setPendingColorFromWidgetPixelPosition(const QPoint widgetPixelPosition);
 
 private:
     Q_DISABLE_COPY(ChromaLightnessDiagramPrivate)
@@ -31,10 +31,18 @@
 // First the interface, which forces the header to be self-contained.
 #include "chromalightnessimage.h"
 
+#include "colorvisiondeficiencysimulation.h"
+#include "gamutcache.h"
+#include "labbuffer.h"
+#include "lchbuffer.h"
 #include "lchvalues.h"
 #include "polarpointf.h"
+#include "rgbdouble.h"
 
 #include <QPainter>
+#include <QVector>
+
+#include <algorithm>
 
 namespace PerceptualColor
 {
@@ -57,8 +65,26 @@ void ChromaLightnessImage::setBackgroundColor(const QColor newBackgroundColor)
 {
     if (m_backgroundColor != newBackgroundColor) {
         m_backgroundColor = newBackgroundColor;
-        // Free the memory used by the old image.
+        // Free the memory used by the old image and its variants.
+        m_image = QImage();
+        m_variants.clear();
+    }
+}
+
+/** @brief Setter for the gamut cache property.
+ *
+ * By default, the image is resampled from
+ * @ref RgbColorSpace::gamutCache(), which is fast, but approximates the
+ * gamut boundary. When disabled, each pixel is calculated exactly.
+ *
+ * @param enabled If the gamut cache is used. */
+void ChromaLightnessImage::setGamutCacheEnabled(const bool enabled)
+{
+    if (m_isGamutCacheEnabled != enabled) {
+        m_isGamutCacheEnabled = enabled;
+        // Free the memory used by the old image and its variants.
         m_image = QImage();
+        m_variants.clear();
     }
 }
 
@@ -80,6 +106,20 @@ void ChromaLightnessImage::setImageSize(const QSize newImageSize)
     }
 }
 
+/** @brief Setter for the device pixel ratio property.
+ *
+ * The image is always rendered in physical pixels (see
+ * @ref setImageSize()) and does not carry a device pixel ratio. This
+ * value is only used to calculate the widget size of the variants: Only
+ * variants for the current widget size are retained.
+ *
+ * @param newDevicePixelRatioF The new device pixel ratio as floating
+ * point data type. */
+void ChromaLightnessImage::setDevicePixelRatioF(const qreal newDevicePixelRatioF)
+{
+    m_devicePixelRatioF = qMax<qreal>(1, newDevicePixelRatioF);
+}
+
 /** @brief Setter for the hue property.
  *
  * @param newHue The new hue. Valid range is <tt>[0, 360[</tt>.
@@ -90,11 +130,75 @@ void ChromaLightnessImage::setHue(const qreal newHue)
     const qreal temp = PolarPointF::normalizedAngleDegree(newHue);
     if (m_hue != temp) {
         m_hue = temp;
-        // Free the memory used by the old image.
+        // Free the memory used by the old image and its variants.
+        m_image = QImage();
+        m_variants.clear();
+    }
+}
+
+/** @brief Setter for the simulated color vision deficiency.
+ *
+ * If not @ref AbstractDiagram::ColorVisionDeficiency::none, the image is
+ * rendered as it is perceived by people with the given color vision
+ * deficiency.
+ *
+ * @param newColorVisionDeficiency The new color vision deficiency. */
+void ChromaLightnessImage::setColorVisionDeficiency(const AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency)
+{
+    if (m_colorVisionDeficiency != newColorVisionDeficiency) {
+        m_colorVisionDeficiency = newColorVisionDeficiency;
+        // Free the memory used by the old image and its variants.
+        m_image = QImage();
+        m_variants.clear();
+    }
+}
+
+/** @brief Setter for the display color space.
+ *
+ * The gamut decisions are always made in the color space that was
+ * passed to the constructor. But if a display color space is set, the
+ * RGB values that are written into the image are calculated for the
+ * display color space, using a single fused transform from Lab.
+ * See @ref DisplayTransform for details.
+ *
+ * @param newDisplayColorSpace The new display color space. If
+ * <tt>nullptr</tt> (default), the RGB values of the color space that
+ * was passed to the constructor are written into the image. */
+void ChromaLightnessImage::setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace)
+{
+    if (m_displayColorSpace != newDisplayColorSpace) {
+        m_displayColorSpace = newDisplayColorSpace;
+        m_displayTransform = DisplayTransform::create(m_rgbColorSpace, m_displayColorSpace);
+        // Free the memory used by the old image and its variants.
         m_image = QImage();
+        m_variants.clear();
     }
 }
 
+/** @brief If images with other geometries are available.
+ *
+ * @returns <tt>true</tt> if at least one image has been rendered with
+ * the current properties apart from the image size, and is still
+ * in the cache. <tt>false</tt>
+ * otherwise. */
+bool ChromaLightnessImage::hasVariants() const
+{
+    return m_variants.size() > 0;
+}
+
+/** @brief If @ref getImage() can deliver the image without rendering.
+ *
+ * @returns <tt>true</tt> if the image for the current properties is
+ * available in the cache, <tt>false</tt> if @ref getImage() would have
+ * to render it first. */
+bool ChromaLightnessImage::isImageAvailable()
+{
+    if (m_image.isNull()) {
+        m_image = m_variants.value(m_imageSizePhysical);
+    }
+    return !m_image.isNull();
+}
+
 /** @brief Delivers an image of a chroma-lightness diagram.
  *
  * @returns A chroma-lightness diagram. For the y axis, its height covers
@@ -121,6 +225,12 @@ QImage ChromaLightnessImage::getImage()
         return m_image;
     }
 
+    // If there is a variant for the current image size, use it.
+    m_image = m_variants.value(m_imageSizePhysical);
+    if (!m_image.isNull()) {
+        return m_image;
+    }
+
     // If no image is in cache, create a new one (in the cache) with
     // correct image size.
     m_image = QImage(m_imageSizePhysical, QImage::Format_ARGB32_Premultiplied);
@@ -132,8 +242,6 @@ QImage ChromaLightnessImage::getImage()
     }
 
     // Initialization
-    LchDouble LCh;
-    QColor rgbColor;
     int x;
     int y;
     const int imageHeight = m_imageSizePhysical.height();
@@ -147,17 +255,53 @@ QImage ChromaLightnessImage::getImage()
     }
 
     // Paint the gamut.
-    LCh.h = PolarPointF::normalizedAngleDegree(m_hue);
+    GamutCache *gamutCache = m_isGamutCacheEnabled //
+        ? &m_rgbColorSpace->gamutCache()
+        : nullptr;
+    // Buffers for a single row. Each row is converted with a single
+    // batch call. Chroma and hue are the same for all rows.
+    LchBuffer rowLch(imageWidth);
+    LabBuffer rowLab(imageWidth);
+    QVector<QRgb> rowRgb(imageWidth);
+    QVector<RgbDouble> rowWorkingRgb(imageWidth);
+    const double hue = PolarPointF::normalizedAngleDegree(m_hue);
+    for (x = 0; x < imageWidth; ++x) {
+        // Using the same scale as on the y axis. floating point
+        // division thanks to 100 which is a "cmsFloat64Number"
+        rowLch.c()[x] = (x + 0.5) * 100.0 / imageHeight;
+        rowLch.h()[x] = hue;
+    }
     for (y = 0; y < imageHeight; ++y) {
-        LCh.l = 100 - (y + 0.5) * 100.0 / imageHeight;
+        const double lightness = 100 - (y + 0.5) * 100.0 / imageHeight;
+        std::fill(rowLch.l(), rowLch.l() + imageWidth, lightness);
+        if (gamutCache == nullptr) {
+            m_rgbColorSpace->toQRgbUnboundFromLch(rowLch.view(), rowLab.view(), rowRgb.data());
+        } else {
+            gamutCache->toQRgbUnboundFromLch(rowLch.view(), rowRgb.data());
+            if (!m_displayTransform.isNull() && (m_colorVisionDeficiency == AbstractDiagram::ColorVisionDeficiency::none)) {
+                LabBuffer::fromLch(rowLch.view(), rowLab.view());
+            }
+        }
+        if (m_colorVisionDeficiency != AbstractDiagram::ColorVisionDeficiency::none) {
+            // The simulation works on the RGB values of the batch
+            // conversion above and includes the conversion to the
+            // display color space.
+            ColorVisionDeficiencySimulation::simulateRow(m_colorVisionDeficiency,
+                                                         *m_rgbColorSpace,
+                                                         m_displayTransform.data(),
+                                                         rowRgb.data(),
+                                                         rowWorkingRgb.data(),
+                                                         imageWidth);
+        } else if (!m_displayTransform.isNull()) {
+            // The gamut decision has been made in the working color space.
+            // The values that are written into the image are calculated
+            // directly from the Lab values.
+            m_displayTransform->toDisplayQRgb(rowLab.view(), rowRgb.data());
+        }
         for (x = 0; x < imageWidth; ++x) {
-            // Using the same scale as on the y axis. floating point
-            // division thanks to 100 which is a "cmsFloat64Number"
-            LCh.c = (x + 0.5) * 100.0 / imageHeight;
-            rgbColor = m_rgbColorSpace->toQColorRgbUnbound(LCh);
-            if (rgbColor.isValid()) {
-                // The pixel is within the gamut
-                m_image.setPixelColor(x, y, rgbColor);
+            // 0 means out-of-gamut: The background stays visible.
+            if (rowRgb.at(x) != 0) {
+                m_image.setPixelColor(x, y, QColor(rowRgb.at(x)));
                 // If color is out-of-gamut: We have chroma on the x axis and
                 // lightness on the y axis. We are drawing the pixmap line per
                 // line, so we go for given lightness from low chroma to high
@@ -172,6 +316,7 @@ QImage ChromaLightnessImage::getImage()
     }
 
     // Now return the cache.
+    m_variants.insert(m_imageSizePhysical, m_image, QSizeF(m_imageSizePhysical) / m_devicePixelRatioF);
     return m_image;
 }
 
@@ -33,6 +33,9 @@
 #include <QImage>
 #include <QSharedPointer>
 
+#include "PerceptualColor/abstractdiagram.h"
+#include "displaytransform.h"
+#include "imagevariantcache.h"
 #include "rgbcolorspace.h"
 
 namespace PerceptualColor
@@ -63,6 +66,14 @@ namespace PerceptualColor
  * usage, as no memory will be hold for data that will not be
  * needed again.)
  *
+ * Images that have been rendered for a different image size but the
+ * same widget size are retained in a small variant cache (see
+ * @ref setDevicePixelRatioF()). So when a window is moved back and forth
+ * between monitors with different device pixel ratios (and therefore
+ * different physical image sizes), the image is rendered only once for
+ * each monitor.
+ * Changing the hue or the background color discards all variants.
+ *
  * @note Resetting a property to its very same value does not trigger an
  * image calculation. So, if the hue is 5, and you call @ref setHue
  * <tt>(5)</tt>, than this will not trigger an image calculation, but the
@@ -81,7 +92,13 @@ class ChromaLightnessImage final
 public:
     explicit ChromaLightnessImage(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace);
     QImage getImage();
+    bool hasVariants() const;
+    bool isImageAvailable();
     void setBackgroundColor(const QColor newBackgroundColor);
+    void setColorVisionDeficiency(const AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency);
+    void setDevicePixelRatioF(const qreal newDevicePixelRatioF);
+    void setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace);
+    void setGamutCacheEnabled(const bool enabled);
     void setHue(const qreal newHue);
     void setImageSize(const QSize newImageSize);
 
@@ -101,6 +118,24 @@ private:
      *
      * @sa @ref setHue() */
     qreal m_hue = 0;
+    /** @brief Internal store for the simulated color vision deficiency.
+     *
+     * @sa @ref setColorVisionDeficiency() */
+    AbstractDiagram::ColorVisionDeficiency m_colorVisionDeficiency = AbstractDiagram::ColorVisionDeficiency::none;
+    /** @brief Internal store for the device pixel ratio.
+     *
+     * @sa @ref setDevicePixelRatioF() */
+    qreal m_devicePixelRatioF = 1;
+    /** @brief Internal store for the display color space.
+     *
+     * @sa @ref setDisplayColorSpace() */
+    QSharedPointer<PerceptualColor::RgbColorSpace> m_displayColorSpace;
+    /** @brief Transform to @ref m_displayColorSpace.
+     *
+     * <tt>nullptr</tt> if no transform is necessary.
+     *
+     * @sa @ref setDisplayColorSpace() */
+    QSharedPointer<DisplayTransform> m_displayTransform;
     /** @brief Internal storage of the image (cache).
      *
      * - If <tt>m_image.isNull()</tt> than either no cache is available
@@ -114,8 +149,15 @@ private:
      *
      * @sa @ref setImageSize() */
     QSize m_imageSizePhysical;
+    /** @brief If the image is resampled from the gamut cache.
+     *
+     * @sa @ref setGamutCacheEnabled() */
+    bool m_isGamutCacheEnabled = true;
     /** @brief Pointer to @ref RgbColorSpace object */
     QSharedPointer<PerceptualColor::RgbColorSpace> m_rgbColorSpace;
+    /** @brief Images that have previously been rendered with the current
+     * hue and background color, but another image size. */
+    ImageVariantCache<QSize> m_variants;
 };
 
 } // namespace PerceptualColor
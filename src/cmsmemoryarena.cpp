@@ -0,0 +1,242 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "cmsmemoryarena.h"
+
+#include <QMutexLocker>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <lcms2_plugin.h>
+
+namespace PerceptualColor
+{
+/** @brief Constructor */
+CmsMemoryArena::CmsMemoryArena()
+{
+}
+
+/** @brief Destructor
+ *
+ * Releases all memory of the arena at once.
+ *
+ * @pre The context created by @ref createContext() has been deleted. */
+CmsMemoryArena::~CmsMemoryArena() noexcept
+{
+}
+
+/** @brief Creates a LittleCMS context that allocates its memory from
+ * this arena.
+ *
+ * @returns The new context, or <tt>nullptr</tt> if LittleCMS was not
+ * able to create it. In the latter case, you can still use
+ * <tt>nullptr</tt> (the default context of LittleCMS) as context.
+ * The caller takes ownership and has to delete the context with
+ * <tt>cmsDeleteContext()</tt> before the arena is destroyed. */
+cmsContext CmsMemoryArena::createContext()
+{
+    cmsPluginMemHandler plugin;
+    std::memset(&plugin, 0, sizeof(plugin));
+    plugin.base.Magic = cmsPluginMagicNumber;
+    plugin.base.ExpectedVersion = LCMS_VERSION;
+    plugin.base.Type = cmsPluginMemHandlerSig;
+    plugin.base.Next = nullptr;
+    plugin.MallocPtr = &CmsMemoryArena::mallocCallback;
+    plugin.FreePtr = &CmsMemoryArena::freeCallback;
+    plugin.ReallocPtr = &CmsMemoryArena::reallocCallback;
+    // The optional functions (MallocZeroPtr, CallocPtr, DupPtr)
+    // stay nullptr. LittleCMS implements them on top of MallocPtr.
+    return cmsCreateContext(&plugin, this);
+}
+
+/** @brief Number of allocations that have been served by the arena.
+ *
+ * Reused allocations are counted, too. Allocations that fall back to
+ * the global heap are not counted.
+ *
+ * @returns Number of allocations that have been served by the arena. */
+int CmsMemoryArena::allocationCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_allocationCount;
+}
+
+/** @brief Memory reserved from the global heap.
+ *
+ * @returns Memory (in bytes) that the arena has reserved from
+ * the global heap. */
+std::size_t CmsMemoryArena::reservedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_reservedBytes;
+}
+
+/** @brief Size rounded up to the alignment of @ref Header
+ *
+ * @param size The requested size
+ * @returns The size, rounded up, so that the following header keeps
+ * its alignment. */
+std::size_t CmsMemoryArena::roundedSize(cmsUInt32Number size)
+{
+    constexpr std::size_t alignment = alignof(Header);
+    return (static_cast<std::size_t>(size) + alignment - 1) / alignment * alignment;
+}
+
+/** @brief Allocates memory from the arena.
+ *
+ * @param size Requested size
+ * @returns Pointer to the memory. */
+void *CmsMemoryArena::allocate(cmsUInt32Number size)
+{
+    const std::size_t usableSize = roundedSize(size);
+    QMutexLocker locker(&m_mutex);
+    ++m_allocationCount;
+
+    // Reuse a freed allocation of the same size if possible.
+    auto freeList = m_freeLists.find(usableSize);
+    if ((freeList != m_freeLists.end()) && !freeList->isEmpty()) {
+        Header *header = freeList->takeLast();
+        return header + 1;
+    }
+
+    const std::size_t totalSize = sizeof(Header) + usableSize;
+    const std::size_t elementCount = totalSize / sizeof(std::max_align_t) + 1;
+    char *memory = nullptr;
+    if (totalSize > blockSize / 4) {
+        // Big allocations get a block of their own. This
+        // avoids wasting the rest of the current block.
+        m_blocks.emplace_back(new std::max_align_t[elementCount]);
+        m_reservedBytes += elementCount * sizeof(std::max_align_t);
+        memory = reinterpret_cast<char *>(m_blocks.back().get());
+    } else {
+        if ((m_currentBlock == nullptr) || (m_currentBlockUsed + totalSize > blockSize)) {
+            m_blocks.emplace_back(new std::max_align_t[blockSize / sizeof(std::max_align_t)]);
+            m_reservedBytes += blockSize;
+            m_currentBlock = reinterpret_cast<char *>(m_blocks.back().get());
+            m_currentBlockUsed = 0;
+        }
+        memory = m_currentBlock + m_currentBlockUsed;
+        m_currentBlockUsed += totalSize;
+    }
+    Header *header = new (memory) Header;
+    header->size = static_cast<cmsUInt32Number>(usableSize);
+    header->isHeapAllocation = false;
+    return header + 1;
+}
+
+/** @brief Allocates memory from the global heap.
+ *
+ * The memory has the same header as memory from the arena, so that
+ * it can be released by @ref freeCallback().
+ *
+ * @param size Requested size
+ * @returns Pointer to the memory, or <tt>nullptr</tt> on failure. */
+void *CmsMemoryArena::heapAllocate(cmsUInt32Number size)
+{
+    void *memory = std::malloc(sizeof(Header) + roundedSize(size));
+    if (memory == nullptr) {
+        return nullptr;
+    }
+    Header *header = new (memory) Header;
+    header->size = static_cast<cmsUInt32Number>(roundedSize(size));
+    header->isHeapAllocation = true;
+    return header + 1;
+}
+
+/** @brief Puts an allocation of the arena on the free list.
+ *
+ * @param header The header of the allocation */
+void CmsMemoryArena::release(Header *header)
+{
+    QMutexLocker locker(&m_mutex);
+    m_freeLists[header->size].append(header);
+}
+
+/** @brief Memory handler for LittleCMS: <tt>malloc</tt>
+ *
+ * @param contextID The LittleCMS context
+ * @param size Requested size
+ * @returns Pointer to the memory, or <tt>nullptr</tt> on failure. */
+void *CmsMemoryArena::mallocCallback(cmsContext contextID, cmsUInt32Number size)
+{
+    CmsMemoryArena *arena = static_cast<CmsMemoryArena *>(cmsGetContextUserData(contextID));
+    if (arena == nullptr) {
+        // The context is still under construction.
+        return heapAllocate(size);
+    }
+    return arena->allocate(size);
+}
+
+/** @brief Memory handler for LittleCMS: <tt>free</tt>
+ *
+ * @param contextID The LittleCMS context
+ * @param pointer Pointer to the memory. Might be <tt>nullptr</tt>. */
+void CmsMemoryArena::freeCallback(cmsContext contextID, void *pointer)
+{
+    if (pointer == nullptr) {
+        return;
+    }
+    Header *header = static_cast<Header *>(pointer) - 1;
+    if (header->isHeapAllocation) {
+        header->~Header();
+        std::free(header);
+        return;
+    }
+    static_cast<CmsMemoryArena *>(cmsGetContextUserData(contextID))->release(header);
+}
+
+/** @brief Memory handler for LittleCMS: <tt>realloc</tt>
+ *
+ * @param contextID The LittleCMS context
+ * @param pointer Pointer to the old memory. Might be <tt>nullptr</tt>.
+ * @param newSize Requested size
+ * @returns Pointer to the memory, or <tt>nullptr</tt> on failure. */
+void *CmsMemoryArena::reallocCallback(cmsContext contextID, void *pointer, cmsUInt32Number newSize)
+{
+    if (pointer == nullptr) {
+        return mallocCallback(contextID, newSize);
+    }
+    const Header *header = static_cast<Header *>(pointer) - 1;
+    if (newSize <= header->size) {
+        // The allocation is already big enough.
+        return pointer;
+    }
+    void *result = mallocCallback(contextID, newSize);
+    if (result != nullptr) {
+        std::memcpy(result, pointer, header->size);
+        freeCallback(contextID, pointer);
+    }
+    return result;
+}
+
+} // namespace PerceptualColor
@@ -0,0 +1,131 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSMEMORYARENA_H
+#define CMSMEMORYARENA_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <lcms2.h>
+
+namespace PerceptualColor
+{
+/** @internal
+ *
+ * @brief Memory arena for a LittleCMS context.
+ *
+ * By default, LittleCMS uses the global <tt>malloc()</tt> for everything.
+ * Parsing a profile and compiling transforms produce thousands of small
+ * allocations. In a long-running process, this fragments the heap.
+ *
+ * This class provides a LittleCMS context whose memory comes from
+ * big blocks owned by this arena. Memory that LittleCMS frees is kept on
+ * a free list (one per rounded allocation size) and reused for later
+ * allocations of the same size. All the blocks are released in one go
+ * when the arena is destroyed.
+ *
+ * Usage:
+ * - Create the arena.
+ * - Create the context with @ref createContext() and pass it to the
+ *   <tt>…THR()</tt> functions of LittleCMS.
+ * - Delete all LittleCMS objects that use this context. Delete the
+ *   context with <tt>cmsDeleteContext()</tt>.
+ * - Destroy the arena.
+ *
+ * The memory functions are protected by a mutex, so the objects
+ * of the context can be used from various threads.
+ *
+ * @note Allocations that LittleCMS makes while the context itself is
+ * still being constructed (and therefore the arena is not yet
+ * known) fall back to the global heap. They are released to the global
+ * heap as well. */
+class CmsMemoryArena final
+{
+public:
+    CmsMemoryArena();
+    ~CmsMemoryArena() noexcept;
+    int allocationCount() const;
+    cmsContext createContext();
+    std::size_t reservedBytes() const;
+
+    /** @brief Size of the blocks that are allocated from the heap. */
+    static constexpr std::size_t blockSize = 64 * 1024;
+
+private:
+    Q_DISABLE_COPY(CmsMemoryArena)
+
+    /** @brief Header in front of each allocation. */
+    struct alignas(std::max_align_t) Header {
+        /** @brief Usable size of the allocation (without header) */
+        cmsUInt32Number size;
+        /** @brief If the allocation comes from the global heap instead
+         * of the arena. */
+        bool isHeapAllocation;
+    };
+
+    void *allocate(cmsUInt32Number size);
+    static void *heapAllocate(cmsUInt32Number size);
+    void release(Header *header);
+    static std::size_t roundedSize(cmsUInt32Number size);
+
+    // LittleCMS callbacks
+    static void freeCallback(cmsContext contextID, void *pointer);
+    static void *mallocCallback(cmsContext contextID, cmsUInt32Number size);
+    static void *reallocCallback(cmsContext contextID, void *pointer, cmsUInt32Number newSize);
+
+    /** @brief Number of allocations that have been served by the arena */
+    int m_allocationCount = 0;
+    /** @brief All blocks of this arena. */
+    std::vector<std::unique_ptr<std::max_align_t[]>> m_blocks;
+    /** @brief The block from which new allocations are cut. */
+    char *m_currentBlock = nullptr;
+    /** @brief Number of bytes already used in @ref m_currentBlock */
+    std::size_t m_currentBlockUsed = 0;
+    /** @brief Freed allocations, that can be reused.
+     *
+     * Key: Usable size of the allocations. Value: The allocations. */
+    QHash<std::size_t, QVector<Header *>> m_freeLists;
+    /** @brief Protects all other data members. */
+    mutable QMutex m_mutex;
+    /** @brief Total size of @ref m_blocks in bytes */
+    std::size_t m_reservedBytes = 0;
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestCmsMemoryArena;
+};
+
+} // namespace PerceptualColor
+
+#endif // CMSMEMORYARENA_H
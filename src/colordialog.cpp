@@ -34,12 +34,14 @@
 #include "colordialog_p.h"
 
 #include <QAction>
+#include <QCoreApplication>
 #include <QFormLayout>
 #include <QGroupBox>
 #include <QGuiApplication>
 #include <QRegularExpressionValidator>
 #include <QScreen>
 #include <QStyle>
+#include <QTimer>
 #include <QVBoxLayout>
 
 #include "PerceptualColor/rgbcolorspacefactory.h"
@@ -319,17 +321,104 @@ void ColorDialog::ColorDialogPrivate::setCurrentOpaqueColor(const PerceptualColo
 }
 
 /** @brief Reads the value from the lightness selector in the dialog and
- * updates the dialog accordingly. */
+ * updates the dialog accordingly.
+ *
+ * While the user drags the lightness selector with the mouse, the gamut
+ * boundary is searched only with @ref interactiveGamutPrecision. The
+ * final lightness and the step that has reduced the chroma most are
+ * recorded, so that @ref finishLightnessDrag() can do the exact
+ * resolution once the mouse button is released. */
 void ColorDialog::ColorDialogPrivate::readLightnessValue()
 {
     LchDouble lch = m_currentOpaqueColor.toLch();
     lch.l = m_lchLightnessSelector->value() * 100;
+    const qreal lightness = lch.l;
+    lch = m_rgbColorSpace->nearestInGamutColorByAdjustingChroma( //
+        lch,
+        m_isLightnessDragActive ? interactiveGamutPrecision : gamutPrecision);
+    if (m_isLightnessDragActive) {
+        m_lightnessDragFinalLightness = lightness;
+        if (lch.c < m_lightnessDragMinimumChroma) {
+            m_lightnessDragMinimumChroma = lch.c;
+            m_lightnessDragLimitingLightness = lightness;
+        }
+    }
+    setCurrentOpaqueColor( //
+        MultiColor::fromLch(m_rgbColorSpace, lch),
+        m_lchLightnessSelector);
+}
+
+/** @brief Ends a mouse drag of the lightness selector.
+ *
+ * Each step of the drag starts from the result of the previous step and
+ * only ever reduces the chroma. So the result of the drag depends only
+ * on the start color, the step that has reduced the chroma most and the
+ * final lightness. This function does the exact search for these two
+ * steps, starting from @ref m_lightnessDragStartColor. That are at most
+ * two searches, independent of the length of the drag.
+ *
+ * The step that has reduced the chroma most has been chosen with
+ * @ref interactiveGamutPrecision, so the chroma might differ from an
+ * exact search for each single step by this precision at most.
+ *
+ * @sa @ref m_isLightnessDragActive */
+void ColorDialog::ColorDialogPrivate::finishLightnessDrag()
+{
+    if (!m_isLightnessDragActive) {
+        return;
+    }
+    m_isLightnessDragActive = false;
+    if (m_lightnessDragFinalLightness < 0) {
+        // The lightness has not changed during the drag.
+        return;
+    }
+    LchDouble lch = m_lightnessDragStartColor;
+    if (m_lightnessDragMinimumChroma < lch.c) {
+        lch.l = m_lightnessDragLimitingLightness;
+        lch = m_rgbColorSpace->nearestInGamutColorByAdjustingChroma(lch);
+    }
+    lch.l = m_lightnessDragFinalLightness;
     lch = m_rgbColorSpace->nearestInGamutColorByAdjustingChroma(lch);
     setCurrentOpaqueColor( //
         MultiColor::fromLch(m_rgbColorSpace, lch),
         m_lchLightnessSelector);
 }
 
+/** @brief Filters events of child widgets.
+ *
+ * Reimplemented from base class.
+ *
+ * Tracks mouse drags of @ref m_lchLightnessSelector. See
+ * @ref m_isLightnessDragActive for details.
+ *
+ * @param watched The object that receives the event
+ * @param event The event
+ *
+ * @returns <tt>false</tt>, so that the event is passed on. */
+bool ColorDialog::ColorDialogPrivate::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_lchLightnessSelector) {
+        switch (event->type()) {
+        case QEvent::Type::MouseButtonPress:
+            if (!m_isLightnessDragActive) {
+                m_lightnessDragStartColor = m_currentOpaqueColor.toLch();
+                m_lightnessDragFinalLightness = -1;
+                m_lightnessDragMinimumChroma = m_lightnessDragStartColor.c;
+                m_isLightnessDragActive = true;
+            }
+            break;
+        case QEvent::Type::MouseButtonRelease:
+            // The slider has not yet handled the release event, so the
+            // final value is read later.
+            QTimer::singleShot(0, this, &ColorDialogPrivate::finishLightnessDrag);
+            break;
+        default:
+            break;
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
 /** @brief Reads the HSV numbers in the dialog and
  * updates the dialog accordingly. */
 void ColorDialog::ColorDialogPrivate::readHsvNumericValues()
@@ -454,6 +543,7 @@ void ColorDialog::ColorDialogPrivate::initialize(const QSharedPointer<Perceptual
     white.a = 1;
     m_lchLightnessSelector->setColors(black, white);
     m_lchLightnessSelector->setAccessibleName(tr("Lightness"));
+    m_lchLightnessSelector->installEventFilter(this);
     m_chromaHueDiagram = new ChromaHueDiagram(m_rgbColorSpace);
     QHBoxLayout *tempLightnesFirstLayout = new QHBoxLayout();
     tempLightnesFirstLayout->addWidget(m_lchLightnessSelector);
@@ -465,7 +555,7 @@ void ColorDialog::ColorDialogPrivate::initialize(const QSharedPointer<Perceptual
     m_tabWidget->addTab(m_lightnessFirstWidget, tr("&Lightness-based"));
 
     // Create the ColorPatch
-    m_colorPatch = new ColorPatch();
+    m_colorPatch = new ColorPatch(m_rgbColorSpace);
     m_colorPatch->setMinimumSize(m_colorPatch->minimumSizeHint() * 1.5);
 
     // Create widget for the numerical values
@@ -880,6 +970,12 @@ bool ColorDialog::testOption(PerceptualColor::ColorDialog::ColorDialogOption opt
 /** @brief Pops up a modal color dialog, lets the user choose a color, and
  *  returns that color.
  *
+ * The dialog is not destroyed after use, but kept hidden for the next call
+ * with the same color space and the same options. This next call resets
+ * the title, the current color and the current tab, but the already
+ * rendered diagrams are reused, so the dialog appears much faster. Only
+ * the few most recently used dialogs are kept; older ones are deleted.
+ *
  * @param colorSpace The color space within which this widget should operate.
  * @param initial    initial value for currentColor()
  * @param parent     parent widget of the dialog (or 0 for no parent)
@@ -888,19 +984,137 @@ bool ColorDialog::testOption(PerceptualColor::ColorDialog::ColorDialogOption opt
  * @param options    the options() for customizing the look and feel of the
  *                   dialog
  * @returns          selectedColor(): The color the user has selected; or an
- *                   invalid color if the user has canceled the dialog. */
+ *                   invalid color if the user has canceled the dialog.
+ *
+ * @sa @ref clearDialogPool() */
 QColor ColorDialog::getColor(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, const QColor &initial, QWidget *parent, const QString &title, QColorDialog::ColorDialogOptions options)
 {
-    ColorDialog temp(colorSpace, parent);
-    if (!title.isEmpty()) {
-        temp.setWindowTitle(title);
+    ColorDialogPrivate::DialogPool &pool = ColorDialogPrivate::dialogPool();
+    const ColorDialogPrivate::DialogPoolKey key(colorSpace.data(), static_cast<int>(options));
+    QPointer<ColorDialog> dialog;
+    for (const auto &entry : qAsConst(pool)) {
+        if (entry.first == key) {
+            dialog = entry.second;
+            break;
+        }
+    }
+    if (!dialog.isNull() && dialog->isVisible()) {
+        // The pooled dialog is yet in use, for example because getColor()
+        // has been called from within the event loop of the pooled dialog.
+        ColorDialog temp(colorSpace, parent);
+        if (!title.isEmpty()) {
+            temp.setWindowTitle(title);
+        }
+        temp.setOptions(options);
+        // setCurrentColor() must be after setOptions()
+        // to allow alpha channel support
+        temp.setCurrentColor(initial);
+        temp.exec();
+        return temp.selectedColor();
     }
-    temp.setOptions(options);
+    if (dialog.isNull()) {
+        dialog = new ColorDialog(colorSpace);
+        dialog->setOptions(options);
+    }
+    ColorDialogPrivate::touchDialogPool(key, dialog);
+
+    // Reset the state of the dialog.
+    dialog->setParent(parent, dialog->windowFlags());
+    dialog->setWindowTitle(title.isEmpty() //
+                               ? QColorDialog::tr("Select Color")
+                               : title);
+    dialog->d_pointer->m_tabWidget->setCurrentIndex(0);
     // setCurrentColor() must be after setOptions()
     // to allow alpha channel support
-    temp.setCurrentColor(initial);
-    temp.exec();
-    return temp.selectedColor();
+    dialog->setCurrentColor(initial);
+
+    dialog->exec();
+
+    if (dialog.isNull()) {
+        // The dialog has been deleted together with its parent.
+        return QColor();
+    }
+    const QColor result = dialog->selectedColor();
+    // Detach the dialog from the parent, so that it survives when
+    // the parent is deleted.
+    dialog->setParent(nullptr, dialog->windowFlags());
+    return result;
+}
+
+/** @brief Deletes the dialogs that @ref getColor() keeps for reuse.
+ *
+ * This frees the memory of these dialogs. The next call of
+ * @ref getColor() will build a new dialog. Dialogs that are currently
+ * shown are deleted as soon as control returns to the event loop.
+ *
+ * This function is called automatically when the application is
+ * about to quit. */
+void ColorDialog::clearDialogPool()
+{
+    ColorDialogPrivate::DialogPool &pool = ColorDialogPrivate::dialogPool();
+    for (const auto &entry : qAsConst(pool)) {
+        ColorDialogPrivate::deletePooledDialog(entry.second);
+    }
+    pool.clear();
+}
+
+/** @brief Deletes a dialog of @ref dialogPool().
+ *
+ * @param dialog The dialog to delete. If it is currently shown, it is
+ * deleted as soon as control returns to the event loop. If it is
+ * a null pointer, nothing happens. */
+void ColorDialog::ColorDialogPrivate::deletePooledDialog(const QPointer<ColorDialog> &dialog)
+{
+    if (dialog.isNull()) {
+        return;
+    }
+    if (dialog->isVisible()) {
+        dialog->deleteLater();
+    } else {
+        delete dialog.data();
+    }
+}
+
+/** @brief Marks a dialog of @ref dialogPool() as most recently used.
+ *
+ * Moves the entry to the front of the pool (adding it if necessary).
+ * Entries whose dialog has been deleted meanwhile are removed. If then
+ * the pool exceeds @ref dialogPoolCapacity, the least recently used
+ * dialogs are deleted.
+ *
+ * @param key The key of the dialog
+ * @param dialog The dialog */
+void ColorDialog::ColorDialogPrivate::touchDialogPool(const DialogPoolKey &key, const QPointer<ColorDialog> &dialog)
+{
+    DialogPool &pool = dialogPool();
+    for (int i = pool.count() - 1; i >= 0; --i) {
+        if ((pool.at(i).first == key) || pool.at(i).second.isNull()) {
+            pool.removeAt(i);
+        }
+    }
+    pool.prepend(qMakePair(key, dialog));
+    while (pool.count() > dialogPoolCapacity) {
+        deletePooledDialog(pool.takeLast().second);
+    }
+}
+
+/** @brief The dialogs that @ref ColorDialog::getColor() keeps for reuse.
+ *
+ * Only for usage in the main thread.
+ *
+ * @returns The dialogs that @ref ColorDialog::getColor() keeps for
+ * reuse, at most one for each combination of color space and options,
+ * and at most @ref dialogPoolCapacity in total. The pool is cleared
+ * automatically when the application is about to quit. */
+ColorDialog::ColorDialogPrivate::DialogPool &ColorDialog::ColorDialogPrivate::dialogPool()
+{
+    static DialogPool pool;
+    static const bool isCleanupConnected = QObject::connect( //
+        QCoreApplication::instance(),
+        &QCoreApplication::aboutToQuit,
+        &ColorDialog::clearDialogPool);
+    Q_UNUSED(isCleanupConnected);
+    return pool;
 }
 
 /** @brief The color that was actually selected by the user.
@@ -973,6 +1187,43 @@ void ColorDialog::done(int result)
     }
 }
 
+/** @brief Getter for the display color space.
+ *
+ * @returns The display color space, or <tt>nullptr</tt> if none is set.
+ *
+ * @sa @ref setDisplayColorSpace() */
+QSharedPointer<PerceptualColor::RgbColorSpace> ColorDialog::displayColorSpace() const
+{
+    return d_pointer->m_displayColorSpace;
+}
+
+/** @brief Sets the display color space of the diagrams and of the color
+ * patch of this dialog.
+ *
+ * @param newDisplayColorSpace The color space of the display, or
+ * <tt>nullptr</tt> (default) to paint the RGB values of the color space
+ * of this dialog directly on the screen.
+ *
+ * @sa @ref displayColorSpace()
+ * @sa @ref AbstractDiagram::setDisplayColorSpace()
+ * @sa @ref ColorPatch::setDisplayColorSpace() */
+void ColorDialog::setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace)
+{
+    d_pointer->m_displayColorSpace = newDisplayColorSpace;
+    if (d_pointer->m_colorPatch != nullptr) {
+        d_pointer->m_colorPatch->setDisplayColorSpace(newDisplayColorSpace);
+    }
+    const QList<AbstractDiagram *> diagrams {d_pointer->m_alphaGradientSlider,
+                                             d_pointer->m_chromaHueDiagram,
+                                             d_pointer->m_lchLightnessSelector,
+                                             d_pointer->m_wheelColorPicker};
+    for (AbstractDiagram *diagram : diagrams) {
+        if (diagram != nullptr) {
+            diagram->setDisplayColorSpace(newDisplayColorSpace);
+        }
+    }
+}
+
 // No documentation here (documentation of properties
 // and its getters are in the header)
 ColorDialog::DialogLayoutDimensions ColorDialog::layoutDimensions() const
@@ -48,7 +48,10 @@
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
+#include <QList>
+#include <QPair>
 #include <QPointer>
+#include <QSharedPointer>
 #include <QTabWidget>
 
 namespace PerceptualColor
@@ -94,6 +97,8 @@ public:
      *
      * @sa @ref currentColor() */
     MultiColor m_currentOpaqueColor;
+    /** @brief Internal storage for @ref ColorDialog::displayColorSpace() */
+    QSharedPointer<PerceptualColor::RgbColorSpace> m_displayColorSpace;
     /** @brief Pointer to the @ref GradientSlider for LCh lightness. */
     QPointer<GradientSlider> m_lchLightnessSelector;
     /** @brief Pointer to the @ref MultiSpinBox for HLC. */
@@ -106,6 +111,12 @@ public:
      * within this dialog.
      * @sa @ref setCurrentOpaqueColor() */
     bool m_isColorChangeInProgress = false;
+    /** @brief Holds whether currently the user drags
+     * @ref m_lchLightnessSelector with the mouse.
+     *
+     * @sa @ref eventFilter()
+     * @sa @ref m_lightnessDragStartColor */
+    bool m_isLightnessDragActive = false;
     /** @brief Holds whether the current text of @ref m_rgbLineEdit differs
      * from the value in @ref m_currentOpaqueColor.
      * @sa @ref readRgbHexValues
@@ -117,6 +128,40 @@ public:
         ColorDialog::DialogLayoutDimensions::collapsed
         //! [layoutDimensionsDefaultValue]
         ;
+    /** @brief The color at the moment the user started to drag
+     * @ref m_lchLightnessSelector.
+     *
+     * The start of the exact resolution in @ref finishLightnessDrag().
+     *
+     * Only meaningful while @ref m_isLightnessDragActive is
+     * <tt>true</tt>. */
+    LchDouble m_lightnessDragStartColor;
+    /** @brief The lightness that @ref readLightnessValue() has applied
+     * last during the current drag of @ref m_lchLightnessSelector.
+     *
+     * Only meaningful while @ref m_isLightnessDragActive is
+     * <tt>true</tt>. Negative if the lightness has not been changed yet
+     * during the current drag.
+     *
+     * @sa @ref finishLightnessDrag() */
+    qreal m_lightnessDragFinalLightness = -1;
+    /** @brief The lightness of the step of the current drag of
+     * @ref m_lchLightnessSelector that has reduced the chroma most.
+     *
+     * Only meaningful while @ref m_isLightnessDragActive is
+     * <tt>true</tt>, and only if @ref m_lightnessDragMinimumChroma is
+     * smaller than the chroma of @ref m_lightnessDragStartColor.
+     *
+     * @sa @ref finishLightnessDrag() */
+    qreal m_lightnessDragLimitingLightness = 0;
+    /** @brief The smallest chroma of all steps of the current drag of
+     * @ref m_lchLightnessSelector.
+     *
+     * Measured with @ref interactiveGamutPrecision. Only meaningful
+     * while @ref m_isLightnessDragActive is <tt>true</tt>.
+     *
+     * @sa @ref m_lightnessDragLimitingLightness */
+    qreal m_lightnessDragMinimumChroma = 0;
     /** @brief Pointer to the graphical selector widget that groups lightness
      *  and chroma-hue selector. */
     QPointer<QWidget> m_lightnessFirstWidget;
@@ -155,12 +200,34 @@ public:
     /** @brief Pointer to the @ref WheelColorPicker widget. */
     QPointer<WheelColorPicker> m_wheelColorPicker;
 
+    /** @brief Key for @ref dialogPool()
+     *
+     * The color space and the options (as integer). */
+    using DialogPoolKey = QPair<const RgbColorSpace *, int>;
+    /** @brief Type of @ref dialogPool()
+     *
+     * Ordered from the most recently used to the least recently used
+     * dialog. */
+    using DialogPool = QList<QPair<DialogPoolKey, QPointer<ColorDialog>>>;
+    /** @brief Maximum number of dialogs in @ref dialogPool()
+     *
+     * Each dialog keeps its color space alive and holds the cached
+     * images of its diagrams. Therefore, only a few dialogs are kept:
+     * The least recently used dialog is deleted when a new one would
+     * exceed this capacity. */
+    static constexpr int dialogPoolCapacity = 3;
+
     void applyLayoutDimensions();
+    static void deletePooledDialog(const QPointer<ColorDialog> &dialog);
+    static DialogPool &dialogPool();
+    virtual bool eventFilter(QObject *watched, QEvent *event) override;
     void initialize(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace);
     QWidget *initializeNumericPage();
     void setCurrentColorWithAlpha(const MultiColor &color, double alpha);
+    static void touchDialogPool(const DialogPoolKey &key, const QPointer<ColorDialog> &dialog);
 
 public Q_SLOTS:
+    void finishLightnessDrag();
     void readChromaHueDiagramValue();
     void readHlcNumericValues();
     void readHsvNumericValues();
@@ -39,17 +39,39 @@
 
 #include "PerceptualColor/abstractdiagram.h"
 
+#include "colorvisiondeficiencysimulation.h"
+#include "displaytransform.h"
 #include "helper.h"
+#include "rgbcolorspace.h"
+#include "rgbdouble.h"
 
 namespace PerceptualColor
 {
 /** @brief Constructor
+ *
+ * The @ref color is interpreted as sRGB color for the simulation of
+ * the @ref colorVisionDeficiency.
+ *
  * @param parent The parent of the widget, if any
  */
 ColorPatch::ColorPatch(QWidget *parent)
+    : ColorPatch(nullptr, parent)
+{
+}
+
+/** @brief Constructor
+ *
+ * @param colorSpace The color space of the @ref color. Its transfer
+ * functions are used for the simulation of the
+ * @ref colorVisionDeficiency, like the diagrams do. If
+ * <tt>nullptr</tt>, the color is interpreted as sRGB color.
+ * @param parent The parent of the widget, if any
+ */
+ColorPatch::ColorPatch(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace, QWidget *parent)
     : QFrame(parent)
     , d_pointer(new ColorPatchPrivate())
 {
+    d_pointer->m_rgbColorSpace = colorSpace;
     setFrameShape(QFrame::StyledPanel);
     setFrameShadow(QFrame::Sunken);
     setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
@@ -109,6 +131,66 @@ void ColorPatch::setColor(const QColor &newColor)
     }
 }
 
+// No documentation here (documentation of properties
+// and its getters are in the header)
+AbstractDiagram::ColorVisionDeficiency ColorPatch::colorVisionDeficiency() const
+{
+    return d_pointer->m_colorVisionDeficiency;
+}
+
+/** @brief Setter for the @ref colorVisionDeficiency property.
+ * @param newColorVisionDeficiency the new color vision deficiency */
+void ColorPatch::setColorVisionDeficiency(const PerceptualColor::AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency)
+{
+    if (newColorVisionDeficiency != d_pointer->m_colorVisionDeficiency) {
+        d_pointer->m_colorVisionDeficiency = newColorVisionDeficiency;
+        Q_EMIT colorVisionDeficiencyChanged(newColorVisionDeficiency);
+        update(); // schedules a paint event
+    }
+}
+
+/** @brief Getter for the display color space.
+ *
+ * @returns The display color space, or <tt>nullptr</tt> if none is set.
+ *
+ * @sa @ref setDisplayColorSpace() */
+QSharedPointer<PerceptualColor::RgbColorSpace> ColorPatch::displayColorSpace() const
+{
+    return d_pointer->m_displayColorSpace;
+}
+
+/** @brief Setter for @ref displayColorSpace().
+ *
+ * By default, the RGB values of the @ref color are painted directly on
+ * the screen. If the working color space (see constructor) is not the
+ * color space of the screen, set the display color space to get
+ * correct colors on the screen, like for
+ * @ref AbstractDiagram::setDisplayColorSpace().
+ *
+ * @param newDisplayColorSpace The new display color space, or
+ * <tt>nullptr</tt> to paint the RGB values of the working color space
+ * directly.
+ *
+ * @sa @ref displayColorSpaceChanged() */
+void ColorPatch::setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace)
+{
+    if (newDisplayColorSpace == d_pointer->m_displayColorSpace) {
+        return;
+    }
+    d_pointer->m_displayColorSpace = newDisplayColorSpace;
+    d_pointer->m_displayTransform.reset();
+    if (!newDisplayColorSpace.isNull()) {
+        if (d_pointer->m_rgbColorSpace.isNull()) {
+            d_pointer->m_rgbColorSpace = RgbColorSpace::createSrgb();
+        }
+        d_pointer->m_displayTransform = DisplayTransform::create( //
+            d_pointer->m_rgbColorSpace,
+            newDisplayColorSpace);
+    }
+    Q_EMIT displayColorSpaceChanged(newDisplayColorSpace);
+    update(); // schedules a paint event
+}
+
 /** @brief Handle paint events.
  *
  * Just draws the frame inherited from QFrame, than paints a rectangle with
@@ -151,18 +233,39 @@ void ColorPatch::paintEvent(QPaintEvent *event)
 
     // Draw content of a valid color
     widgetPainter.setRenderHint(QPainter::Antialiasing, false);
+    QColor displayColor = d_pointer->m_color;
+    if (d_pointer->m_colorVisionDeficiency != AbstractDiagram::ColorVisionDeficiency::none) {
+        if (d_pointer->m_rgbColorSpace.isNull()) {
+            d_pointer->m_rgbColorSpace = RgbColorSpace::createSrgb();
+        }
+        displayColor = ColorVisionDeficiencySimulation::simulate( //
+            d_pointer->m_colorVisionDeficiency,
+            *d_pointer->m_rgbColorSpace,
+            d_pointer->m_color);
+    }
+    if (!d_pointer->m_displayTransform.isNull()) {
+        const RgbDouble workingRgb {displayColor.redF(), //
+                                    displayColor.greenF(),
+                                    displayColor.blueF()};
+        // Any non-zero alpha, because the transform keeps 0 unchanged.
+        QRgb displayRgb = qRgb(0, 0, 0);
+        d_pointer->m_displayTransform->toDisplayQRgb(&workingRgb, &displayRgb, 1);
+        const qreal alpha = displayColor.alphaF();
+        displayColor = QColor(displayRgb);
+        displayColor.setAlphaF(alpha);
+    }
     // Create an image to paint on
     QImage tempImage = QImage(
         // deliberately rounding down with static_cast<int>
         static_cast<int>(contentsRect().width() * devicePixelRatioF()),
         static_cast<int>(contentsRect().height() * devicePixelRatioF()),
         QImage::Format_RGB32);
-    if (d_pointer->m_color.alphaF() < 1) {
+    if (displayColor.alphaF() < 1) {
         // Prepare the image with (semi-)transparent color
         // Background for colors that are not fully opaque
         QImage tempBackground = transparencyBackground(devicePixelRatioF());
         // Paint the color above
-        QPainter(&tempBackground).fillRect(0, 0, size().width(), size().height(), d_pointer->m_color);
+        QPainter(&tempBackground).fillRect(0, 0, size().width(), size().height(), displayColor);
         // Fill a given rectangle with tiles. (QBrush will ignore
         // the devicePixelRatioF of the image of the tile.)
         QPainter(&tempImage).fillRect(0, 0, tempImage.width(), tempImage.height(), QBrush(tempBackground));
@@ -176,7 +279,7 @@ void ColorPatch::paintEvent(QPaintEvent *event)
         }
     } else {
         // Prepare the image with plain color
-        tempImage.fill(d_pointer->m_color);
+        tempImage.fill(displayColor);
     }
     // Set correct devicePixelRatioF for image
     tempImage.setDevicePixelRatio(devicePixelRatioF());
@@ -34,6 +34,10 @@
 #include "PerceptualColor/colorpatch.h"
 
 #include "constpropagatingrawpointer.h"
+#include "displaytransform.h"
+#include "rgbcolorspace.h"
+
+#include <QSharedPointer>
 
 namespace PerceptualColor
 {
@@ -57,6 +61,22 @@ public:
      * should be for the property @ref ColorPatch::color, so no need to
      * initialize here explicitly. */
     QColor m_color;
+    /** @brief Internal storage for property
+     * @ref ColorPatch::colorVisionDeficiency */
+    AbstractDiagram::ColorVisionDeficiency m_colorVisionDeficiency = AbstractDiagram::ColorVisionDeficiency::none;
+    /** @brief The color space of @ref m_color.
+     *
+     * Used for the simulation of the color vision deficiency and for
+     * the display transform. If <tt>nullptr</tt>, it is set to sRGB when
+     * it is needed the first time. */
+    QSharedPointer<RgbColorSpace> m_rgbColorSpace;
+    /** @brief Internal storage for @ref ColorPatch::displayColorSpace() */
+    QSharedPointer<RgbColorSpace> m_displayColorSpace;
+    /** @brief Transform from @ref m_rgbColorSpace to
+     * @ref m_displayColorSpace.
+     *
+     * <tt>nullptr</tt> if no transform is necessary. */
+    QSharedPointer<DisplayTransform> m_displayTransform;
 
 private:
     Q_DISABLE_COPY(ColorPatchPrivate)
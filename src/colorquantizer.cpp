@@ -0,0 +1,471 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own header
+#include "colorquantizer.h"
+
+#include "rgbcolorspace.h"
+#include "rgbdouble.h"
+
+#include <QHash>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+
+namespace PerceptualColor
+{
+/** @brief Runs a function on a sub-range of items.
+ *
+ * Helper for @ref ColorQuantizer::parallelFor(). */
+class ColorQuantizer::RangeRunnable final : public QRunnable
+{
+public:
+    /** @brief Constructor
+     *
+     * @param function The function to call. The reference must stay valid
+     * until @ref run() has returned.
+     * @param chunk Index of the chunk
+     * @param begin First item of the chunk
+     * @param end Item after the last item of the chunk */
+    RangeRunnable(const std::function<void(int, int, int)> &function, int chunk, int begin, int end)
+        : m_function(function)
+        , m_chunk(chunk)
+        , m_begin(begin)
+        , m_end(end)
+    {
+    }
+
+    /** @brief Calls the function. */
+    void run() override
+    {
+        m_function(m_chunk, m_begin, m_end);
+    }
+
+private:
+    Q_DISABLE_COPY(RangeRunnable)
+
+    /** @brief The function to call. */
+    const std::function<void(int, int, int)> &m_function;
+    /** @brief Index of the chunk */
+    const int m_chunk;
+    /** @brief First item of the chunk */
+    const int m_begin;
+    /** @brief Item after the last item of the chunk */
+    const int m_end;
+};
+
+/** @brief Number of chunks that @ref parallelFor() will use.
+ *
+ * @param count Number of items
+ * @param minimumChunkSize Minimum number of items per chunk
+ * @returns The number of chunks. This is <tt>0</tt> if there are no
+ * items, and at most <tt>QThread::idealThreadCount()</tt>. */
+int ColorQuantizer::chunkCount(int count, int minimumChunkSize)
+{
+    if (count < 1) {
+        return 0;
+    }
+    return qBound(1, count / qMax(1, minimumChunkSize), qMax(1, QThread::idealThreadCount()));
+}
+
+/** @brief Calls a function in parallel for sub-ranges of items.
+ *
+ * The items are divided into @ref chunkCount() chunks of (almost) equal
+ * size. The function is called once for each chunk. The calls happen
+ * in parallel; this function returns after all calls have finished.
+ *
+ * @param count Number of items
+ * @param minimumChunkSize Minimum number of items per chunk
+ * @param function The function to call. It receives the index of the
+ * chunk, the first item of the chunk and the item after the last item
+ * of the chunk. */
+void ColorQuantizer::parallelFor(int count, int minimumChunkSize, const std::function<void(int chunk, int begin, int end)> &function)
+{
+    const int chunks = chunkCount(count, minimumChunkSize);
+    if (chunks < 1) {
+        return;
+    }
+    if (chunks == 1) {
+        // No need for the overhead of a thread pool.
+        function(0, 0, count);
+        return;
+    }
+    QThreadPool pool;
+    pool.setMaxThreadCount(chunks);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        const int begin = static_cast<int>(static_cast<qint64>(count) * chunk / chunks);
+        const int end = static_cast<int>(static_cast<qint64>(count) * (chunk + 1) / chunks);
+        // The pool takes ownership of the runnable.
+        pool.start(new RangeRunnable(function, chunk, begin, end));
+    }
+    pool.waitForDone();
+}
+
+/** @brief The distinct opaque colors of an image, converted to Lab.
+ *
+ * @param image The image
+ * @param colorSpace The color space of the image
+ * @returns The distinct colors of all pixels that are not fully
+ * transparent. The alpha channel is ignored otherwise. The weight of
+ * each color is the number of pixels that have this color. */
+ColorQuantizer::Samples ColorQuantizer::samplesFromImage(const QImage &image, const QSharedPointer<RgbColorSpace> &colorSpace)
+{
+    Samples samples;
+    const QImage argbImage = image.convertToFormat(QImage::Format_ARGB32);
+    const int width = argbImage.width();
+    const int height = argbImage.height();
+    const int minimumRows = qMax(1, minimumItemsPerChunk / qMax(1, width));
+
+    // Build partial histograms for horizontal stripes of the image.
+    std::vector<QHash<QRgb, int>> partialHistograms( //
+        static_cast<std::size_t>(chunkCount(height, minimumRows)));
+    parallelFor(height, minimumRows, [&](int chunk, int begin, int end) {
+        QHash<QRgb, int> &histogram = partialHistograms.at(static_cast<std::size_t>(chunk));
+        for (int y = begin; y < end; ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(argbImage.constScanLine(y));
+            int x = 0;
+            while (x < width) {
+                // Photos and especially synthetic images have often runs
+                // of identical pixels. Counting runs saves hash lookups.
+                const QRgb color = line[x];
+                int runLength = 1;
+                while ((x + runLength < width) && (line[x + runLength] == color)) {
+                    ++runLength;
+                }
+                x += runLength;
+                if (qAlpha(color) > 0) {
+                    histogram[color | 0xFF000000u] += runLength;
+                }
+            }
+        }
+    });
+    if (partialHistograms.empty()) {
+        return samples;
+    }
+
+    // Merge the partial histograms.
+    QHash<QRgb, int> histogram = std::move(partialHistograms.front());
+    for (std::size_t i = 1; i < partialHistograms.size(); ++i) {
+        const QHash<QRgb, int> &partialHistogram = partialHistograms.at(i);
+        for (auto it = partialHistogram.constBegin(); it != partialHistogram.constEnd(); ++it) {
+            histogram[it.key()] += it.value();
+        }
+    }
+
+    // Convert each distinct color exactly once.
+    const int count = histogram.count();
+    std::vector<QRgb> colors;
+    colors.reserve(static_cast<std::size_t>(count));
+    samples.weight.reserve(static_cast<std::size_t>(count));
+    for (auto it = histogram.constBegin(); it != histogram.constEnd(); ++it) {
+        colors.push_back(it.key());
+        samples.weight.push_back(it.value());
+    }
+    std::vector<RgbDouble> rgbBuffer(static_cast<std::size_t>(count));
+    samples.lab.resize(count);
+    const PlanarView<double> lab = samples.lab.view();
+    parallelFor(count, minimumItemsPerChunk, [&](int, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const QRgb color = colors[static_cast<std::size_t>(i)];
+            RgbDouble &rgb = rgbBuffer[static_cast<std::size_t>(i)];
+            rgb.red = qRed(color) / 255.0;
+            rgb.green = qGreen(color) / 255.0;
+            rgb.blue = qBlue(color) / 255.0;
+        }
+        // Each chunk writes directly into its own slice of the buffer.
+        colorSpace->toCielab(&rgbBuffer[static_cast<std::size_t>(begin)], //
+                             lab.slice(begin, end - begin));
+    });
+    return samples;
+}
+
+/** @brief Weighted median-cut
+ *
+ * Starting with a single box that contains all samples, the box with the
+ * highest priority is split repeatedly at the weighted median of its
+ * longest axis. The priority of a box is its weight multiplied with the
+ * extent of its longest axis.
+ *
+ * @param samples The samples
+ * @param colorCount The requested number of boxes
+ * @returns The index of the box of each sample. Box indices start
+ * with <tt>0</tt> and are contiguous. There are at most
+ * <tt>colorCount</tt> boxes, but less if the samples cannot be
+ * split further. */
+std::vector<int> ColorQuantizer::medianCut(const Samples &samples, int colorCount)
+{
+    const int count = static_cast<int>(samples.weight.size());
+    std::vector<int> indices(static_cast<std::size_t>(count));
+    std::iota(indices.begin(), indices.end(), 0);
+    const double *axes[3] = {samples.lab.l(), samples.lab.a(), samples.lab.b()};
+
+    struct Box {
+        int begin;
+        int end;
+        int axis;
+        double priority;
+    };
+    const auto makeBox = [&](int begin, int end) -> Box {
+        double minimum[3] = {std::numeric_limits<double>::max(), //
+                             std::numeric_limits<double>::max(),
+                             std::numeric_limits<double>::max()};
+        double maximum[3] = {std::numeric_limits<double>::lowest(), //
+                             std::numeric_limits<double>::lowest(),
+                             std::numeric_limits<double>::lowest()};
+        double weightSum = 0;
+        for (int i = begin; i < end; ++i) {
+            const std::size_t index = static_cast<std::size_t>(indices[static_cast<std::size_t>(i)]);
+            for (int axis = 0; axis < 3; ++axis) {
+                minimum[axis] = qMin(minimum[axis], axes[axis][index]);
+                maximum[axis] = qMax(maximum[axis], axes[axis][index]);
+            }
+            weightSum += samples.weight.at(index);
+        }
+        Box box {begin, end, 0, 0};
+        double longestExtent = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (maximum[axis] - minimum[axis] > longestExtent) {
+                longestExtent = maximum[axis] - minimum[axis];
+                box.axis = axis;
+            }
+        }
+        if (end - begin > 1) {
+            box.priority = longestExtent * weightSum;
+        }
+        return box;
+    };
+
+    std::vector<Box> boxes {makeBox(0, count)};
+    while (static_cast<int>(boxes.size()) < colorCount) {
+        const auto boxIterator = std::max_element( //
+            boxes.begin(),
+            boxes.end(),
+            [](const Box &first, const Box &second) {
+                return first.priority < second.priority;
+            });
+        if (boxIterator->priority <= 0) {
+            // No box can be split anymore.
+            break;
+        }
+        const Box box = *boxIterator;
+        const double *values = axes[box.axis];
+        std::sort(indices.begin() + box.begin, //
+                  indices.begin() + box.end,
+                  [values](int first, int second) {
+                      return values[static_cast<std::size_t>(first)] < values[static_cast<std::size_t>(second)];
+                  });
+        double totalWeight = 0;
+        for (int i = box.begin; i < box.end; ++i) {
+            totalWeight += samples.weight.at(static_cast<std::size_t>(indices[static_cast<std::size_t>(i)]));
+        }
+        // Find the weighted median, but make sure that both
+        // new boxes contain at least one sample.
+        double accumulatedWeight = 0;
+        int split = box.begin + 1;
+        for (int i = box.begin; i < box.end - 1; ++i) {
+            accumulatedWeight += samples.weight.at(static_cast<std::size_t>(indices[static_cast<std::size_t>(i)]));
+            split = i + 1;
+            if (accumulatedWeight >= totalWeight / 2) {
+                break;
+            }
+        }
+        *boxIterator = makeBox(box.begin, split);
+        boxes.push_back(makeBox(split, box.end));
+    }
+
+    std::vector<int> assignment(static_cast<std::size_t>(count));
+    for (std::size_t boxIndex = 0; boxIndex < boxes.size(); ++boxIndex) {
+        for (int i = boxes[boxIndex].begin; i < boxes[boxIndex].end; ++i) {
+            assignment[static_cast<std::size_t>(indices[static_cast<std::size_t>(i)])] = static_cast<int>(boxIndex);
+        }
+    }
+    return assignment;
+}
+
+/** @brief Extracts a palette from an image.
+ *
+ * @param image The image. Fully transparent pixels are ignored.
+ * @param colorSpace The color space of the image
+ * @param colorCount The requested number of colors
+ * @returns The palette, sorted by the number of pixels that each
+ * palette color represents (most frequent color first). The colors are
+ * within the gamut of <tt>colorSpace</tt>. The palette can contain less
+ * than <tt>colorCount</tt> colors if the image has less distinct colors.
+ * It is empty if the image is null, <tt>colorSpace</tt> is null or
+ * <tt>colorCount</tt> is smaller than <tt>1</tt>.
+ *
+ * This function is thread-safe. */
+QList<LchDouble> ColorQuantizer::quantize(const QImage &image, const QSharedPointer<RgbColorSpace> &colorSpace, int colorCount)
+{
+    QList<LchDouble> result;
+    if (image.isNull() || colorSpace.isNull() || (colorCount < 1)) {
+        return result;
+    }
+    const Samples samples = samplesFromImage(image, colorSpace);
+    const int count = static_cast<int>(samples.weight.size());
+    if (count < 1) {
+        return result;
+    }
+
+    std::vector<int> assignment = medianCut(samples, colorCount);
+    const int clusterCount = *std::max_element(assignment.begin(), assignment.end()) + 1;
+    std::vector<double> centerL(static_cast<std::size_t>(clusterCount));
+    std::vector<double> centerA(static_cast<std::size_t>(clusterCount));
+    std::vector<double> centerB(static_cast<std::size_t>(clusterCount));
+    std::vector<double> clusterWeight(static_cast<std::size_t>(clusterCount));
+    const int chunks = chunkCount(count, minimumItemsPerChunk);
+    // For each chunk and each cluster: weighted sum of L, a, b and the weight
+    std::vector<std::vector<double>> partialSums(static_cast<std::size_t>(chunks));
+    std::vector<int> partialChanges(static_cast<std::size_t>(chunks));
+
+    // Weighted k-means (Lloyd’s algorithm)
+    for (int iteration = 0; iteration <= maximumIterations; ++iteration) {
+        // Update step: Move each center to the weighted mean of its samples.
+        parallelFor(count, minimumItemsPerChunk, [&](int chunk, int begin, int end) {
+            std::vector<double> &sums = partialSums[static_cast<std::size_t>(chunk)];
+            sums.assign(static_cast<std::size_t>(clusterCount) * 4, 0);
+            for (int i = begin; i < end; ++i) {
+                const std::size_t sample = static_cast<std::size_t>(i);
+                const std::size_t offset = static_cast<std::size_t>(assignment[sample]) * 4;
+                const double weight = samples.weight[sample];
+                sums[offset] += weight * samples.lab.l()[sample];
+                sums[offset + 1] += weight * samples.lab.a()[sample];
+                sums[offset + 2] += weight * samples.lab.b()[sample];
+                sums[offset + 3] += weight;
+            }
+        });
+        for (std::size_t cluster = 0; cluster < static_cast<std::size_t>(clusterCount); ++cluster) {
+            double sumL = 0;
+            double sumA = 0;
+            double sumB = 0;
+            double weight = 0;
+            for (const std::vector<double> &sums : partialSums) {
+                sumL += sums[cluster * 4];
+                sumA += sums[cluster * 4 + 1];
+                sumB += sums[cluster * 4 + 2];
+                weight += sums[cluster * 4 + 3];
+            }
+            clusterWeight[cluster] = weight;
+            if (weight > 0) {
+                centerL[cluster] = sumL / weight;
+                centerA[cluster] = sumA / weight;
+                centerB[cluster] = sumB / weight;
+            }
+        }
+        if (iteration == maximumIterations) {
+            break;
+        }
+
+        // Assignment step: Assign each sample to the nearest center.
+        // The samples are processed in blocks. For each cluster, a
+        // distance pass and a separate minimum pass run over the whole
+        // block. An argmin loop over the clusters would not vectorize;
+        // these passes do: Both have a constant trip count (the tail of
+        // the last block is padded), both work on a single element type
+        // (the cluster index is stored as double) and the minimum pass
+        // uses std::min() instead of a branch.
+        parallelFor(count, minimumItemsPerChunk, [&](int chunk, int begin, int end) {
+            std::array<double, assignmentBlockSize> l;
+            std::array<double, assignmentBlockSize> a;
+            std::array<double, assignmentBlockSize> b;
+            std::array<double, assignmentBlockSize> distance;
+            std::array<double, assignmentBlockSize> nearestDistance;
+            std::array<double, assignmentBlockSize> nearestCluster;
+            int changes = 0;
+            for (int blockBegin = begin; blockBegin < end; blockBegin += assignmentBlockSize) {
+                const int blockCount = qMin(assignmentBlockSize, end - blockBegin);
+                std::copy_n(samples.lab.l() + blockBegin, blockCount, l.begin());
+                std::copy_n(samples.lab.a() + blockBegin, blockCount, a.begin());
+                std::copy_n(samples.lab.b() + blockBegin, blockCount, b.begin());
+                std::fill(l.begin() + blockCount, l.end(), 0);
+                std::fill(a.begin() + blockCount, a.end(), 0);
+                std::fill(b.begin() + blockCount, b.end(), 0);
+                nearestDistance.fill(std::numeric_limits<double>::max());
+                nearestCluster.fill(0);
+                for (int cluster = 0; cluster < clusterCount; ++cluster) {
+                    const std::size_t c = static_cast<std::size_t>(cluster);
+                    const double clusterL = centerL[c];
+                    const double clusterA = centerA[c];
+                    const double clusterB = centerB[c];
+                    const double clusterIndex = cluster;
+                    for (int i = 0; i < assignmentBlockSize; ++i) {
+                        const double deltaL = clusterL - l[i];
+                        const double deltaA = clusterA - a[i];
+                        const double deltaB = clusterB - b[i];
+                        distance[i] = deltaL * deltaL + deltaA * deltaA + deltaB * deltaB;
+                    }
+                    for (int i = 0; i < assignmentBlockSize; ++i) {
+                        const double oldDistance = nearestDistance[i];
+                        nearestCluster[i] = (distance[i] < oldDistance) ? clusterIndex : nearestCluster[i];
+                        nearestDistance[i] = std::min(distance[i], oldDistance);
+                    }
+                }
+                int *const blockAssignment = assignment.data() + blockBegin;
+                for (int i = 0; i < blockCount; ++i) {
+                    const int nearest = static_cast<int>(nearestCluster[i]);
+                    changes += (blockAssignment[i] != nearest) ? 1 : 0;
+                    blockAssignment[i] = nearest;
+                }
+            }
+            partialChanges[static_cast<std::size_t>(chunk)] = changes;
+        });
+        if (std::accumulate(partialChanges.cbegin(), partialChanges.cend(), 0) == 0) {
+            // Converged. The centers correspond already
+            // to the current assignment.
+            break;
+        }
+    }
+
+    // Sort by weight, most frequent color first.
+    std::vector<int> order(static_cast<std::size_t>(clusterCount));
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&clusterWeight](int first, int second) {
+        return clusterWeight[static_cast<std::size_t>(first)] > clusterWeight[static_cast<std::size_t>(second)];
+    });
+    for (const int cluster : order) {
+        const std::size_t c = static_cast<std::size_t>(cluster);
+        if (clusterWeight[c] <= 0) {
+            // Empty clusters do not represent any pixel.
+            continue;
+        }
+        cmsCIELab lab;
+        lab.L = centerL[c];
+        lab.a = centerA[c];
+        lab.b = centerB[c];
+        result.append(colorSpace->nearestInGamutColorByAdjustingChroma(colorSpace->toLch(lab)));
+    }
+    return result;
+}
+
+} // namespace PerceptualColor
@@ -0,0 +1,187 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "colorvisiondeficiencysimulation.h"
+
+#include "displaytransform.h"
+#include "rgbcolorspace.h"
+
+namespace PerceptualColor
+{
+/** @brief The simulation matrix for a given color vision deficiency.
+ *
+ * @param deficiency The color vision deficiency
+ * @returns The matrix to apply on linear sRGB values. For
+ * <tt>ColorVisionDeficiency::none</tt>, this is the identity matrix. */
+const ColorVisionDeficiencySimulation::Matrix &ColorVisionDeficiencySimulation::matrix(AbstractDiagram::ColorVisionDeficiency deficiency)
+{
+    // Machado, Oliveira and Fernandes (2009), severity 1.0
+    static const Matrix protanopia {0.152286, 1.052583, -0.204868, //
+                                    0.114503, 0.786281, 0.099216,
+                                    -0.003882, -0.048116, 1.051998};
+    static const Matrix deuteranopia {0.367322, 0.860646, -0.227968, //
+                                      0.280085, 0.672501, 0.047413,
+                                      -0.011820, 0.042940, 0.968881};
+    static const Matrix tritanopia {1.255528, -0.076749, -0.178779, //
+                                    -0.078411, 0.930809, 0.147602,
+                                    0.004733, 0.691367, 0.303900};
+    static const Matrix identity {1, 0, 0, //
+                                  0, 1, 0,
+                                  0, 0, 1};
+    switch (deficiency) {
+    case AbstractDiagram::ColorVisionDeficiency::protanopia:
+        return protanopia;
+    case AbstractDiagram::ColorVisionDeficiency::deuteranopia:
+        return deuteranopia;
+    case AbstractDiagram::ColorVisionDeficiency::tritanopia:
+        return tritanopia;
+    case AbstractDiagram::ColorVisionDeficiency::none:
+        break;
+    }
+    return identity;
+}
+
+/** @brief Simulates how a color is perceived with a color
+ * vision deficiency.
+ *
+ * @param deficiency The color vision deficiency
+ * @param colorSpace The color space of <tt>color</tt>
+ * @param color The original color
+ * @returns The simulated color. The alpha channel is preserved. If
+ * <tt>deficiency</tt> is <tt>ColorVisionDeficiency::none</tt> or
+ * <tt>color</tt> is invalid, <tt>color</tt> is returned without changes.
+ *
+ * This function is thread-safe. */
+QColor ColorVisionDeficiencySimulation::simulate(AbstractDiagram::ColorVisionDeficiency deficiency, const RgbColorSpace &colorSpace, const QColor &color)
+{
+    if ((deficiency == AbstractDiagram::ColorVisionDeficiency::none) || !color.isValid()) {
+        return color;
+    }
+    QRgb rgb = color.rgb();
+    simulate(deficiency, colorSpace, &rgb, 1);
+    QColor result(rgb);
+    result.setAlpha(color.alpha());
+    return result;
+}
+
+/** @brief Simulates how colors are perceived with a color
+ * vision deficiency (batch processing).
+ *
+ * The values are linearized with table lookups, then the simulation
+ * matrix is applied, and then they are re-encoded with table lookups.
+ *
+ * @param deficiency The color vision deficiency
+ * @param colorSpace The color space of the RGB values. Its transfer
+ * functions are used for linearization and re-encoding.
+ * @param rgb Buffer with <tt>count</tt> values. Values that are
+ * <tt>0</tt> (out-of-gamut for the batch conversions) stay unchanged.
+ * All other values are replaced by the simulated values; their alpha
+ * channel is preserved.
+ * @param count Number of values
+ *
+ * This function is thread-safe. */
+void ColorVisionDeficiencySimulation::simulate(AbstractDiagram::ColorVisionDeficiency deficiency, const RgbColorSpace &colorSpace, QRgb *rgb, int count)
+{
+    if (deficiency == AbstractDiagram::ColorVisionDeficiency::none) {
+        return;
+    }
+    const Matrix &m = matrix(deficiency);
+    // Work on chunks, so that the scratch buffers can live on the stack.
+    std::array<RgbDouble, chunkSize> linear;
+    std::array<QRgb, chunkSize> simulated;
+    for (int begin = 0; begin < count; begin += chunkSize) {
+        const int chunkCount = qMin(chunkSize, count - begin);
+        QRgb *const chunk = rgb + begin;
+        colorSpace.toLinearRgb(chunk, linear.data(), chunkCount);
+        for (int i = 0; i < chunkCount; ++i) {
+            const double red = linear[i].red;
+            const double green = linear[i].green;
+            const double blue = linear[i].blue;
+            linear[i].red = m[0] * red + m[1] * green + m[2] * blue;
+            linear[i].green = m[3] * red + m[4] * green + m[5] * blue;
+            linear[i].blue = m[6] * red + m[7] * green + m[8] * blue;
+        }
+        colorSpace.fromLinearRgb(linear.data(), simulated.data(), chunkCount);
+        for (int i = 0; i < chunkCount; ++i) {
+            if (chunk[i] != 0) {
+                chunk[i] = (chunk[i] & 0xff000000) | (simulated[i] & 0x00ffffff);
+            }
+        }
+    }
+}
+
+/** @brief Simulates a color vision deficiency on a row of an image.
+ *
+ * This is the last stage of the row conversion of the image classes:
+ * The simulation is applied on the 8-bit RGB values of the working
+ * color space that the batch conversion of the row has produced, and
+ * then the values are converted to the display color space (if any).
+ * There is no additional conversion from Lab.
+ *
+ * @param deficiency The color vision deficiency. If it is
+ * <tt>ColorVisionDeficiency::none</tt>, nothing happens.
+ * @param colorSpace The working color space
+ * @param displayTransform The transform to the display color space,
+ * or <tt>nullptr</tt> if the working color space is used directly.
+ * @param rgb Buffer with <tt>count</tt> values of the working color
+ * space. Colors that are <tt>0</tt> (out-of-gamut) stay unchanged. All
+ * other colors are replaced by the simulated opaque colors.
+ * @param workingRgb Buffer with at least <tt>count</tt> values. Its
+ * content is overwritten. It is used only if <tt>displayTransform</tt>
+ * is not <tt>nullptr</tt>. Callers that convert repeatedly (like row by
+ * row) can reuse the same buffer.
+ * @param count Number of values
+ *
+ * This function is thread-safe. */
+void ColorVisionDeficiencySimulation::simulateRow(AbstractDiagram::ColorVisionDeficiency deficiency,
+                                                  const RgbColorSpace &colorSpace,
+                                                  const DisplayTransform *displayTransform,
+                                                  QRgb *rgb,
+                                                  RgbDouble *workingRgb,
+                                                  int count)
+{
+    if (deficiency == AbstractDiagram::ColorVisionDeficiency::none) {
+        return;
+    }
+    simulate(deficiency, colorSpace, rgb, count);
+    if (displayTransform == nullptr) {
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        workingRgb[i].red = qRed(rgb[i]) / 255.0;
+        workingRgb[i].green = qGreen(rgb[i]) / 255.0;
+        workingRgb[i].blue = qBlue(rgb[i]) / 255.0;
+    }
+    // Keeps the entries that are 0.
+    displayTransform->toDisplayQRgb(workingRgb, rgb, count);
+}
+
+} // namespace PerceptualColor
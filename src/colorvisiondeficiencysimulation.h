@@ -0,0 +1,93 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef COLORVISIONDEFICIENCYSIMULATION_H
+#define COLORVISIONDEFICIENCYSIMULATION_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QColor>
+
+#include <array>
+
+#include "PerceptualColor/abstractdiagram.h"
+#include "rgbdouble.h"
+
+namespace PerceptualColor
+{
+class DisplayTransform;
+class RgbColorSpace;
+
+/** @internal
+ *
+ * @brief Simulation of color vision deficiencies.
+ *
+ * The simulation works in linear RGB and uses the matrices
+ * of <a href="https://www.inf.ufrgs.br/~oliveira/pubs_files/CVD_Simulation/CVD_Simulation.html">
+ * Machado, Oliveira and Fernandes (2009)</a> for severity 1.0.
+ *
+ * The image classes (like @ref ChromaHueImage) apply this simulation
+ * on the 8-bit RGB values that their batch conversion of each row has
+ * already produced, and not as a separate pass over the finished image.
+ * Linearization and re-encoding are table lookups with the transfer
+ * functions of the working color space (see
+ * @ref RgbColorSpace::toLinearRgb()). @ref ColorPatch uses the same
+ * functions for its single color.
+ *
+ * @note The matrices are defined for sRGB primaries. For RGB color
+ * spaces with other primaries, the simulation is an approximation. */
+class ColorVisionDeficiencySimulation final
+{
+public:
+    static QColor simulate(AbstractDiagram::ColorVisionDeficiency deficiency, const RgbColorSpace &colorSpace, const QColor &color);
+    static void simulate(AbstractDiagram::ColorVisionDeficiency deficiency, const RgbColorSpace &colorSpace, QRgb *rgb, int count);
+    static void simulateRow(AbstractDiagram::ColorVisionDeficiency deficiency,
+                            const RgbColorSpace &colorSpace,
+                            const DisplayTransform *displayTransform,
+                            QRgb *rgb,
+                            RgbDouble *workingRgb,
+                            int count);
+
+private:
+    /** @brief Delete the constructor to disallow creating an instance
+     * of this class. */
+    ColorVisionDeficiencySimulation() = delete;
+
+    /** @brief A 3×3 matrix, row by row */
+    using Matrix = std::array<double, 9>;
+    /** @brief Number of values that @ref simulate() processes at once */
+    static constexpr int chunkSize = 256;
+
+    static const Matrix &matrix(AbstractDiagram::ColorVisionDeficiency deficiency);
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestColorVisionDeficiencySimulation;
+};
+
+} // namespace PerceptualColor
+
+#endif // COLORVISIONDEFICIENCYSIMULATION_H
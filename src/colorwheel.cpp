@@ -317,7 +317,6 @@ void ColorWheel::keyPressEvent(QKeyEvent *event)
  * @todo Better design (smaller wheel ribbon?) for small widget sizes */
 void ColorWheel::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event);
     // We do not paint directly on the widget, but on a QImage buffer first:
     // Render anti-aliased looks better. But as Qt documentation says:
     //
@@ -336,13 +335,21 @@ void ColorWheel::paintEvent(QPaintEvent *event)
     //       use the platform independent QImage as paint device; i.e. using
     //       QImage will ensure that the result has an identical pixel
     //       representation on any platform.”
-    QImage paintBuffer(maximumPhysicalSquareSize(),        // width
-                       maximumPhysicalSquareSize(),        // height
-                       QImage::Format_ARGB32_Premultiplied // format
-    );
-    paintBuffer.fill(Qt::transparent);
-    paintBuffer.setDevicePixelRatio(devicePixelRatioF());
+    //
+    // The buffer is kept between paint events. Only the annulus
+    // (the wheel ribbon and the focus indicator around) is painted;
+    // the center of the wheel is empty anyway, and within
+    // WheelColorPicker it is covered by a child widget. So both,
+    // the buffer and the widget, are clipped to the annulus.
+    const QSize bufferSize(maximumPhysicalSquareSize(), maximumPhysicalSquareSize());
+    QImage &paintBuffer = d_pointer->m_paintBuffer;
+    if ((paintBuffer.size() != bufferSize) || (paintBuffer.devicePixelRatio() != devicePixelRatioF())) {
+        paintBuffer = QImage(bufferSize, QImage::Format_ARGB32_Premultiplied);
+        paintBuffer.setDevicePixelRatio(devicePixelRatioF());
+    }
+    const QRegion annulus = d_pointer->annulusRegion();
     QPainter bufferPainter(&paintBuffer);
+    bufferPainter.setClipRegion(annulus);
 
     // Paint the color wheel
     bufferPainter.setRenderHint(QPainter::Antialiasing, false);
@@ -352,9 +359,16 @@ void ColorWheel::paintEvent(QPaintEvent *event)
     d_pointer->m_wheelImage.setDevicePixelRatioF(devicePixelRatioF());
     d_pointer->m_wheelImage.setImageSize(maximumPhysicalSquareSize());
     d_pointer->m_wheelImage.setWheelThickness(gradientThickness() * devicePixelRatioF());
+    d_pointer->m_wheelImage.setColorVisionDeficiency(colorVisionDeficiency());
+    d_pointer->m_wheelImage.setDisplayColorSpace(displayColorSpace());
+    // The wheel image covers the whole buffer. Using
+    // CompositionMode_Source, it replaces the content of the previous
+    // paint event, so the buffer does not need to be cleared before.
+    bufferPainter.setCompositionMode(QPainter::CompositionMode_Source);
     bufferPainter.drawImage(QPoint(0, 0),                      // image position (top-left)
                             d_pointer->m_wheelImage.getImage() // the image itself
     );
+    bufferPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
 
     // Paint the handle
     const qreal wheelOuterRadius = maximumWidgetSquareSize() / 2.0 - spaceForFocusIndicator();
@@ -395,6 +409,7 @@ void ColorWheel::paintEvent(QPaintEvent *event)
 
     // Paint the buffer to the actual widget
     QPainter widgetPainter(this);
+    widgetPainter.setClipRegion(annulus.intersected(event->region()));
     widgetPainter.setRenderHint(QPainter::Antialiasing, false);
     widgetPainter.drawImage(QPoint(0, 0), paintBuffer);
 }
@@ -430,7 +445,7 @@ void ColorWheel::setHue(const qreal newHue)
     if (d_pointer->m_hue != newHue) {
         d_pointer->m_hue = newHue;
         Q_EMIT hueChanged(d_pointer->m_hue);
-        update();
+        scheduleRepaint();
     }
 }
 
@@ -508,4 +523,25 @@ qreal ColorWheel::ColorWheelPrivate::innerDiameter() const
         - 2 * q_pointer->spaceForFocusIndicator();
 }
 
+/** @brief The region that is actually painted by @ref paintEvent().
+ *
+ * This is the square of the widget without the empty circle within
+ * the color wheel. The empty circle is reduced by @ref overlap, so that
+ * the anti-aliased inner border of the wheel ribbon is still part of
+ * the region.
+ *
+ * @returns The region that is actually painted by @ref paintEvent(),
+ * measured in <em>device-independant pixels</em>. */
+QRegion ColorWheel::ColorWheelPrivate::annulusRegion() const
+{
+    const int squareSize = qCeil(q_pointer->maximumWidgetSquareSize());
+    const int emptyDiameter = qFloor(innerDiameter()) - 2 * overlap;
+    QRegion result(0, 0, squareSize, squareSize);
+    if (emptyDiameter > 0) {
+        const int emptyOffset = (squareSize - emptyDiameter) / 2;
+        result -= QRegion(emptyOffset, emptyOffset, emptyDiameter, emptyDiameter, QRegion::Ellipse);
+    }
+    return result;
+}
+
 } // namespace PerceptualColor
@@ -37,6 +37,9 @@
 #include "constpropagatingrawpointer.h"
 #include "polarpointf.h"
 
+#include <QImage>
+#include <QRegion>
+
 namespace PerceptualColor
 {
 /** @internal
@@ -71,12 +74,18 @@ public:
      * circular widget, only reacting on mouse events within the circle;
      * this requires this custom implementation. */
     bool m_isMouseEventActive = false;
+    /** @brief Buffer for @ref paintEvent()
+     *
+     * It is kept between paint events to avoid reallocating it on
+     * each repaint. */
+    QImage m_paintBuffer;
     /** @brief Pointer to @ref RgbColorSpace object used to describe the
      * color space. */
     QSharedPointer<RgbColorSpace> m_rgbColorSpace;
     /** @brief The image of the wheel itself. */
     ColorWheelImage m_wheelImage;
 
+    QRegion annulusRegion() const;
     int border() const;
     QPointF fromWheelToWidgetCoordinates(const PolarPointF wheelCoordinates) const;
     PolarPointF fromWidgetToWheelCoordinates(const QPoint widgetCoordinatePoint) const;
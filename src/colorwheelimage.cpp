@@ -31,11 +31,17 @@
 // First the interface, which forces the header to be self-contained.
 #include "colorwheelimage.h"
 
+#include "colorvisiondeficiencysimulation.h"
+#include "gamutcache.h"
 #include "helper.h"
+#include "labbuffer.h"
+#include "lchbuffer.h"
 #include "lchvalues.h"
 #include "polarpointf.h"
+#include "rgbdouble.h"
 
 #include <QPainter>
+#include <QVector>
 #include <QtMath>
 
 namespace PerceptualColor
@@ -149,6 +155,45 @@ void ColorWheelImage::setWheelThickness(const qreal newWheelThickness)
     }
 }
 
+/** @brief Setter for the simulated color vision deficiency.
+ *
+ * If not @ref AbstractDiagram::ColorVisionDeficiency::none, the image is
+ * rendered as it is perceived by people with the given color vision
+ * deficiency.
+ *
+ * @param newColorVisionDeficiency The new color vision deficiency. */
+void ColorWheelImage::setColorVisionDeficiency(const AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency)
+{
+    if (m_colorVisionDeficiency != newColorVisionDeficiency) {
+        m_colorVisionDeficiency = newColorVisionDeficiency;
+        // Free the memory used by the old image and its variants.
+        m_image = QImage();
+        m_variants.clear();
+    }
+}
+
+/** @brief Setter for the display color space.
+ *
+ * The gamut decisions are always made in the color space that was
+ * passed to the constructor. But if a display color space is set, the
+ * RGB values that are written into the image are calculated for the
+ * display color space, using a single fused transform from Lab.
+ * See @ref DisplayTransform for details.
+ *
+ * @param newDisplayColorSpace The new display color space. If
+ * <tt>nullptr</tt> (default), the RGB values of the color space that
+ * was passed to the constructor are written into the image. */
+void ColorWheelImage::setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace)
+{
+    if (m_displayColorSpace != newDisplayColorSpace) {
+        m_displayColorSpace = newDisplayColorSpace;
+        m_displayTransform = DisplayTransform::create(m_rgbColorSpace, m_displayColorSpace);
+        // Free the memory used by the old image and its variants.
+        m_image = QImage();
+        m_variants.clear();
+    }
+}
+
 /** @brief Delivers an image of a color wheel
  *
  * @returns Delivers a square image of a color wheel. Its size
@@ -168,6 +213,12 @@ QImage ColorWheelImage::getImage()
         return m_image;
     }
 
+    // If there is a variant for the current geometry, use it.
+    m_image = m_variants.value(variantKey());
+    if (!m_image.isNull()) {
+        return m_image;
+    }
+
     // If no cache is available (m_image.isNull()), render a new image.
 
     // Special case: zero-size-image
@@ -189,6 +240,7 @@ QImage ColorWheelImage::getImage()
         // we might get a non-transparent pixel in the middle.
         // Set the correct scaling information for the image and return
         m_image.setDevicePixelRatio(m_devicePixelRatioF);
+        m_variants.insert(variantKey(), m_image, QSizeF(m_imageSizePhysical, m_imageSizePhysical) / m_devicePixelRatioF);
         return m_image;
     }
 
@@ -200,7 +252,6 @@ QImage ColorWheelImage::getImage()
     PolarPointF polarCoordinates;
     int x;
     int y;
-    QColor rgbColor;
     LchDouble lch;
     qreal center = (m_imageSizePhysical - 1) / static_cast<qreal>(2);
     m_image = QImage(QSize(m_imageSizePhysical, m_imageSizePhysical), QImage::Format_ARGB32_Premultiplied);
@@ -215,18 +266,53 @@ QImage ColorWheelImage::getImage()
     // artifacts in the anti-aliasing process. So we don't do that.
     const qreal minimumRadial = center - m_wheelThicknessPhysical - m_borderPhysical - overlap;
     const qreal maximumRadial = center - m_borderPhysical + overlap;
+    // Buffers for a single row. The pixels of a row that are within the
+    // wheel are converted with a single batch call.
+    GamutCache &gamutCache = m_rgbColorSpace->gamutCache();
+    LchBuffer rowLch(m_imageSizePhysical);
+    LabBuffer rowLab(m_imageSizePhysical);
+    QVector<int> rowX(m_imageSizePhysical);
+    QVector<QRgb> rowRgb(m_imageSizePhysical);
+    QVector<RgbDouble> rowWorkingRgb(m_imageSizePhysical);
     for (x = 0; x < m_imageSizePhysical; ++x) {
-        for (y = 0; y < m_imageSizePhysical; ++y) {
+        rowLch.l()[x] = lch.l;
+        rowLch.c()[x] = lch.c;
+    }
+    for (y = 0; y < m_imageSizePhysical; ++y) {
+        int rowCount = 0;
+        for (x = 0; x < m_imageSizePhysical; ++x) {
             polarCoordinates = PolarPointF(QPointF(x - center, center - y));
-            if (isInRange<qreal>(minimumRadial, polarCoordinates.radial(), maximumRadial)
-
-            ) {
+            if (isInRange<qreal>(minimumRadial, polarCoordinates.radial(), maximumRadial)) {
                 // We are within the wheel
-                lch.h = polarCoordinates.angleDegree();
-                rgbColor = m_rgbColorSpace->toQColorRgbUnbound(lch);
-                if (rgbColor.isValid()) {
-                    m_image.setPixelColor(x, y, rgbColor);
-                }
+                rowLch.h()[rowCount] = polarCoordinates.angleDegree();
+                rowX[rowCount] = x;
+                ++rowCount;
+            }
+        }
+        if (rowCount == 0) {
+            continue;
+        }
+        gamutCache.toQRgbUnboundFromLch(rowLch.view().slice(0, rowCount), rowRgb.data());
+        if (m_colorVisionDeficiency != AbstractDiagram::ColorVisionDeficiency::none) {
+            // The simulation works on the RGB values of the batch
+            // conversion above and includes the conversion to the
+            // display color space.
+            ColorVisionDeficiencySimulation::simulateRow(m_colorVisionDeficiency,
+                                                         *m_rgbColorSpace,
+                                                         m_displayTransform.data(),
+                                                         rowRgb.data(),
+                                                         rowWorkingRgb.data(),
+                                                         rowCount);
+        } else if (!m_displayTransform.isNull()) {
+            // The gamut decision has been made in the working color space.
+            // The values that are written into the image are calculated
+            // directly from the Lab values.
+            LabBuffer::fromLch(rowLch.view().slice(0, rowCount), rowLab.view().slice(0, rowCount));
+            m_displayTransform->toDisplayQRgb(rowLab.view().slice(0, rowCount), rowRgb.data());
+        }
+        for (int i = 0; i < rowCount; ++i) {
+            if (rowRgb.at(i) != 0) {
+                m_image.setPixelColor(rowX.at(i), y, QColor(rowRgb.at(i)));
             }
         }
     }
@@ -264,7 +350,16 @@ QImage ColorWheelImage::getImage()
 
     // Set the correct scaling information for the image and return
     m_image.setDevicePixelRatio(m_devicePixelRatioF);
+    m_variants.insert(variantKey(), m_image, QSizeF(m_imageSizePhysical, m_imageSizePhysical) / m_devicePixelRatioF);
     return m_image;
 }
 
+/** @brief The key of the current geometry within @ref m_variants.
+ *
+ * @returns The key of the current geometry within @ref m_variants. */
+ColorWheelImage::VariantKey ColorWheelImage::variantKey() const
+{
+    return VariantKey(m_imageSizePhysical, m_borderPhysical, m_wheelThicknessPhysical, m_devicePixelRatioF);
+}
+
 } // namespace PerceptualColor
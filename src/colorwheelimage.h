@@ -34,6 +34,11 @@
 #include <QObject>
 #include <QSharedPointer>
 
+#include <tuple>
+
+#include "PerceptualColor/abstractdiagram.h"
+#include "displaytransform.h"
+#include "imagevariantcache.h"
 #include "rgbcolorspace.h"
 
 namespace PerceptualColor
@@ -64,6 +69,12 @@ namespace PerceptualColor
  *
  * This class supports HiDPI via its @ref setDevicePixelRatioF function.
  *
+ * All properties of this class describe the geometry of the image. Images
+ * that have been rendered for another geometry are retained in a small
+ * variant cache. So when a window is moved back and forth between monitors
+ * with different device pixel ratios, the wheel is rendered only once for
+ * each monitor.
+ *
  * @note Resetting a property to its very same value does not trigger an
  * image calculation. So, if the border is 5, and you call @ref setBorder
  * <tt>(5)</tt>, than this will not trigger an image calculation, but the
@@ -83,7 +94,9 @@ public:
     explicit ColorWheelImage(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace);
     QImage getImage();
     void setBorder(const qreal newBorder);
+    void setColorVisionDeficiency(const AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency);
     void setDevicePixelRatioF(const qreal newDevicePixelRatioF);
+    void setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace);
     void setImageSize(const int newImageSize);
     void setWheelThickness(const qreal newWheelThickness);
 
@@ -93,6 +106,12 @@ private:
     /** @internal @brief Only for unit tests. */
     friend class TestColorWheelImage;
 
+    /** @brief Key for @ref m_variants.
+     *
+     * Image size, border, wheel thickness and device pixel ratio. */
+    using VariantKey = std::tuple<int, qreal, qreal, qreal>;
+    VariantKey variantKey() const;
+
     /** @brief Internal store for the border size, measured in physical pixels.
      *
      * @sa @ref setBorder() */
@@ -101,6 +120,20 @@ private:
      *
      * @sa @ref setDevicePixelRatioF() */
     qreal m_devicePixelRatioF = 1;
+    /** @brief Internal store for the simulated color vision deficiency.
+     *
+     * @sa @ref setColorVisionDeficiency() */
+    AbstractDiagram::ColorVisionDeficiency m_colorVisionDeficiency = AbstractDiagram::ColorVisionDeficiency::none;
+    /** @brief Internal store for the display color space.
+     *
+     * @sa @ref setDisplayColorSpace() */
+    QSharedPointer<PerceptualColor::RgbColorSpace> m_displayColorSpace;
+    /** @brief Transform to @ref m_displayColorSpace.
+     *
+     * <tt>nullptr</tt> if no transform is necessary.
+     *
+     * @sa @ref setDisplayColorSpace() */
+    QSharedPointer<DisplayTransform> m_displayTransform;
     /** @brief Internal storage of the image (cache).
      *
      * - If <tt>m_image.isNull()</tt> than either no cache is available
@@ -116,6 +149,9 @@ private:
     int m_imageSizePhysical = 0;
     /** @brief Pointer to @ref RgbColorSpace object */
     QSharedPointer<PerceptualColor::RgbColorSpace> m_rgbColorSpace;
+    /** @brief Images that have previously been rendered for
+     * another geometry. */
+    ImageVariantCache<VariantKey> m_variants;
     /** @brief Internal store for the image size, measured in physical pixels.
      *
      * @sa @ref setWheelThickness() */
@@ -0,0 +1,408 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own header
+#include "contrastmatrix.h"
+
+#include "labbuffer.h"
+#include "lchbuffer.h"
+#include "rgbcolorspace.h"
+#include "rgbdouble.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace PerceptualColor
+{
+/** @brief Runs a function on a range of rows.
+ *
+ * Helper for @ref ContrastMatrix::parallelRows(). */
+class ContrastMatrix::RowRunnable final : public QRunnable
+{
+public:
+    /** @brief Constructor
+     *
+     * @param function The function to call. The reference must stay valid
+     * until @ref run() has returned.
+     * @param begin First row
+     * @param end Row after the last row */
+    RowRunnable(const std::function<void(int, int)> &function, int begin, int end)
+        : m_function(function)
+        , m_begin(begin)
+        , m_end(end)
+    {
+    }
+
+    /** @brief Calls the function. */
+    void run() override
+    {
+        m_function(m_begin, m_end);
+    }
+
+private:
+    Q_DISABLE_COPY(RowRunnable)
+
+    /** @brief The function to call. */
+    const std::function<void(int, int)> &m_function;
+    /** @brief First row */
+    const int m_begin;
+    /** @brief Row after the last row */
+    const int m_end;
+};
+
+/** @brief Calls a function in parallel for ranges of rows.
+ *
+ * The rows are divided into chunks of (almost) equal size. The function
+ * is called once for each chunk. The calls happen in parallel; this
+ * function returns after all calls have finished.
+ *
+ * @param pool The thread pool. Callers that call this function
+ * repeatedly pass the same pool, so that its threads are reused.
+ * @param rowBegin First row
+ * @param rowEnd Row after the last row
+ * @param columnCount Number of columns, which determines the amount of
+ * work per row.
+ * @param function The function to call. It receives the first row of the
+ * chunk and the row after the last row of the chunk. */
+void ContrastMatrix::parallelRows(QThreadPool *pool, int rowBegin, int rowEnd, int columnCount, const std::function<void(int begin, int end)> &function)
+{
+    const int rowCount = rowEnd - rowBegin;
+    if (rowCount < 1) {
+        return;
+    }
+    const qint64 pairCount = static_cast<qint64>(rowCount) * columnCount;
+    const int chunks = static_cast<int>(qBound<qint64>( //
+        1,
+        pairCount / minimumPairsPerChunk,
+        qMin(rowCount, qMax(1, QThread::idealThreadCount()))));
+    if (chunks == 1) {
+        // No need for the overhead of a thread pool.
+        function(rowBegin, rowEnd);
+        return;
+    }
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        const int begin = rowBegin + rowCount * chunk / chunks;
+        const int end = rowBegin + rowCount * (chunk + 1) / chunks;
+        // The pool takes ownership of the runnable.
+        pool->start(new RowRunnable(function, begin, end));
+    }
+    pool->waitForDone();
+}
+
+/** @brief Luminance of each color of a palette.
+ *
+ * The palette is converted within a single batch call. Out-of-gamut
+ * colors are clipped to the RGB range.
+ *
+ * @param palette The palette
+ * @param colorSpace The color space of the palette
+ * @param wcag If not <tt>nullptr</tt>, receives the relative luminance
+ * as defined by WCAG 2.
+ * @param apca If not <tt>nullptr</tt>, receives the estimated screen
+ * luminance as defined by APCA (before the black level soft clamp). */
+void ContrastMatrix::rgbLuminance(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace, std::vector<double> *wcag, std::vector<double> *apca)
+{
+    const std::size_t count = static_cast<std::size_t>(palette.count());
+    if (wcag != nullptr) {
+        wcag->resize(count);
+    }
+    if (apca != nullptr) {
+        apca->resize(count);
+    }
+    if (count == 0) {
+        return;
+    }
+    const LchBuffer lch = LchBuffer::fromVector(palette);
+    const LabBuffer lab = LabBuffer::fromLch(lch.view());
+    std::vector<RgbDouble> rgb(count);
+    colorSpace->toRgbDoubleUnbound(lab.view(), rgb.data());
+
+    // Linearization of sRGB, as defined by WCAG 2
+    const auto linear = [](double value) {
+        return (value <= 0.03928) //
+            ? value / 12.92
+            : qPow((value + 0.055) / 1.055, 2.4);
+    };
+    for (std::size_t i = 0; i < count; ++i) {
+        const double red = qBound(0.0, rgb[i].red, 1.0);
+        const double green = qBound(0.0, rgb[i].green, 1.0);
+        const double blue = qBound(0.0, rgb[i].blue, 1.0);
+        if (wcag != nullptr) {
+            (*wcag)[i] = 0.2126 * linear(red) //
+                + 0.7152 * linear(green) //
+                + 0.0722 * linear(blue);
+        }
+        if (apca != nullptr) {
+            (*apca)[i] = 0.2126729 * qPow(red, 2.4) //
+                + 0.7151522 * qPow(green, 2.4) //
+                + 0.0721750 * qPow(blue, 2.4);
+        }
+    }
+}
+
+/** @brief Relative luminance of each color of a palette.
+ *
+ * @param palette The palette
+ * @param colorSpace The color space of the palette
+ * @returns The relative luminance as defined by WCAG 2, in the range
+ * <tt>[0, 1]</tt>, for each color of the palette. Out-of-gamut colors
+ * are clipped before. */
+std::vector<double> ContrastMatrix::relativeLuminance(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace)
+{
+    std::vector<double> result;
+    rgbLuminance(palette, colorSpace, &result, nullptr);
+    return result;
+}
+
+/** @brief WCAG 2 contrast ratio.
+ *
+ * @param firstLuminance Relative luminance of the first color
+ * @param secondLuminance Relative luminance of the second color
+ * @returns The contrast ratio. Range: 1 to 21.
+ *
+ * @sa @ref relativeLuminance() */
+double ContrastMatrix::wcagContrastRatio(double firstLuminance, double secondLuminance)
+{
+    const double brighter = qMax(firstLuminance, secondLuminance);
+    const double darker = qMin(firstLuminance, secondLuminance);
+    return (brighter + 0.05) / (darker + 0.05);
+}
+
+/** @brief The black level soft clamp of APCA.
+ *
+ * @param luminance The estimated screen luminance
+ * @returns The clamped luminance */
+double ContrastMatrix::apcaLuminance(double luminance)
+{
+    constexpr double blackThreshold = 0.022;
+    constexpr double blackClamp = 1.414;
+    return (luminance > blackThreshold) //
+        ? luminance
+        : luminance + qPow(blackThreshold - luminance, blackClamp);
+}
+
+/** @brief APCA lightness contrast.
+ *
+ * This is the reference implementation for a single pair, following
+ * APCA-W3 0.0.98G-4g. @ref contrastMatrix() provides the same values
+ * (within float precision) for many pairs.
+ *
+ * @param textLuminance Estimated screen luminance of the text
+ * @param backgroundLuminance Estimated screen luminance of the background
+ * @returns The lightness contrast <em>Lc</em>. See
+ * @ref Metric::ApcaLightnessContrast for details. */
+double ContrastMatrix::apcaLightnessContrast(double textLuminance, double backgroundLuminance)
+{
+    const double text = apcaLuminance(textLuminance);
+    const double background = apcaLuminance(backgroundLuminance);
+    if (qAbs(background - text) < 0.0005) {
+        return 0;
+    }
+    if (background > text) {
+        // Normal polarity: Dark text on light background
+        const double sapc = (qPow(background, 0.56) - qPow(text, 0.57)) * 1.14;
+        return (sapc < 0.1) ? 0 : (sapc - 0.027) * 100;
+    }
+    // Reverse polarity: Light text on dark background
+    const double sapc = (qPow(background, 0.65) - qPow(text, 0.62)) * 1.14;
+    return (sapc > -0.1) ? 0 : (sapc + 0.027) * 100;
+}
+
+/** @brief Per-color terms of a palette.
+ *
+ * @param palette The palette
+ * @param colorSpace The color space of the palette
+ * @returns The per-color terms of both metrics. */
+ContrastMatrix::Terms ContrastMatrix::terms(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace)
+{
+    std::vector<double> wcag;
+    std::vector<double> apca;
+    rgbLuminance(palette, colorSpace, &wcag, &apca);
+    const std::size_t count = wcag.size();
+    Terms result;
+    result.wcagLuminance.resize(count);
+    result.apcaLuminance.resize(count);
+    result.normalText.resize(count);
+    result.normalBackground.resize(count);
+    result.reverseText.resize(count);
+    result.reverseBackground.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const double clamped = apcaLuminance(apca[i]);
+        result.wcagLuminance[i] = static_cast<float>(wcag[i] + 0.05);
+        result.apcaLuminance[i] = static_cast<float>(clamped);
+        result.normalText[i] = static_cast<float>(qPow(clamped, 0.57));
+        result.normalBackground[i] = static_cast<float>(qPow(clamped, 0.56));
+        result.reverseText[i] = static_cast<float>(qPow(clamped, 0.62));
+        result.reverseBackground[i] = static_cast<float>(qPow(clamped, 0.65));
+    }
+    return result;
+}
+
+/** @brief Calculates some rows of the contrast matrix.
+ *
+ * The columns are processed in blocks of @ref blockSize, so that the
+ * per-color terms of the columns stay in the cache while all rows are
+ * processed. The inner loops only combine the precalculated per-color
+ * terms; they do not call any power functions.
+ *
+ * @param terms The per-color terms
+ * @param metric The metric
+ * @param rowBegin First row
+ * @param rowEnd Row after the last row
+ * @param upperTriangleOnly If <tt>true</tt>, only the columns after the
+ * diagonal (<tt>column > row</tt>) are calculated. The other values of
+ * <tt>result</tt> stay untouched.
+ * @param result Receives the rows, in row-major order. The first value
+ * is the first column of <tt>rowBegin</tt>. */
+void ContrastMatrix::calculateRows(const Terms &terms, Metric metric, int rowBegin, int rowEnd, bool upperTriangleOnly, float *result)
+{
+    const int count = static_cast<int>(terms.wcagLuminance.size());
+    const float *const wcagLuminance = terms.wcagLuminance.data();
+    const float *const apcaLuminance = terms.apcaLuminance.data();
+    const float *const normalBackground = terms.normalBackground.data();
+    const float *const reverseBackground = terms.reverseBackground.data();
+    // Blocks that are entirely left of the diagonal can be skipped.
+    const int firstBlock = upperTriangleOnly //
+        ? (rowBegin + 1) / blockSize * blockSize
+        : 0;
+    for (int blockBegin = firstBlock; blockBegin < count; blockBegin += blockSize) {
+        const int columnEnd = qMin(count, blockBegin + blockSize);
+        for (int row = rowBegin; row < rowEnd; ++row) {
+            const int columnBegin = upperTriangleOnly //
+                ? qMax(blockBegin, row + 1)
+                : blockBegin;
+            float *const resultRow = result + static_cast<std::ptrdiff_t>(row - rowBegin) * count;
+            const std::size_t rowIndex = static_cast<std::size_t>(row);
+            if (metric == Metric::WcagContrastRatio) {
+                const float first = wcagLuminance[rowIndex];
+                for (int column = columnBegin; column < columnEnd; ++column) {
+                    const float second = wcagLuminance[column];
+                    resultRow[column] = std::max(first, second) / std::min(first, second);
+                }
+            } else {
+                const float text = terms.apcaLuminance[rowIndex];
+                const float normalText = terms.normalText[rowIndex];
+                const float reverseText = terms.reverseText[rowIndex];
+                for (int column = columnBegin; column < columnEnd; ++column) {
+                    const float background = apcaLuminance[column];
+                    const float normal = (normalBackground[column] - normalText) * 1.14f;
+                    const float reverse = (reverseBackground[column] - reverseText) * 1.14f;
+                    const float sapc = (background > text) ? normal : reverse;
+                    float contrast = (sapc > 0.1f) ? sapc - 0.027f : 0.0f;
+                    contrast = (sapc < -0.1f) ? sapc + 0.027f : contrast;
+                    contrast = (std::abs(background - text) < 0.0005f) ? 0.0f : contrast;
+                    resultRow[column] = contrast * 100;
+                }
+            }
+        }
+    }
+}
+
+/** @brief The contrast of all pairs of colors of a palette.
+ *
+ * @param palette The palette
+ * @param colorSpace The color space of the palette
+ * @param metric The metric
+ * @returns The contrast matrix, in row-major order: The value at
+ * <tt>row * palette.count() + column</tt> is the contrast of the color
+ * <tt>row</tt> (text) and the color <tt>column</tt> (background).
+ *
+ * @note The matrix has <em>N²</em> values. For large palettes, consider
+ * @ref lowContrastPairs(), which does not materialize the matrix. */
+std::vector<float> ContrastMatrix::contrastMatrix(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace, Metric metric)
+{
+    const int count = palette.count();
+    std::vector<float> result(static_cast<std::size_t>(count) * static_cast<std::size_t>(count));
+    const Terms paletteTerms = terms(palette, colorSpace);
+    float *const data = result.data();
+    QThreadPool pool;
+    parallelRows(&pool, 0, count, count, [&](int begin, int end) {
+        calculateRows(paletteTerms, metric, begin, end, false, data + static_cast<std::ptrdiff_t>(begin) * count);
+    });
+    return result;
+}
+
+/** @brief The pairs of colors of a palette with a low contrast.
+ *
+ * The pairs are streamed to a receiver. Only a few rows of the matrix
+ * are calculated at a time, so the memory usage grows only linearly with
+ * the size of the palette.
+ *
+ * @param palette The palette
+ * @param colorSpace The color space of the palette
+ * @param metric The metric
+ * @param threshold Pairs whose contrast is below this threshold are
+ * reported. For @ref Metric::ApcaLightnessContrast, the absolute value
+ * of the contrast is compared.
+ * @param receiver Is called for each pair with a low contrast. It is
+ * called in the thread that calls this function, ordered by rows and
+ * columns. For the symmetric @ref Metric::WcagContrastRatio, each pair is
+ * reported only once (with <tt>text < background</tt>); for
+ * @ref Metric::ApcaLightnessContrast, both orders are reported. A color
+ * is never paired with itself. */
+void ContrastMatrix::lowContrastPairs(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace, Metric metric, double threshold, const PairReceiver &receiver)
+{
+    const int count = palette.count();
+    const Terms paletteTerms = terms(palette, colorSpace);
+    const bool isSymmetric = (metric == Metric::WcagContrastRatio);
+    const float floatThreshold = static_cast<float>(threshold);
+    std::vector<float> rows(static_cast<std::size_t>(qMin(count, rowsPerRound)) * static_cast<std::size_t>(count));
+    float *const data = rows.data();
+    // A single pool for all rounds, so that the threads are reused.
+    QThreadPool pool;
+    for (int roundBegin = 0; roundBegin < count; roundBegin += rowsPerRound) {
+        const int roundEnd = qMin(count, roundBegin + rowsPerRound);
+        // For the symmetric metric, only the upper triangle is needed.
+        const int columnCount = isSymmetric ? count - roundBegin : count;
+        parallelRows(&pool, roundBegin, roundEnd, columnCount, [&](int begin, int end) {
+            calculateRows(paletteTerms, //
+                          metric,
+                          begin,
+                          end,
+                          isSymmetric,
+                          data + static_cast<std::ptrdiff_t>(begin - roundBegin) * count);
+        });
+        for (int row = roundBegin; row < roundEnd; ++row) {
+            const float *const resultRow = data + static_cast<std::ptrdiff_t>(row - roundBegin) * count;
+            for (int column = isSymmetric ? row + 1 : 0; column < count; ++column) {
+                const float contrast = resultRow[column];
+                if ((std::abs(contrast) < floatThreshold) && (column != row)) {
+                    receiver(row, column, static_cast<double>(contrast));
+                }
+            }
+        }
+    }
+}
+
+} // namespace PerceptualColor
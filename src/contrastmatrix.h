@@ -0,0 +1,154 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CONTRASTMATRIX_H
+#define CONTRASTMATRIX_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+
+#include <functional>
+#include <vector>
+
+#include "PerceptualColor/lchdouble.h"
+
+namespace PerceptualColor
+{
+class RgbColorSpace;
+
+/** @internal
+ *
+ * @brief Pairwise contrast of all colors of a palette.
+ *
+ * For accessibility audits, the contrast of each pair of colors of a
+ * palette is needed. For palettes of a few thousand colors, these are
+ * millions of pairs. Therefore:
+ *
+ * 1. The palette is converted to RGB within a single batch call of
+ *    @ref RgbColorSpace::toRgbDoubleUnbound(). Out-of-gamut colors are
+ *    clipped, like @ref RgbColorSpace::toQColorRgbBound() does. All
+ *    per-color terms (luminance, powers) are calculated only once.
+ * 2. The per-color terms are stored as structure-of-arrays. The
+ *    pairwise loop only combines them with some basic arithmetic.
+ * 3. The matrix is calculated in blocks of columns, so that the data of
+ *    the columns stays in the cache while the rows are processed.
+ * 4. Rows are distributed over multiple threads.
+ *
+ * Both, WCAG 2 and APCA, are defined for sRGB. The RGB values of the
+ * color space are interpreted as sRGB values, just like the results of
+ * @ref RgbColorSpace::toQColorRgbBound() usually are. So the results are
+ * conformant if the color space is sRGB.
+ *
+ * Example:
+ * @snippet test/testcontrastmatrix.cpp Use ContrastMatrix */
+struct ContrastMatrix final {
+public:
+    /** @brief Contrast metrics. */
+    enum class Metric {
+        /** @brief Contrast ratio of
+         * <a href="https://www.w3.org/TR/WCAG21/#dfn-contrast-ratio">WCAG
+         * 2</a>.
+         *
+         * Range: 1 (no contrast) to 21 (black and white). Symmetric. */
+        WcagContrastRatio,
+        /** @brief Lightness contrast <em>Lc</em> of
+         * <a href="https://github.com/Myndex/apca-w3">APCA</a>
+         * (version 0.0.98G-4g).
+         *
+         * Range: About -108 to 106. Positive for dark text on light
+         * background, negative for light text on dark background, 0 for
+         * no contrast. <em>Not</em> symmetric: The first color is the
+         * text, the second one the background. */
+        ApcaLightnessContrast
+    };
+
+    /** @brief Receiver for @ref lowContrastPairs().
+     *
+     * Parameters: Index of the text color, index of the background
+     * color, contrast. */
+    using PairReceiver = std::function<void(int text, int background, double contrast)>;
+
+    static double apcaLightnessContrast(double textLuminance, double backgroundLuminance);
+    static std::vector<float> contrastMatrix(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace, Metric metric);
+    static void lowContrastPairs(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace, Metric metric, double threshold, const PairReceiver &receiver);
+    static std::vector<double> relativeLuminance(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace);
+    static double wcagContrastRatio(double firstLuminance, double secondLuminance);
+
+private:
+    /** @brief Delete the constructor to disallow creating an instance
+     * of this class. */
+    ContrastMatrix() = delete;
+
+    /** @brief Number of columns of a cache block.
+     *
+     * The per-color terms of these columns (a few kilobytes) fit easily
+     * into the L1 cache. */
+    static constexpr int blockSize = 512;
+    /** @brief Minimum number of pairs that justifies an additional
+     * thread. */
+    static constexpr qint64 minimumPairsPerChunk = 65536;
+    /** @brief Number of rows that @ref lowContrastPairs() calculates
+     * before passing the results to the receiver. */
+    static constexpr int rowsPerRound = 64;
+
+    /** @brief Per-color terms of a palette, stored as
+     * structure-of-arrays.
+     *
+     * All vectors have the same size: The number of colors. */
+    struct Terms {
+        /** @brief WCAG: Relative luminance + 0.05 */
+        std::vector<float> wcagLuminance;
+        /** @brief APCA: Luminance after the black level soft clamp */
+        std::vector<float> apcaLuminance;
+        /** @brief APCA: Text luminance ^ 0.57 (normal polarity) */
+        std::vector<float> normalText;
+        /** @brief APCA: Background luminance ^ 0.56 (normal polarity) */
+        std::vector<float> normalBackground;
+        /** @brief APCA: Text luminance ^ 0.62 (reverse polarity) */
+        std::vector<float> reverseText;
+        /** @brief APCA: Background luminance ^ 0.65 (reverse polarity) */
+        std::vector<float> reverseBackground;
+    };
+
+    class RowRunnable;
+
+    static double apcaLuminance(double luminance);
+    static void calculateRows(const Terms &terms, Metric metric, int rowBegin, int rowEnd, bool upperTriangleOnly, float *result);
+    static void parallelRows(QThreadPool *pool, int rowBegin, int rowEnd, int columnCount, const std::function<void(int begin, int end)> &function);
+    static void rgbLuminance(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace, std::vector<double> *wcag, std::vector<double> *apca);
+    static Terms terms(const QVector<LchDouble> &palette, const QSharedPointer<RgbColorSpace> &colorSpace);
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestContrastMatrix;
+};
+
+} // namespace PerceptualColor
+
+#endif // CONTRASTMATRIX_H
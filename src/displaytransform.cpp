@@ -0,0 +1,240 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "displaytransform.h"
+
+#include "helper.h"
+#include "rgbcolorspace.h"
+
+namespace PerceptualColor
+{
+/** @brief Creates a transform to the display color space.
+ *
+ * @param workingColorSpace The working color space. It is used by the
+ * caller for the gamut decisions. The transforms are created within its
+ * LittleCMS context, and the returned object keeps a reference to it.
+ * @param displayColorSpace The color space of the display.
+ *
+ * @returns A transform from Lab to <tt>displayColorSpace</tt>, or
+ * <tt>nullptr</tt> if no transform is possible or necessary (one of the
+ * color spaces is <tt>nullptr</tt>, or both have the same profile) or if
+ * the transform could not be created.
+ * In both cases, the caller should use the RGB values of the working
+ * color space directly. */
+QSharedPointer<DisplayTransform> DisplayTransform::create(const QSharedPointer<RgbColorSpace> &workingColorSpace, const QSharedPointer<RgbColorSpace> &displayColorSpace)
+{
+    if (workingColorSpace.isNull() || displayColorSpace.isNull()) {
+        return nullptr;
+    }
+    const QByteArray displayProfileData = displayColorSpace->profileData();
+    if (displayProfileData.isEmpty()) {
+        return nullptr;
+    }
+    const QByteArray workingProfileData = workingColorSpace->profileData();
+    if (workingProfileData == displayProfileData) {
+        return nullptr;
+    }
+
+    // The transforms are created within the context of the working color
+    // space, like all the other transforms of this library.
+    const cmsContext context = workingColorSpace->context();
+    cmsHPROFILE displayProfileHandle = cmsOpenProfileFromMemTHR( //
+        context,
+        displayProfileData.constData(),
+        static_cast<cmsUInt32Number>(displayProfileData.size()));
+    if (displayProfileHandle == nullptr) {
+        return nullptr;
+    }
+    // Same white point as the Lab profile of RgbColorSpace (D50).
+    cmsHPROFILE labProfileHandle = cmsCreateLab4ProfileTHR(context, nullptr);
+    QSharedPointer<DisplayTransform> result {new DisplayTransform()};
+    result->m_workingColorSpace = workingColorSpace;
+    // Same rendering intent as the transforms of RgbColorSpace. The
+    // integer output clips colors that are out of the display gamut,
+    // which is what the display would do anyway. cmsFLAGS_NOCACHE makes
+    // the transforms thread-safe.
+    result->m_transformLabToDisplayHandle = cmsCreateTransformTHR( //
+        context,                                                   // LittleCMS context
+        labProfileHandle,                                          // input profile handle
+        TYPE_Lab_DBL,                                              // input buffer format
+        displayProfileHandle,                                      // output profile handle
+        TYPE_RGB_16,                                               // output buffer format
+        INTENT_ABSOLUTE_COLORIMETRIC,                              // rendering intent
+        cmsFLAGS_NOCACHE                                           // flags
+    );
+    result->m_transformLabPlanarToDisplayHandle = cmsCreateTransformTHR( //
+        context,                                                         // LittleCMS context
+        labProfileHandle,                                                // input profile handle
+        typeLabDoublePlanar,                                             // input buffer format
+        displayProfileHandle,                                            // output profile handle
+        typeQRgb,                                                        // output buffer format
+        INTENT_ABSOLUTE_COLORIMETRIC,                                    // rendering intent
+        cmsFLAGS_NOCACHE                                                 // flags
+    );
+    cmsHPROFILE workingProfileHandle = workingProfileData.isEmpty() //
+        ? nullptr
+        : cmsOpenProfileFromMemTHR(context, //
+                                   workingProfileData.constData(),
+                                   static_cast<cmsUInt32Number>(workingProfileData.size()));
+    if (workingProfileHandle != nullptr) {
+        result->m_transformRgbToDisplayHandle = cmsCreateTransformTHR( //
+            context,                                                   // LittleCMS context
+            workingProfileHandle,                                      // input profile handle
+            TYPE_RGB_DBL,                                              // input buffer format
+            displayProfileHandle,                                      // output profile handle
+            typeQRgb,                                                  // output buffer format
+            INTENT_ABSOLUTE_COLORIMETRIC,                              // rendering intent
+            cmsFLAGS_NOCACHE                                           // flags
+        );
+        cmsCloseProfile(workingProfileHandle);
+    }
+    // It is mandatory to close the profiles to prevent memory leaks:
+    cmsCloseProfile(labProfileHandle);
+    cmsCloseProfile(displayProfileHandle);
+    if ((result->m_transformLabToDisplayHandle == nullptr) //
+        || (result->m_transformLabPlanarToDisplayHandle == nullptr) //
+        || (result->m_transformRgbToDisplayHandle == nullptr) //
+    ) {
+        // The destructor deletes the transforms that have been created.
+        return nullptr;
+    }
+    return result;
+}
+
+/** @brief Destructor */
+DisplayTransform::~DisplayTransform() noexcept
+{
+    // The transforms are deleted before m_workingColorSpace, which
+    // owns their context.
+    for (cmsHTRANSFORM handle : {m_transformLabToDisplayHandle, //
+                                 m_transformLabPlanarToDisplayHandle,
+                                 m_transformRgbToDisplayHandle}) {
+        if (handle != nullptr) {
+            cmsDeleteTransform(handle);
+        }
+    }
+}
+
+/** @brief Converts a color to the display color space.
+ *
+ * @param lab The color to convert
+ * @returns The color in the display color space. Colors that are
+ * out-of-gamut for the display are clipped. */
+QColor DisplayTransform::toDisplayColor(const cmsCIELab &lab) const
+{
+    cmsUInt16Number rgb[3];
+    cmsDoTransform(m_transformLabToDisplayHandle, &lab, rgb, 1);
+    return QColor(QRgba64::fromRgba64(rgb[0], rgb[1], rgb[2], 0xFFFF));
+}
+
+/** @brief Converts a color to the display color space.
+ *
+ * @param lch The color to convert
+ * @returns The color in the display color space. Colors that are
+ * out-of-gamut for the display are clipped. */
+QColor DisplayTransform::toDisplayColor(const LchDouble &lch) const
+{
+    cmsCIELab lab;
+    const cmsCIELCh myCmsCieLch = toCmsCieLch(lch);
+    cmsLCh2Lab(&lab, &myCmsCieLch);
+    return toDisplayColor(lab);
+}
+
+/** @brief Converts a row of colors to the display color space
+ * (batch processing).
+ *
+ * The whole row is converted with a single call to LittleCMS, reading
+ * directly from the planar buffer.
+ *
+ * @param lab View to a @ref LabBuffer (or a slice of it)
+ * @param rgb Buffer with <tt>lab.count()</tt> values, typically filled
+ * before by the batch functions of the working color space. Colors
+ * that are <tt>0</tt> (out-of-gamut in the working color space) stay
+ * unchanged. All other colors are replaced by the opaque display
+ * color. Colors that are out-of-gamut for the display are clipped. */
+void DisplayTransform::toDisplayQRgb(PlanarView<const double> lab, QRgb *rgb) const
+{
+    const int count = lab.count();
+    if (count < 1) {
+        return;
+    }
+    const cmsUInt32Number cmsCount = static_cast<cmsUInt32Number>(count);
+    // The alpha channel is not touched by the transform, so it still
+    // tells which colors are out-of-gamut in the working color space.
+    cmsDoTransformLineStride(m_transformLabPlanarToDisplayHandle, // handle to transform function
+                             lab.plane(0),                        // input
+                             rgb,                                 // output
+                             cmsCount,                            // pixels per line
+                             1,                                   // line count
+                             cmsCount * sizeof(double),           // bytes per line (input)
+                             cmsCount * sizeof(QRgb),             // bytes per line (output)
+                             static_cast<cmsUInt32Number>(lab.planeStride() * sizeof(double)), // bytes per plane (input)
+                             0                                    // bytes per plane (output, chunky)
+    );
+    for (int i = 0; i < count; ++i) {
+        if (qAlpha(rgb[i]) == 0) {
+            rgb[i] = 0;
+        }
+    }
+}
+
+/** @brief Converts a row of colors from the working color space to
+ * the display color space (batch processing).
+ *
+ * The whole row is converted with a single call to LittleCMS.
+ *
+ * @param workingRgb Buffer with <tt>count</tt> RGB values of the working
+ * color space, for example from @ref RgbColorSpace::toRgbDoubleBound().
+ * @param rgb Buffer with <tt>count</tt> values. Like for
+ * @ref toDisplayQRgb(PlanarView<const double>, QRgb *) const, colors
+ * that are <tt>0</tt> stay unchanged. All other colors are replaced by
+ * the opaque display color. Colors that are out-of-gamut for the
+ * display are clipped.
+ * @param count Number of colors */
+void DisplayTransform::toDisplayQRgb(const RgbDouble *workingRgb, QRgb *rgb, int count) const
+{
+    if (count < 1) {
+        return;
+    }
+    // The alpha channel is not touched by the transform, so it still
+    // tells which colors are out-of-gamut in the working color space.
+    cmsDoTransform(m_transformRgbToDisplayHandle, // handle to transform function
+                   workingRgb,                    // input
+                   rgb,                           // output
+                   static_cast<cmsUInt32Number>(count));
+    for (int i = 0; i < count; ++i) {
+        rgb[i] = (qAlpha(rgb[i]) == 0) //
+            ? 0
+            : qRgb(qRed(rgb[i]), qGreen(rgb[i]), qBlue(rgb[i]));
+    }
+}
+
+} // namespace PerceptualColor
@@ -0,0 +1,125 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DISPLAYTRANSFORM_H
+#define DISPLAYTRANSFORM_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QColor>
+#include <QSharedPointer>
+
+#include "PerceptualColor/lchdouble.h"
+#include "planarbuffer.h"
+#include "rgbdouble.h"
+
+#include <lcms2.h>
+
+namespace PerceptualColor
+{
+class RgbColorSpace;
+
+/** @internal
+ *
+ * @brief Fused transform from Lab to the color space of the display.
+ *
+ * The diagrams of this library work within a <em>working</em> color
+ * space: This color space decides which colors are in-gamut and
+ * therefore painted. However, the resulting RGB values are written into
+ * <tt>QImage</tt> objects, and these are interpreted by the compositor
+ * as values in the color space of the <em>display</em> (usually sRGB).
+ * If the working color space is not the display color space (for
+ * example WideGamutRGB), the colors on the screen are wrong.
+ *
+ * Converting the working-space RGB values afterwards to the display
+ * color space would need a second transform per pixel and would add
+ * rounding errors. This class instead provides a single transform from
+ * Lab directly to the display color space. The image classes keep using
+ * the working color space for the gamut decision and use this transform
+ * only to calculate the RGB values that are actually written into the
+ * image, within the same loop over the pixels.
+ *
+ * For whole rows of pixels, there are batch functions that convert the
+ * row with a single call, either from the planar Lab buffer (for colors
+ * within the working gamut) or from RGB values of the working color
+ * space (for colors that have been clipped to the working gamut).
+ *
+ * @snippet test/testdisplaytransform.cpp Use DisplayTransform
+ *
+ * This class is thread-safe. */
+class DisplayTransform final
+{
+public:
+    static QSharedPointer<DisplayTransform> create(const QSharedPointer<PerceptualColor::RgbColorSpace> &workingColorSpace,
+                                                   const QSharedPointer<PerceptualColor::RgbColorSpace> &displayColorSpace);
+    ~DisplayTransform() noexcept;
+    QColor toDisplayColor(const cmsCIELab &lab) const;
+    QColor toDisplayColor(const LchDouble &lch) const;
+    void toDisplayQRgb(PlanarView<const double> lab, QRgb *rgb) const;
+    void toDisplayQRgb(const RgbDouble *workingRgb, QRgb *rgb, int count) const;
+
+private:
+    Q_DISABLE_COPY(DisplayTransform)
+
+    /** @brief Private constructor.
+     *
+     * Use @ref create() to get objects of this class. */
+    DisplayTransform() = default;
+
+    /** @brief The working color space.
+     *
+     * The transforms are created within its LittleCMS context, so it
+     * must live at least as long as the transforms. */
+    QSharedPointer<PerceptualColor::RgbColorSpace> m_workingColorSpace;
+    /** @brief Transform from Lab to the display color space. */
+    cmsHTRANSFORM m_transformLabToDisplayHandle = nullptr;
+    /** @brief Like @ref m_transformLabToDisplayHandle, but from a planar
+     * Lab buffer to <tt>QRgb</tt>. */
+    cmsHTRANSFORM m_transformLabPlanarToDisplayHandle = nullptr;
+    /** @brief Transform from the working color space to the display
+     * color space, with <tt>QRgb</tt> output. */
+    cmsHTRANSFORM m_transformRgbToDisplayHandle = nullptr;
+    /** @brief LittleCMS buffer format for @ref LabBuffer
+     *
+     * Like <tt>TYPE_Lab_DBL</tt>, but planar. */
+    static constexpr cmsUInt32Number typeLabDoublePlanar = TYPE_Lab_DBL | PLANAR_SH(1);
+    /** @brief LittleCMS buffer format for <tt>QRgb</tt>
+     *
+     * The alpha channel is not touched by the transforms. */
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    static constexpr cmsUInt32Number typeQRgb = TYPE_BGRA_8;
+#else
+    static constexpr cmsUInt32Number typeQRgb = TYPE_ARGB_8;
+#endif
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestDisplayTransform;
+};
+
+} // namespace PerceptualColor
+
+#endif // DISPLAYTRANSFORM_H
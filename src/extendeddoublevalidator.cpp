@@ -81,8 +81,11 @@ QString ExtendedDoubleValidator::suffix() const
 
 QValidator::State ExtendedDoubleValidator::validate(QString &input, int &pos) const
 {
-    QString myInput = input;
-    int myPos = pos;
+    // This function is called on each key stroke. It works therefore
+    // on QStringView and avoids temporary allocations.
+    const QStringView myInput {input};
+    int numberPosition = 0;
+    int numberLength = input.size();
 
     // IF (m_prefix.isEmpty && !m_prefix.isNull)
     // THEN input.startsWith(m_prefix)
@@ -99,26 +102,38 @@ QValidator::State ExtendedDoubleValidator::validate(QString &input, int &pos) co
     // This is apparently wrong (at least for Qt 5).
     if (!d_pointer->m_prefix.isEmpty()) {
         if (myInput.startsWith(d_pointer->m_prefix)) {
-            myInput.remove(0, d_pointer->m_prefix.size());
-            myPos -= d_pointer->m_prefix.size();
+            numberPosition = d_pointer->m_prefix.size();
+            numberLength -= d_pointer->m_prefix.size();
         } else {
             return QValidator::State::Invalid;
         }
     }
     if (!d_pointer->m_suffix.isEmpty()) {
-        if (myInput.endsWith(d_pointer->m_suffix)) {
-            myInput.chop(d_pointer->m_suffix.size());
+        if (myInput.mid(numberPosition).endsWith(d_pointer->m_suffix)) {
+            numberLength -= d_pointer->m_suffix.size();
         } else {
             return QValidator::State::Invalid;
         }
     }
+    const QStringView number = myInput.mid(numberPosition, numberLength);
 
-    QValidator::State result = QDoubleValidator::validate(myInput, myPos);
+    // QDoubleValidator::validate() needs a QString. We reuse the
+    // capacity of a buffer, so that no memory allocation happens
+    // once the buffer is big enough.
+    QString &buffer = d_pointer->m_validationBuffer;
+    buffer.setUnicode(number.data(), numberLength);
+    int myPos = pos - numberPosition;
+
+    QValidator::State result = QDoubleValidator::validate(buffer, myPos);
     // Following the Qt documentation, QDoubleValidator::validate() is allowed
     // and intended to make changes the arguments passed by reference. We
     // have to write back these changes also in this reimplemented function.
-    input = d_pointer->m_prefix + myInput + d_pointer->m_suffix;
-    pos = myPos + d_pointer->m_prefix.size();
+    // As this happens rarely, the input is modified in-place and only
+    // if necessary.
+    if (number.compare(buffer) != 0) {
+        input.replace(numberPosition, numberLength, buffer);
+    }
+    pos = myPos + numberPosition;
 
     return result;
 }
@@ -56,6 +56,13 @@ public:
     QString m_prefix;
     /** @brief Internal storage for property @ref suffix */
     QString m_suffix;
+    /** @brief Buffer for @ref ExtendedDoubleValidator::validate()
+     *
+     * The number part of the input is copied into this buffer before
+     * it is passed to <tt>QDoubleValidator::validate()</tt>. Reusing the
+     * buffer (and its capacity) avoids a memory allocation on each
+     * key stroke. */
+    mutable QString m_validationBuffer;
 
 private:
     Q_DISABLE_COPY(ExtendedDoubleValidatorPrivate)
@@ -0,0 +1,341 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "gamutboundary.h"
+
+#include "PerceptualColor/lchdouble.h"
+#include "helper.h"
+#include "labbuffer.h"
+#include "rgbcolorspace.h"
+#include "rgbdouble.h"
+
+#include <QtMath>
+
+#include <cmath>
+
+namespace PerceptualColor
+{
+/** @brief Constructor
+ *
+ * Calculates the table.
+ *
+ * @param colorSpace The color space. Must stay valid during the live
+ * time of this object.
+ * @param blackpointL The darkest in-gamut point on the L* axis
+ * @param whitepointL The lightest in-gamut point on the L* axis */
+GamutBoundary::GamutBoundary(const RgbColorSpace *colorSpace, qreal blackpointL, qreal whitepointL)
+    : m_blackpointL(blackpointL)
+    , m_colorSpace(colorSpace)
+    , m_whitepointL(whitepointL)
+{
+    buildTable();
+}
+
+/** @brief Calculates @ref m_table.
+ *
+ * All grid points run through the same bisection at the same time.
+ * Each step of the bisection is a single batch call to LittleCMS. */
+void GamutBoundary::buildTable()
+{
+    const int count = lightnessCount * hueCount;
+    const double maximumChroma = m_colorSpace->maximumChroma();
+    QVector<double> cosine(hueCount);
+    QVector<double> sine(hueCount);
+    for (int h = 0; h < hueCount; ++h) {
+        const double hueRadian = qDegreesToRadians(static_cast<double>(h) / resolution);
+        cosine[h] = std::cos(hueRadian);
+        sine[h] = std::sin(hueRadian);
+    }
+    LabBuffer lab(count);
+    for (int l = 0; l < lightnessCount; ++l) {
+        for (int h = 0; h < hueCount; ++h) {
+            lab.l()[l * hueCount + h] = static_cast<double>(l) / resolution;
+        }
+    }
+    QVector<RgbDouble> rgb(count);
+    QVector<bool> isInGamut(count);
+    // Converts the given chroma values and writes the result
+    // to isInGamut.
+    auto testChroma = [&](const QVector<double> &chroma) {
+        for (int i = 0; i < count; ++i) {
+            const int h = i % hueCount;
+            lab.a()[i] = chroma.at(i) * cosine.at(h);
+            lab.b()[i] = chroma.at(i) * sine.at(h);
+        }
+        m_colorSpace->toRgbDoubleUnbound(lab.view(), rgb.data());
+        m_colorSpace->isInGamut(lab.view(), rgb.constData(), isInGamut.data());
+    };
+
+    QVector<double> lower(count, 0);
+    QVector<double> upper(count, maximumChroma);
+
+    // Gray axis
+    testChroma(lower);
+    const QVector<bool> isGrayInGamut = isInGamut;
+
+    // Bisection
+    testChroma(upper);
+    for (int i = 0; i < count; ++i) {
+        if (isInGamut.at(i)) {
+            // Even the maximum chroma is in-gamut.
+            lower[i] = maximumChroma;
+        }
+    }
+    QVector<double> candidate(count);
+    for (double width = maximumChroma; width > gamutPrecision; width /= 2) {
+        for (int i = 0; i < count; ++i) {
+            candidate[i] = (lower.at(i) + upper.at(i)) / 2;
+        }
+        testChroma(candidate);
+        for (int i = 0; i < count; ++i) {
+            if (isInGamut.at(i)) {
+                lower[i] = candidate.at(i);
+            } else {
+                upper[i] = candidate.at(i);
+            }
+        }
+    }
+
+    m_table.resize(count);
+    for (int i = 0; i < count; ++i) {
+        m_table[i] = isGrayInGamut.at(i) ? lower.at(i) : -1;
+    }
+}
+
+/** @brief Normalizes a hue.
+ *
+ * @param hue The hue
+ * @returns The normalized hue, within the range <tt>[0, 360[</tt> */
+qreal GamutBoundary::normalizedHue(qreal hue)
+{
+    qreal result = std::fmod(hue, 360);
+    if (result < 0) {
+        result += 360;
+    }
+    return result;
+}
+
+/** @brief Table value, interpolated linearly on the hue axis.
+ *
+ * @param lightnessIndex Index on the lightness axis
+ * @param hue0 Lower index on the hue axis
+ * @param hue1 Upper index on the hue axis
+ * @param hueWeight Weight of the upper index
+ * @returns The interpolated table value. */
+qreal GamutBoundary::interpolatedValue(int lightnessIndex, int hue0, int hue1, qreal hueWeight) const
+{
+    const double *row = m_table.constData() + lightnessIndex * hueCount;
+    return row[hue0] + hueWeight * (row[hue1] - row[hue0]);
+}
+
+/** @brief The maximum in-gamut chroma.
+ *
+ * The value is interpolated from the table. This function does not
+ * call LittleCMS.
+ *
+ * @param lightness The lightness
+ * @param hue The hue. Values outside of the range <tt>[0, 360[</tt>
+ * are normalized.
+ * @returns The maximum chroma that is in-gamut for the given lightness
+ * and hue. <tt>0</tt> if even the gray color of this lightness is
+ * out-of-gamut. */
+qreal GamutBoundary::maximumChroma(qreal lightness, qreal hue) const
+{
+    if (!isInRange(m_blackpointL, lightness, m_whitepointL)) {
+        return 0;
+    }
+    const qreal lightnessPosition = lightness * resolution;
+    const int l0 = qBound(0, qFloor(lightnessPosition), lightnessCount - 2);
+    const qreal lightnessWeight = lightnessPosition - l0;
+    const qreal huePosition = normalizedHue(hue) * resolution;
+    const int h0 = qMin(qFloor(huePosition), hueCount - 1);
+    const int h1 = (h0 + 1) % hueCount; // The hue axis is circular.
+    const qreal hueWeight = huePosition - h0;
+    const qreal lowerValue = interpolatedValue(l0, h0, h1, hueWeight);
+    const qreal upperValue = interpolatedValue(l0 + 1, h0, h1, hueWeight);
+    return qMax<qreal>(lowerValue + lightnessWeight * (upperValue - lowerValue), 0);
+}
+
+/** @brief The maximum in-gamut chroma with a given precision.
+ *
+ * The table value is used as start value for a bisection with
+ * exact in-gamut tests.
+ *
+ * @param lightness The lightness
+ * @param hue The hue. Values outside of the range <tt>[0, 360[</tt>
+ * are normalized.
+ * @param precision The precision of the result
+ * @returns The maximum chroma that is in-gamut for the given lightness
+ * and hue. <tt>0</tt> if even the gray color of this lightness is
+ * out-of-gamut. The return value itself is in-gamut. */
+qreal GamutBoundary::maximumChroma(qreal lightness, qreal hue, qreal precision) const
+{
+    if (!isInRange(m_blackpointL, lightness, m_whitepointL)) {
+        return 0;
+    }
+    const qreal chromaLimit = m_colorSpace->maximumChroma();
+    const qreal estimate = maximumChroma(lightness, hue);
+    LchDouble candidate;
+    candidate.l = lightness;
+    candidate.h = normalizedHue(hue);
+
+    // Find an in-gamut lower bound.
+    qreal step = 1.0 / resolution;
+    qreal lower = qMax<qreal>(estimate - step, 0);
+    candidate.c = lower;
+    while (!m_colorSpace->isInGamut(candidate)) {
+        if (lower <= 0) {
+            return 0;
+        }
+        step *= 2;
+        lower = qMax<qreal>(lower - step, 0);
+        candidate.c = lower;
+    }
+
+    // Find an out-of-gamut upper bound.
+    step = 1.0 / resolution;
+    qreal upper = estimate + step;
+    candidate.c = upper;
+    while (m_colorSpace->isInGamut(candidate)) {
+        if (upper >= chromaLimit) {
+            return chromaLimit;
+        }
+        lower = upper;
+        step *= 2;
+        upper = qMin(upper + step, chromaLimit);
+        candidate.c = upper;
+    }
+
+    while (upper - lower > precision) {
+        candidate.c = (lower + upper) / 2;
+        if (m_colorSpace->isInGamut(candidate)) {
+            lower = candidate.c;
+        } else {
+            upper = candidate.c;
+        }
+    }
+    return lower;
+}
+
+/** @brief The maximum in-gamut chroma (batch processing).
+ *
+ * This is the batch version of @ref maximumChroma(qreal, qreal) const.
+ *
+ * @param lch View to a @ref LchBuffer (or a slice of it). The lightness
+ * and hue planes are the input. The results are written to the
+ * chroma plane. */
+void GamutBoundary::maximumChroma(PlanarView<double> lch) const
+{
+    const int count = lch.count();
+    const double *lightness = lch.plane(0);
+    double *chroma = lch.plane(1);
+    const double *hue = lch.plane(2);
+    for (int i = 0; i < count; ++i) {
+        chroma[i] = maximumChroma(lightness[i], hue[i]);
+    }
+}
+
+/** @brief The range of lightness that is in-gamut.
+ *
+ * The value is interpolated from the table. This function does not
+ * call LittleCMS. It assumes that the gamut has no holes: For a given
+ * hue and chroma, the in-gamut lightness values form a single range.
+ *
+ * @param hue The hue. Values outside of the range <tt>[0, 360[</tt>
+ * are normalized.
+ * @param chroma The chroma
+ * @returns The minimum lightness (first) and the maximum
+ * lightness (second) for which the color with the given hue and
+ * chroma is in-gamut. If no such lightness exists (the chroma is beyond
+ * the cusp), both values are NaN. */
+QPair<qreal, qreal> GamutBoundary::lightnessRange(qreal hue, qreal chroma) const
+{
+    if (chroma <= 0) {
+        return QPair<qreal, qreal>(m_blackpointL, m_whitepointL);
+    }
+    const qreal huePosition = normalizedHue(hue) * resolution;
+    const int h0 = qMin(qFloor(huePosition), hueCount - 1);
+    const int h1 = (h0 + 1) % hueCount; // The hue axis is circular.
+    const qreal hueWeight = huePosition - h0;
+    int first = -1;
+    int last = -1;
+    for (int l = 0; l < lightnessCount; ++l) {
+        if (interpolatedValue(l, h0, h1, hueWeight) >= chroma) {
+            if (first < 0) {
+                first = l;
+            }
+            last = l;
+        }
+    }
+    if (first < 0) {
+        return QPair<qreal, qreal>(qQNaN(), qQNaN());
+    }
+
+    // Interpolate the position where the boundary crosses the chroma.
+    qreal minimum = 0;
+    if (first > 0) {
+        const qreal outside = interpolatedValue(first - 1, h0, h1, hueWeight);
+        const qreal inside = interpolatedValue(first, h0, h1, hueWeight);
+        minimum = (first - 1 + (chroma - outside) / (inside - outside)) / resolution;
+    }
+    qreal maximum = 100;
+    if (last < lightnessCount - 1) {
+        const qreal inside = interpolatedValue(last, h0, h1, hueWeight);
+        const qreal outside = interpolatedValue(last + 1, h0, h1, hueWeight);
+        maximum = (last + (inside - chroma) / (inside - outside)) / resolution;
+    }
+    return QPair<qreal, qreal>(qBound(m_blackpointL, minimum, m_whitepointL), //
+                               qBound(m_blackpointL, maximum, m_whitepointL));
+}
+
+/** @brief The range of lightness that is in-gamut (batch processing).
+ *
+ * This is the batch version of @ref lightnessRange(qreal, qreal) const.
+ *
+ * @param lch View to a @ref LchBuffer (or a slice of it). The chroma
+ * and hue planes are the input; the lightness plane is ignored.
+ * @param minimum Buffer that will receive <tt>lch.count()</tt> values:
+ * the minimum lightness
+ * @param maximum Buffer that will receive <tt>lch.count()</tt> values:
+ * the maximum lightness */
+void GamutBoundary::lightnessRange(PlanarView<const double> lch, double *minimum, double *maximum) const
+{
+    const int count = lch.count();
+    const double *chroma = lch.plane(1);
+    const double *hue = lch.plane(2);
+    for (int i = 0; i < count; ++i) {
+        const QPair<qreal, qreal> range = lightnessRange(hue[i], chroma[i]);
+        minimum[i] = range.first;
+        maximum[i] = range.second;
+    }
+}
+
+} // namespace PerceptualColor
@@ -0,0 +1,110 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAMUTBOUNDARY_H
+#define GAMUTBOUNDARY_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QPair>
+#include <QVector>
+#include <QtGlobal>
+
+#include "planarbuffer.h"
+
+namespace PerceptualColor
+{
+class RgbColorSpace;
+
+/** @internal
+ *
+ * @brief Precomputed boundary of the gamut of a color space.
+ *
+ * The boundary is stored as a table of the maximum in-gamut chroma on
+ * a grid over lightness and hue, with @ref resolution entries per unit
+ * of lightness and per degree of hue. The table is calculated in the
+ * constructor with a bisection that processes all grid points
+ * together, so only a few batch calls to LittleCMS are necessary.
+ *
+ * Queries interpolate within the table and do not call LittleCMS.
+ * The interpolated values are accurate far below one chroma unit
+ * almost everywhere; only next to the cusp, where the boundary has
+ * a sharp edge, the error can be bigger. Where this matters, the
+ * value can be refined by an exact bisection that starts from the
+ * table value (see @ref maximumChroma(qreal, qreal, qreal) const).
+ *
+ * This class is thread-safe: After construction, it is read-only.
+ *
+ * Each color space owns one boundary, see @ref RgbColorSpace. */
+class GamutBoundary final
+{
+public:
+    GamutBoundary(const RgbColorSpace *colorSpace, qreal blackpointL, qreal whitepointL);
+    QPair<qreal, qreal> lightnessRange(qreal hue, qreal chroma) const;
+    void lightnessRange(PlanarView<const double> lch, double *minimum, double *maximum) const;
+    qreal maximumChroma(qreal lightness, qreal hue) const;
+    qreal maximumChroma(qreal lightness, qreal hue, qreal precision) const;
+    void maximumChroma(PlanarView<double> lch) const;
+
+    /** @brief Number of table entries per unit of lightness and per
+     * degree of hue. */
+    static constexpr int resolution = 1;
+
+private:
+    Q_DISABLE_COPY(GamutBoundary)
+
+    void buildTable();
+    qreal interpolatedValue(int lightnessIndex, int hue0, int hue1, qreal hueWeight) const;
+    static qreal normalizedHue(qreal hue);
+
+    /** @brief Number of grid points on the lightness axis. */
+    static constexpr int lightnessCount = 100 * resolution + 1;
+    /** @brief Number of grid points on the hue axis. */
+    static constexpr int hueCount = 360 * resolution;
+
+    /** @brief The lightness of the black point. */
+    qreal m_blackpointL;
+    /** @brief The color space. Not owned by this object. */
+    const RgbColorSpace *m_colorSpace;
+    /** @brief The maximum in-gamut chroma for each grid point.
+     *
+     * The entry for lightness index <tt>l</tt> and hue index <tt>h</tt>
+     * is at <tt>l * @ref hueCount + h</tt>. Grid points where even the
+     * gray color is out-of-gamut (below the black point or above the
+     * white point) have the value <tt>-1</tt>, so that interpolation
+     * gives a good estimation of the black point and white point. */
+    QVector<double> m_table;
+    /** @brief The lightness of the white point. */
+    qreal m_whitepointL;
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestGamutBoundary;
+};
+
+} // namespace PerceptualColor
+
+#endif // GAMUTBOUNDARY_H
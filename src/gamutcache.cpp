@@ -0,0 +1,462 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "gamutcache.h"
+
+#include "helper.h"
+#include "labbuffer.h"
+#include "lchbuffer.h"
+#include "rgbcolorspace.h"
+#include "rgbdouble.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace PerceptualColor
+{
+/** @brief Calculates tiles.
+ *
+ * Helper for @ref GamutCache::populate(). */
+class GamutCache::TileRunnable final : public QRunnable
+{
+public:
+    /** @brief Constructor
+     *
+     * @param cache The cache
+     * @param tileIndices Indices of the tiles to calculate */
+    TileRunnable(GamutCache *cache, const QVector<int> &tileIndices)
+        : m_cache(cache)
+        , m_tileIndices(tileIndices)
+    {
+    }
+
+    /** @brief Calculates the tiles. */
+    void run() override
+    {
+        for (int tileIndex : qAsConst(m_tileIndices)) {
+            m_cache->tile(tileIndex);
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(TileRunnable)
+
+    /** @brief The cache */
+    GamutCache *const m_cache;
+    /** @brief Indices of the tiles to calculate */
+    const QVector<int> m_tileIndices;
+};
+
+/** @brief Constructor
+ *
+ * The constructor does not calculate any tiles.
+ *
+ * @param colorSpace The color space. Must stay valid during the live
+ * time of this object. */
+GamutCache::GamutCache(const RgbColorSpace *colorSpace)
+    : m_colorSpace(colorSpace)
+{
+    m_lightnessCount = 100 / gridSpacing + 1;
+    m_chromaCount = qMax(colorSpace->maximumChroma() / gridSpacing, 1) + 1;
+    m_hueCount = 360 / gridSpacing;
+    m_lightnessTileCount = (m_lightnessCount + tileSize - 1) / tileSize;
+    m_chromaTileCount = (m_chromaCount + tileSize - 1) / tileSize;
+    m_hueTileCount = (m_hueCount + tileSize - 1) / tileSize;
+    const int tileCount = m_lightnessTileCount * m_chromaTileCount * m_hueTileCount;
+    m_tiles.reset(new std::atomic<Tile *>[tileCount]);
+    for (int i = 0; i < tileCount; ++i) {
+        m_tiles[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+/** @brief Destructor */
+GamutCache::~GamutCache() noexcept
+{
+    const int tileCount = m_lightnessTileCount * m_chromaTileCount * m_hueTileCount;
+    for (int i = 0; i < tileCount; ++i) {
+        delete m_tiles[i].load(std::memory_order_relaxed);
+    }
+}
+
+/** @brief Number of tiles that have been calculated so far.
+ *
+ * @returns Number of tiles that have been calculated so far. */
+int GamutCache::populatedTileCount() const
+{
+    return m_populatedTileCount.load(std::memory_order_relaxed);
+}
+
+/** @brief Position of a grid point within a tile.
+ *
+ * @param lightness Lightness index within the tile
+ * @param chroma Chroma index within the tile
+ * @param hue Hue index within the tile
+ * @returns The index of the first component of the grid point
+ * within @ref Tile. */
+int GamutCache::cellIndex(int lightness, int chroma, int hue)
+{
+    return ((lightness * tileSize + chroma) * tileSize + hue) * 3;
+}
+
+/** @brief Calculates a tile.
+ *
+ * All grid points of the tile are calculated within a single call
+ * to LittleCMS. At the upper end of the lightness and chroma axis,
+ * tiles might reach beyond the range of the cache. These grid points
+ * are calculated anyway (it is cheaper than treating them
+ * specially), but they are never used.
+ *
+ * @param lightnessTile Tile index on the lightness axis
+ * @param chromaTile Tile index on the chroma axis
+ * @param hueTile Tile index on the hue axis
+ * @returns A newly allocated tile. The caller takes ownership. */
+GamutCache::Tile *GamutCache::calculateTile(int lightnessTile, int chromaTile, int hueTile) const
+{
+    LchBuffer lch(tileCellCount);
+    int position = 0;
+    for (int l = 0; l < tileSize; ++l) {
+        for (int c = 0; c < tileSize; ++c) {
+            for (int h = 0; h < tileSize; ++h) {
+                lch.l()[position] = (lightnessTile * tileSize + l) * gridSpacing;
+                lch.c()[position] = (chromaTile * tileSize + c) * gridSpacing;
+                lch.h()[position] = (hueTile * tileSize + h) * gridSpacing;
+                ++position;
+            }
+        }
+    }
+    const LabBuffer lab = LabBuffer::fromLch(lch.view());
+    QVector<RgbDouble> rgb(tileCellCount);
+    m_colorSpace->toRgbDoubleUnbound(lab.view(), rgb.data());
+    QVector<bool> isInGamut(tileCellCount);
+    m_colorSpace->isInGamut(lab.view(), rgb.constData(), isInGamut.data());
+    Tile *result = new Tile;
+    constexpr double limit = 32767;
+    for (int i = 0; i < tileCellCount; ++i) {
+        RgbDouble value = rgb.at(i);
+        if (!isInGamut.at(i)) {
+            // For profiles whose transforms clip, out-of-gamut colors
+            // might have RGB values within the range. Make sure that
+            // they are out-of-range in the cache.
+            const bool isWithinRange = isInRange<double>(0, value.red, 1) //
+                && isInRange<double>(0, value.green, 1) //
+                && isInRange<double>(0, value.blue, 1);
+            if (isWithinRange) {
+                value = RgbDouble {-1, -1, -1};
+            }
+        }
+        (*result)[i * 3 + 0] = static_cast<qint16>(qRound(qBound(-limit, value.red * fixedPointFactor, limit)));
+        (*result)[i * 3 + 1] = static_cast<qint16>(qRound(qBound(-limit, value.green * fixedPointFactor, limit)));
+        (*result)[i * 3 + 2] = static_cast<qint16>(qRound(qBound(-limit, value.blue * fixedPointFactor, limit)));
+    }
+    return result;
+}
+
+/** @brief A tile, that is calculated if necessary.
+ *
+ * @param tileIndex Index of the tile within @ref m_tiles
+ * @param lightnessTile Tile index on the lightness axis
+ * @param chromaTile Tile index on the chroma axis
+ * @param hueTile Tile index on the hue axis
+ * @returns The tile. */
+const GamutCache::Tile *GamutCache::tile(int tileIndex, int lightnessTile, int chromaTile, int hueTile)
+{
+    Tile *result = m_tiles[tileIndex].load(std::memory_order_acquire);
+    if (result != nullptr) {
+        return result;
+    }
+    Tile *newTile = calculateTile(lightnessTile, chromaTile, hueTile);
+    if (m_tiles[tileIndex].compare_exchange_strong(result, newTile, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        m_populatedTileCount.fetch_add(1, std::memory_order_relaxed);
+        return newTile;
+    }
+    // Another thread has been faster. Now, result contains its tile.
+    delete newTile;
+    return result;
+}
+
+/** @brief The unbounded RGB value of a grid point.
+ *
+ * @param lightnessIndex Lightness index within the whole grid
+ * @param chromaIndex Chroma index within the whole grid
+ * @param hueIndex Hue index within the whole grid
+ * @returns Pointer to the three components in fixed-point
+ * representation. */
+const qint16 *GamutCache::gridPoint(int lightnessIndex, int chromaIndex, int hueIndex)
+{
+    const int lightnessTile = lightnessIndex / tileSize;
+    const int chromaTile = chromaIndex / tileSize;
+    const int hueTile = hueIndex / tileSize;
+    const int tileIndex = (lightnessTile * m_chromaTileCount + chromaTile) * m_hueTileCount + hueTile;
+    const Tile *myTile = tile(tileIndex, lightnessTile, chromaTile, hueTile);
+    return myTile->data()
+        + cellIndex(lightnessIndex % tileSize, //
+                    chromaIndex % tileSize,
+                    hueIndex % tileSize);
+}
+
+/** @brief A tile, that is calculated if necessary.
+ *
+ * @param tileIndex Index of the tile within @ref m_tiles
+ * @returns The tile. */
+const GamutCache::Tile *GamutCache::tile(int tileIndex)
+{
+    const int hueTile = tileIndex % m_hueTileCount;
+    const int chromaTile = (tileIndex / m_hueTileCount) % m_chromaTileCount;
+    const int lightnessTile = tileIndex / (m_hueTileCount * m_chromaTileCount);
+    return tile(tileIndex, lightnessTile, chromaTile, hueTile);
+}
+
+/** @brief Calculates the tiles for a range of the cache in advance.
+ *
+ * The missing tiles are calculated in parallel. This function returns
+ * after all of them have been calculated.
+ *
+ * @param lightnessMinimum Minimum lightness
+ * @param lightnessMaximum Maximum lightness
+ * @param chromaMaximum Maximum chroma. All hues are calculated. */
+void GamutCache::populate(qreal lightnessMinimum, qreal lightnessMaximum, qreal chromaMaximum)
+{
+    const int lightnessTileBegin = qBound(0, qFloor(lightnessMinimum / gridSpacing) / tileSize, m_lightnessTileCount - 1);
+    const int lightnessTileEnd = qBound(0, (qFloor(lightnessMaximum / gridSpacing) + 1) / tileSize, m_lightnessTileCount - 1) + 1;
+    const int chromaTileEnd = qBound(0, (qFloor(chromaMaximum / gridSpacing) + 1) / tileSize, m_chromaTileCount - 1) + 1;
+    QVector<int> missingTiles;
+    for (int l = lightnessTileBegin; l < lightnessTileEnd; ++l) {
+        for (int c = 0; c < chromaTileEnd; ++c) {
+            for (int h = 0; h < m_hueTileCount; ++h) {
+                const int tileIndex = (l * m_chromaTileCount + c) * m_hueTileCount + h;
+                if (m_tiles[tileIndex].load(std::memory_order_acquire) == nullptr) {
+                    missingTiles.append(tileIndex);
+                }
+            }
+        }
+    }
+    const int chunks = qBound(1, missingTiles.count() / minimumTilesPerThread, qMax(1, QThread::idealThreadCount()));
+    if (chunks == 1) {
+        // No need for the overhead of a thread pool.
+        for (int tileIndex : qAsConst(missingTiles)) {
+            tile(tileIndex);
+        }
+        return;
+    }
+    QThreadPool pool;
+    pool.setMaxThreadCount(chunks);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        const int begin = missingTiles.count() * chunk / chunks;
+        const int end = missingTiles.count() * (chunk + 1) / chunks;
+        // The pool takes ownership of the runnable.
+        pool.start(new TileRunnable(this, missingTiles.mid(begin, end - begin)));
+    }
+    pool.waitForDone();
+}
+
+/** @brief Approximated RGB value by interpolation.
+ *
+ * Tiles that are needed for the lookup and that are not yet available
+ * are calculated.
+ *
+ * @param lch The LCh color
+ * @param rgb Receives the result if the return value is <tt>true</tt>:
+ * The opaque RGB value if the color is in-gamut, <tt>0</tt> (fully
+ * transparent) otherwise. Also colors beyond the range of the cache are
+ * reported as out-of-gamut.
+ * @returns <tt>true</tt> on success. <tt>false</tt> if the color is
+ * close to the gamut boundary, so that the interpolation cannot decide
+ * reliably if it is in-gamut. In this case, <tt>rgb</tt> is undefined. */
+bool GamutCache::interpolate(const LchDouble &lch, QRgb *rgb)
+{
+    const double lightness = lch.l / gridSpacing;
+    const double chroma = lch.c / gridSpacing;
+    if (!isInRange<double>(0, lightness, m_lightnessCount - 1) //
+        || !isInRange<double>(0, chroma, m_chromaCount - 1)) {
+        *rgb = 0;
+        return true;
+    }
+    double hue = std::fmod(lch.h, 360);
+    if (hue < 0) {
+        hue += 360;
+    }
+    hue = hue / gridSpacing;
+
+    // Lower grid point on each axis. On the lightness and chroma axis,
+    // the upper grid point must still be within the grid.
+    const int l0 = qMin(qFloor(lightness), m_lightnessCount - 2);
+    const int c0 = qMin(qFloor(chroma), m_chromaCount - 2);
+    const int h0 = qMin(qFloor(hue), m_hueCount - 1);
+    const int h1 = (h0 + 1) % m_hueCount; // The hue axis is circular.
+
+    // Tetrahedral interpolation. The corners of the grid cell are
+    // identified by bit masks: 1 is the upper lightness, 2 the upper
+    // chroma and 4 the upper hue. The tetrahedron that contains the
+    // point is the one along the path from corner 0 to corner 7 that
+    // goes first along the axis with the biggest fraction, than along
+    // the axis with the second-biggest fraction.
+    struct Axis {
+        double fraction;
+        int bit;
+    };
+    Axis axes[3] = {{lightness - l0, 1}, {chroma - c0, 2}, {hue - h0, 4}};
+    std::sort(std::begin(axes), std::end(axes), [](const Axis &first, const Axis &second) {
+        return first.fraction > second.fraction;
+    });
+    const int corners[4] = {0, //
+                            axes[0].bit,
+                            axes[0].bit | axes[1].bit,
+                            7};
+    const double weights[4] = {1 - axes[0].fraction, //
+                               axes[0].fraction - axes[1].fraction,
+                               axes[1].fraction - axes[2].fraction,
+                               axes[2].fraction};
+    double red = 0;
+    double green = 0;
+    double blue = 0;
+    int inGamutCorners = 0;
+    int usedCorners = 0;
+    constexpr int fixedPointOne = static_cast<int>(fixedPointFactor);
+    for (int i = 0; i < 4; ++i) {
+        if (weights[i] == 0) {
+            continue;
+        }
+        const int corner = corners[i];
+        const qint16 *value = gridPoint( //
+            (corner & 1) ? l0 + 1 : l0,
+            (corner & 2) ? c0 + 1 : c0,
+            (corner & 4) ? h1 : h0);
+        ++usedCorners;
+        if (isInRange<int>(0, value[0], fixedPointOne) //
+            && isInRange<int>(0, value[1], fixedPointOne) //
+            && isInRange<int>(0, value[2], fixedPointOne)) {
+            ++inGamutCorners;
+        }
+        red += weights[i] * value[0];
+        green += weights[i] * value[1];
+        blue += weights[i] * value[2];
+    }
+    if (inGamutCorners == 0) {
+        *rgb = 0;
+        return true;
+    }
+    if (inGamutCorners < usedCorners) {
+        // Close to the gamut boundary
+        return false;
+    }
+    *rgb = qRgb(qRound(red / fixedPointFactor * 255), //
+                qRound(green / fixedPointFactor * 255),
+                qRound(blue / fixedPointFactor * 255));
+    return true;
+}
+
+/** @brief RGB value of an LCh color.
+ *
+ * Tiles that are needed for the lookup and that are not yet available
+ * are calculated.
+ *
+ * @param lch The LCh color
+ * @returns If the color is within the RGB gamut, the opaque RGB value.
+ * <tt>0</tt> (fully transparent) otherwise. Also colors beyond the range
+ * of the cache are reported as out-of-gamut.
+ *
+ * @sa @ref RgbColorSpace::toQColorRgbUnbound() for the exact value. */
+QRgb GamutCache::toQRgbUnbound(const LchDouble &lch)
+{
+    QRgb result;
+    if (interpolate(lch, &result)) {
+        return result;
+    }
+    const QColor exact = m_colorSpace->toQColorRgbUnbound(lch);
+    return exact.isValid() ? exact.rgb() : 0;
+}
+
+/** @brief Converts LCh values to RGB values (batch processing).
+ *
+ * Colors close to the gamut boundary are calculated exactly with a single
+ * batch call to LittleCMS.
+ *
+ * @param lch View to a @ref LchBuffer (or a slice of it)
+ * @param rgb Buffer that will receive <tt>lch.count()</tt> values.
+ * See @ref toQRgbUnbound(const LchDouble &) for details.
+ *
+ * @sa @ref RgbColorSpace::toQRgbUnboundFromLch() for the exact values. */
+void GamutCache::toQRgbUnboundFromLch(PlanarView<const double> lch, QRgb *rgb)
+{
+    const int count = lch.count();
+    const double *lightness = lch.plane(0);
+    const double *chroma = lch.plane(1);
+    const double *hue = lch.plane(2);
+    LchDouble value;
+    QVector<int> boundaryIndices;
+    for (int i = 0; i < count; ++i) {
+        value.l = lightness[i];
+        value.c = chroma[i];
+        value.h = hue[i];
+        if (!interpolate(value, &rgb[i])) {
+            boundaryIndices.append(i);
+        }
+    }
+    if (boundaryIndices.isEmpty()) {
+        return;
+    }
+    const int boundaryCount = boundaryIndices.count();
+    LchBuffer boundaryLch(boundaryCount);
+    for (int i = 0; i < boundaryCount; ++i) {
+        const int index = boundaryIndices.at(i);
+        boundaryLch.l()[i] = lightness[index];
+        boundaryLch.c()[i] = chroma[index];
+        boundaryLch.h()[i] = hue[index];
+    }
+    LabBuffer boundaryLab(boundaryCount);
+    QVector<QRgb> boundaryRgb(boundaryCount);
+    m_colorSpace->toQRgbUnboundFromLch(boundaryLch.view(), boundaryLab.view(), boundaryRgb.data());
+    for (int i = 0; i < boundaryCount; ++i) {
+        rgb[boundaryIndices.at(i)] = boundaryRgb.at(i);
+    }
+}
+
+/** @brief Converts Lab values to RGB values (batch processing).
+ *
+ * @param lab View to a @ref LabBuffer (or a slice of it)
+ * @param rgb Buffer that will receive <tt>lab.count()</tt> values.
+ * See @ref toQRgbUnbound(const LchDouble &) for details.
+ *
+ * @sa @ref RgbColorSpace::toQRgbUnbound() for the exact values. */
+void GamutCache::toQRgbUnbound(PlanarView<const double> lab, QRgb *rgb)
+{
+    const LchBuffer lch = LchBuffer::fromLab(lab);
+    toQRgbUnboundFromLch(lch.view(), rgb);
+}
+
+} // namespace PerceptualColor
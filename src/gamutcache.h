@@ -0,0 +1,170 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAMUTCACHE_H
+#define GAMUTCACHE_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QColor>
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include "PerceptualColor/lchdouble.h"
+#include "planarbuffer.h"
+
+namespace PerceptualColor
+{
+class RgbColorSpace;
+
+/** @internal
+ *
+ * @brief Lazily filled cache of the RGB values of an LCh grid.
+ *
+ * The cache covers the whole LCh range of a color space: lightness
+ * <tt>[0, 100]</tt>, chroma <tt>[0, @ref RgbColorSpace::maximumChroma()]</tt>
+ * and all hues. Grid points have a distance of @ref gridSpacing.
+ *
+ * The grid is split into cubic tiles of @ref tileSize grid points per
+ * axis. A tile is calculated (with a single call to LittleCMS) only when
+ * a value within it is requested for the first time, or when
+ * @ref populate() is called, which calculates many tiles in parallel.
+ * Diagrams that show slices through the gamut (like @ref ChromaHueImage,
+ * @ref ChromaLightnessImage and @ref ColorWheelImage) render by
+ * resampling from this cache, so that after the warm-up, moving the
+ * slice calls LittleCMS only for the few pixels at the gamut boundary.
+ *
+ * The cache stores the <em>unbounded</em> RGB values (not clipped to
+ * <tt>[0, 1]</tt>). For profiles whose transforms clip anyway (see
+ * @ref RgbColorSpace::isInGamut()), out-of-gamut grid points are stored
+ * as <tt>-1</tt> on all channels. Lookups use tetrahedral interpolation: The grid cell
+ * is divided into six tetrahedra, and the value is interpolated between
+ * the four corners of the tetrahedron that contains the requested point.
+ * This needs only four grid points instead of the eight of a trilinear
+ * interpolation.
+ *
+ * If the four corners are all in-gamut, the interpolated value is used.
+ * If they are all out-of-gamut, the color is considered out-of-gamut.
+ * Otherwise, the point is close to the gamut boundary, and the color is
+ * calculated exactly. This is <em>not</em> an exact classification: The
+ * gamut is not convex, so a tetrahedron whose four corners are all
+ * in-gamut (or all out-of-gamut) can still be crossed by the gamut
+ * boundary. Such errors are limited to a distance of less than one grid
+ * cell (@ref gridSpacing) from the boundary. They are rare: In the unit
+ * tests, less than 0.1 % of random samples are misclassified.
+ *
+ * Away from the boundary, the values are approximations. Where exact
+ * results are required (for example for gamut mapping),
+ * use @ref RgbColorSpace directly.
+ *
+ * This class is thread-safe. Tiles are published with atomic
+ * operations. When two threads calculate the same tile at the same
+ * time, one of the results is discarded.
+ *
+ * Each color space owns one cache, see @ref RgbColorSpace::gamutCache(). */
+class GamutCache final
+{
+public:
+    explicit GamutCache(const RgbColorSpace *colorSpace);
+    ~GamutCache() noexcept;
+    void populate(qreal lightnessMinimum, qreal lightnessMaximum, qreal chromaMaximum);
+    int populatedTileCount() const;
+    QRgb toQRgbUnbound(const LchDouble &lch);
+    void toQRgbUnbound(PlanarView<const double> lab, QRgb *rgb);
+    void toQRgbUnboundFromLch(PlanarView<const double> lch, QRgb *rgb);
+
+    /** @brief Distance between neighboring grid points in LCh units.
+     *
+     * This applies to lightness, chroma and hue (in degree). A chroma
+     * unit is smaller than a pixel for diagrams of usual size. */
+    static constexpr int gridSpacing = 1;
+    /** @brief Number of grid points per axis in a tile. */
+    static constexpr int tileSize = 8;
+
+private:
+    Q_DISABLE_COPY(GamutCache)
+
+    /** @brief Number of grid points in a tile. */
+    static constexpr int tileCellCount = tileSize * tileSize * tileSize;
+    /** @brief Minimum number of tiles that justifies an additional
+     * thread in @ref populate(). */
+    static constexpr int minimumTilesPerThread = 64;
+    /** @brief Factor for the fixed-point representation of the
+     * RGB components.
+     *
+     * Components are stored as <tt>qint16</tt>. This gives a
+     * precision of <tt>1/4096</tt>, which is more than enough for
+     * 8-bit output, and a range of <tt>[-8, 8]</tt>. Values beyond this
+     * range are clipped; they are far out-of-gamut anyway. */
+    static constexpr double fixedPointFactor = 4096;
+
+    /** @brief Unbounded RGB values of the grid points of a tile.
+     *
+     * Three components per grid point, in fixed-point representation.
+     * See @ref cellIndex() for the layout. */
+    using Tile = std::array<qint16, tileCellCount * 3>;
+
+    class TileRunnable;
+
+    const qint16 *gridPoint(int lightnessIndex, int chromaIndex, int hueIndex);
+    bool interpolate(const LchDouble &lch, QRgb *rgb);
+    const Tile *tile(int tileIndex, int lightnessTile, int chromaTile, int hueTile);
+    const Tile *tile(int tileIndex);
+    Tile *calculateTile(int lightnessTile, int chromaTile, int hueTile) const;
+    static int cellIndex(int lightness, int chroma, int hue);
+
+    /** @brief The color space. Not owned by this object. */
+    const RgbColorSpace *m_colorSpace;
+    /** @brief Number of grid points on the lightness axis. */
+    int m_lightnessCount;
+    /** @brief Number of grid points on the chroma axis. */
+    int m_chromaCount;
+    /** @brief Number of grid points on the hue axis. */
+    int m_hueCount;
+    /** @brief Number of tiles on the lightness axis. */
+    int m_lightnessTileCount;
+    /** @brief Number of tiles on the chroma axis. */
+    int m_chromaTileCount;
+    /** @brief Number of tiles on the hue axis. */
+    int m_hueTileCount;
+    /** @brief The tiles.
+     *
+     * <tt>nullptr</tt> for tiles that have not yet been calculated. */
+    std::unique_ptr<std::atomic<Tile *>[]> m_tiles;
+    /** @brief Number of tiles that are not <tt>nullptr</tt>. */
+    std::atomic<int> m_populatedTileCount {0};
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestGamutCache;
+};
+
+} // namespace PerceptualColor
+
+#endif // GAMUTCACHE_H
@@ -33,9 +33,14 @@
 
 #include <math.h>
 
+#include "colorvisiondeficiencysimulation.h"
 #include "helper.h"
+#include "labbuffer.h"
+#include "lchbuffer.h"
+#include "rgbdouble.h"
 
 #include <QPainter>
+#include <QVector>
 
 namespace PerceptualColor
 {
@@ -82,8 +87,9 @@ void GradientImage::setFirstColor(const LchaDouble &newFirstColor)
     if (!m_firstColorCorrected.hasSameCoordinates(correctedNewFirstColor)) {
         m_firstColorCorrected = correctedNewFirstColor;
         updateSecondColor();
-        // Free the memory used by the old image.
+        // Free the memory used by the old image and its variants.
         m_image = QImage();
+        m_variants.clear();
     }
 }
 
@@ -96,8 +102,9 @@ void GradientImage::setSecondColor(const LchaDouble &newSecondColor)
     if (!m_secondColorCorrectedAndAltered.hasSameCoordinates(correctedNewSecondColor)) {
         m_secondColorCorrectedAndAltered = correctedNewSecondColor;
         updateSecondColor();
-        // Free the memory used by the old image.
+        // Free the memory used by the old image and its variants.
         m_image = QImage();
+        m_variants.clear();
     }
 }
 
@@ -117,12 +124,60 @@ void GradientImage::updateSecondColor()
     }
 }
 
+/** @brief Setter for the simulated color vision deficiency.
+ *
+ * If not @ref AbstractDiagram::ColorVisionDeficiency::none, the image is
+ * rendered as it is perceived by people with the given color vision
+ * deficiency.
+ *
+ * @param newColorVisionDeficiency The new color vision deficiency. */
+void GradientImage::setColorVisionDeficiency(const AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency)
+{
+    if (m_colorVisionDeficiency != newColorVisionDeficiency) {
+        m_colorVisionDeficiency = newColorVisionDeficiency;
+        // Free the memory used by the old image and its variants.
+        m_image = QImage();
+        m_variants.clear();
+    }
+}
+
+/** @brief Setter for the display color space.
+ *
+ * The gamut decisions are always made in the color space that was
+ * passed to the constructor. But if a display color space is set, the
+ * RGB values that are written into the image are calculated for the
+ * display color space, using a single fused transform from Lab.
+ * See @ref DisplayTransform for details.
+ *
+ * @param newDisplayColorSpace The new display color space. If
+ * <tt>nullptr</tt> (default), the RGB values of the color space that
+ * was passed to the constructor are written into the image. */
+void GradientImage::setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace)
+{
+    if (m_displayColorSpace != newDisplayColorSpace) {
+        m_displayColorSpace = newDisplayColorSpace;
+        m_displayTransform = DisplayTransform::create(m_rgbColorSpace, m_displayColorSpace);
+        // Free the memory used by the old image and its variants.
+        m_image = QImage();
+        m_variants.clear();
+    }
+}
+
 /** @brief Delivers an image of a gradient
  *
- * @returns Delivers an image of a gradient. Its size is @ref m_gradientLength
- * and its height is @ref m_gradientThickness. The first color will be
- * at the left, and the second color will be at the right. The background
- * of transparent colors (if any) will be aligned to the top-left edge.
+ * @returns Delivers an image of a gradient in its final orientation and
+ * layout direction, so that it can be painted on a widget without
+ * further transformation.
+ * - Horizontal orientation: The size is @ref m_gradientLength and the
+ *   height is @ref m_gradientThickness. The first color will be at the
+ *   left and the second color at the right (mirrored for right-to-left
+ *   layout direction).
+ * - Vertical orientation: The size is @ref m_gradientThickness and the
+ *   height is @ref m_gradientLength. The first color will be at the
+ *   bottom and the second color at the top.
+ *
+ * The background of transparent colors (if any) will be aligned to the
+ * top-left edge (top-right edge for right-to-left layout direction).
  *
  * If a color is out-of-gamut, a nearby substitution color will be used. */
 QImage GradientImage::getImage()
@@ -132,6 +187,12 @@ QImage GradientImage::getImage()
         return m_image;
     }
 
+    // If there is a variant for the current geometry, use it.
+    m_image = m_variants.value(variantKey());
+    if (!m_image.isNull()) {
+        return m_image;
+    }
+
     // If no cache is available (m_image.isNull()), render a new image.
 
     // Special case: zero-size-image
@@ -146,10 +207,49 @@ QImage GradientImage::getImage()
     // minimize this.)
     QImage temp(m_gradientLength, 1, QImage::Format_ARGB32_Premultiplied);
     temp.fill(Qt::transparent); // Initialize the image with transparency.
+    // The whole row is converted with batch calls.
+    LchBuffer rowLch(m_gradientLength);
+    QVector<qreal> rowAlpha(m_gradientLength);
     LchaDouble color;
     for (int i = 0; i < m_gradientLength; ++i) {
         color = colorFromValue((i + 0.5) / static_cast<qreal>(m_gradientLength));
-        temp.setPixelColor(i, 0, m_rgbColorSpace->toQColorRgbBound(color));
+        rowLch.l()[i] = color.l;
+        rowLch.c()[i] = color.c;
+        rowLch.h()[i] = color.h;
+        rowAlpha[i] = color.a;
+    }
+    const LabBuffer rowLab = LabBuffer::fromLch(rowLch.view());
+    // The gamut decision is made in the working color space: Out-of-gamut
+    // colors are clipped like RgbColorSpace::toQColorRgbBound() does.
+    QVector<RgbDouble> rowWorkingRgb(m_gradientLength);
+    m_rgbColorSpace->toRgbDoubleBound(rowLab.view(), rowWorkingRgb.data());
+    // After clipping, all colors are in-gamut. (0 would mean
+    // out-of-gamut for DisplayTransform::toDisplayQRgb() and for
+    // ColorVisionDeficiencySimulation.)
+    QVector<QRgb> rowRgb(m_gradientLength, qRgb(0, 0, 0));
+    if (m_displayTransform.isNull() || (m_colorVisionDeficiency != AbstractDiagram::ColorVisionDeficiency::none)) {
+        for (int i = 0; i < m_gradientLength; ++i) {
+            const RgbDouble &value = rowWorkingRgb.at(i);
+            rowRgb[i] = qRgb(qRound(value.red * 255), //
+                             qRound(value.green * 255),
+                             qRound(value.blue * 255));
+        }
+        // The simulation works on the encoded values and includes the
+        // conversion to the display color space.
+        ColorVisionDeficiencySimulation::simulateRow(m_colorVisionDeficiency,
+                                                     *m_rgbColorSpace,
+                                                     m_displayTransform.data(),
+                                                     rowRgb.data(),
+                                                     rowWorkingRgb.data(),
+                                                     m_gradientLength);
+    } else {
+        m_displayTransform->toDisplayQRgb(rowWorkingRgb.constData(), rowRgb.data(), m_gradientLength);
+    }
+    QColor rgbColor;
+    for (int i = 0; i < m_gradientLength; ++i) {
+        rgbColor = QColor(rowRgb.at(i));
+        rgbColor.setAlphaF(rowAlpha.at(i));
+        temp.setPixelColor(i, 0, rgbColor);
     }
 
     // Now, create a full image of the gradient
@@ -166,11 +266,37 @@ QImage GradientImage::getImage()
         painter.drawImage(0, i, temp);
     }
 
+    painter.end();
+
+    // Bring the image to its final orientation and layout direction. This
+    // happens once for each rendering, so painting the image on the widget
+    // needs no transformation anymore.
+    if (m_orientation == Qt::Orientation::Vertical) {
+        QTransform rotation;
+        rotation.rotate(270);
+        m_image = m_image.transformed(rotation);
+    }
+    if (m_layoutDirection == Qt::LayoutDirection::RightToLeft) {
+        // Even on vertical gradients, we mirror the image, so that
+        // the well-aligned edge of the transparency background is
+        // always aligned according to the writing direction.
+        m_image = m_image.mirrored(true, false);
+    }
+
     // Set the correct scaling information for the image and return
     m_image.setDevicePixelRatio(m_devicePixelRatioF);
+    m_variants.insert(variantKey(), m_image, QSizeF(m_gradientLength, m_gradientThickness) / m_devicePixelRatioF);
     return m_image;
 }
 
+/** @brief The key of the current geometry within @ref m_variants.
+ *
+ * @returns The key of the current geometry within @ref m_variants. */
+GradientImage::VariantKey GradientImage::variantKey() const
+{
+    return VariantKey(m_gradientLength, m_gradientThickness, m_devicePixelRatioF, m_orientation, m_layoutDirection);
+}
+
 /** @brief The color that the gradient has at a given position of the gradient.
  * @param value The position. Valid range: <tt>[0.0, 1.0]</tt>. <tt>0.0</tt>
  * means the first color, <tt>1.0</tt> means the second color, and everything
@@ -245,4 +371,32 @@ void GradientImage::setGradientThickness(const int newGradientThickness)
     }
 }
 
+/** @brief Setter for the layout direction property.
+ *
+ * @param newLayoutDirection The new layout direction. For
+ * <tt>Qt::LayoutDirection::RightToLeft</tt>, the image is mirrored
+ * horizontally. */
+void GradientImage::setLayoutDirection(const Qt::LayoutDirection newLayoutDirection)
+{
+    if (m_layoutDirection != newLayoutDirection) {
+        m_layoutDirection = newLayoutDirection;
+        // Free the memory used by the old image.
+        m_image = QImage();
+    }
+}
+
+/** @brief Setter for the orientation property.
+ *
+ * @param newOrientation The new orientation. For
+ * <tt>Qt::Orientation::Vertical</tt>, the image is rotated so that
+ * the first color is at the bottom. */
+void GradientImage::setOrientation(const Qt::Orientation newOrientation)
+{
+    if (m_orientation != newOrientation) {
+        m_orientation = newOrientation;
+        // Free the memory used by the old image.
+        m_image = QImage();
+    }
+}
+
 } // namespace PerceptualColor
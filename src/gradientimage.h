@@ -33,7 +33,12 @@
 #include <QImage>
 #include <QSharedPointer>
 
+#include <tuple>
+
 #include "PerceptualColor/lchadouble.h"
+#include "PerceptualColor/abstractdiagram.h"
+#include "displaytransform.h"
+#include "imagevariantcache.h"
 #include "rgbcolorspace.h"
 
 namespace PerceptualColor
@@ -69,6 +74,12 @@ namespace PerceptualColor
  *
  * This class supports HiDPI via its @ref setDevicePixelRatioF function.
  *
+ * Images that have been rendered for a different geometry (length,
+ * thickness, device pixel ratio, orientation, layout direction) are retained in a small variant cache.
+ * So when a window is moved back and forth between monitors with different
+ * device pixel ratios, the gradient is rendered only once for each monitor.
+ * Changing the colors discards all variants.
+ *
  * @note Resetting a property to its very same value does not trigger an
  * image calculation. So, if @ref setGradientThickness is 5, and you
  * call @ref setGradientThickness <tt>(5)</tt>, than this will not
@@ -88,10 +99,14 @@ public:
     explicit GradientImage(const QSharedPointer<PerceptualColor::RgbColorSpace> &colorSpace);
     LchaDouble colorFromValue(qreal value) const;
     QImage getImage();
+    void setColorVisionDeficiency(const AbstractDiagram::ColorVisionDeficiency newColorVisionDeficiency);
     void setDevicePixelRatioF(const qreal newDevicePixelRatioF);
+    void setDisplayColorSpace(const QSharedPointer<PerceptualColor::RgbColorSpace> &newDisplayColorSpace);
     void setFirstColor(const LchaDouble &newFirstColor);
     void setGradientLength(const int newGradientLength);
     void setGradientThickness(const int newGradientThickness);
+    void setLayoutDirection(const Qt::LayoutDirection newLayoutDirection);
+    void setOrientation(const Qt::Orientation newOrientation);
     void setSecondColor(const LchaDouble &newFirstColor);
 
 private:
@@ -100,9 +115,16 @@ private:
     /** @internal @brief Only for unit tests. */
     friend class TestGradientImage;
 
+    /** @brief Key for @ref m_variants.
+     *
+     * Gradient length, gradient thickness, device pixel ratio,
+     * orientation and layout direction. */
+    using VariantKey = std::tuple<int, int, qreal, Qt::Orientation, Qt::LayoutDirection>;
+
     // Methods
     static LchaDouble completlyNormalizedAndBounded(const LchaDouble &color);
     void updateSecondColor();
+    VariantKey variantKey() const;
 
     // Data members
     /** @brief Internal storage of the device pixel ratio as floating point.
@@ -124,6 +146,28 @@ private:
      *
      * @sa @ref setGradientThickness() */
     int m_gradientThickness = 0;
+    /** @brief Internal storage for the layout direction.
+     *
+     * @sa @ref setLayoutDirection() */
+    Qt::LayoutDirection m_layoutDirection = Qt::LayoutDirection::LeftToRight;
+    /** @brief Internal storage for the orientation.
+     *
+     * @sa @ref setOrientation() */
+    Qt::Orientation m_orientation = Qt::Orientation::Horizontal;
+    /** @brief Internal store for the simulated color vision deficiency.
+     *
+     * @sa @ref setColorVisionDeficiency() */
+    AbstractDiagram::ColorVisionDeficiency m_colorVisionDeficiency = AbstractDiagram::ColorVisionDeficiency::none;
+    /** @brief Internal store for the display color space.
+     *
+     * @sa @ref setDisplayColorSpace() */
+    QSharedPointer<PerceptualColor::RgbColorSpace> m_displayColorSpace;
+    /** @brief Transform to @ref m_displayColorSpace.
+     *
+     * <tt>nullptr</tt> if no transform is necessary.
+     *
+     * @sa @ref setDisplayColorSpace() */
+    QSharedPointer<DisplayTransform> m_displayTransform;
     /** @brief Internal storage of the image (cache).
      *
      * - If <tt>m_image.isNull()</tt> than either no cache is available
@@ -150,6 +194,9 @@ private:
      * @sa @ref completlyNormalizedAndBounded()
      * @sa @ref updateSecondColor() */
     LchaDouble m_secondColorCorrectedAndAltered;
+    /** @brief Images that have previously been rendered with the
+     * current colors, but another geometry. */
+    ImageVariantCache<VariantKey> m_variants;
 };
 
 } // namespace PerceptualColor
@@ -134,7 +134,7 @@ void GradientSlider::setFirstColor(const PerceptualColor::LchaDouble &newFirstCo
         d_pointer->m_firstColor = newFirstColor;
         d_pointer->m_gradientImageCache.setFirstColor(newFirstColor);
         Q_EMIT firstColorChanged(newFirstColor);
-        update();
+        scheduleRepaint();
     }
 }
 
@@ -154,7 +154,7 @@ void GradientSlider::setSecondColor(const PerceptualColor::LchaDouble &newSecond
         d_pointer->m_secondColor = newSecondColor;
         d_pointer->m_gradientImageCache.setSecondColor(newSecondColor);
         Q_EMIT secondColorChanged(newSecondColor);
-        update();
+        scheduleRepaint();
     }
 }
 
@@ -282,7 +282,7 @@ void GradientSlider::setValue(qreal newValue)
     qreal temp = qBound<qreal>(0, newValue, 1);
     if (d_pointer->m_value != temp) {
         d_pointer->m_value = temp;
-        update();
+        scheduleRepaint();
         Q_EMIT valueChanged(temp);
     }
 }
@@ -430,6 +430,7 @@ void GradientSlider::GradientSliderPrivate::setOrientationWithoutSignalAndForceN
         q_pointer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     }
     m_orientation = newOrientation;
+    m_gradientImageCache.setOrientation(newOrientation);
     m_gradientImageCache.setGradientLength(physicalPixelLength());
     m_gradientImageCache.setGradientThickness(
         // Normally, this should not change, but maybe on Hight-DPI
@@ -515,25 +516,6 @@ qreal GradientSlider::GradientSliderPrivate::fromWidgetPixelPositionToValue(QPoi
 void GradientSlider::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
-    // We do not paint directly on the widget, but on a QImage buffer first:
-    // Render anti-aliased looks better. But as Qt documentation says:
-    //
-    //      “Renderhints are used to specify flags to QPainter that may or
-    //       may not be respected by any given engine.”
-    //
-    // Painting here directly on the widget might lead to different
-    // anti-aliasing results depending on the underlying window system. This
-    // is especially problematic as anti-aliasing might shift or not a pixel
-    // to the left or to the right. So we paint on a QImage first. As QImage
-    // (at difference to QPixmap and a QWidget) is independent of native
-    // platform rendering, it guarantees identical anti-aliasing results on
-    // all platforms. Here the quote from QPainter class documentation:
-    //
-    //      “To get the optimal rendering result using QPainter, you should
-    //       use the platform independent QImage as paint device; i.e. using
-    //       QImage will ensure that the result has an identical pixel
-    //       representation on any platform.”
-    QImage paintBuffer;
 
     // Paint the gradient itself.
     // Make sure the image will be correct. We set length and thicknes,
@@ -548,11 +530,20 @@ void GradientSlider::paintEvent(QPaintEvent *event)
     d_pointer->m_gradientImageCache.setGradientThickness(
         // Normally, this should not change, but maybe on Hight-DPI
         // devices there are some differences.
-        d_pointer->physicalPixelLength());
-    paintBuffer = d_pointer->m_gradientImageCache.getImage();
+        d_pointer->physicalPixelThickness());
+    d_pointer->m_gradientImageCache.setOrientation(d_pointer->m_orientation);
+    d_pointer->m_gradientImageCache.setLayoutDirection(layoutDirection());
+    d_pointer->m_gradientImageCache.setColorVisionDeficiency(colorVisionDeficiency());
+    d_pointer->m_gradientImageCache.setDisplayColorSpace(displayColorSpace());
+    // The image is yet in the final orientation and layout direction,
+    // so we can paint it without transformation. We paint it directly
+    // on the widget and do not open a QPainter on the image: That would
+    // detach the image from the cache, which means a deep copy on each
+    // paint event.
+    QPainter widgetPainter(this);
+    widgetPainter.drawImage(0, 0, d_pointer->m_gradientImageCache.getImage());
 
     // Draw slider handle
-    QPainter bufferPainter(&paintBuffer);
     // We use antialiasing. As our current handle is just a horizontal or
     // vertical line, it might be slightly sharper without antialiasing.
     // But all other widgets of this library WILL USE antialiasing because
@@ -563,34 +554,14 @@ void GradientSlider::paintEvent(QPaintEvent *event)
     // a good idea. Therefore, we USE antialiasing here. Anyway, in practical
     // tests, it seems almost as sharp as without antialiasing, and
     // additionally the position is more exact!
-    bufferPainter.setRenderHint(QPainter::Antialiasing, true);
-    QPen pen;
-    const qreal handleCoordinatePoint = d_pointer->physicalPixelLength() / devicePixelRatioF() * d_pointer->m_value;
-    if (hasFocus()) {
-        pen.setWidthF(handleOutlineThickness() * 3);
-        pen.setColor(focusIndicatorColor());
-        bufferPainter.setPen(pen);
-        bufferPainter.drawLine(QPointF(handleCoordinatePoint, 0), QPointF(handleCoordinatePoint, gradientThickness()));
-    }
-    pen.setWidthF(handleOutlineThickness());
-    pen.setColor(handleColorFromBackgroundLightness(d_pointer->m_gradientImageCache.colorFromValue(d_pointer->m_value).l));
-    bufferPainter.setPen(pen);
-    bufferPainter.drawLine(QPointF(handleCoordinatePoint, 0), QPointF(handleCoordinatePoint, gradientThickness()));
-
-    // Paint the buffer to the actual widget
+    widgetPainter.setRenderHint(QPainter::Antialiasing, true);
+    // The handle is defined in the default form of the gradient: The first
+    // color is on the left, and the second color is on the right. To paint
+    // it, we have to rotate it if our actual orientation is vertical. And
+    // we have to mirror it when our actual layout direction is RTL.
     QTransform transform;
-    // The m_gradientImageCache contains the gradient always
-    // in a default form, independant of the actual orientation
-    // of this widget and independant of its actual layout direction:
-    // In the default form, the first color is always on the left, and the
-    // second color is always on the right. To paint it, we have to
-    // rotate it if our actual orientation is vertical. And we have to
-    // mirror it when our actual layout direction is RTL.
     if (d_pointer->m_orientation == Qt::Orientation::Vertical) {
         if (layoutDirection() == Qt::LayoutDirection::RightToLeft) {
-            // Even on vertical gradients, we mirror the image, so that
-            // the well-aligned edge of the transparency background is
-            // always aligned according to the writing direction.
             transform.scale(-1, 1);
             transform.rotate(270);
             transform.translate(size().height() * (-1), size().width() * (-1));
@@ -604,9 +575,19 @@ void GradientSlider::paintEvent(QPaintEvent *event)
             transform.translate(size().width() * (-1), 0);
         }
     }
-    QPainter widgetPainter(this);
     widgetPainter.setTransform(transform);
-    widgetPainter.drawImage(0, 0, paintBuffer);
+    QPen pen;
+    const qreal handleCoordinatePoint = d_pointer->physicalPixelLength() / devicePixelRatioF() * d_pointer->m_value;
+    if (hasFocus()) {
+        pen.setWidthF(handleOutlineThickness() * 3);
+        pen.setColor(focusIndicatorColor());
+        widgetPainter.setPen(pen);
+        widgetPainter.drawLine(QPointF(handleCoordinatePoint, 0), QPointF(handleCoordinatePoint, gradientThickness()));
+    }
+    pen.setWidthF(handleOutlineThickness());
+    pen.setColor(handleColorFromBackgroundLightness(d_pointer->m_gradientImageCache.colorFromValue(d_pointer->m_value).l));
+    widgetPainter.setPen(pen);
+    widgetPainter.drawLine(QPointF(handleCoordinatePoint, 0), QPointF(handleCoordinatePoint, gradientThickness()));
 
     //     // TODO Draw a focus rectangle like this?:
     //     widgetPainter.setTransform(QTransform());
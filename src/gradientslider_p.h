@@ -64,11 +64,10 @@ public:
     LchaDouble m_firstColor;
     /** @brief Cache for the gradient image
      *
-     * Holds the current gradient image (without the handle).
-     * Always at the left is the first color, always at the right is the
-     * second color. This is idependent from the actual @ref orientation
-     * and the actual LTR or RTL layout. So when painting, it might be
-     * necessary to rotate or mirror the image. */
+     * Holds the current gradient image (without the handle), yet
+     * rotated and mirrored according to the actual @ref orientation
+     * and the actual LTR or RTL layout. So it can be painted without
+     * transformation. */
     GradientImage m_gradientImageCache;
     /** @brief Internal storage for property @ref orientation */
     Qt::Orientation m_orientation;
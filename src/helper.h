@@ -61,6 +61,16 @@ namespace PerceptualColor
  * slower processing. */
 constexpr qreal gamutPrecision = 0.001;
 
+/** @internal
+ *
+ * @brief Precision for gamut boundary search during mouse drags
+ *
+ * While a mouse button is held, the widgets search the gamut boundary
+ * only with this (coarser) precision, which is still well below one
+ * pixel. Once the mouse button is released, they search again with
+ * @ref gamutPrecision, so the final color does not depend on this value. */
+constexpr qreal interactiveGamutPrecision = 0.1;
+
 /** @internal
  *
  * @brief Template function to test if a value is within a certain range
@@ -0,0 +1,208 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef IMAGEVARIANTCACHE_H
+#define IMAGEVARIANTCACHE_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QImage>
+#include <QList>
+#include <QSizeF>
+
+namespace PerceptualColor
+{
+/** @internal
+ *
+ * @brief Default memory budget for @ref ImageVariantCache, measured
+ * in bytes.
+ *
+ * This budget applies to <em>each</em> cache instance. As each instance
+ * holds only variants for the current widget size, the budget is only a
+ * safety net. */
+constexpr qsizetype imageVariantCacheBudget = 32 * 1024 * 1024;
+
+/** @internal
+ *
+ * @brief A small cache of previously rendered variants of an image.
+ *
+ * The image classes of this library (like @ref ChromaHueImage) hold a
+ * single cached image. When a window is moved between monitors with
+ * different device pixel ratios, the physical image size (and the
+ * device pixel ratio) change back and forth, and each move would
+ * trigger a new rendering. This class retains the previously rendered
+ * variants, identified by a key that describes the geometry of the image
+ * (physical size, border, device pixel ratio…). Moving back to a monitor
+ * can therefore reuse the old variant instantly.
+ *
+ * Only the <em>geometry</em> may be part of the key. When a property
+ * that changes the actual content of the image (like the lightness in
+ * @ref ChromaHueImage) is modified, the owner has to call @ref clear().
+ *
+ * Only variants for the current widget size are retained: Inserting a
+ * variant drops all variants for another widget size (measured in
+ * device-independent pixels). These are stale after the widget has been
+ * resized. So interactive resizing does not fill the cache, while the
+ * variants for other device pixel ratios (or other orientations) of the
+ * same widget size are kept.
+ *
+ * Furthermore, the memory of this instance is bounded by a budget (see
+ * @ref setBudget()). When inserting a new variant exceeds the budget, the
+ * least recently used variants are dropped. The most recently inserted
+ * variant is always kept, even if it alone exceeds the budget.
+ *
+ * <tt>QImage</tt> is implicitly shared. Storing an image here that is
+ * also stored elsewhere does not consume additional memory.
+ *
+ * @tparam Key The key type. Must provide <tt>operator==</tt>. A
+ * <tt>std::tuple</tt> of the geometry properties is a good choice.
+ *
+ * @note This class is not based on <tt>QCache</tt> because the cost
+ * of an image is only known after rendering, and because the number of
+ * variants is very small (a linear search is faster than hashing here). */
+template<typename Key> class ImageVariantCache final
+{
+public:
+    /** @brief Default constructor */
+    ImageVariantCache() = default;
+
+    /** @brief Default destructor */
+    ~ImageVariantCache() noexcept = default;
+
+    /** @brief Removes all variants. */
+    void clear()
+    {
+        m_entries.clear();
+    }
+
+    /** @brief Inserts a variant.
+     *
+     * If there is yet a variant for the given key, it is replaced. All
+     * variants for another widget size are removed. The new variant
+     * becomes the most recently used one.
+     *
+     * @param key The key of the variant
+     * @param image The image. Null images are ignored.
+     * @param widgetSize The size of the widget for which the image has
+     * been rendered, measured in device-independent pixels. This is
+     * typically the physical image size divided by the device pixel
+     * ratio. As the physical size is rounded, sizes that differ by less
+     * than one pixel are considered equal. */
+    void insert(const Key &key, const QImage &image, const QSizeF &widgetSize)
+    {
+        if (image.isNull()) {
+            return;
+        }
+        for (int i = m_entries.size() - 1; i >= 0; --i) {
+            const Entry &entry = m_entries.at(i);
+            const bool isOtherWidgetSize = //
+                (qAbs(entry.widgetSize.width() - widgetSize.width()) >= 1) //
+                || (qAbs(entry.widgetSize.height() - widgetSize.height()) >= 1);
+            if ((entry.key == key) || isOtherWidgetSize) {
+                m_entries.removeAt(i);
+            }
+        }
+        m_entries.prepend(Entry {key, image, widgetSize});
+        shrinkToBudget();
+    }
+
+    /** @brief Sets the memory budget.
+     *
+     * @param newBudget The new budget, measured in bytes. */
+    void setBudget(const qsizetype newBudget)
+    {
+        m_budget = qMax<qsizetype>(0, newBudget);
+        shrinkToBudget();
+    }
+
+    /** @brief The number of variants currently held.
+     *
+     * @returns The number of variants currently held. */
+    int size() const
+    {
+        return m_entries.size();
+    }
+
+    /** @brief Looks up a variant.
+     *
+     * If a variant is found, it becomes the most recently used one.
+     *
+     * @param key The key of the variant
+     * @returns The image of the variant if available. A null image
+     * otherwise. */
+    QImage value(const Key &key)
+    {
+        for (int i = 0; i < m_entries.size(); ++i) {
+            if (m_entries.at(i).key == key) {
+                m_entries.move(i, 0);
+                return m_entries.at(0).image;
+            }
+        }
+        return QImage();
+    }
+
+private:
+    Q_DISABLE_COPY(ImageVariantCache)
+
+    /** @brief A single variant */
+    struct Entry {
+        /** @brief The key */
+        Key key;
+        /** @brief The image */
+        QImage image;
+        /** @brief The widget size of the image, measured in
+         * device-independent pixels */
+        QSizeF widgetSize;
+    };
+
+    /** @brief Drops the least recently used variants until the
+     * memory budget is respected.
+     *
+     * The most recently used variant is never dropped. */
+    void shrinkToBudget()
+    {
+        qsizetype total = 0;
+        for (const Entry &entry : qAsConst(m_entries)) {
+            total += entry.image.sizeInBytes();
+        }
+        while ((m_entries.size() > 1) && (total > m_budget)) {
+            total -= m_entries.last().image.sizeInBytes();
+            m_entries.removeLast();
+        }
+    }
+
+    /** @brief Internal storage for the memory budget.
+     *
+     * @sa @ref setBudget() */
+    qsizetype m_budget = imageVariantCacheBudget;
+    /** @brief The variants, the most recently used one first. */
+    QList<Entry> m_entries;
+};
+
+} // namespace PerceptualColor
+
+#endif // IMAGEVARIANTCACHE_H
@@ -0,0 +1,129 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "labbuffer.h"
+
+#include <QtMath>
+
+namespace PerceptualColor
+{
+/** @brief The value at a given index.
+ *
+ * @param index The index. Valid range: <tt>[0, @ref count()[</tt>
+ * @returns The value at the given index */
+cmsCIELab LabBuffer::at(int index) const
+{
+    cmsCIELab result;
+    result.L = l()[index];
+    result.a = a()[index];
+    result.b = b()[index];
+    return result;
+}
+
+/** @brief Converts LCh values to Lab values.
+ *
+ * @param lch A view to LCh values, with the plane layout
+ * of @ref LchBuffer.
+ * @returns The corresponding Lab values. */
+LabBuffer LabBuffer::fromLch(PlanarView<const double> lch)
+{
+    LabBuffer result(lch.count());
+    fromLch(lch, result.view());
+    return result;
+}
+
+/** @brief Converts LCh values to Lab values.
+ *
+ * Like @ref fromLch(PlanarView<const double>), but writes into an
+ * existing buffer, so that callers that convert repeatedly do not
+ * allocate new memory each time.
+ *
+ * @param lch A view to LCh values, with the plane layout
+ * of @ref LchBuffer.
+ * @param lab View to a @ref LabBuffer (or a slice of it) that will
+ * receive <tt>lch.count()</tt> values. */
+void LabBuffer::fromLch(PlanarView<const double> lch, PlanarView<double> lab)
+{
+    const int count = lch.count();
+    const double *lchL = lch.plane(0);
+    const double *lchC = lch.plane(1);
+    const double *lchH = lch.plane(2);
+    double *labL = lab.plane(0);
+    double *labA = lab.plane(1);
+    double *labB = lab.plane(2);
+    for (int i = 0; i < count; ++i) {
+        labL[i] = lchL[i];
+    }
+    for (int i = 0; i < count; ++i) {
+        const double hueRadian = qDegreesToRadians(lchH[i]);
+        labA[i] = lchC[i] * qCos(hueRadian);
+        labB[i] = lchC[i] * qSin(hueRadian);
+    }
+}
+
+/** @brief Conversion from <tt>QVector<cmsCIELab></tt>.
+ *
+ * @param vector The values to convert
+ * @returns A buffer with the same values */
+LabBuffer LabBuffer::fromVector(const QVector<cmsCIELab> &vector)
+{
+    LabBuffer result(vector.count());
+    for (int i = 0; i < vector.count(); ++i) {
+        result.set(i, vector.at(i));
+    }
+    return result;
+}
+
+/** @brief Sets the value at a given index.
+ *
+ * @param index The index. Valid range: <tt>[0, @ref count()[</tt>
+ * @param value The new value */
+void LabBuffer::set(int index, const cmsCIELab &value)
+{
+    l()[index] = value.L;
+    a()[index] = value.a;
+    b()[index] = value.b;
+}
+
+/** @brief Conversion to <tt>QVector<cmsCIELab></tt>.
+ *
+ * @returns A vector with the same values */
+QVector<cmsCIELab> LabBuffer::toVector() const
+{
+    QVector<cmsCIELab> result;
+    result.reserve(count());
+    for (int i = 0; i < count(); ++i) {
+        result.append(at(i));
+    }
+    return result;
+}
+
+} // namespace PerceptualColor
@@ -0,0 +1,108 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LABBUFFER_H
+#define LABBUFFER_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QVector>
+
+#include "planarbuffer.h"
+
+#include <lcms2.h>
+
+namespace PerceptualColor
+{
+/** @internal
+ *
+ * @brief A buffer of Lab values, stored as structure-of-arrays.
+ *
+ * Plane <tt>0</tt> contains L*, plane <tt>1</tt> contains a* and
+ * plane <tt>2</tt> contains b*. See @ref PlanarBuffer for details
+ * about the memory layout. This layout can be passed directly to the
+ * batch functions of @ref RgbColorSpace.
+ *
+ * @sa @ref LchBuffer */
+class LabBuffer final : public PlanarBuffer
+{
+public:
+    /** @brief Constructor
+     *
+     * @param count Number of values. They are initialized with
+     * <tt>0</tt>. */
+    explicit LabBuffer(int count = 0)
+        : PlanarBuffer(count)
+    {
+    }
+    /** @brief The a* plane
+     * @returns Pointer to the first a* value */
+    double *a() noexcept
+    {
+        return plane(1);
+    }
+    /** @brief The a* plane
+     * @returns Pointer to the first a* value */
+    const double *a() const noexcept
+    {
+        return plane(1);
+    }
+    cmsCIELab at(int index) const;
+    /** @brief The b* plane
+     * @returns Pointer to the first b* value */
+    double *b() noexcept
+    {
+        return plane(2);
+    }
+    /** @brief The b* plane
+     * @returns Pointer to the first b* value */
+    const double *b() const noexcept
+    {
+        return plane(2);
+    }
+    static LabBuffer fromLch(PlanarView<const double> lch);
+    static void fromLch(PlanarView<const double> lch, PlanarView<double> lab);
+    static LabBuffer fromVector(const QVector<cmsCIELab> &vector);
+    /** @brief The L* plane
+     * @returns Pointer to the first L* value */
+    double *l() noexcept
+    {
+        return plane(0);
+    }
+    /** @brief The L* plane
+     * @returns Pointer to the first L* value */
+    const double *l() const noexcept
+    {
+        return plane(0);
+    }
+    void set(int index, const cmsCIELab &value);
+    QVector<cmsCIELab> toVector() const;
+};
+
+} // namespace PerceptualColor
+
+#endif // LABBUFFER_H
@@ -0,0 +1,141 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "latencyhistogram.h"
+
+#include <QtAlgorithms>
+#include <QtMath>
+
+namespace PerceptualColor
+{
+Q_LOGGING_CATEGORY(latencyLoggingCategory, "perceptualcolor.latency", QtWarningMsg)
+
+/** @brief The bucket for a given value.
+ *
+ * @param microseconds The value
+ *
+ * @returns The index of the bucket that counts the value. */
+int LatencyHistogram::bucketIndex(qint64 microseconds)
+{
+    if (microseconds < linearLimit) {
+        return qMax<int>(static_cast<int>(microseconds), 0);
+    }
+    const int exponent = 63 - qCountLeadingZeroBits(static_cast<quint64>(microseconds));
+    if (exponent >= maximumExponent) {
+        return bucketCount - 1;
+    }
+    const int subBucket = static_cast<int>( //
+        (microseconds >> (exponent - subBucketBits)) & (subBucketCount - 1));
+    return linearLimit + (exponent - linearExponent) * subBucketCount + subBucket;
+}
+
+/** @brief The biggest value that is counted in a given bucket.
+ *
+ * @param index The index of the bucket
+ *
+ * @returns The biggest value that is counted in the given bucket. */
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < linearLimit) {
+        return index;
+    }
+    const int exponent = linearExponent + (index - linearLimit) / subBucketCount;
+    const int subBucket = (index - linearLimit) % subBucketCount;
+    const qint64 width = Q_INT64_C(1) << (exponent - subBucketBits);
+    return (subBucketCount + subBucket) * width + width - 1;
+}
+
+/** @brief Adds a sample.
+ *
+ * @param microseconds The latency. Negative values are counted as 0. */
+void LatencyHistogram::addSample(qint64 microseconds)
+{
+    const qint64 value = qMax<qint64>(microseconds, 0);
+    ++m_buckets[static_cast<std::size_t>(bucketIndex(value))];
+    ++m_count;
+    m_maximum = qMax(m_maximum, value);
+}
+
+/** @brief Removes all samples. */
+void LatencyHistogram::clear()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_maximum = 0;
+}
+
+/** @brief The number of samples.
+ *
+ * @returns The number of samples. */
+int LatencyHistogram::count() const
+{
+    return m_count;
+}
+
+/** @brief The biggest sample.
+ *
+ * @returns The biggest sample, measured in microseconds, or 0 if there
+ * are no samples. */
+qint64 LatencyHistogram::maximum() const
+{
+    return m_maximum;
+}
+
+/** @brief A percentile of the samples.
+ *
+ * @param percentile The percentile. Range: <tt>[0, 100]</tt>. For
+ * example, <tt>50</tt> for the median or <tt>99</tt> for the value that
+ * 99 % of the samples do not exceed.
+ *
+ * @returns The percentile, measured in microseconds. The value is the
+ * upper bound of the bucket that contains the percentile (but never bigger
+ * than @ref maximum()), so it is never smaller than the exact value.
+ * 0 if there are no samples. */
+qint64 LatencyHistogram::percentile(qreal percentile) const
+{
+    if (m_count <= 0) {
+        return 0;
+    }
+    const qreal boundedPercentile = qBound<qreal>(0, percentile, 100);
+    const int rank = qBound(1, //
+                            qCeil(boundedPercentile / 100 * m_count),
+                            m_count);
+    int cumulativeCount = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        cumulativeCount += m_buckets[static_cast<std::size_t>(i)];
+        if (cumulativeCount >= rank) {
+            return qMin(bucketUpperBound(i), m_maximum);
+        }
+    }
+    return m_maximum;
+}
+
+} // namespace PerceptualColor
@@ -0,0 +1,102 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QLoggingCategory>
+#include <QtGlobal>
+
+#include <array>
+
+namespace PerceptualColor
+{
+/** @internal
+ *
+ * @brief Logging category for input-to-paint latencies.
+ *
+ * The category name is <tt>perceptualcolor.latency</tt>. Only warnings
+ * are enabled by default. To get a debug message for each sample, use
+ * for example the environment variable
+ * <tt>QT_LOGGING_RULES="perceptualcolor.latency.debug=true"</tt>. */
+Q_DECLARE_LOGGING_CATEGORY(latencyLoggingCategory)
+
+/** @internal
+ *
+ * @brief Histogram of latencies.
+ *
+ * Samples are measured in microseconds. The histogram does not store the
+ * samples themselves, but only counts them in buckets of logarithmic
+ * width: Values below 16 µs have a bucket of their own; above that, each
+ * power of two is split into 8 buckets. So the memory usage is constant,
+ * adding a sample is <em>O(1)</em>, and the relative error of
+ * @ref percentile() is at most 12.5 %. */
+class LatencyHistogram final
+{
+public:
+    void addSample(qint64 microseconds);
+    void clear();
+    int count() const;
+    qint64 maximum() const;
+    qint64 percentile(qreal percentile) const;
+
+private:
+    /** @brief Number of sub-buckets per power of two, as power of two. */
+    static constexpr int subBucketBits = 3;
+    /** @brief Number of sub-buckets per power of two. */
+    static constexpr int subBucketCount = 1 << subBucketBits;
+    /** @brief Exponent of the first power of two that is split into
+     * sub-buckets. Smaller values have a bucket of their own. */
+    static constexpr int linearExponent = subBucketBits + 1;
+    /** @brief Values below this limit have a bucket of their own. */
+    static constexpr int linearLimit = 1 << linearExponent;
+    /** @brief Values from <tt>2^maximumExponent</tt> µs (about 12 days)
+     * on are counted in the last bucket. */
+    static constexpr int maximumExponent = 40;
+    /** @brief Total number of buckets. */
+    static constexpr int bucketCount = //
+        linearLimit + (maximumExponent - linearExponent) * subBucketCount;
+
+    static int bucketIndex(qint64 microseconds);
+    static qint64 bucketUpperBound(int index);
+
+    /** @brief Number of samples per bucket. */
+    std::array<int, bucketCount> m_buckets {};
+    /** @brief Total number of samples. */
+    int m_count = 0;
+    /** @brief Biggest sample. */
+    qint64 m_maximum = 0;
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestLatencyHistogram;
+};
+
+} // namespace PerceptualColor
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,119 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "lchbuffer.h"
+
+#include <QtMath>
+
+namespace PerceptualColor
+{
+/** @brief The value at a given index.
+ *
+ * @param index The index. Valid range: <tt>[0, @ref count()[</tt>
+ * @returns The value at the given index */
+LchDouble LchBuffer::at(int index) const
+{
+    LchDouble result;
+    result.l = l()[index];
+    result.c = c()[index];
+    result.h = h()[index];
+    return result;
+}
+
+/** @brief Converts Lab values to LCh values.
+ *
+ * @param lab A view to Lab values, with the plane layout
+ * of @ref LabBuffer.
+ * @returns The corresponding LCh values. The hue is within
+ * <tt>[0, 360[</tt>. */
+LchBuffer LchBuffer::fromLab(PlanarView<const double> lab)
+{
+    const int count = lab.count();
+    LchBuffer result(count);
+    const double *labL = lab.plane(0);
+    const double *labA = lab.plane(1);
+    const double *labB = lab.plane(2);
+    double *lchL = result.l();
+    double *lchC = result.c();
+    double *lchH = result.h();
+    // Separate loops, so that at least the first two
+    // can be vectorized by the compiler.
+    for (int i = 0; i < count; ++i) {
+        lchL[i] = labL[i];
+    }
+    for (int i = 0; i < count; ++i) {
+        lchC[i] = qSqrt(labA[i] * labA[i] + labB[i] * labB[i]);
+    }
+    for (int i = 0; i < count; ++i) {
+        const double hue = qRadiansToDegrees(qAtan2(labB[i], labA[i]));
+        lchH[i] = (hue < 0) ? hue + 360 : hue;
+    }
+    return result;
+}
+
+/** @brief Conversion from <tt>QVector<LchDouble></tt>.
+ *
+ * @param vector The values to convert
+ * @returns A buffer with the same values */
+LchBuffer LchBuffer::fromVector(const QVector<LchDouble> &vector)
+{
+    LchBuffer result(vector.count());
+    for (int i = 0; i < vector.count(); ++i) {
+        result.set(i, vector.at(i));
+    }
+    return result;
+}
+
+/** @brief Sets the value at a given index.
+ *
+ * @param index The index. Valid range: <tt>[0, @ref count()[</tt>
+ * @param value The new value */
+void LchBuffer::set(int index, const LchDouble &value)
+{
+    l()[index] = value.l;
+    c()[index] = value.c;
+    h()[index] = value.h;
+}
+
+/** @brief Conversion to <tt>QVector<LchDouble></tt>.
+ *
+ * @returns A vector with the same values */
+QVector<LchDouble> LchBuffer::toVector() const
+{
+    QVector<LchDouble> result;
+    result.reserve(count());
+    for (int i = 0; i < count(); ++i) {
+        result.append(at(i));
+    }
+    return result;
+}
+
+} // namespace PerceptualColor
@@ -0,0 +1,107 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LCHBUFFER_H
+#define LCHBUFFER_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QVector>
+
+#include "PerceptualColor/lchdouble.h"
+#include "planarbuffer.h"
+
+namespace PerceptualColor
+{
+/** @internal
+ *
+ * @brief A buffer of LCh values, stored as structure-of-arrays.
+ *
+ * Plane <tt>0</tt> contains the lightness, plane <tt>1</tt> the chroma
+ * and plane <tt>2</tt> the hue. See @ref PlanarBuffer for details
+ * about the memory layout.
+ *
+ * @snippet test/testlchbuffer.cpp Use LchBuffer
+ *
+ * @sa @ref LabBuffer */
+class LchBuffer final : public PlanarBuffer
+{
+public:
+    /** @brief Constructor
+     *
+     * @param count Number of values. They are initialized with
+     * <tt>0</tt>. */
+    explicit LchBuffer(int count = 0)
+        : PlanarBuffer(count)
+    {
+    }
+    LchDouble at(int index) const;
+    /** @brief The chroma plane
+     * @returns Pointer to the first chroma value */
+    double *c() noexcept
+    {
+        return plane(1);
+    }
+    /** @brief The chroma plane
+     * @returns Pointer to the first chroma value */
+    const double *c() const noexcept
+    {
+        return plane(1);
+    }
+    static LchBuffer fromLab(PlanarView<const double> lab);
+    static LchBuffer fromVector(const QVector<LchDouble> &vector);
+    /** @brief The hue plane
+     * @returns Pointer to the first hue value */
+    double *h() noexcept
+    {
+        return plane(2);
+    }
+    /** @brief The hue plane
+     * @returns Pointer to the first hue value */
+    const double *h() const noexcept
+    {
+        return plane(2);
+    }
+    /** @brief The lightness plane
+     * @returns Pointer to the first lightness value */
+    double *l() noexcept
+    {
+        return plane(0);
+    }
+    /** @brief The lightness plane
+     * @returns Pointer to the first lightness value */
+    const double *l() const noexcept
+    {
+        return plane(0);
+    }
+    void set(int index, const LchDouble &value);
+    QVector<LchDouble> toVector() const;
+};
+
+} // namespace PerceptualColor
+
+#endif // LCHBUFFER_H
@@ -145,49 +145,45 @@ MultiSpinBox::MultiSpinBoxPrivate::MultiSpinBoxPrivate(MultiSpinBox *backLink)
 {
 }
 
-/** @brief The recommended size for the widget
- *
- * Reimplemented from base class.
+/** @brief The size of the content of the widget.
  *
- * @returns the size hint
+ * This is the size of the longest possible text, which is calculated
+ * for the current font, the current locale and the current section
+ * configurations.
  *
- * @internal
- *
- * @sa @ref minimumSizeHint() */
-QSize MultiSpinBox::sizeHint() const
+ * @returns The size of the content. The value is cached in
+ * @ref m_contentSizeHint because layouts might ask often for the
+ * size hint, while measuring the text is expensive. */
+QSize MultiSpinBox::MultiSpinBoxPrivate::contentSizeHint() const
 {
-    // This function intentionally does not cache the text string.
-    // Which variant is the longest text string, that depends on the current
-    // font policy. This might have changed since the last call. Therefore,
-    // each time this functin is called, we calculate again the longest
-    // test string (“completeString”).
-
-    ensurePolished();
+    if (m_contentSizeHint.isValid()) {
+        return m_contentSizeHint;
+    }
 
-    const QFontMetrics myFontMetrics(fontMetrics());
-    QList<MultiSpinBoxSectionConfiguration> myConfiguration = d_pointer->m_sectionConfigurations;
-    int height = lineEdit()->sizeHint().height();
+    const QFontMetrics myFontMetrics(q_pointer->fontMetrics());
+    const QLocale myLocale = q_pointer->locale();
+    int height = q_pointer->lineEdit()->sizeHint().height();
     int width = 0;
     QString textOfMinimumValue;
     QString textOfMaximumValue;
     QString completeString;
 
     // Get the text for all the sections
-    for (int i = 0; i < myConfiguration.count(); ++i) {
+    for (int i = 0; i < m_sectionConfigurations.count(); ++i) {
         // Prefix
-        completeString += myConfiguration.at(i).prefix();
+        completeString += m_sectionConfigurations.at(i).prefix();
         // For each section, test if the minimum value or the maximum
         // takes more space (width). Choose the one that takes more place
         // (width).
-        textOfMinimumValue = locale().toString( //
-            myConfiguration.at(i).minimum(),    // value
-            'f',                                // format
-            myConfiguration.at(i).decimals()    // precision
+        textOfMinimumValue = myLocale.toString(        //
+            m_sectionConfigurations.at(i).minimum(),   // value
+            'f',                                       // format
+            m_sectionConfigurations.at(i).decimals()   // precision
         );
-        textOfMaximumValue = locale().toString( //
-            myConfiguration.at(i).maximum(),    // value
-            'f',                                // format
-            myConfiguration.at(i).decimals()    // precision
+        textOfMaximumValue = myLocale.toString(        //
+            m_sectionConfigurations.at(i).maximum(),   // value
+            'f',                                       // format
+            m_sectionConfigurations.at(i).decimals()   // precision
         );
         if (myFontMetrics.horizontalAdvance(textOfMinimumValue) > myFontMetrics.horizontalAdvance(textOfMaximumValue)) {
             completeString += textOfMinimumValue;
@@ -195,7 +191,7 @@ QSize MultiSpinBox::sizeHint() const
             completeString += textOfMaximumValue;
         }
         // Suffix
-        completeString += myConfiguration.at(i).suffix();
+        completeString += m_sectionConfigurations.at(i).suffix();
     }
 
     // Add some extra space, just as QSpinBox seems to do also.
@@ -205,16 +201,32 @@ QSize MultiSpinBox::sizeHint() const
     // blinking space.
     width = myFontMetrics.horizontalAdvance(completeString) + 2;
 
+    m_contentSizeHint = QSize(width, height);
+    return m_contentSizeHint;
+}
+
+/** @brief The recommended size for the widget
+ *
+ * Reimplemented from base class.
+ *
+ * @returns the size hint
+ *
+ * @internal
+ *
+ * @sa @ref minimumSizeHint() */
+QSize MultiSpinBox::sizeHint() const
+{
+    ensurePolished();
+
     // Calculate the final size in pixel
     QStyleOptionSpinBox myStyleOptionsForSpinBoxes;
     initStyleOption(&myStyleOptionsForSpinBoxes);
-    QSize contentSize(width, height);
     // Calculate widget size necessary to display a given content
     QSize result = style()
-                       ->sizeFromContents(QStyle::CT_SpinBox,          // type
-                                          &myStyleOptionsForSpinBoxes, // style options
-                                          contentSize,                 // size of the content
-                                          this                         // optional widget argument (for better caluclations)
+                       ->sizeFromContents(QStyle::CT_SpinBox,           // type
+                                          &myStyleOptionsForSpinBoxes,  // style options
+                                          d_pointer->contentSizeHint(), // size of the content
+                                          this                          // optional widget argument (for better caluclations)
                                           )
                        .expandedTo(QApplication::globalStrut());
 
@@ -264,19 +276,28 @@ QSize MultiSpinBox::sizeHint() const
 void MultiSpinBox::changeEvent(QEvent *event)
 {
     switch (event->type()) {
+    case QEvent::FontChange:
+    case QEvent::StyleChange:
+        // The size hint has to be calculated again. A content and geometry
+        // update is yet triggered by the base class’s implementation of
+        // this function.
+        d_pointer->m_contentSizeHint = QSize();
+        break;
     case QEvent::LanguageChange:
     case QEvent::LocaleChange:
-    // The base class’s implementation for QEvent::LayoutDirectionChange
-    // would only call update, not updateGeometry…
-    case QEvent::LayoutDirectionChange:
+        // The size hint has to be calculated again.
+        d_pointer->m_contentSizeHint = QSize();
         // Updates the widget content and its geometry
         update();
         updateGeometry();
         break;
+    case QEvent::LayoutDirectionChange:
+        // The base class’s implementation for QEvent::LayoutDirectionChange
+        // would only call update, not updateGeometry…
+        update();
+        updateGeometry();
+        break;
     default:
-        // QEvent::StyleChange or QEvent::FontChange are not handled here
-        // because they trigger yet a content and geometry update in the
-        // base class’s implementation of this function.
         break;
     }
     QAbstractSpinBox::changeEvent(event);
@@ -316,7 +337,7 @@ QString MultiSpinBox::MultiSpinBoxPrivate::formattedValue(int index) const
 {
     return q_pointer->locale().toString(
         // The value to be formatted:
-        q_pointer->sectionValues().at(index),
+        m_sectionValues.at(index),
         // Format as floating point with decimal digits
         'f',
         // Number of decimal digits
@@ -441,8 +462,8 @@ void MultiSpinBox::MultiSpinBoxPrivate::setCurrentIndexWithoutUpdatingText(int n
  * @returns whether stepping up and down is legal */
 QAbstractSpinBox::StepEnabled MultiSpinBox::stepEnabled() const
 {
-    const MultiSpinBoxSectionConfiguration currentSectionConfiguration = d_pointer->m_sectionConfigurations.at(d_pointer->m_currentIndex);
-    const double currentSectionValue = sectionValues().at(d_pointer->m_currentIndex);
+    const MultiSpinBoxSectionConfiguration &currentSectionConfiguration = d_pointer->m_sectionConfigurations.at(d_pointer->m_currentIndex);
+    const double currentSectionValue = d_pointer->m_sectionValues.at(d_pointer->m_currentIndex);
 
     // When wrapping is enabled, step up and step down are always possible.
     if (currentSectionConfiguration.isWrapping()) {
@@ -486,6 +507,8 @@ void MultiSpinBox::setSectionConfigurations(const QList<PerceptualColor::MultiSp
 
     // Set new section configuration
     d_pointer->m_sectionConfigurations = newSectionConfigurations;
+    d_pointer->m_contentSizeHint = QSize();
+    updateGeometry();
 
     // Make sure the value list has the correct length and the
     // values are updated to the new configuration:
@@ -520,6 +543,69 @@ QList<double> MultiSpinBox::sectionValues() const
     return d_pointer->m_sectionValues;
 }
 
+/** @brief Adapts a value to the configuration of a given section.
+ *
+ * @param index The index of the section
+ * @param value The value to adapt
+ * @returns The value, rounded to the number of decimals of the section,
+ * and then wrapped or bound (depending on the section configuration)
+ * to the range between minimum and maximum. */
+double MultiSpinBox::MultiSpinBoxPrivate::fixedSectionValue(int index, double value) const
+{
+    const MultiSpinBoxSectionConfiguration &myConfig = m_sectionConfigurations.at(index);
+    // Round value _before_ applying boundaries/wrapping.
+    const double roundedValue = roundToDigits(value, myConfig.decimals());
+    if (myConfig.isWrapping()) {
+        const double rangeWidth = myConfig.maximum() - myConfig.minimum();
+        if (rangeWidth <= 0) {
+            // This is a speciel case.
+            // This happens when minimum == maximum (or
+            // if minimum > maximum, which is invalid).
+            return myConfig.minimum();
+        }
+        // floating-point modulo (fmod) operation
+        double temp = fmod(
+            // Dividend:
+            roundedValue - myConfig.minimum(),
+            // Divisor:
+            rangeWidth);
+        if (temp < 0) {
+            // Negative results shall be convertet
+            // in positive results:
+            temp += rangeWidth;
+        }
+        return temp + myConfig.minimum();
+    }
+    // If there is no wrapping, simply bound:
+    return qBound(myConfig.minimum(), roundedValue, myConfig.maximum());
+}
+
+/** @brief Sets the value of the current section without updating
+ * other things.
+ *
+ * Like @ref setSectionValuesWithoutFurtherUpdating(), but changes only
+ * the value of the current section. The value is changed in-place, so
+ * no temporary copy of @ref m_sectionValues is created. This function is
+ * called on each key stroke and on each auto-repeat step, so this matters.
+ *
+ * @param newValue The new value of the current section. It will be
+ * adapted by @ref fixedSectionValue() before being applied.
+ *
+ * @post The current value within @ref m_sectionValues gets updated. The
+ * signal @ref sectionValuesChanged() gets emitted if the new value
+ * is actually different from the old one. */
+void MultiSpinBox::MultiSpinBoxPrivate::setCurrentSectionValueWithoutFurtherUpdating(double newValue)
+{
+    if (!isInRange(0, m_currentIndex, m_sectionValues.count() - 1)) {
+        return;
+    }
+    const double fixedValue = fixedSectionValue(m_currentIndex, newValue);
+    if (m_sectionValues.at(m_currentIndex) != fixedValue) {
+        m_sectionValues[m_currentIndex] = fixedValue;
+        Q_EMIT q_pointer->sectionValuesChanged(m_sectionValues);
+    }
+}
+
 /** @brief Sets @ref m_sectionValues without updating other things.
  *
  * Other data of this widget, including the <tt>QLineEdit</tt> text,
@@ -555,43 +641,8 @@ void MultiSpinBox::MultiSpinBoxPrivate::setSectionValuesWithoutFurtherUpdating(c
 
     // Make sure the new section values are
     // valid (minimum <= value <= maximum):
-    MultiSpinBoxSectionConfiguration myConfig;
-    double rangeWidth;
-    qreal temp; // TODO Why qreal and not double?
     for (int i = 0; i < sectionCount; ++i) {
-        myConfig = m_sectionConfigurations.at(i);
-        fixedNewSectionValues[i] =
-            // Round value _before_ applying boundaries/wrapping.
-            roundToDigits(fixedNewSectionValues.at(i), myConfig.decimals());
-        if (myConfig.isWrapping()) {
-            rangeWidth = myConfig.maximum() - myConfig.minimum();
-            if (rangeWidth <= 0) {
-                // This is a speciel case.
-                // This happens when minimum == maximum (or
-                // if minimum > maximum, which is invalid).
-                fixedNewSectionValues[i] = myConfig.minimum();
-            } else {
-                // floating-point modulo (fmod) operation
-                temp = fmod(
-                    // Dividend:
-                    fixedNewSectionValues.at(i) - myConfig.minimum(),
-                    // Divisor:
-                    rangeWidth);
-                if (temp < 0) {
-                    // Negative results shall be convertet
-                    // in positive results:
-                    temp += rangeWidth;
-                }
-                temp += myConfig.minimum();
-                fixedNewSectionValues[i] = temp;
-            }
-        } else {
-            fixedNewSectionValues[i] = qBound(
-                // If there is no wrapping, simply bound:
-                myConfig.minimum(),
-                fixedNewSectionValues.at(i),
-                myConfig.maximum());
-        }
+        fixedNewSectionValues[i] = fixedSectionValue(i, fixedNewSectionValues.at(i));
     }
 
     if (m_sectionValues != fixedNewSectionValues) {
@@ -769,15 +820,18 @@ void MultiSpinBox::focusInEvent(QFocusEvent *event)
 void MultiSpinBox::stepBy(int steps)
 {
     const int currentIndex = d_pointer->m_currentIndex;
-    QList<double> myValues = sectionValues();
-    myValues[currentIndex] += steps * d_pointer->m_sectionConfigurations.at(currentIndex).singleStep();
     // As explained in QAbstractSpinBox documentation:
     //    “Note that this function is called even if the resulting value will
     //     be outside the bounds of minimum and maximum. It’s this function’s
     //     job to handle these situations.”
     // Therefore, the result has to be bound to the actual minimum and maximum
-    // values.
-    setSectionValues(myValues);
+    // values. This is done by setCurrentSectionValueWithoutFurtherUpdating(),
+    // which changes the value in-place. (This function is called
+    // continuously during auto-repeat, so we avoid copying the value list.)
+    d_pointer->setCurrentSectionValueWithoutFurtherUpdating( //
+        d_pointer->m_sectionValues.at(currentIndex) //
+        + steps * d_pointer->m_sectionConfigurations.at(currentIndex).singleStep());
+    d_pointer->updatePrefixValueSuffixText();
     // Update the content of the QLineEdit and select the current
     // value (as cursor text selection):
     d_pointer->setCurrentIndexAndUpdateTextAndSelectValue(currentIndex);
@@ -800,10 +854,12 @@ void MultiSpinBox::MultiSpinBoxPrivate::updateCurrentValueFromText(const QString
     // Get the clean test. That means, we start with “text”, but
     // we remove the m_currentSectionTextBeforeValue and the
     // m_currentSectionTextAfterValue, so that only the text of
-    // the value itself remains.
-    QString cleanText = lineEditText;
+    // the value itself remains. This function is called on each key
+    // stroke, so we work on a QStringView and do not allocate
+    // temporary strings.
+    QStringView cleanText {lineEditText};
     if (cleanText.startsWith(m_textBeforeCurrentValue)) {
-        cleanText.remove(0, m_textBeforeCurrentValue.count());
+        cleanText = cleanText.mid(m_textBeforeCurrentValue.count());
     } else {
         // The text does not start with the correct characters.
         // This is an error.
@@ -831,9 +887,8 @@ void MultiSpinBox::MultiSpinBoxPrivate::updateCurrentValueFromText(const QString
 
     // Update…
     bool ok;
-    QList<double> myValues = q_pointer->sectionValues();
-    myValues[m_currentIndex] = q_pointer->locale().toDouble(cleanText, &ok);
-    setSectionValuesWithoutFurtherUpdating(myValues);
+    setCurrentSectionValueWithoutFurtherUpdating( //
+        q_pointer->locale().toDouble(cleanText, &ok));
     // Make sure that the buttons for step up and step down are updated.
     q_pointer->update();
     // The lineEdit()->text() property is intentionally not updated because
@@ -77,6 +77,15 @@ public:
      * @sa @ref sectionConfigurations()
      * @sa @ref setSectionConfigurations() */
     QList<MultiSpinBoxSectionConfiguration> m_sectionConfigurations;
+    /** @brief Cache for the content size within @ref MultiSpinBox::sizeHint()
+     *
+     * This is the size of the longest possible text, measured with the
+     * current font and locale. An invalid size if there is no
+     * cached value.
+     *
+     * The cache is discarded when the section configurations, the font,
+     * the style, the locale or the language change. */
+    mutable QSize m_contentSizeHint;
     /** @brief Internal storage for property @ref sectionValues. */
     QList<double> m_sectionValues;
     /** @brief The string of everything <em>after</em> the value of the
@@ -111,11 +120,14 @@ public:
     QPointer<ExtendedDoubleValidator> m_validator;
 
     // Functions
+    QSize contentSizeHint() const;
+    double fixedSectionValue(int index, double value) const;
     QString formattedValue(int index) const;
     bool isCursorPositionAtCurrentSectionValue(const int cursorPosition) const;
     void setCurrentIndexAndUpdateTextAndSelectValue(int newIndex);
     void setCurrentIndexToZeroAndUpdateTextAndSelectValue();
     void setCurrentIndexWithoutUpdatingText(int newIndex);
+    void setCurrentSectionValueWithoutFurtherUpdating(double newValue);
     void setSectionValuesWithoutFurtherUpdating(const QList<double> &newSectionValues);
     void updatePrefixValueSuffixText();
 
@@ -0,0 +1,176 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// Own headers
+// First the interface, which forces the header to be self-contained.
+#include "planarbuffer.h"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+namespace PerceptualColor
+{
+/** @brief Constructor
+ *
+ * @param count Number of values per plane. The values are initialized
+ * with <tt>0</tt>. Negative values are treated as <tt>0</tt>. */
+PlanarBuffer::PlanarBuffer(int count)
+{
+    resize(count);
+}
+
+/** @brief Copy constructor
+ *
+ * @param other The object to copy */
+PlanarBuffer::PlanarBuffer(const PlanarBuffer &other)
+    : m_data(allocate(other.m_planeStride))
+    , m_count(other.m_count)
+    , m_planeStride(other.m_planeStride)
+{
+    if (m_data != nullptr) {
+        std::copy(other.m_data, other.m_data + planeCount * m_planeStride, m_data);
+    }
+}
+
+/** @brief Move constructor
+ *
+ * @param other The object to move. It will be empty afterwards. */
+PlanarBuffer::PlanarBuffer(PlanarBuffer &&other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_count(std::exchange(other.m_count, 0))
+    , m_planeStride(std::exchange(other.m_planeStride, 0))
+{
+}
+
+/** @brief Destructor */
+PlanarBuffer::~PlanarBuffer() noexcept
+{
+    deallocate(m_data);
+}
+
+/** @brief Copy assignment operator
+ *
+ * @param other The object to copy
+ * @returns A reference to this object */
+PlanarBuffer &PlanarBuffer::operator=(const PlanarBuffer &other)
+{
+    if (this != &other) {
+        PlanarBuffer temp(other);
+        *this = std::move(temp);
+    }
+    return *this;
+}
+
+/** @brief Move assignment operator
+ *
+ * @param other The object to move. It will be empty afterwards.
+ * @returns A reference to this object */
+PlanarBuffer &PlanarBuffer::operator=(PlanarBuffer &&other) noexcept
+{
+    if (this != &other) {
+        deallocate(m_data);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_count = std::exchange(other.m_count, 0);
+        m_planeStride = std::exchange(other.m_planeStride, 0);
+    }
+    return *this;
+}
+
+/** @brief Changes the number of values per plane.
+ *
+ * Existing values are preserved as far as they fit into the new size.
+ * New values are initialized with <tt>0</tt>. Existing views are
+ * invalidated.
+ *
+ * @param count The new number of values per plane. Negative values are
+ * treated as <tt>0</tt>. */
+void PlanarBuffer::resize(int count)
+{
+    const int newCount = qMax(0, count);
+    const int newPlaneStride = planeStrideForCount(newCount);
+    if (newPlaneStride == m_planeStride) {
+        // The existing allocation can be reused.
+        for (int i = 0; i < planeCount; ++i) {
+            double *currentPlane = plane(i);
+            std::fill(currentPlane + qMin(m_count, newCount), currentPlane + m_planeStride, 0.0);
+        }
+        m_count = newCount;
+        return;
+    }
+    double *newData = allocate(newPlaneStride);
+    const int preservedCount = qMin(m_count, newCount);
+    for (int i = 0; i < planeCount; ++i) {
+        double *newPlane = newData + static_cast<std::ptrdiff_t>(i) * newPlaneStride;
+        std::copy(plane(i), plane(i) + preservedCount, newPlane);
+        std::fill(newPlane + preservedCount, newPlane + newPlaneStride, 0.0);
+    }
+    deallocate(m_data);
+    m_data = newData;
+    m_count = newCount;
+    m_planeStride = newPlaneStride;
+}
+
+/** @brief Allocates memory for all planes.
+ *
+ * @param planeStride The plane stride
+ * @returns Pointer to uninitialized memory for @ref planeCount planes,
+ * aligned to @ref alignment. <tt>nullptr</tt> if <tt>planeStride</tt>
+ * is <tt>0</tt>. */
+double *PlanarBuffer::allocate(int planeStride)
+{
+    if (planeStride <= 0) {
+        return nullptr;
+    }
+    const std::size_t size = sizeof(double) * static_cast<std::size_t>(planeCount) * static_cast<std::size_t>(planeStride);
+    return static_cast<double *>(::operator new(size, std::align_val_t(alignment)));
+}
+
+/** @brief Frees memory that was allocated by @ref allocate().
+ *
+ * @param data The memory to free. Might be <tt>nullptr</tt>. */
+void PlanarBuffer::deallocate(double *data) noexcept
+{
+    if (data != nullptr) {
+        ::operator delete(data, std::align_val_t(alignment));
+    }
+}
+
+/** @brief The plane stride for a given number of values.
+ *
+ * @param count Number of values per plane
+ * @returns <tt>count</tt>, rounded up so that each plane starts at an
+ * @ref alignment boundary. */
+int PlanarBuffer::planeStrideForCount(int count) noexcept
+{
+    constexpr int valuesPerAlignment = static_cast<int>(alignment / sizeof(double));
+    return (count + valuesPerAlignment - 1) / valuesPerAlignment * valuesPerAlignment;
+}
+
+} // namespace PerceptualColor
@@ -0,0 +1,232 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLANARBUFFER_H
+#define PLANARBUFFER_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QtGlobal>
+
+#include <cstddef>
+#include <type_traits>
+
+namespace PerceptualColor
+{
+/** @internal
+ *
+ * @brief Non-owning view to a @ref PlanarBuffer or a part of it.
+ *
+ * A view is cheap to copy. It stays valid as long as the buffer it
+ * refers to is neither destroyed nor resized.
+ *
+ * @tparam T <tt>double</tt> for a view that allows to modify the values,
+ * <tt>const double</tt> for a read-only view. A modifiable view converts
+ * implicitly to a read-only view. */
+template<typename T> class PlanarView final
+{
+public:
+    /** @brief Constructs an empty view. */
+    PlanarView() noexcept = default;
+
+    /** @brief Constructor
+     *
+     * @param data Pointer to the first value of the first plane
+     * @param count Number of values per plane
+     * @param planeStride Distance (measured in values) between the
+     * beginnings of two consecutive planes */
+    PlanarView(T *data, int count, int planeStride) noexcept
+        : m_data(data)
+        , m_count(count)
+        , m_planeStride(planeStride)
+    {
+    }
+
+    /** @brief Conversion from a modifiable to a read-only view.
+     *
+     * @param other The view to convert */
+    template<typename U, typename = std::enable_if_t<std::is_convertible<U *, T *>::value>>
+    PlanarView(const PlanarView<U> &other) noexcept
+        : m_data(other.plane(0))
+        , m_count(other.count())
+        , m_planeStride(other.planeStride())
+    {
+    }
+
+    /** @brief Number of values per plane
+     *
+     * @returns Number of values per plane */
+    int count() const noexcept
+    {
+        return m_count;
+    }
+
+    /** @brief Distance between two planes.
+     *
+     * @returns Distance (measured in values) between the beginnings of
+     * two consecutive planes. */
+    int planeStride() const noexcept
+    {
+        return m_planeStride;
+    }
+
+    /** @brief Access to a plane.
+     *
+     * @param index Index of the plane. Valid range: <tt>[0, 2]</tt>
+     * @returns Pointer to the first value of the plane */
+    T *plane(int index) const noexcept
+    {
+        return m_data + static_cast<std::ptrdiff_t>(index) * m_planeStride;
+    }
+
+    /** @brief A part of this view.
+     *
+     * Slicing keeps @ref planeStride(). A slice can therefore be passed
+     * to LittleCMS like the whole buffer. However, only slices that
+     * start at a multiple of 8 are guaranteed to keep the 64-byte
+     * alignment of the buffer.
+     *
+     * @param begin Index of the first value of the slice. Is bound to
+     * the valid range.
+     * @param count Number of values within the slice. Is bound to the
+     * valid range.
+     * @returns A view to the requested part of this view */
+    PlanarView slice(int begin, int count) const noexcept
+    {
+        const int boundBegin = qBound(0, begin, m_count);
+        const int boundCount = qBound(0, count, m_count - boundBegin);
+        return PlanarView(m_data + boundBegin, boundCount, m_planeStride);
+    }
+
+private:
+    /** @brief Pointer to the first value of the first plane */
+    T *m_data = nullptr;
+    /** @brief Number of values per plane */
+    int m_count = 0;
+    /** @brief Distance (measured in values) between the beginnings
+     * of two consecutive planes */
+    int m_planeStride = 0;
+};
+
+/** @internal
+ *
+ * @brief Buffer for three channels of <tt>double</tt> values, stored as
+ * structure-of-arrays.
+ *
+ * The values of each channel are stored contiguously in their own
+ * <em>plane</em>, and each plane starts at a 64-byte boundary. Compared
+ * to an array of structures like <tt>QVector<LchDouble></tt>, loops that
+ * work on a single channel touch only the memory they need and can be
+ * vectorized by the compiler. Furthermore, all planes are within a single
+ * allocation with a constant distance (@ref planeStride()), which is
+ * exactly the <em>planar</em> buffer layout that LittleCMS supports
+ * natively.
+ *
+ * This is the common base of @ref LchBuffer and @ref LabBuffer. */
+class PlanarBuffer
+{
+public:
+    /** @brief Number of planes */
+    static constexpr int planeCount = 3;
+    /** @brief Alignment of each plane, measured in bytes */
+    static constexpr std::size_t alignment = 64;
+
+    PlanarBuffer() noexcept = default;
+    explicit PlanarBuffer(int count);
+    PlanarBuffer(const PlanarBuffer &other);
+    PlanarBuffer(PlanarBuffer &&other) noexcept;
+    ~PlanarBuffer() noexcept;
+    PlanarBuffer &operator=(const PlanarBuffer &other);
+    PlanarBuffer &operator=(PlanarBuffer &&other) noexcept;
+    /** @brief Number of values per plane
+     *
+     * @returns Number of values per plane */
+    int count() const noexcept
+    {
+        return m_count;
+    }
+    /** @brief Access to a plane.
+     *
+     * @param index Index of the plane. Valid range: <tt>[0, 2]</tt>
+     * @returns Pointer to the first value of the plane */
+    double *plane(int index) noexcept
+    {
+        return m_data + static_cast<std::ptrdiff_t>(index) * m_planeStride;
+    }
+    /** @brief Access to a plane.
+     *
+     * @param index Index of the plane. Valid range: <tt>[0, 2]</tt>
+     * @returns Pointer to the first value of the plane */
+    const double *plane(int index) const noexcept
+    {
+        return m_data + static_cast<std::ptrdiff_t>(index) * m_planeStride;
+    }
+    /** @brief Distance between two planes.
+     *
+     * @returns Distance (measured in values) between the beginnings of
+     * two consecutive planes. This is a multiple of 8, so that each
+     * plane starts at a 64-byte boundary. */
+    int planeStride() const noexcept
+    {
+        return m_planeStride;
+    }
+    void resize(int count);
+    /** @brief A view to the whole buffer.
+     *
+     * @returns A view to the whole buffer */
+    PlanarView<double> view() noexcept
+    {
+        return PlanarView<double>(m_data, m_count, m_planeStride);
+    }
+    /** @brief A read-only view to the whole buffer.
+     *
+     * @returns A read-only view to the whole buffer */
+    PlanarView<const double> view() const noexcept
+    {
+        return PlanarView<const double>(m_data, m_count, m_planeStride);
+    }
+
+private:
+    static double *allocate(int planeStride);
+    static void deallocate(double *data) noexcept;
+    static int planeStrideForCount(int count) noexcept;
+
+    /** @brief The memory of all planes, or <tt>nullptr</tt> if empty. */
+    double *m_data = nullptr;
+    /** @brief Number of values per plane */
+    int m_count = 0;
+    /** @brief Distance (measured in values) between the beginnings
+     * of two consecutive planes */
+    int m_planeStride = 0;
+
+    /** @internal @brief Only for unit tests. */
+    friend class TestPlanarBuffer;
+};
+
+} // namespace PerceptualColor
+
+#endif // PLANARBUFFER_H
@@ -0,0 +1,99 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RENDERINGINTENT_H
+#define RENDERINGINTENT_H
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QHash>
+#include <QMetaType>
+
+#include <lcms2.h>
+
+namespace PerceptualColor
+{
+/** @internal
+ *
+ * @brief A rendering intent, with optional black point compensation.
+ *
+ * Identifies the LittleCMS transforms that @ref RgbColorSpace uses
+ * for a conversion. The default value is the one that @ref RgbColorSpace
+ * uses when no rendering intent is given: Absolute colorimetric, without
+ * black point compensation.
+ *
+ * @note LittleCMS ignores black point compensation for the absolute
+ * colorimetric intent.
+ *
+ * This type is declared as type to Qt’s type system via
+ * <tt>Q_DECLARE_METATYPE</tt>. */
+struct RenderingIntent {
+    /** @brief The LittleCMS rendering intent, like
+     * <tt>INTENT_PERCEPTUAL</tt> or
+     * <tt>INTENT_RELATIVE_COLORIMETRIC</tt> */
+    cmsUInt32Number intent = INTENT_ABSOLUTE_COLORIMETRIC;
+    /** @brief If black point compensation is used. */
+    bool blackPointCompensation = false;
+};
+
+/** @brief Equal operator
+ *
+ * @param first The first value
+ * @param second The second value
+ * @returns <tt>true</tt> if both values are identical. */
+inline bool operator==(const RenderingIntent &first, const RenderingIntent &second)
+{
+    return (first.intent == second.intent) //
+        && (first.blackPointCompensation == second.blackPointCompensation);
+}
+
+/** @brief Unequal operator
+ *
+ * @param first The first value
+ * @param second The second value
+ * @returns <tt>true</tt> if both values are different. */
+inline bool operator!=(const RenderingIntent &first, const RenderingIntent &second)
+{
+    return !(first == second);
+}
+
+/** @brief Hash function, so that @ref RenderingIntent can be used as
+ * key in <tt>QHash</tt>.
+ *
+ * @param key The value
+ * @param seed The seed
+ * @returns The hash value */
+inline uint qHash(const RenderingIntent &key, uint seed = 0)
+{
+    return ::qHash(key.intent * 2 + (key.blackPointCompensation ? 1 : 0), seed);
+}
+
+} // namespace PerceptualColor
+
+Q_DECLARE_METATYPE(PerceptualColor::RenderingIntent)
+
+#endif // RENDERINGINTENT_H
@@ -35,9 +35,13 @@
 
 #include "helper.h"
 #include "iohandlerfactory.h"
+#include "labbuffer.h"
 #include "polarpointf.h"
 
 #include <QDebug>
+#include <QtMath>
+
+#include <cmath>
 
 // TODO There should be no dependency on Posix headers, but only on standard C++.
 #include <unistd.h> // Posix header
@@ -65,7 +69,8 @@ QSharedPointer<PerceptualColor::RgbColorSpace> RgbColorSpace::createSrgb()
     QSharedPointer<PerceptualColor::RgbColorSpace> result {new RgbColorSpace()};
 
     // Transform it into a valid object:
-    cmsHPROFILE srgb = cmsCreate_sRGBProfile(); // Use build-in profile
+    cmsHPROFILE srgb = cmsCreate_sRGBProfileTHR( // Use build-in profile
+        result->d_pointer->m_context);
     result->d_pointer->initialize(srgb);
     cmsCloseProfile(srgb);
 
@@ -92,13 +97,18 @@ QSharedPointer<PerceptualColor::RgbColorSpace> RgbColorSpace::createSrgb()
  * A shared pointer to <tt>nullptr</tt> otherwise. */
 QSharedPointer<PerceptualColor::RgbColorSpace> RgbColorSpace::createFromFile(const QString &fileName)
 {
-    cmsIOHANDLER *myIOHandler = IOHandlerFactory::createReadOnly(nullptr, fileName);
+    // Create an invalid object. It is created already here because
+    // it provides the LittleCMS context for reading the profile.
+    QSharedPointer<PerceptualColor::RgbColorSpace> newObject {new RgbColorSpace()};
+    cmsContext myContext = newObject->d_pointer->m_context;
+
+    cmsIOHANDLER *myIOHandler = IOHandlerFactory::createReadOnly(myContext, fileName);
     if (myIOHandler == nullptr) {
         return nullptr;
     }
 
     cmsHPROFILE myProfileHandle = cmsOpenProfileFromIOhandlerTHR( //
-        nullptr,                                                  // ContextID
+        myContext,                                                // ContextID
         myIOHandler                                               // IO handler
     );
     if (myProfileHandle == nullptr) {
@@ -108,8 +118,6 @@ QSharedPointer<PerceptualColor::RgbColorSpace> RgbColorSpace::createFromFile(con
         return nullptr;
     }
 
-    // Create an invalid object:
-    QSharedPointer<PerceptualColor::RgbColorSpace> newObject {new RgbColorSpace()};
     // Try to transform it into a valid object:
     const bool success = newObject->d_pointer->initialize(myProfileHandle);
     // Clean up
@@ -143,8 +151,20 @@ bool RgbColorSpace::RgbColorSpacePrivate::initialize(cmsHPROFILE rgbProfileHandl
     m_cmsInfoManufacturer = getInformationFromProfile(rgbProfileHandle, cmsInfoManufacturer);
     m_cmsInfoModel = getInformationFromProfile(rgbProfileHandle, cmsInfoModel);
 
+    // Keep a serialized copy of the profile. Other objects (like
+    // DisplayTransform) can create their own transforms from it
+    // after rgbProfileHandle has been closed.
+    cmsUInt32Number profileSize = 0;
+    if (cmsSaveProfileToMem(rgbProfileHandle, nullptr, &profileSize) && (profileSize > 0)) {
+        m_profileData.resize(static_cast<int>(profileSize));
+        if (!cmsSaveProfileToMem(rgbProfileHandle, m_profileData.data(), &profileSize)) {
+            m_profileData.clear();
+        }
+    }
+
     // Create an ICC v4 profile object for the Lab color space.
-    cmsHPROFILE labProfileHandle = cmsCreateLab4Profile(
+    cmsHPROFILE labProfileHandle = cmsCreateLab4ProfileTHR(
+        m_context,
         // nullptr means: Default white point (D50)
         // TODO Does this make sense? sRGB white point is D65!
         nullptr);
@@ -157,8 +177,9 @@ bool RgbColorSpace::RgbColorSpacePrivate::initialize(cmsHPROFILE rgbProfileHandl
     // so anyway it is not likely to have two consecutive pixels with
     // the same color, which is the only situation where the 1-pixel-cache
     // makes processing faster.
-    m_transformLabToRgbHandle = cmsCreateTransform(
+    m_transformLabToRgbHandle = cmsCreateTransformTHR(
         // Create a transform function and get a handle to this function:
+        m_context,                    // LittleCMS context
         labProfileHandle,             // input profile handle
         TYPE_Lab_DBL,                 // input buffer format
         rgbProfileHandle,             // output profile handle
@@ -166,8 +187,9 @@ bool RgbColorSpace::RgbColorSpacePrivate::initialize(cmsHPROFILE rgbProfileHandl
         INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
         cmsFLAGS_NOCACHE              // flags
     );
-    m_transformLabToRgb16Handle = cmsCreateTransform(
+    m_transformLabToRgb16Handle = cmsCreateTransformTHR(
         // Create a transform function and get a handle to this function:
+        m_context,                    // LittleCMS context
         labProfileHandle,             // input profile handle
         TYPE_Lab_DBL,                 // input buffer format
         rgbProfileHandle,             // output profile handle
@@ -175,8 +197,9 @@ bool RgbColorSpace::RgbColorSpacePrivate::initialize(cmsHPROFILE rgbProfileHandl
         INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
         cmsFLAGS_NOCACHE              // flags
     );
-    m_transformRgbToLabHandle = cmsCreateTransform(
+    m_transformRgbToLabHandle = cmsCreateTransformTHR(
         // Create a transform function and get a handle to this function:
+        m_context,                    // LittleCMS context
         rgbProfileHandle,             // input profile handle
         TYPE_RGB_DBL,                 // input buffer format
         labProfileHandle,             // output profile handle
@@ -184,21 +207,54 @@ bool RgbColorSpace::RgbColorSpacePrivate::initialize(cmsHPROFILE rgbProfileHandl
         INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
         cmsFLAGS_NOCACHE              // flags
     );
+    // Variants for Lab values in planar (structure-of-arrays) buffers,
+    // see LabBuffer. The distance between the planes is passed on each
+    // call to cmsDoTransformLineStride().
+    m_transformLabPlanarToRgbHandle = cmsCreateTransformTHR(
+        // Create a transform function and get a handle to this function:
+        m_context,                    // LittleCMS context
+        labProfileHandle,             // input profile handle
+        typeLabDoublePlanar,          // input buffer format
+        rgbProfileHandle,             // output profile handle
+        TYPE_RGB_DBL,                 // output buffer format
+        INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
+        cmsFLAGS_NOCACHE              // flags
+    );
+    m_transformRgbToLabPlanarHandle = cmsCreateTransformTHR(
+        // Create a transform function and get a handle to this function:
+        m_context,                    // LittleCMS context
+        rgbProfileHandle,             // input profile handle
+        TYPE_RGB_DBL,                 // input buffer format
+        labProfileHandle,             // output profile handle
+        typeLabDoublePlanar,          // output buffer format
+        INTENT_ABSOLUTE_COLORIMETRIC, // rendering intent
+        cmsFLAGS_NOCACHE              // flags
+    );
     // It is mandatory to close the profiles to prevent memory leaks:
     cmsCloseProfile(labProfileHandle);
 
     // After having closed the profiles, we can now return
     // (if appropriate) without having memory leaks:
-    if ((m_transformLabToRgbHandle == nullptr)      //
-        || (m_transformLabToRgb16Handle == nullptr) //
-        || (m_transformRgbToLabHandle == nullptr)   //
+    if ((m_transformLabToRgbHandle == nullptr)          //
+        || (m_transformLabToRgb16Handle == nullptr)     //
+        || (m_transformRgbToLabHandle == nullptr)       //
+        || (m_transformLabPlanarToRgbHandle == nullptr) //
+        || (m_transformRgbToLabPlanarHandle == nullptr) //
     ) {
         RgbColorSpacePrivate::deleteTransform(m_transformLabToRgb16Handle);
         RgbColorSpacePrivate::deleteTransform(m_transformLabToRgbHandle);
         RgbColorSpacePrivate::deleteTransform(m_transformRgbToLabHandle);
+        RgbColorSpacePrivate::deleteTransform(m_transformLabPlanarToRgbHandle);
+        RgbColorSpacePrivate::deleteTransform(m_transformRgbToLabPlanarHandle);
         return false;
     }
 
+    m_isLabToRgbBounded = detectBoundedTransform();
+    if (m_isLabToRgbBounded) {
+        m_boundedRoundTripTolerance = calculateBoundedRoundTripTolerance();
+    }
+    buildLinearizationTables(rgbProfileHandle);
+
     // Maximum chroma:
     // TODO m_maximumChroma should depend on the actual profile.
     // m_maximumChroma = LchValues::humanMaximumChroma;
@@ -224,11 +280,23 @@ bool RgbColorSpace::RgbColorSpacePrivate::initialize(cmsHPROFILE rgbProfileHandl
         throw 0;
     }
 
+    // The gamut boundary is built here and not on first use, so that
+    // the first query (which might happen during a paint event) does
+    // not pay for it.
+    m_gamutBoundary.reset(new GamutBoundary(q_pointer, m_blackpointL, m_whitepointL));
+
     // Dirty hacks:
-    QSharedPointer<PerceptualColor::RgbColorSpace> pointerToMainObject;
-    pointerToMainObject.reset(q_pointer);
-    // TODO Self-reference is always a bad idea…
-    m_nearestNeighborSearchImage = new ChromaLightnessImage(pointerToMainObject);
+    // The image needs a shared pointer to this object. An owning one
+    // would be a reference cycle (and a second, independent owner of an
+    // object that is yet owned by the caller), so it gets a non-owning
+    // one with a deleter that does nothing. The image is owned by this
+    // object, so it never outlives it.
+    const QSharedPointer<PerceptualColor::RgbColorSpace> nonOwningPointer( //
+        static_cast<PerceptualColor::RgbColorSpace *>(q_pointer),
+        [](PerceptualColor::RgbColorSpace *) {
+            // Do not delete anything.
+        });
+    m_nearestNeighborSearchImage.reset(new ChromaLightnessImage(nonOwningPointer));
     const QSize nearestNeighborImageSize = QSize(
         // width:
         qRound(nearestNeighborSearchImageHeight / 100.0 * LchValues::humanMaximumChroma) + 1,
@@ -236,6 +304,8 @@ bool RgbColorSpace::RgbColorSpacePrivate::initialize(cmsHPROFILE rgbProfileHandl
         nearestNeighborSearchImageHeight);
     m_nearestNeighborSearchImage->setImageSize(nearestNeighborImageSize);
     m_nearestNeighborSearchImage->setBackgroundColor(Qt::transparent);
+    // Gamut mapping needs the exact gamut boundary.
+    m_nearestNeighborSearchImage->setGamutCacheEnabled(false);
 
     return true;
 }
@@ -243,9 +313,20 @@ bool RgbColorSpace::RgbColorSpacePrivate::initialize(cmsHPROFILE rgbProfileHandl
 /** @brief Destructor */
 RgbColorSpace::~RgbColorSpace() noexcept
 {
+    // The image holds a non-owning pointer to this object, so it is
+    // destroyed first.
+    d_pointer->m_nearestNeighborSearchImage.reset();
+    d_pointer->m_gamutCache.reset();
+    d_pointer->m_gamutBoundary.reset();
+    for (auto &transforms : d_pointer->m_intentTransforms) {
+        RgbColorSpacePrivate::deleteTransform(transforms.labToRgb16Handle);
+        RgbColorSpacePrivate::deleteTransform(transforms.rgbToLabHandle);
+    }
     RgbColorSpacePrivate::deleteTransform(d_pointer->m_transformLabToRgb16Handle);
     RgbColorSpacePrivate::deleteTransform(d_pointer->m_transformLabToRgbHandle);
     RgbColorSpacePrivate::deleteTransform(d_pointer->m_transformRgbToLabHandle);
+    RgbColorSpacePrivate::deleteTransform(d_pointer->m_transformLabPlanarToRgbHandle);
+    RgbColorSpacePrivate::deleteTransform(d_pointer->m_transformRgbToLabPlanarHandle);
 }
 
 /** @brief Constructor
@@ -255,6 +336,22 @@ RgbColorSpace::~RgbColorSpace() noexcept
 RgbColorSpace::RgbColorSpacePrivate::RgbColorSpacePrivate(RgbColorSpace *backLink)
     : q_pointer(backLink)
 {
+    // Profile parsing and transform compilation produce many small
+    // allocations. They go to an arena that is owned by this object.
+    m_context = m_memoryArena.createContext();
+}
+
+/** @brief Destructor
+ *
+ * @pre All LittleCMS objects that use @ref m_context have
+ * been deleted. */
+RgbColorSpace::RgbColorSpacePrivate::~RgbColorSpacePrivate() noexcept
+{
+    if (m_context != nullptr) {
+        cmsDeleteContext(m_context);
+    }
+    // The memory of m_memoryArena is released when this
+    // object is destroyed.
 }
 
 /** @brief Conveniance function for deleting LittleCMS transforms
@@ -285,6 +382,243 @@ void RgbColorSpace::RgbColorSpacePrivate::deleteTransform(cmsHTRANSFORM &transfo
     }
 }
 
+/** @brief Checks if a Lab value is within the RGB gamut.
+ *
+ * @param lab The Lab value
+ * @param rgb The Lab value converted with @ref m_transformLabToRgbHandle
+ *
+ * @returns <tt>true</tt> if the color is in-gamut. If
+ * @ref m_isLabToRgbBounded, this needs a round trip back to Lab;
+ * otherwise, it is a simple range check. */
+bool RgbColorSpace::RgbColorSpacePrivate::isInGamut(const cmsCIELab &lab, const RgbDouble &rgb) const
+{
+    if (!(isInRange<cmsFloat64Number>(0, rgb.red, 1)      //
+          && isInRange<cmsFloat64Number>(0, rgb.green, 1) //
+          && isInRange<cmsFloat64Number>(0, rgb.blue, 1))) {
+        return false;
+    }
+    if (!m_isLabToRgbBounded) {
+        return true;
+    }
+    const cmsCIELab roundTrip = colorLab(rgb);
+    return cmsDeltaE(&lab, &roundTrip) <= m_boundedRoundTripTolerance;
+}
+
+/** @brief Detects if the Lab-to-RGB transforms clip their results.
+ *
+ * Converts some colors that are far outside of the gamut of any
+ * real-world RGB profile. If none of them leaves the range
+ * <tt>[0, 1]</tt>, the transform clips.
+ *
+ * @pre @ref m_transformLabToRgbHandle is valid.
+ *
+ * @returns The value for @ref m_isLabToRgbBounded. */
+bool RgbColorSpace::RgbColorSpacePrivate::detectBoundedTransform() const
+{
+    constexpr int probeCount = 4;
+    const cmsCIELab probes[probeCount] = {{50, 120, 120}, //
+                                          {50, 120, -120},
+                                          {50, -120, 120},
+                                          {50, -120, -120}};
+    RgbDouble rgb[probeCount];
+    cmsDoTransform(m_transformLabToRgbHandle, // handle to transform function
+                   probes,                    // input
+                   rgb,                       // output
+                   probeCount                 // number of values
+    );
+    for (const RgbDouble &value : rgb) {
+        const bool isClipped = isInRange<double>(0, value.red, 1) //
+            && isInRange<double>(0, value.green, 1) //
+            && isInRange<double>(0, value.blue, 1);
+        if (!isClipped) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Derives the round trip tolerance from the profile.
+ *
+ * Converts a grid of RGB values, which are in-gamut by definition, to
+ * Lab. Then measures how far these Lab values move during a round trip
+ * through RGB, as done by @ref isInGamut(). The interpolation of the
+ * CLUTs causes this error. It is biggest for dark colors and at the
+ * gamut boundary, where the grid of the Lab-to-RGB CLUT mixes clipped
+ * and unclipped grid points.
+ *
+ * @pre The transforms are valid.
+ *
+ * @returns The value for @ref m_boundedRoundTripTolerance: The maximum
+ * error, multiplied by @ref boundedRoundTripToleranceFactor, but at
+ * least @ref minimumBoundedRoundTripTolerance. */
+double RgbColorSpace::RgbColorSpacePrivate::calculateBoundedRoundTripTolerance() const
+{
+    // Includes the corners and the edges of the RGB cube.
+    constexpr int gridPoints = 9;
+    constexpr int count = gridPoints * gridPoints * gridPoints;
+    QVector<RgbDouble> rgb;
+    rgb.reserve(count);
+    for (int red = 0; red < gridPoints; ++red) {
+        for (int green = 0; green < gridPoints; ++green) {
+            for (int blue = 0; blue < gridPoints; ++blue) {
+                rgb.append(RgbDouble {static_cast<double>(red) / (gridPoints - 1), //
+                                      static_cast<double>(green) / (gridPoints - 1),
+                                      static_cast<double>(blue) / (gridPoints - 1)});
+            }
+        }
+    }
+    QVector<cmsCIELab> lab(count);
+    cmsDoTransform(m_transformRgbToLabHandle, rgb.constData(), lab.data(), static_cast<cmsUInt32Number>(count));
+    QVector<RgbDouble> roundTripRgb(count);
+    cmsDoTransform(m_transformLabToRgbHandle, lab.constData(), roundTripRgb.data(), static_cast<cmsUInt32Number>(count));
+    QVector<cmsCIELab> roundTripLab(count);
+    cmsDoTransform(m_transformRgbToLabHandle, roundTripRgb.constData(), roundTripLab.data(), static_cast<cmsUInt32Number>(count));
+    double maximumError = 0;
+    for (int i = 0; i < count; ++i) {
+        maximumError = qMax(maximumError, cmsDeltaE(&lab.at(i), &roundTripLab.at(i)));
+    }
+    return qMax(minimumBoundedRoundTripTolerance, //
+                maximumError * boundedRoundTripToleranceFactor);
+}
+
+/** @brief Tabulates the transfer functions of the profile.
+ *
+ * Initializes @ref m_linearizationTables and
+ * @ref m_delinearizationTables. The tone curves are evaluated only here,
+ * so that the conversion itself needs only table lookups.
+ *
+ * @param rgbProfileHandle Handle for the RGB profile */
+void RgbColorSpace::RgbColorSpacePrivate::buildLinearizationTables(cmsHPROFILE rgbProfileHandle)
+{
+    // Parameters of the sRGB curve for cmsBuildParametricToneCurve(),
+    // type 4: Y = (aX + b)^g for X ≥ d, and Y = cX for X < d
+    const cmsFloat64Number srgbParameters[5] {2.4, // g
+                                              1 / 1.055, // a
+                                              0.055 / 1.055, // b
+                                              1 / 12.92, // c
+                                              0.04045}; // d
+    const cmsTagSignature tags[3] {cmsSigRedTRCTag, cmsSigGreenTRCTag, cmsSigBlueTRCTag};
+    const bool isMatrixShaper = cmsIsMatrixShaper(rgbProfileHandle);
+    for (std::size_t channel = 0; channel < m_linearizationTables.size(); ++channel) {
+        const cmsToneCurve *profileCurve = isMatrixShaper //
+            ? static_cast<const cmsToneCurve *>(cmsReadTag(rgbProfileHandle, tags[channel]))
+            : nullptr;
+        cmsToneCurve *curve = (profileCurve == nullptr) //
+            ? cmsBuildParametricToneCurve(m_context, 4, srgbParameters)
+            : cmsDupToneCurve(profileCurve);
+        cmsToneCurve *reverseCurve = (curve == nullptr) //
+            ? nullptr
+            : cmsReverseToneCurve(curve);
+        // If a curve could not be created, the values are used
+        // without change.
+        std::array<double, 256> &linearization = m_linearizationTables[channel];
+        for (std::size_t i = 0; i < linearization.size(); ++i) {
+            const double value = i / 255.0;
+            linearization[i] = (curve == nullptr) //
+                ? value
+                : cmsEvalToneCurveFloat(curve, static_cast<cmsFloat32Number>(value));
+        }
+        auto &delinearization = m_delinearizationTables[channel];
+        for (std::size_t i = 0; i < delinearization.size(); ++i) {
+            const double value = static_cast<double>(i) / delinearizationTableResolution;
+            const double encoded = (reverseCurve == nullptr) //
+                ? value
+                : cmsEvalToneCurveFloat(reverseCurve, static_cast<cmsFloat32Number>(value));
+            delinearization[i] = static_cast<quint8>(qBound(0, qRound(encoded * 255), 255));
+        }
+        for (cmsToneCurve *temp : {curve, reverseCurve}) {
+            if (temp != nullptr) {
+                cmsFreeToneCurve(temp);
+            }
+        }
+    }
+}
+
+/** @brief Creates the transforms for a rendering intent.
+ *
+ * The profile is read again from @ref m_profileData, because the
+ * original profile handle is closed after @ref initialize().
+ *
+ * @param intent The rendering intent
+ * @returns The newly created transforms. The caller takes ownership.
+ * Transforms that could not be created are <tt>nullptr</tt>. */
+RgbColorSpace::RgbColorSpacePrivate::IntentTransforms RgbColorSpace::RgbColorSpacePrivate::createIntentTransforms(const RenderingIntent &intent) const
+{
+    IntentTransforms result;
+    if (m_profileData.isEmpty()) {
+        return result;
+    }
+    cmsHPROFILE rgbProfileHandle = cmsOpenProfileFromMemTHR( //
+        m_context,
+        m_profileData.constData(),
+        static_cast<cmsUInt32Number>(m_profileData.size()));
+    if (rgbProfileHandle == nullptr) {
+        return result;
+    }
+    cmsHPROFILE labProfileHandle = cmsCreateLab4ProfileTHR(m_context, nullptr);
+    // See initialize() for why cmsFLAGS_NOCACHE is used.
+    cmsUInt32Number flags = cmsFLAGS_NOCACHE;
+    if (intent.blackPointCompensation) {
+        flags |= cmsFLAGS_BLACKPOINTCOMPENSATION;
+    }
+    result.labToRgb16Handle = cmsCreateTransformTHR( //
+        m_context,
+        labProfileHandle,
+        TYPE_Lab_DBL,
+        rgbProfileHandle,
+        TYPE_RGB_16,
+        intent.intent,
+        flags);
+    result.rgbToLabHandle = cmsCreateTransformTHR( //
+        m_context,
+        rgbProfileHandle,
+        TYPE_RGB_DBL,
+        labProfileHandle,
+        TYPE_Lab_DBL,
+        intent.intent,
+        flags);
+    cmsCloseProfile(labProfileHandle);
+    cmsCloseProfile(rgbProfileHandle);
+    return result;
+}
+
+/** @brief The transforms for a rendering intent.
+ *
+ * The transforms are created on first use and cached
+ * in @ref m_intentTransforms.
+ *
+ * This function is thread-safe.
+ *
+ * @param intent The rendering intent
+ * @returns The transforms for the rendering intent. If they could not be
+ * created, the transforms of the default rendering intent are returned
+ * instead. The transforms stay valid during the live time of this
+ * object. */
+RgbColorSpace::RgbColorSpacePrivate::IntentTransforms RgbColorSpace::RgbColorSpacePrivate::intentTransforms(const RenderingIntent &intent) const
+{
+    IntentTransforms result;
+    if (intent != RenderingIntent()) {
+        QMutexLocker locker(&m_intentTransformsMutex);
+        auto iterator = m_intentTransforms.constFind(intent);
+        if (iterator == m_intentTransforms.constEnd()) {
+            iterator = m_intentTransforms.insert(intent, createIntentTransforms(intent));
+            if ((iterator->labToRgb16Handle == nullptr) || (iterator->rgbToLabHandle == nullptr)) {
+                qWarning() << "Unable to create transforms for rendering intent" //
+                           << intent.intent //
+                           << "- falling back to absolute colorimetric.";
+            }
+        }
+        result = iterator.value();
+    }
+    if (result.labToRgb16Handle == nullptr) {
+        result.labToRgb16Handle = m_transformLabToRgb16Handle;
+    }
+    if (result.rgbToLabHandle == nullptr) {
+        result.rgbToLabHandle = m_transformRgbToLabHandle;
+    }
+    return result;
+}
+
 /** @brief Calculates the Lab value
  *
  * @param rgbColor the color that will be converted. (If this is not an
@@ -330,22 +664,216 @@ PerceptualColor::LchDouble RgbColorSpace::toLch(const QColor &rgbColor) const
     return result;
 }
 
+/** @brief Calculates the LCh value with a given rendering intent.
+ *
+ * The transforms for the rendering intent are created on first use and
+ * kept for the live time of this object, so switching between
+ * rendering intents does not create transforms again.
+ *
+ * This function is thread-safe.
+ *
+ * @param rgbColor the color that will be converted
+ * @param intent The rendering intent
+ * @returns The LCh value */
+PerceptualColor::LchDouble RgbColorSpace::toLch(const QColor &rgbColor, const PerceptualColor::RenderingIntent &intent) const
+{
+    RgbDouble rgb;
+    rgb.red = rgbColor.redF();
+    rgb.green = rgbColor.greenF();
+    rgb.blue = rgbColor.blueF();
+    cmsCIELab lab = RgbColorSpacePrivate::colorLab( //
+        rgb,
+        d_pointer->intentTransforms(intent).rgbToLabHandle);
+    return toLch(lab);
+}
+
 /** @brief Calculates the Lab value
  *
  * @param rgb the color that will be converted.
  * @returns If the color is valid, the corresponding LCh value might also
  * be invalid. */
 cmsCIELab RgbColorSpace::RgbColorSpacePrivate::colorLab(const RgbDouble &rgb) const
+{
+    return colorLab(rgb, m_transformRgbToLabHandle);
+}
+
+/** @brief Calculates the Lab value
+ *
+ * @param rgb the color that will be converted.
+ * @param transformHandle The transform from RGB to Lab
+ * @returns If the color is valid, the corresponding LCh value might also
+ * be invalid. */
+cmsCIELab RgbColorSpace::RgbColorSpacePrivate::colorLab(const RgbDouble &rgb, cmsHTRANSFORM transformHandle)
 {
     cmsCIELab lab;
-    cmsDoTransform(m_transformRgbToLabHandle, // handle to transform function
-                   &rgb,                      // input
-                   &lab,                      // output
-                   1                          // convert exactly 1 value
+    cmsDoTransform(transformHandle, // handle to transform function
+                   &rgb,            // input
+                   &lab,            // output
+                   1                // convert exactly 1 value
     );
     return lab;
 }
 
+/** @brief Converts many RGB values to Lab at once.
+ *
+ * This is faster than calling @ref toLch() color by color, because
+ * LittleCMS processes the whole buffer within a single call.
+ *
+ * The underlying transform is created with <tt>cmsFLAGS_NOCACHE</tt>,
+ * therefore this function can be called from various threads at the
+ * same time.
+ *
+ * @param rgb Buffer with (at least) <tt>count</tt> RGB values
+ * @param lab Buffer that will receive <tt>count</tt> Lab values
+ * @param count Number of values to convert. If smaller
+ * than <tt>1</tt>, nothing happens. */
+void RgbColorSpace::toCielab(const RgbDouble *rgb, cmsCIELab *lab, int count) const
+{
+    if (count < 1) {
+        return;
+    }
+    cmsDoTransform(d_pointer->m_transformRgbToLabHandle, // handle to transform function
+                   rgb,                                  // input
+                   lab,                                  // output
+                   static_cast<cmsUInt32Number>(count)   // number of values
+    );
+}
+
+/** @brief Converts RGB values to Lab values (batch processing).
+ *
+ * Like @ref toCielab(const RgbDouble *, cmsCIELab *, int) const, but
+ * writes the result directly into a planar buffer.
+ *
+ * This function is thread-safe.
+ *
+ * @param rgb Buffer with (at least) <tt>lab.count()</tt> RGB values
+ * @param lab View to a @ref LabBuffer (or a slice of it) that will
+ * receive the Lab values. */
+void RgbColorSpace::toCielab(const RgbDouble *rgb, PlanarView<double> lab) const
+{
+    if (lab.count() < 1) {
+        return;
+    }
+    const cmsUInt32Number count = static_cast<cmsUInt32Number>(lab.count());
+    cmsDoTransformLineStride(d_pointer->m_transformRgbToLabPlanarHandle, // handle to transform function
+                             rgb,                                        // input
+                             lab.plane(0),                               // output
+                             count,                                      // pixels per line
+                             1,                                          // line count
+                             count * sizeof(RgbDouble),                  // bytes per line (input)
+                             count * sizeof(double),                     // bytes per line (output)
+                             0,                                          // bytes per plane (input, chunky)
+                             static_cast<cmsUInt32Number>(lab.planeStride() * sizeof(double)) // bytes per plane (output)
+    );
+}
+
+/** @brief Converts Lab values to RGB values, bound to the gamut
+ * (batch processing).
+ *
+ * This is the batch version of @ref toQColorRgbBound(): Out-of-gamut
+ * colors are clipped component-wise to the range <tt>[0, 1]</tt>, like
+ * the 16-bit transform of @ref toQColorRgbBound() does.
+ *
+ * This function is thread-safe.
+ *
+ * @param lab View to a @ref LabBuffer (or a slice of it)
+ * @param rgb Buffer that will receive <tt>lab.count()</tt> values. */
+void RgbColorSpace::toRgbDoubleBound(PlanarView<const double> lab, RgbDouble *rgb) const
+{
+    toRgbDoubleUnbound(lab, rgb);
+    const int count = lab.count();
+    for (int i = 0; i < count; ++i) {
+        rgb[i].red = qBound<double>(0, rgb[i].red, 1);
+        rgb[i].green = qBound<double>(0, rgb[i].green, 1);
+        rgb[i].blue = qBound<double>(0, rgb[i].blue, 1);
+    }
+}
+
+/** @brief Converts Lab values to unbounded RGB values (batch processing).
+ *
+ * LittleCMS processes the whole buffer within a single call, reading
+ * directly from the planar buffer.
+ *
+ * This function is thread-safe.
+ *
+ * @param lab View to a @ref LabBuffer (or a slice of it)
+ * @param rgb Buffer that will receive <tt>lab.count()</tt> values. The
+ * values are <em>not</em> clipped: Colors that are out-of-gamut have
+ * at least one component outside of the range <tt>[0, 1]</tt>. */
+void RgbColorSpace::toRgbDoubleUnbound(PlanarView<const double> lab, RgbDouble *rgb) const
+{
+    const int count = lab.count();
+    if (count < 1) {
+        return;
+    }
+    const cmsUInt32Number cmsCount = static_cast<cmsUInt32Number>(count);
+    cmsDoTransformLineStride(d_pointer->m_transformLabPlanarToRgbHandle, // handle to transform function
+                             lab.plane(0),                               // input
+                             rgb,                                        // output
+                             cmsCount,                                   // pixels per line
+                             1,                                          // line count
+                             cmsCount * sizeof(double),                  // bytes per line (input)
+                             cmsCount * sizeof(RgbDouble),               // bytes per line (output)
+                             static_cast<cmsUInt32Number>(lab.planeStride() * sizeof(double)), // bytes per plane (input)
+                             0                                           // bytes per plane (output, chunky)
+    );
+}
+
+/** @brief Converts Lab values to RGB values (batch processing).
+ *
+ * This is the batch version of @ref toQColorRgbUnbound(). LittleCMS
+ * processes the whole buffer within a single call, reading directly
+ * from the planar buffer.
+ *
+ * This function is thread-safe.
+ *
+ * @param lab View to a @ref LabBuffer (or a slice of it)
+ * @param rgb Buffer that will receive <tt>lab.count()</tt> values. Colors
+ * within the gamut are opaque. Colors that are out-of-gamut are
+ * <tt>0</tt> (fully transparent), so the buffer can be copied directly
+ * into the scan line of an image in a premultiplied format.
+ *
+ * @sa @ref toRgbDoubleUnbound() */
+void RgbColorSpace::toQRgbUnbound(PlanarView<const double> lab, QRgb *rgb) const
+{
+    const int count = lab.count();
+    if (count < 1) {
+        return;
+    }
+    QVector<RgbDouble> rgbDouble(count);
+    toRgbDoubleUnbound(lab, rgbDouble.data());
+    QVector<bool> inGamut(count);
+    isInGamut(lab, rgbDouble.constData(), inGamut.data());
+    for (int i = 0; i < count; ++i) {
+        const RgbDouble &value = rgbDouble.at(i);
+        if (inGamut.at(i)) {
+            rgb[i] = qRgb(qRound(value.red * 255), //
+                          qRound(value.green * 255),
+                          qRound(value.blue * 255));
+        } else {
+            rgb[i] = 0;
+        }
+    }
+}
+
+/** @brief Converts LCh values to RGB values (batch processing).
+ *
+ * @param lch View to a @ref LchBuffer (or a slice of it)
+ * @param lab View to a @ref LabBuffer (or a slice of it) with at
+ * least <tt>lch.count()</tt> values. Receives the Lab values, which
+ * are needed for the conversion. Callers that convert repeatedly (like
+ * row by row) can reuse the same buffer, so no memory is allocated
+ * for each call.
+ * @param rgb Buffer that will receive <tt>lch.count()</tt> values.
+ * See @ref toQRgbUnbound(PlanarView<const double>, QRgb *) const
+ * for details. */
+void RgbColorSpace::toQRgbUnboundFromLch(PlanarView<const double> lch, PlanarView<double> lab, QRgb *rgb) const
+{
+    const PlanarView<double> labSlice = lab.slice(0, lch.count());
+    LabBuffer::fromLch(lch, labSlice);
+    toQRgbUnbound(labSlice, rgb);
+}
+
 /** @brief Calculates the RGB value
  *
  * @param Lab a L*a*b* color
@@ -363,10 +891,7 @@ QColor RgbColorSpace::toQColorRgbUnbound(const cmsCIELab &Lab) const
         &rgb,                                 // output
         1                                     // convert exactly 1 value
     );
-    if (isInRange<cmsFloat64Number>(0, rgb.red, 1)      //
-        && isInRange<cmsFloat64Number>(0, rgb.green, 1) //
-        && isInRange<cmsFloat64Number>(0, rgb.blue, 1)  //
-    ) {
+    if (d_pointer->isInGamut(Lab, rgb)) {
         // We are within the gamut
         temp = QColor::fromRgbF(rgb.red, rgb.green, rgb.blue);
     }
@@ -393,14 +918,25 @@ QColor RgbColorSpace::toQColorRgbUnbound(const LchDouble &lch) const
 }
 
 RgbDouble RgbColorSpace::RgbColorSpacePrivate::colorRgbBoundSimple(const cmsCIELab &Lab) const
+{
+    return colorRgbBoundSimple(Lab, m_transformLabToRgb16Handle);
+}
+
+/** @brief Calculates the RGB value, bound to the gamut.
+ *
+ * @param Lab a L*a*b* color
+ * @param transformHandle The transform from Lab to 16-bit RGB
+ * @returns The RGB value. Out-of-gamut colors are mapped into the gamut
+ * by LittleCMS, depending on the rendering intent of the transform. */
+RgbDouble RgbColorSpace::RgbColorSpacePrivate::colorRgbBoundSimple(const cmsCIELab &Lab, cmsHTRANSFORM transformHandle)
 {
     cmsUInt16Number rgb_int[3];
     cmsDoTransform(
         // Parameters:
-        m_transformLabToRgb16Handle, // handle to transform function
-        &Lab,                        // input
-        rgb_int,                     // output
-        1                            // convert exactly 1 value
+        transformHandle, // handle to transform function
+        &Lab,            // input
+        rgb_int,         // output
+        1                // convert exactly 1 value
     );
     RgbDouble temp;
     temp.red = rgb_int[0] / static_cast<qreal>(65535);
@@ -451,9 +987,30 @@ QColor RgbColorSpace::toQColorRgbBound(const PerceptualColor::LchaDouble &lcha)
     return result;
 }
 
-// TODO What to do with in-gamut tests if LittleCMS has fallen back to
-// bounded mode because of too complicate profiles? Out in-gamut detection
-// would not work anymore!
+/** @brief Calculates the RGB value with a given rendering intent.
+ *
+ * The transforms for the rendering intent are created on first use and
+ * kept for the live time of this object, so switching between
+ * rendering intents does not create transforms again.
+ *
+ * This function is thread-safe.
+ *
+ * @param lch an LCh color
+ * @param intent The rendering intent
+ * @returns If the color is within the RGB gamut, a QColor with the RGB
+ * values. A nearby (in-gamut) RGB QColor otherwise. Which one, depends
+ * on the rendering intent. */
+QColor RgbColorSpace::toQColorRgbBound(const PerceptualColor::LchDouble &lch, const PerceptualColor::RenderingIntent &intent) const
+{
+    cmsCIELab lab; // uses cmsFloat64Number internally
+    const cmsCIELCh myCmsCieLch = toCmsCieLch(lch);
+    // convert from LCh to Lab
+    cmsLCh2Lab(&lab, &myCmsCieLch);
+    const RgbDouble rgb = RgbColorSpacePrivate::colorRgbBoundSimple( //
+        lab,
+        d_pointer->intentTransforms(intent).labToRgb16Handle);
+    return QColor::fromRgbF(rgb.red, rgb.green, rgb.blue);
+}
 
 /** @brief check if an LCh value is within a specific RGB gamut
  * @param lch the LCh color
@@ -478,7 +1035,11 @@ bool RgbColorSpace::isInGamut(const LchDouble &lch) const
 /** @brief check if a Lab value is within a specific RGB gamut
  * @param lab the Lab color
  * @returns Returns true if it is in the specified RGB gamut. Returns
- * false otherwise. */
+ * false otherwise.
+ *
+ * For profiles whose transforms clip out-of-gamut colors, the result
+ * has the precision described at
+ * @ref RgbColorSpacePrivate::m_boundedRoundTripTolerance. */
 bool RgbColorSpace::isInGamut(const cmsCIELab &lab) const
 {
     RgbDouble rgb;
@@ -491,7 +1052,47 @@ bool RgbColorSpace::isInGamut(const cmsCIELab &lab) const
         1                                     // convert exactly 1 value
     );
 
-    return (isInRange<cmsFloat64Number>(0, rgb.red, 1) && isInRange<cmsFloat64Number>(0, rgb.green, 1) && isInRange<cmsFloat64Number>(0, rgb.blue, 1));
+    return d_pointer->isInGamut(lab, rgb);
+}
+
+/** @brief Checks if Lab values are within the RGB gamut (batch
+ * processing).
+ *
+ * This is the batch version of @ref isInGamut(const cmsCIELab &) const
+ * for values that have yet been converted with
+ * @ref toRgbDoubleUnbound(). Usually, this is just a range check of the
+ * RGB values. Only for profiles whose transforms clip out-of-gamut
+ * colors, the RGB values are converted back to Lab within a single batch
+ * call and compared with the original values.
+ *
+ * This function is thread-safe.
+ *
+ * @param lab View to a @ref LabBuffer (or a slice of it)
+ * @param rgb The result of @ref toRgbDoubleUnbound() for <tt>lab</tt>
+ * @param result Buffer that will receive <tt>lab.count()</tt> values:
+ * <tt>true</tt> for in-gamut colors, <tt>false</tt> otherwise. */
+void RgbColorSpace::isInGamut(PlanarView<const double> lab, const RgbDouble *rgb, bool *result) const
+{
+    const int count = lab.count();
+    for (int i = 0; i < count; ++i) {
+        result[i] = isInRange<double>(0, rgb[i].red, 1) //
+            && isInRange<double>(0, rgb[i].green, 1) //
+            && isInRange<double>(0, rgb[i].blue, 1);
+    }
+    if ((!d_pointer->m_isLabToRgbBounded) || (count < 1)) {
+        return;
+    }
+    LabBuffer roundTrip(count);
+    toCielab(rgb, roundTrip.view());
+    const double squaredTolerance = //
+        d_pointer->m_boundedRoundTripTolerance * d_pointer->m_boundedRoundTripTolerance;
+    for (int i = 0; i < count; ++i) {
+        const double deltaL = lab.plane(0)[i] - roundTrip.l()[i];
+        const double deltaA = lab.plane(1)[i] - roundTrip.a()[i];
+        const double deltaB = lab.plane(2)[i] - roundTrip.b()[i];
+        result[i] = result[i] //
+            && (deltaL * deltaL + deltaA * deltaA + deltaB * deltaB <= squaredTolerance);
+    }
 }
 
 QString RgbColorSpace::profileInfoCopyright() const
@@ -526,13 +1127,96 @@ QString RgbColorSpace::profileInfoModel() const
     return d_pointer->m_cmsInfoModel;
 }
 
-/** @returns A <em>normalized</em> (this is guaranteed!) in-gamut color,
+/** @brief The ICC profile of this color space.
+ *
+ * @returns The ICC profile of this color space, serialized as it would
+ * be stored in an ICC file. Might be empty if the profile could not be
+ * serialized. */
+QByteArray RgbColorSpace::profileData() const
+{
+    return d_pointer->m_profileData;
+}
+
+/** @brief Converts RGB values of this color space to linear RGB values.
+ *
+ * This applies the transfer functions of this color space (for
+ * matrix-shaper profiles, the tone curves of the profile; for other
+ * profiles, the sRGB curve as an approximation). The transfer functions
+ * are tabulated when the color space is created, so this function needs
+ * only a table lookup per channel.
+ *
+ * This function is thread-safe.
+ *
+ * @param rgb Buffer with <tt>count</tt> 8-bit RGB values of this color
+ * space, like they are produced by the batch conversions. The alpha
+ * channel is ignored.
+ * @param linearRgb Buffer with at least <tt>count</tt> values. Receives
+ * the linear RGB values within the range <tt>[0, 1]</tt>.
+ * @param count Number of values
+ *
+ * @sa @ref fromLinearRgb() */
+void RgbColorSpace::toLinearRgb(const QRgb *rgb, RgbDouble *linearRgb, int count) const
+{
+    const auto &tables = d_pointer->m_linearizationTables;
+    for (int i = 0; i < count; ++i) {
+        linearRgb[i].red = tables[0][static_cast<std::size_t>(qRed(rgb[i]))];
+        linearRgb[i].green = tables[1][static_cast<std::size_t>(qGreen(rgb[i]))];
+        linearRgb[i].blue = tables[2][static_cast<std::size_t>(qBlue(rgb[i]))];
+    }
+}
+
+/** @brief Converts linear RGB values to RGB values of this color space.
+ *
+ * This is the inverse of @ref toLinearRgb(). It needs only a table
+ * lookup per channel.
+ *
+ * This function is thread-safe.
+ *
+ * @param linearRgb Buffer with <tt>count</tt> linear RGB values. Values
+ * outside the range <tt>[0, 1]</tt> are clipped.
+ * @param rgb Buffer with at least <tt>count</tt> values. Receives the
+ * opaque 8-bit RGB values of this color space.
+ * @param count Number of values */
+void RgbColorSpace::fromLinearRgb(const RgbDouble *linearRgb, QRgb *rgb, int count) const
+{
+    constexpr int resolution = RgbColorSpacePrivate::delinearizationTableResolution;
+    const auto &tables = d_pointer->m_delinearizationTables;
+    const auto index = [](double value) {
+        return static_cast<std::size_t>(qRound(qBound<double>(0, value, 1) * resolution));
+    };
+    for (int i = 0; i < count; ++i) {
+        rgb[i] = qRgb(tables[0][index(linearRgb[i].red)], //
+                      tables[1][index(linearRgb[i].green)],
+                      tables[2][index(linearRgb[i].blue)]);
+    }
+}
+
+/** @brief The LittleCMS context of this color space.
+ *
+ * Other objects that create LittleCMS objects on behalf of this color
+ * space (like @ref DisplayTransform) should use the <tt>…THR()</tt>
+ * functions of LittleCMS with this context. These objects have to be
+ * deleted before this color space is destroyed.
+ *
+ * @returns The LittleCMS context of this color space. Might be
+ * <tt>nullptr</tt> (the default context of LittleCMS). */
+cmsContext RgbColorSpace::context() const
+{
+    return d_pointer->m_context;
+}
+
+/** @param color The original color
+ * @param precision Precision of the gamut boundary search. The default
+ * value is appropriate for final results. Widgets might use a coarser
+ * value (like @ref interactiveGamutPrecision) during mouse drags.
+ *
+ * @returns A <em>normalized</em> (this is guaranteed!) in-gamut color,
  * maybe with different chroma (and even lightness??)
  *
  * @todo This function should never change anything than chroma. If it fails,
  * it should throw an exception.
  */
-PerceptualColor::LchDouble RgbColorSpace::nearestInGamutColorByAdjustingChroma(const PerceptualColor::LchDouble &color) const
+PerceptualColor::LchDouble RgbColorSpace::nearestInGamutColorByAdjustingChroma(const PerceptualColor::LchDouble &color, qreal precision) const
 {
     LchDouble result = color;
     PolarPointF temp(result.c, result.h);
@@ -552,7 +1236,7 @@ PerceptualColor::LchDouble RgbColorSpace::nearestInGamutColorByAdjustingChroma(c
         // Now we know for sure that lowerChroma is in-gamut
         // and upperChroma is out-of-gamut…
         candidate = upperChroma;
-        while (upperChroma.c - lowerChroma.c > gamutPrecision) {
+        while (upperChroma.c - lowerChroma.c > precision) {
             // Our test candidate is half the way between lowerChroma
             // and upperChroma:
             candidate.c = ((lowerChroma.c + upperChroma.c) / 2);
@@ -605,6 +1289,215 @@ PerceptualColor::LchDouble RgbColorSpace::nearestInGamutColorByAdjustingChromaLi
     return result;
 }
 
+/** @brief Builds @ref RgbColorSpacePrivate::m_cuspTable.
+ *
+ * For RGB color spaces, the cusps are on the edges of the RGB cube that
+ * connect the primary and the secondary colors (red → yellow → green →
+ * cyan → blue → magenta → red). These edges are sampled densely, converted
+ * to Lab within a single batch, and for each entry of the table, the
+ * sample with the highest chroma is kept. Entries that got no sample are
+ * interpolated linearly between their neighbors.
+ *
+ * Do not call this function directly; it is called (only once) by
+ * @ref cusp(). */
+void RgbColorSpace::RgbColorSpacePrivate::buildCuspTable() const
+{
+    constexpr int samplesPerEdge = 8192;
+    constexpr int edgeCount = 6;
+    const RgbDouble corners[edgeCount + 1] = {{1, 0, 0}, // red
+                                              {1, 1, 0}, // yellow
+                                              {0, 1, 0}, // green
+                                              {0, 1, 1}, // cyan
+                                              {0, 0, 1}, // blue
+                                              {1, 0, 1}, // magenta
+                                              {1, 0, 0}}; // red
+    const int sampleCount = edgeCount * samplesPerEdge;
+    QVector<RgbDouble> rgbBuffer(sampleCount);
+    for (int edge = 0; edge < edgeCount; ++edge) {
+        const RgbDouble &from = corners[edge];
+        const RgbDouble &to = corners[edge + 1];
+        for (int i = 0; i < samplesPerEdge; ++i) {
+            const double t = static_cast<double>(i) / samplesPerEdge;
+            RgbDouble &sample = rgbBuffer[edge * samplesPerEdge + i];
+            sample.red = from.red + t * (to.red - from.red);
+            sample.green = from.green + t * (to.green - from.green);
+            sample.blue = from.blue + t * (to.blue - from.blue);
+        }
+    }
+    QVector<cmsCIELab> labBuffer(sampleCount);
+    q_pointer->toCielab(rgbBuffer.constData(), labBuffer.data(), sampleCount);
+
+    const int tableSize = 360 * cuspTableResolution;
+    // Chroma -1 marks entries that did not get a sample yet.
+    QVector<LchDouble> table(tableSize, LchDouble {0, -1, 0});
+    for (const cmsCIELab &lab : qAsConst(labBuffer)) {
+        const LchDouble lch = q_pointer->toLch(lab);
+        const int index = qRound(lch.h * cuspTableResolution) % tableSize;
+        if (lch.c > table.at(index).c) {
+            table[index].l = lch.l;
+            table[index].c = lch.c;
+        }
+    }
+
+    // Fill the gaps
+    int previousFilled = -1;
+    for (int i = tableSize - 1; i >= 0; --i) {
+        if (table.at(i).c >= 0) {
+            previousFilled = i;
+            break;
+        }
+    }
+    if (previousFilled < 0) {
+        // No sample at all. This should never happen.
+        table.fill(LchDouble {(m_blackpointL + m_whitepointL) / 2, 0, 0});
+    } else {
+        for (int i = 0; i < tableSize; ++i) {
+            if (table.at(i).c >= 0) {
+                previousFilled = i;
+                continue;
+            }
+            int nextFilled = i + 1;
+            while (table.at(nextFilled % tableSize).c < 0) {
+                ++nextFilled;
+            }
+            // Distances, taking into account that the table is circular:
+            const int distanceToPrevious = (i - previousFilled + tableSize) % tableSize;
+            const int distanceToNext = nextFilled - i;
+            const qreal t = static_cast<qreal>(distanceToPrevious) / (distanceToPrevious + distanceToNext);
+            const LchDouble &previous = table.at(previousFilled);
+            const LchDouble &next = table.at(nextFilled % tableSize);
+            table[i].l = previous.l + t * (next.l - previous.l);
+            table[i].c = previous.c + t * (next.c - previous.c);
+            // Do not update previousFilled: The next gap entry has
+            // still to be interpolated between the same neighbors.
+        }
+    }
+    for (int i = 0; i < tableSize; ++i) {
+        table[i].h = static_cast<qreal>(i) / cuspTableResolution;
+    }
+    m_cuspTable = table;
+}
+
+/** @brief The cusp of the gamut at a given hue.
+ *
+ * The cusp is the point of maximum chroma at a given hue. This function
+ * interpolates linearly within @ref m_cuspTable, which is built on
+ * the first call.
+ *
+ * This function is thread-safe.
+ *
+ * @param hue The hue. Values outside of the range <tt>[0, 360[</tt>
+ * are normalized.
+ * @returns The cusp at the given hue. The hue of the return value is the
+ * normalized <tt>hue</tt>. */
+LchDouble RgbColorSpace::RgbColorSpacePrivate::cusp(qreal hue) const
+{
+    std::call_once(m_cuspTableOnceFlag, [this]() {
+        buildCuspTable();
+    });
+    const int tableSize = m_cuspTable.count();
+    LchDouble result;
+    result.h = std::fmod(hue, 360);
+    if (result.h < 0) {
+        result.h += 360;
+    }
+    const qreal position = result.h * cuspTableResolution;
+    const int index = qFloor(position);
+    const qreal t = position - index;
+    const LchDouble &first = m_cuspTable.at(index % tableSize);
+    const LchDouble &second = m_cuspTable.at((index + 1) % tableSize);
+    result.l = first.l + t * (second.l - first.l);
+    result.c = first.c + t * (second.c - first.c);
+    return result;
+}
+
+/** @brief Hue-preserving gamut mapping towards the cusp.
+ *
+ * Out-of-gamut colors are moved on a straight line (within the
+ * chroma-lightness plane of their hue) towards the point on the gray
+ * axis that has the lightness of the cusp. This preserves the hue and
+ * usually gives more natural results for very light and very dark
+ * colors than reducing only the chroma, because it reduces chroma and
+ * adapts lightness at the same time.
+ *
+ * The cusp comes from a precomputed per-color-space table. A triangle
+ * approximation of the gamut (black point, cusp, white point) provides
+ * a first estimate, which is then refined by a short bisection.
+ *
+ * @param color The original color
+ * @param precision Precision of the gamut boundary search. The default
+ * value is appropriate for final results. Widgets might use a coarser
+ * value (like @ref interactiveGamutPrecision) during mouse drags.
+ * @returns A <em>normalized</em> in-gamut color with the same hue. If the
+ * original color is yet in-gamut, it is returned (normalized) without
+ * further changes.
+ *
+ * @sa @ref nearestInGamutColorByAdjustingChroma()
+ * @sa @ref nearestInGamutColorByAdjustingChromaLightness() */
+PerceptualColor::LchDouble RgbColorSpace::nearestInGamutColorByCuspMapping(const PerceptualColor::LchDouble &color, qreal precision) const
+{
+    LchDouble result = color;
+    PolarPointF temp(result.c, result.h);
+    result.c = temp.radial();
+    result.h = temp.angleDegree();
+    if (isInGamut(result)) {
+        return result;
+    }
+
+    const LchDouble cusp = d_pointer->cusp(result.h);
+    const qreal blackL = d_pointer->m_blackpointL;
+    const qreal whiteL = d_pointer->m_whitepointL;
+    // The anchor on the gray axis, at the lightness of the cusp:
+    const LchDouble anchor {qBound(blackL, cusp.l, whiteL), 0, result.h};
+    if (!isInGamut(anchor)) {
+        // Should never happen, but we stay on the safe side.
+        return nearestInGamutColorByAdjustingChroma(result, precision);
+    }
+    // Points on the line between anchor (t = 0) and result (t = 1):
+    const auto pointAt = [&anchor, &result](qreal t) {
+        return LchDouble {anchor.l + t * (result.l - anchor.l), t * result.c, result.h};
+    };
+
+    // First estimate: Intersection with the triangle
+    // black point – cusp – white point.
+    qreal estimate = 1;
+    const qreal deltaL = result.l - anchor.l;
+    qreal denominator;
+    if (deltaL >= 0) {
+        // Intersection with the upper edge (cusp – white point)
+        denominator = result.c * (whiteL - anchor.l) + cusp.c * deltaL;
+        if (denominator > 0) {
+            estimate = cusp.c * (whiteL - anchor.l) / denominator;
+        }
+    } else {
+        // Intersection with the lower edge (black point – cusp)
+        denominator = result.c * (anchor.l - blackL) - cusp.c * deltaL;
+        if (denominator > 0) {
+            estimate = cusp.c * (anchor.l - blackL) / denominator;
+        }
+    }
+    estimate = qBound<qreal>(0, estimate, 1);
+
+    qreal lower = 0; // in-gamut
+    qreal upper = 1; // out-of-gamut
+    if (isInGamut(pointAt(estimate))) {
+        lower = estimate;
+    } else {
+        upper = estimate;
+    }
+    // Short line search (bisection)
+    const qreal lineLength = qSqrt(deltaL * deltaL + result.c * result.c);
+    while ((upper - lower) * lineLength > precision) {
+        const qreal candidate = (lower + upper) / 2;
+        if (isInGamut(pointAt(candidate))) {
+            lower = candidate;
+        } else {
+            upper = candidate;
+        }
+    }
+    return pointAt(lower);
+}
+
 /** @brief Search the nearest non-transparent neighbor pixel
  *
  * This implements a
@@ -797,4 +1690,167 @@ int RgbColorSpace::maximumChroma() const
     return d_pointer->m_maximumChroma;
 }
 
+/** @brief The precomputed gamut boundary.
+ *
+ * The boundary is built during initialization.
+ *
+ * This function is thread-safe.
+ *
+ * @returns The precomputed gamut boundary. */
+const GamutBoundary &RgbColorSpace::RgbColorSpacePrivate::gamutBoundary() const
+{
+    return *m_gamutBoundary;
+}
+
+/** @brief The maximum in-gamut chroma.
+ *
+ * The value is interpolated from a precomputed table of the gamut
+ * boundary, which is built when the color space is created. This
+ * function is cheap and does not call LittleCMS, so it can be called
+ * very often. The interpolated values are approximations. Next to the
+ * cusp, the error might be some chroma units. Use
+ * @ref maximumInGamutChroma(qreal, qreal, qreal) const for exact values.
+ *
+ * This function is thread-safe.
+ *
+ * @param lightness The lightness
+ * @param hue The hue. Values outside of the range <tt>[0, 360[</tt>
+ * are normalized.
+ * @returns The maximum chroma that is in-gamut for the given lightness
+ * and hue. <tt>0</tt> if even the gray color of this lightness is
+ * out-of-gamut.
+ *
+ * @sa @ref maximumInGamutChroma(PlanarView<double>) const for
+ * batch processing */
+qreal RgbColorSpace::maximumInGamutChroma(qreal lightness, qreal hue) const
+{
+    return d_pointer->gamutBoundary().maximumChroma(lightness, hue);
+}
+
+/** @brief The maximum in-gamut chroma with a given precision.
+ *
+ * The precomputed table of the gamut boundary provides the start
+ * value. It is refined by a bisection with exact in-gamut tests, which
+ * is usually short.
+ *
+ * This function is thread-safe.
+ *
+ * @param lightness The lightness
+ * @param hue The hue. Values outside of the range <tt>[0, 360[</tt>
+ * are normalized.
+ * @param precision The precision of the result, for example
+ * @ref gamutPrecision
+ * @returns The maximum chroma that is in-gamut for the given lightness
+ * and hue. <tt>0</tt> if even the gray color of this lightness is
+ * out-of-gamut. The color with the returned chroma is in-gamut. */
+qreal RgbColorSpace::maximumInGamutChroma(qreal lightness, qreal hue, qreal precision) const
+{
+    return d_pointer->gamutBoundary().maximumChroma(lightness, hue, precision);
+}
+
+/** @brief The maximum in-gamut chroma (batch processing).
+ *
+ * This is the batch version of @ref maximumInGamutChroma(qreal, qreal) const.
+ *
+ * @param lch View to a @ref LchBuffer (or a slice of it). The lightness
+ * and hue planes are the input. The results are written to the
+ * chroma plane. */
+void RgbColorSpace::maximumInGamutChroma(PlanarView<double> lch) const
+{
+    d_pointer->gamutBoundary().maximumChroma(lch);
+}
+
+/** @brief The range of lightness that is in-gamut.
+ *
+ * The value is interpolated from a precomputed table of the gamut
+ * boundary, like @ref maximumInGamutChroma(qreal, qreal) const.
+ *
+ * This function is thread-safe.
+ *
+ * @param hue The hue. Values outside of the range <tt>[0, 360[</tt>
+ * are normalized.
+ * @param chroma The chroma
+ * @returns The minimum lightness (first) and the maximum
+ * lightness (second) for which the color with the given hue and
+ * chroma is in-gamut. If no such lightness exists (the chroma is beyond
+ * the cusp), both values are NaN.
+ *
+ * @sa @ref lightnessRange(PlanarView<const double>, double *, double *) const
+ * for batch processing */
+QPair<qreal, qreal> RgbColorSpace::lightnessRange(qreal hue, qreal chroma) const
+{
+    return d_pointer->gamutBoundary().lightnessRange(hue, chroma);
+}
+
+/** @brief The range of lightness that is in-gamut (batch processing).
+ *
+ * This is the batch version of @ref lightnessRange(qreal, qreal) const.
+ *
+ * @param lch View to a @ref LchBuffer (or a slice of it). The chroma
+ * and hue planes are the input; the lightness plane is ignored.
+ * @param minimum Buffer that will receive <tt>lch.count()</tt> values:
+ * the minimum lightness
+ * @param maximum Buffer that will receive <tt>lch.count()</tt> values:
+ * the maximum lightness */
+void RgbColorSpace::lightnessRange(PlanarView<const double> lch, double *minimum, double *maximum) const
+{
+    d_pointer->gamutBoundary().lightnessRange(lch, minimum, maximum);
+}
+
+/** @brief The cusp of the gamut at a given hue.
+ *
+ * The cusp is the point of maximum chroma at a given hue. The value is
+ * interpolated from a precomputed table.
+ *
+ * This function is thread-safe.
+ *
+ * @param hue The hue. Values outside of the range <tt>[0, 360[</tt>
+ * are normalized.
+ * @returns The cusp at the given hue. The hue of the return value is the
+ * normalized <tt>hue</tt>.
+ *
+ * @sa @ref cusp(PlanarView<double>) const for batch processing */
+LchDouble RgbColorSpace::cusp(qreal hue) const
+{
+    return d_pointer->cusp(hue);
+}
+
+/** @brief The cusp of the gamut (batch processing).
+ *
+ * This is the batch version of @ref cusp(qreal) const.
+ *
+ * @param lch View to a @ref LchBuffer (or a slice of it). The hue
+ * plane is the input. The lightness and chroma of the cusps are written
+ * to the lightness and the chroma plane. The hue plane is normalized. */
+void RgbColorSpace::cusp(PlanarView<double> lch) const
+{
+    const int count = lch.count();
+    double *lightness = lch.plane(0);
+    double *chroma = lch.plane(1);
+    double *hue = lch.plane(2);
+    for (int i = 0; i < count; ++i) {
+        const LchDouble value = d_pointer->cusp(hue[i]);
+        lightness[i] = value.l;
+        chroma[i] = value.c;
+        hue[i] = value.h;
+    }
+}
+
+/** @brief The gamut cache of this color space.
+ *
+ * The cache is created on first use. Its tiles are calculated on
+ * demand. It is shared by all diagrams that use this color space.
+ *
+ * This function is thread-safe.
+ *
+ * @returns The gamut cache of this color space. It is valid as long as
+ * this object exists. */
+GamutCache &RgbColorSpace::gamutCache() const
+{
+    std::call_once(d_pointer->m_gamutCacheOnceFlag, [this]() {
+        d_pointer->m_gamutCache.reset(new GamutCache(this));
+    });
+    return *d_pointer->m_gamutCache;
+}
+
 } // namespace PerceptualColor
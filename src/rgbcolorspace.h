@@ -30,16 +30,25 @@
 #include "PerceptualColor/perceptualcolorglobal.h"
 #include "perceptualcolorinternal.h"
 
+#include <QByteArray>
+#include <QColor>
 #include <QObject>
+#include <QPair>
 
 #include "PerceptualColor/constpropagatinguniquepointer.h"
 #include "PerceptualColor/lchadouble.h"
 #include "PerceptualColor/lchdouble.h"
+#include "helper.h"
+#include "planarbuffer.h"
+#include "renderingintent.h"
+#include "rgbdouble.h"
 
 #include <lcms2.h>
 
 namespace PerceptualColor
 {
+class GamutCache;
+
 /** @internal
  *
  * @brief Provides access to LittleCMS color management library
@@ -60,21 +69,43 @@ public:
     Q_INVOKABLE static QSharedPointer<PerceptualColor::RgbColorSpace> createFromFile(const QString &fileName);
     Q_INVOKABLE static QSharedPointer<PerceptualColor::RgbColorSpace> createSrgb();
     virtual ~RgbColorSpace() noexcept override;
+    cmsContext context() const;
+    Q_INVOKABLE PerceptualColor::LchDouble cusp(qreal hue) const;
+    void cusp(PlanarView<double> lch) const;
+    void fromLinearRgb(const RgbDouble *linearRgb, QRgb *rgb, int count) const;
+    GamutCache &gamutCache() const;
     Q_INVOKABLE bool isInGamut(const cmsCIELab &lab) const;
     Q_INVOKABLE bool isInGamut(const PerceptualColor::LchDouble &lch) const;
+    void isInGamut(PlanarView<const double> lab, const RgbDouble *rgb, bool *result) const;
+    Q_INVOKABLE QPair<qreal, qreal> lightnessRange(qreal hue, qreal chroma) const;
+    void lightnessRange(PlanarView<const double> lch, double *minimum, double *maximum) const;
     Q_INVOKABLE int maximumChroma() const;
-    Q_INVOKABLE PerceptualColor::LchDouble nearestInGamutColorByAdjustingChroma(const PerceptualColor::LchDouble &color) const;
+    Q_INVOKABLE qreal maximumInGamutChroma(qreal lightness, qreal hue) const;
+    Q_INVOKABLE qreal maximumInGamutChroma(qreal lightness, qreal hue, qreal precision) const;
+    void maximumInGamutChroma(PlanarView<double> lch) const;
+    Q_INVOKABLE PerceptualColor::LchDouble nearestInGamutColorByAdjustingChroma(const PerceptualColor::LchDouble &color, qreal precision = gamutPrecision) const;
     Q_INVOKABLE PerceptualColor::LchDouble nearestInGamutColorByAdjustingChromaLightness(const PerceptualColor::LchDouble &color);
+    Q_INVOKABLE PerceptualColor::LchDouble nearestInGamutColorByCuspMapping(const PerceptualColor::LchDouble &color, qreal precision = gamutPrecision) const;
     QString profileInfoCopyright() const;
     QString profileInfoDescription() const;
     QString profileInfoManufacturer() const;
     QString profileInfoModel() const;
+    QByteArray profileData() const;
+    void toLinearRgb(const QRgb *rgb, RgbDouble *linearRgb, int count) const;
     Q_INVOKABLE PerceptualColor::LchDouble toLch(const cmsCIELab &lab) const;
     Q_INVOKABLE PerceptualColor::LchDouble toLch(const QColor &rgbColor) const;
+    Q_INVOKABLE PerceptualColor::LchDouble toLch(const QColor &rgbColor, const PerceptualColor::RenderingIntent &intent) const;
     Q_INVOKABLE QColor toQColorRgbBound(const PerceptualColor::LchDouble &lch) const;
     Q_INVOKABLE QColor toQColorRgbBound(const PerceptualColor::LchaDouble &lcha) const;
+    Q_INVOKABLE QColor toQColorRgbBound(const PerceptualColor::LchDouble &lch, const PerceptualColor::RenderingIntent &intent) const;
     Q_INVOKABLE QColor toQColorRgbUnbound(const cmsCIELab &Lab) const;                  // TODO Isn’t QColor _always_ bound??? No: Unbound means, out-of-gamut color create an INVALID QColor.
     Q_INVOKABLE QColor toQColorRgbUnbound(const PerceptualColor::LchDouble &lch) const; // TODO Isn’t QColor _always_ bound???
+    void toCielab(const RgbDouble *rgb, cmsCIELab *lab, int count) const;
+    void toCielab(const RgbDouble *rgb, PlanarView<double> lab) const;
+    void toQRgbUnbound(PlanarView<const double> lab, QRgb *rgb) const;
+    void toQRgbUnboundFromLch(PlanarView<const double> lch, PlanarView<double> lab, QRgb *rgb) const;
+    void toRgbDoubleBound(PlanarView<const double> lab, RgbDouble *rgb) const;
+    void toRgbDoubleUnbound(PlanarView<const double> lab, RgbDouble *rgb) const;
 
 private:
     Q_DISABLE_COPY(RgbColorSpace)
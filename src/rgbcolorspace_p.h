@@ -34,10 +34,23 @@
 #include "rgbcolorspace.h"
 
 #include "chromalightnessimage.h"
+#include "cmsmemoryarena.h"
 #include "constpropagatingrawpointer.h"
+#include "gamutboundary.h"
+#include "gamutcache.h"
 #include "lchvalues.h"
+#include "renderingintent.h"
 #include "rgbdouble.h"
 
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include <array>
+#include <memory>
+#include <mutex>
+
 namespace PerceptualColor
 {
 /** @internal
@@ -52,7 +65,7 @@ public:
      *
      * The destructor is non-<tt>virtual</tt> because
      * the class as a whole is <tt>final</tt>. */
-    ~RgbColorSpacePrivate() noexcept = default;
+    ~RgbColorSpacePrivate() noexcept;
 
     // Data members:
     /** @brief The darkest in-gamut point on the L* axis.
@@ -62,35 +75,160 @@ public:
     QString m_cmsInfoDescription;
     QString m_cmsInfoManufacturer;
     QString m_cmsInfoModel;
+    /** @brief Number of entries per degree of hue in @ref m_cuspTable */
+    static constexpr int cuspTableResolution = 10;
+    /** @brief Table of the cusps of the gamut.
+     *
+     * The cusp is the point of maximum chroma at a given hue. The entry
+     * at index <tt>i</tt> contains the cusp for the hue
+     * <tt>i / @ref cuspTableResolution</tt>. Use @ref cusp() to access
+     * the table. It is built lazily on first usage by
+     * @ref buildCuspTable(). */
+    mutable QVector<LchDouble> m_cuspTable;
+    /** @brief Makes sure that @ref buildCuspTable() is called only once,
+     * also when various threads access @ref m_cuspTable at the same time. */
+    mutable std::once_flag m_cuspTableOnceFlag;
+    /** @brief The LittleCMS context of this color space.
+     *
+     * All profiles and transforms of this color space are created
+     * within this context. Its memory comes from @ref m_memoryArena.
+     * Might be <tt>nullptr</tt> (the default context of LittleCMS) if
+     * the context could not be created. */
+    cmsContext m_context = nullptr;
+    /** @brief Whether the Lab-to-RGB transforms clip their results.
+     *
+     * LittleCMS supports unbounded transforms only for some profiles
+     * (like matrix-shaper profiles). For other profiles (like profiles
+     * with a 16-bit CLUT), out-of-gamut colors are clipped silently to
+     * the range <tt>[0, 1]</tt>, so that a range check of the RGB values
+     * cannot detect them. For these profiles, the in-gamut checks
+     * additionally convert the RGB values back to Lab and compare
+     * with the original value.
+     *
+     * @sa @ref detectBoundedTransform()
+     * @sa @ref m_boundedRoundTripTolerance */
+    bool m_isLabToRgbBounded = false;
+    /** @brief Maximum Euclidean distance in Lab (CIE76 ΔE) between the
+     * original color and its round trip through RGB, for colors that
+     * are considered in-gamut.
+     *
+     * Only used if @ref m_isLabToRgbBounded. Even for in-gamut colors,
+     * the round trip through interpolated CLUTs is not exact. Therefore,
+     * this value is derived from the profile itself by
+     * @ref calculateBoundedRoundTripTolerance(). It is also the precision
+     * of the gamut boundary for these profiles: Colors that are
+     * out-of-gamut by less than this distance are considered in-gamut. */
+    double m_boundedRoundTripTolerance = minimumBoundedRoundTripTolerance;
+    /** @brief Lower limit for @ref m_boundedRoundTripTolerance. */
+    static constexpr double minimumBoundedRoundTripTolerance = 1;
+    /** @brief Headroom of @ref m_boundedRoundTripTolerance.
+     *
+     * The round trip error is measured on a grid only. Between the
+     * grid points, the interpolation error might be somewhat bigger. */
+    static constexpr double boundedRoundTripToleranceFactor = 2;
+    /** @brief The boundary for the gamut boundary queries.
+     *
+     * Created during initialization, see @ref gamutBoundary(). */
+    std::unique_ptr<GamutBoundary> m_gamutBoundary;
+    /** @brief The cache for @ref RgbColorSpace::gamutCache()
+     *
+     * Created on first use. */
+    mutable std::unique_ptr<GamutCache> m_gamutCache;
+    /** @brief Makes sure that @ref m_gamutCache is created only once,
+     * also when various threads access it at the same time. */
+    mutable std::once_flag m_gamutCacheOnceFlag;
     int m_maximumChroma = LchValues::humanMaximumChroma;
+    /** @brief The serialized ICC profile of this color space.
+     *
+     * @sa @ref RgbColorSpace::profileData() */
+    QByteArray m_profileData;
+    /** @brief Memory arena for @ref m_context */
+    CmsMemoryArena m_memoryArena;
+    cmsHTRANSFORM m_transformLabPlanarToRgbHandle = nullptr;
     cmsHTRANSFORM m_transformLabToRgb16Handle = nullptr;
     cmsHTRANSFORM m_transformLabToRgbHandle = nullptr;
     cmsHTRANSFORM m_transformRgbToLabHandle = nullptr;
+    cmsHTRANSFORM m_transformRgbToLabPlanarHandle = nullptr;
+    /** @brief The transforms that depend on the rendering intent. */
+    struct IntentTransforms {
+        /** @brief Like @ref m_transformLabToRgb16Handle */
+        cmsHTRANSFORM labToRgb16Handle = nullptr;
+        /** @brief Like @ref m_transformRgbToLabHandle */
+        cmsHTRANSFORM rgbToLabHandle = nullptr;
+    };
+    /** @brief Cache for @ref intentTransforms()
+     *
+     * Contains the transforms for all rendering intents that have been
+     * used so far, except the default rendering intent, which uses
+     * @ref m_transformLabToRgb16Handle and @ref m_transformRgbToLabHandle.
+     * Transforms that could not be created are <tt>nullptr</tt>.
+     *
+     * Protected by @ref m_intentTransformsMutex. */
+    mutable QHash<RenderingIntent, IntentTransforms> m_intentTransforms;
+    /** @brief Protects @ref m_intentTransforms. */
+    mutable QMutex m_intentTransformsMutex;
+    /** @brief Number of entries (minus one) of
+     * @ref m_delinearizationTables */
+    static constexpr int delinearizationTableResolution = 4095;
+    /** @brief The transfer functions of the RGB channels, tabulated.
+     *
+     * For each channel (red, green, blue), the linear value for each
+     * 8-bit value. For matrix-shaper profiles, the tone curves of the
+     * profile are used. For other profiles, the sRGB curve is used as
+     * an approximation.
+     *
+     * @sa @ref RgbColorSpace::toLinearRgb()
+     * @sa @ref m_delinearizationTables */
+    std::array<std::array<double, 256>, 3> m_linearizationTables;
+    /** @brief The inverse functions of @ref m_linearizationTables,
+     * tabulated.
+     *
+     * For each channel (red, green, blue), the entry at index <tt>i</tt>
+     * is the 8-bit value for the linear value
+     * <tt>i / @ref delinearizationTableResolution</tt>.
+     *
+     * @sa @ref RgbColorSpace::fromLinearRgb() */
+    std::array<std::array<quint8, delinearizationTableResolution + 1>, 3> m_delinearizationTables;
+    /** @brief LittleCMS buffer format for @ref LabBuffer
+     *
+     * Like <tt>TYPE_Lab_DBL</tt>, but planar. */
+    static constexpr cmsUInt32Number typeLabDoublePlanar = TYPE_Lab_DBL | PLANAR_SH(1);
     /** @brief The lightest in-gamut point on the L* axis.
      * @sa blackpointL() */
     qreal m_whitepointL;
 
     // Functions:
+    void buildCuspTable() const;
+    void buildLinearizationTables(cmsHPROFILE rgbProfileHandle);
+    double calculateBoundedRoundTripTolerance() const;
     cmsCIELab colorLab(const RgbDouble &rgb) const;
+    static cmsCIELab colorLab(const RgbDouble &rgb, cmsHTRANSFORM transformHandle);
     RgbDouble colorRgbBoundSimple(const cmsCIELab &Lab) const;
+    static RgbDouble colorRgbBoundSimple(const cmsCIELab &Lab, cmsHTRANSFORM transformHandle);
+    IntentTransforms createIntentTransforms(const RenderingIntent &intent) const;
+    LchDouble cusp(qreal hue) const;
     static void deleteTransform(cmsHTRANSFORM &transformHandle);
+    bool detectBoundedTransform() const;
+    const GamutBoundary &gamutBoundary() const;
     static QString getInformationFromProfile(cmsHPROFILE profileHandle, cmsInfoType infoType);
     bool initialize(cmsHPROFILE rgbProfileHandle);
+    IntentTransforms intentTransforms(const RenderingIntent &intent) const;
+    bool isInGamut(const cmsCIELab &lab, const RgbDouble &rgb) const;
     cmsCIELab toLab(const QColor &rgbColor) const;
     QColor toQColorRgbBound(const cmsCIELab &Lab) const;
 
     // Dirty hacks:
     static QPoint nearestNeighborSearch(const QPoint originalPoint, const QImage &image);
-    /** TODO WARNING This is a memory leak. This member is not deleted in
-     * the desctuctor of the class. This is because ChromaLightnessImage has
-     * a shared pointer to _this_ object. If nearestNeighborSearchImage
-     * would be on the heap, deleting in when _this_ object is deleted will
-     * call again deleting _this_ object, and this recursive destructor
-     * call will crash the library. Therefore, we implement
-     * nearestNeighborSearchImage as a pointer with memory leak to avoid
-     * the crash. This memory leak is not fixed currently, because
-     * anyway we need to re-write all the code for nearest-neigbor search. */
-    ChromaLightnessImage *m_nearestNeighborSearchImage;
+    /** @brief Image for @ref nearestNeighborSearch()
+     *
+     * The image needs a shared pointer to <em>this</em> color space. An
+     * owning shared pointer would be a reference cycle, so the image gets
+     * a non-owning shared pointer instead (see @ref initialize()). This
+     * is safe because the image is owned by <em>this</em> object and
+     * therefore never outlives it.
+     *
+     * <tt>nullptr</tt> if @ref initialize() has not succeeded. */
+    std::unique_ptr<ChromaLightnessImage> m_nearestNeighborSearchImage;
     static constexpr int nearestNeighborSearchImageHeight = 400;
 
 private:
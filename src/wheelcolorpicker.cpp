@@ -86,6 +86,24 @@ WheelColorPicker::WheelColorPicker(const QSharedPointer<PerceptualColor::RgbColo
             // As value is stored anyway within ChromaLightnessDiagram member,
             // it’s enough to just emit the corresponding signal of this class:
             &WheelColorPicker::currentColorChanged);
+    // The child widgets use the same color vision deficiency and the
+    // same display color space as this widget:
+    connect(this, //
+            &AbstractDiagram::colorVisionDeficiencyChanged,
+            d_pointer->m_colorWheel,
+            &AbstractDiagram::setColorVisionDeficiency);
+    connect(this, //
+            &AbstractDiagram::displayColorSpaceChanged,
+            d_pointer->m_colorWheel,
+            &AbstractDiagram::setDisplayColorSpace);
+    connect(this, //
+            &AbstractDiagram::displayColorSpaceChanged,
+            d_pointer->m_chromaLightnessDiagram,
+            &AbstractDiagram::setDisplayColorSpace);
+    connect(this, //
+            &AbstractDiagram::colorVisionDeficiencyChanged,
+            d_pointer->m_chromaLightnessDiagram,
+            &AbstractDiagram::setColorVisionDeficiency);
     connect(
         // QWidget’s constructor requires a QApplication object. As this
         // is a class derived from QWidget, calling qApp is save here.
@@ -139,6 +157,33 @@ void WheelColorPicker::WheelColorPickerPrivate::handleFocusChanged(QWidget *old,
     }
 }
 
+/** @brief The main event handler.
+ *
+ * Reimplemented from base class.
+ *
+ * Discards the cached @ref minimumSizeHint() when the widget is
+ * polished, when the style or the font changes, or when a child widget
+ * has requested a new layout because its size hint has changed. Apart
+ * from that, it calls the implementation in the parent class.
+ *
+ * @param event the event to be handled.
+ *
+ * @returns The return value of the implementation in the parent class. */
+bool WheelColorPicker::event(QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::Type::FontChange:
+    case QEvent::Type::LayoutRequest:
+    case QEvent::Type::Polish:
+    case QEvent::Type::StyleChange:
+        d_pointer->m_minimumSizeHint = QSize();
+        break;
+    default:
+        break;
+    }
+    return AbstractDiagram::event(event);
+}
+
 /** @brief React on a resize event.
  *
  * Reimplemented from base class.
@@ -360,6 +405,9 @@ void WheelColorPicker::setCurrentColor(const LchDouble &newCurrentColor)
  * @sa @ref sizeHint() */
 QSize WheelColorPicker::minimumSizeHint() const
 {
+    if (d_pointer->m_minimumSizeHint.isValid()) {
+        return d_pointer->m_minimumSizeHint;
+    }
     const QSizeF minimumDiagramSize =
         // Get the mimimum size of the chroma-lightness widget.
         d_pointer->m_chromaLightnessDiagram->minimumSizeHint()
@@ -383,11 +431,12 @@ QSize WheelColorPicker::minimumSizeHint() const
                                           diameterForMinimumDiagramSize  // y
     );
 
-    return sizeForMinimumDiagramSize
-        // Expand to the minimumSizeHint() of the color wheel itself
-        .expandedTo(d_pointer->m_colorWheel->minimumSizeHint())
-        // Expand to the global minimum size for GUI elements
-        .expandedTo(QApplication::globalStrut());
+    d_pointer->m_minimumSizeHint = sizeForMinimumDiagramSize
+                                       // Expand to the minimumSizeHint() of the color wheel itself
+                                       .expandedTo(d_pointer->m_colorWheel->minimumSizeHint())
+                                       // Expand to the global minimum size for GUI elements
+                                       .expandedTo(QApplication::globalStrut());
+    return d_pointer->m_minimumSizeHint;
 }
 
 /** @brief Recommmended minimum size for the widget.
@@ -68,6 +68,12 @@ public:
     QSharedPointer<PerceptualColor::RgbColorSpace> m_rgbColorSpace;
     /** @brief A pointer to the @ref ColorWheel child widget. */
     QPointer<ColorWheel> m_colorWheel;
+    /** @brief Cache for @ref WheelColorPicker::minimumSizeHint()
+     *
+     * An invalid size if there is no cached value.
+     *
+     * @sa @ref WheelColorPicker::event() */
+    mutable QSize m_minimumSizeHint;
 
 public Q_SLOTS:
     void handleFocusChanged(QWidget *old, QWidget *now);
@@ -30,12 +30,16 @@
 // First included header is the public header of the class we are testing;
 // this forces the header to be self-contained.
 #include "PerceptualColor/abstractdiagram.h"
+// Second, the private implementation.
+#include "abstractdiagram_p.h"
 
 #include <QtTest>
 
 #include "helper.h"
 
+#include <QKeyEvent>
 #include <QPainter>
+#include <QStyleFactory>
 #include <QWidget>
 
 class TestAbstractDiagramHelperClass : public PerceptualColor::AbstractDiagram
@@ -72,6 +76,23 @@ public:
         myPainter.fillRect(0, 0, 150, 200, QBrush(QColor(255, 0, 0, 128)));
         //! [useTransparencyBackground]
     }
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override
+    {
+        // Accepts Key_Up and Key_Down, but only Key_Up changes the widget.
+        switch (event->key()) {
+        case Qt::Key_Up:
+            event->accept();
+            scheduleRepaint();
+            break;
+        case Qt::Key_Down:
+            event->accept();
+            break;
+        default:
+            AbstractDiagram::keyPressEvent(event);
+        }
+    }
 };
 
 namespace PerceptualColor
@@ -119,6 +140,59 @@ private Q_SLOTS:
         helper.testSnippet01();
     }
 
+    void testColorVisionDeficiency()
+    {
+        PerceptualColor::AbstractDiagram myDiagram;
+        QCOMPARE(myDiagram.colorVisionDeficiency(), //
+                 PerceptualColor::AbstractDiagram::ColorVisionDeficiency::none);
+        QSignalSpy spy(&myDiagram, &PerceptualColor::AbstractDiagram::colorVisionDeficiencyChanged);
+        myDiagram.setColorVisionDeficiency(PerceptualColor::AbstractDiagram::ColorVisionDeficiency::tritanopia);
+        QCOMPARE(myDiagram.colorVisionDeficiency(), //
+                 PerceptualColor::AbstractDiagram::ColorVisionDeficiency::tritanopia);
+        QCOMPARE(spy.count(), 1);
+        // Setting the same value again does not emit a signal.
+        myDiagram.setColorVisionDeficiency(PerceptualColor::AbstractDiagram::ColorVisionDeficiency::tritanopia);
+        QCOMPARE(spy.count(), 1);
+    }
+
+    void testInputLatency()
+    {
+        PerceptualColor::AbstractDiagram myDiagram;
+        QCOMPARE(myDiagram.inputLatencySampleCount(), 0);
+        QCOMPARE(myDiagram.inputLatencyPercentile(99), 0);
+        myDiagram.show();
+        // AbstractDiagram itself does not accept key events, so they
+        // are not measured.
+        QTest::keyClick(&myDiagram, Qt::Key_Up);
+        myDiagram.repaint();
+        QCOMPARE(myDiagram.inputLatencySampleCount(), 0);
+        myDiagram.resetInputLatency();
+        QCOMPARE(myDiagram.inputLatencySampleCount(), 0);
+    }
+
+    void testInputLatencyOnlyForRepaints()
+    {
+        TestAbstractDiagramHelperClass myDiagram;
+        myDiagram.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&myDiagram));
+        myDiagram.resetInputLatency();
+        // Accepted, but without scheduling a paint event: Not measured,
+        // not even by the next unrelated paint event.
+        QTest::keyClick(&myDiagram, Qt::Key_Down);
+        myDiagram.repaint();
+        QCOMPARE(myDiagram.inputLatencySampleCount(), 0);
+        // Accepted and scheduling a paint event: Measured.
+        QTest::keyClick(&myDiagram, Qt::Key_Up);
+        myDiagram.repaint();
+        QCOMPARE(myDiagram.inputLatencySampleCount(), 1);
+        // Mixed within the same event loop iteration: Only the event
+        // that scheduled the paint event is measured.
+        QTest::keyClick(&myDiagram, Qt::Key_Down);
+        QTest::keyClick(&myDiagram, Qt::Key_Up);
+        myDiagram.repaint();
+        QCOMPARE(myDiagram.inputLatencySampleCount(), 2);
+    }
+
     void testTransparencyBackground()
     {
         PerceptualColor::AbstractDiagram myDiagram;
@@ -179,6 +253,31 @@ private Q_SLOTS:
         QVERIFY(temp.gradientMinimumLength() > temp.gradientThickness());
     }
 
+    void testGradientMetricsCache()
+    {
+        // The style has to live longer than the widget.
+        QScopedPointer<QStyle> style(QStyleFactory::create(QStringLiteral("Fusion")));
+        if (style.isNull()) {
+            QSKIP("Fusion style is not available.");
+        }
+        AbstractDiagram temp;
+        const int thickness = temp.gradientThickness();
+        const int length = temp.gradientMinimumLength();
+        QCOMPARE(temp.d_pointer->m_gradientThickness, thickness);
+        QCOMPARE(temp.d_pointer->m_gradientMinimumLength, length);
+        // A style change discards the cache.
+        temp.setStyle(style.data());
+        QCOMPARE(temp.d_pointer->m_gradientThickness, -1);
+        QCOMPARE(temp.d_pointer->m_gradientMinimumLength, -1);
+        QVERIFY(temp.gradientThickness() > 0);
+        QVERIFY(temp.gradientMinimumLength() > temp.gradientThickness());
+        // A font change discards the cache.
+        QFont font = temp.font();
+        font.setPointSize(font.pointSize() + 5);
+        temp.setFont(font);
+        QCOMPARE(temp.d_pointer->m_gradientThickness, -1);
+    }
+
     void testHandleColorFromBackgroundLightness()
     {
         AbstractDiagram temp;
@@ -0,0 +1,405 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "batchcoloredit.h"
+
+#include <QtTest>
+
+#include "helper.h"
+#include "rgbcolorspace.h"
+
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtMath>
+
+#include <cmath>
+
+#include <lcms2.h>
+
+Q_DECLARE_METATYPE(PerceptualColor::BatchColorEdit::GamutMapping)
+
+static QVector<PerceptualColor::LchDouble> snippet01()
+{
+    QSharedPointer<PerceptualColor::RgbColorSpace> colorSpace = PerceptualColor::RgbColorSpace::createSrgb();
+    QVector<PerceptualColor::LchDouble> swatches;
+    swatches.append(PerceptualColor::LchDouble {50, 20, 30});
+    swatches.append(PerceptualColor::LchDouble {60, 30, 200});
+    //! [Use BatchColorEdit]
+    // Make all swatches 5 units lighter, keep hue:
+    PerceptualColor::BatchColorEdit edit(colorSpace, swatches);
+    PerceptualColor::BatchColorEdit::Adjustment lighter;
+    lighter.lightnessOffset = 5;
+    QVector<PerceptualColor::LchDouble> result = edit.result( //
+        lighter,
+        PerceptualColor::BatchColorEdit::GamutMapping::AdjustChroma);
+    //! [Use BatchColorEdit]
+    return result;
+}
+
+namespace PerceptualColor
+{
+class TestBatchColorEdit : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestBatchColorEdit(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    QSharedPointer<RgbColorSpace> m_rgbColorSpace = RgbColorSpace::createSrgb();
+
+    /** @brief In-gamut colors at random. */
+    QVector<LchDouble> randomInGamutColors(int count) const
+    {
+        QRandomGenerator random(count);
+        QVector<LchDouble> result;
+        result.reserve(count);
+        while (result.count() < count) {
+            const LchDouble color {random.generateDouble() * 100, //
+                                   random.generateDouble() * 100,
+                                   random.generateDouble() * 360};
+            if (m_rgbColorSpace->isInGamut(color)) {
+                result.append(color);
+            }
+        }
+        return result;
+    }
+
+    /** @brief A color space with sRGB primaries and a black point of
+     * 2 % luminance.
+     *
+     * @param directory Directory for the profile file
+     * @returns The color space, or a null pointer on failure. */
+    static QSharedPointer<RgbColorSpace> liftedBlackColorSpace(const QTemporaryDir &directory)
+    {
+        // The sRGB curve, scaled to the range between black level and 1.
+        // Type 5: Y = (aX + b)^g + e for X ≥ d; Y = cX + f for X < d
+        const double blackLevel = 0.02;
+        const double range = 1 - blackLevel;
+        const double gamma = 2.4;
+        const double scale = qPow(range, 1 / gamma);
+        const double parameters[7] = {gamma,
+                                      scale / 1.055,
+                                      scale * 0.055 / 1.055,
+                                      range / 12.92,
+                                      0.04045,
+                                      blackLevel,
+                                      blackLevel};
+        cmsToneCurve *curve = cmsBuildParametricToneCurve(nullptr, 5, parameters);
+        cmsToneCurve *curves[3] = {curve, curve, curve};
+        cmsCIExyY whitePoint;
+        cmsWhitePointFromTemp(&whitePoint, 6504);
+        const cmsCIExyYTRIPLE primaries = {{0.6400, 0.3300, 1}, //
+                                           {0.3000, 0.6000, 1},
+                                           {0.1500, 0.0600, 1}};
+        cmsHPROFILE profile = cmsCreateRGBProfile(&whitePoint, &primaries, curves);
+        cmsFreeToneCurve(curve);
+        const QString fileName = directory.filePath(QStringLiteral("liftedblack.icc"));
+        const bool isSaved = cmsSaveProfileToFile(profile, QFile::encodeName(fileName).constData());
+        cmsCloseProfile(profile);
+        if (!isSaved) {
+            return QSharedPointer<RgbColorSpace>();
+        }
+        return RgbColorSpace::createFromFile(fileName);
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testConstructor()
+    {
+        const QVector<LchDouble> colors = randomInGamutColors(10);
+        BatchColorEdit edit(m_rgbColorSpace, colors);
+        QCOMPARE(edit.count(), 10);
+        const QVector<LchDouble> storedColors = edit.colors();
+        QCOMPARE(storedColors.count(), colors.count());
+        for (int i = 0; i < colors.count(); ++i) {
+            QVERIFY(storedColors.at(i).hasSameCoordinates(colors.at(i)));
+        }
+    }
+
+    void testIdentity_data()
+    {
+        QTest::addColumn<BatchColorEdit::GamutMapping>("gamutMapping");
+        QTest::newRow("AdjustChroma") << BatchColorEdit::GamutMapping::AdjustChroma;
+        QTest::newRow("CuspMapping") << BatchColorEdit::GamutMapping::CuspMapping;
+    }
+
+    void testIdentity()
+    {
+        QFETCH(BatchColorEdit::GamutMapping, gamutMapping);
+        const QVector<LchDouble> colors = randomInGamutColors(100);
+        BatchColorEdit edit(m_rgbColorSpace, colors);
+        const QVector<LchDouble> result = //
+            edit.result(BatchColorEdit::Adjustment(), gamutMapping);
+        QCOMPARE(result.count(), colors.count());
+        for (int i = 0; i < colors.count(); ++i) {
+            QVERIFY(qAbs(result.at(i).l - colors.at(i).l) < 1e-6);
+            QVERIFY(qAbs(result.at(i).c - colors.at(i).c) < 1e-6);
+            QVERIFY(qAbs(result.at(i).h - colors.at(i).h) < 1e-6);
+        }
+    }
+
+    void testAdjustment()
+    {
+        const QVector<LchDouble> colors {LchDouble {50, 10, 350}, //
+                                         LchDouble {98, 10, 10}};
+        BatchColorEdit edit(m_rgbColorSpace, colors);
+        BatchColorEdit::Adjustment adjustment;
+        adjustment.lightnessOffset = 5;
+        adjustment.chromaScale = 0.5;
+        adjustment.hueOffset = 20;
+        const QVector<LchDouble> result = edit.result( //
+            adjustment,
+            BatchColorEdit::GamutMapping::AdjustChroma);
+        QCOMPARE(result.at(0).l, 55.0);
+        QCOMPARE(result.at(0).c, 5.0);
+        // The hue is normalized.
+        QVERIFY(qAbs(result.at(0).h - 10) < 1e-9);
+        // The lightness is bound.
+        QVERIFY(result.at(1).l <= 100);
+        QVERIFY(qAbs(result.at(1).h - 30) < 1e-9);
+    }
+
+    void testResultIsInGamut_data()
+    {
+        testIdentity_data();
+    }
+
+    void testResultIsInGamut()
+    {
+        QFETCH(BatchColorEdit::GamutMapping, gamutMapping);
+        BatchColorEdit edit(m_rgbColorSpace, randomInGamutColors(200));
+        BatchColorEdit::Adjustment adjustment;
+        adjustment.chromaScale = 3;
+        adjustment.lightnessOffset = 10;
+        const QVector<LchDouble> result = edit.result(adjustment, gamutMapping);
+        for (const LchDouble &color : result) {
+            QVERIFY(m_rgbColorSpace->isInGamut(color));
+        }
+    }
+
+    void testCuspMappingKeepsHue()
+    {
+        BatchColorEdit edit(m_rgbColorSpace, QVector<LchDouble> {LchDouble {90, 30, 250}});
+        BatchColorEdit::Adjustment adjustment;
+        adjustment.chromaScale = 5;
+        const LchDouble result = edit.result( //
+                                         adjustment,
+                                         BatchColorEdit::GamutMapping::CuspMapping)
+                                     .at(0);
+        QVERIFY(qAbs(result.h - 250) < 1e-9);
+        // Cusp mapping changes also the lightness.
+        QVERIFY(result.l < 90);
+    }
+
+    void testPreviewMatchesResult_data()
+    {
+        testIdentity_data();
+    }
+
+    void testPreviewMatchesResult()
+    {
+        QFETCH(BatchColorEdit::GamutMapping, gamutMapping);
+        BatchColorEdit edit(m_rgbColorSpace, randomInGamutColors(500));
+        BatchColorEdit::Adjustment adjustment;
+        adjustment.chromaScale = 2;
+        adjustment.hueOffset = 40;
+        QVector<QRgb> preview(edit.count());
+        edit.preview(adjustment, gamutMapping, preview.data());
+        const QVector<LchDouble> result = edit.result(adjustment, gamutMapping);
+        for (int i = 0; i < result.count(); ++i) {
+            const QColor expected = m_rgbColorSpace->toQColorRgbBound(result.at(i));
+            const QColor actual = QColor(preview.at(i));
+            QCOMPARE(actual.alpha(), 255);
+            // The preview searches the gamut boundary only with
+            // interactiveGamutPrecision, which is below one step of
+            // 8-bit RGB. Together with the different rounding of both
+            // conversion paths, this gives at most two steps.
+            QVERIFY(qAbs(actual.red() - expected.red()) <= 2);
+            QVERIFY(qAbs(actual.green() - expected.green()) <= 2);
+            QVERIFY(qAbs(actual.blue() - expected.blue()) <= 2);
+        }
+    }
+
+    void testResultMatchesColorSpace_data()
+    {
+        testIdentity_data();
+    }
+
+    void testResultMatchesColorSpace()
+    {
+        QFETCH(BatchColorEdit::GamutMapping, gamutMapping);
+        BatchColorEdit edit(m_rgbColorSpace, randomInGamutColors(300));
+        BatchColorEdit::Adjustment adjustment;
+        adjustment.chromaScale = 2.5;
+        adjustment.hueOffset = 20;
+        adjustment.lightnessOffset = -5;
+        const QVector<LchDouble> result = edit.result(adjustment, gamutMapping);
+        const QVector<LchDouble> colors = edit.colors();
+        int mappedCount = 0;
+        for (int i = 0; i < result.count(); ++i) {
+            LchDouble adjusted = colors.at(i);
+            adjusted.l = qBound<qreal>(0, adjusted.l - 5, 100);
+            adjusted.c = adjusted.c * 2.5;
+            adjusted.h = std::fmod(adjusted.h + 20, 360);
+            if (m_rgbColorSpace->isInGamut(adjusted)) {
+                continue;
+            }
+            ++mappedCount;
+            const LchDouble expected = (gamutMapping == BatchColorEdit::GamutMapping::CuspMapping) //
+                ? m_rgbColorSpace->nearestInGamutColorByCuspMapping(adjusted)
+                : m_rgbColorSpace->nearestInGamutColorByAdjustingChroma(adjusted);
+            // Same strategy, same precision: The batch search and the
+            // scalar search find the same point on the gamut boundary.
+            // (The anchor of the cusp mapping comes from the gamut
+            // boundary table, so it might differ very slightly.)
+            QVERIFY(qAbs(result.at(i).l - expected.l) < 0.05);
+            QVERIFY(qAbs(result.at(i).c - expected.c) < 0.05);
+            QVERIFY(qAbs(result.at(i).h - expected.h) < 1e-9);
+        }
+        QVERIFY(mappedCount > 0);
+    }
+
+    void testPreviewBelowBlackpoint_data()
+    {
+        testIdentity_data();
+    }
+
+    void testPreviewBelowBlackpoint()
+    {
+        QFETCH(BatchColorEdit::GamutMapping, gamutMapping);
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QSharedPointer<RgbColorSpace> space = liftedBlackColorSpace(directory);
+        QVERIFY(!space.isNull());
+        const qreal blackpointL = space->lightnessRange(0, 0).first;
+        QVERIFY(blackpointL > 10);
+        QVector<LchDouble> colors;
+        for (const LchDouble &color : randomInGamutColors(300)) {
+            if (space->isInGamut(color)) {
+                colors.append(color);
+            }
+        }
+        BatchColorEdit edit(space, colors);
+        // Darkening moves many colors below the black point.
+        BatchColorEdit::Adjustment adjustment;
+        adjustment.lightnessOffset = -40;
+        QVector<QRgb> preview(edit.count());
+        edit.preview(adjustment, gamutMapping, preview.data());
+        // All colors stay within the batch search, so that the preview
+        // is fast enough for a mouse drag.
+        QVERIFY(edit.m_search.fallback.isEmpty());
+        const QVector<LchDouble> result = edit.result(adjustment, gamutMapping);
+        QVERIFY(edit.m_search.fallback.isEmpty());
+        int belowBlackpointCount = 0;
+        for (int i = 0; i < result.count(); ++i) {
+            if (colors.at(i).l - 40 < blackpointL) {
+                ++belowBlackpointCount;
+            }
+            QVERIFY(space->isInGamut(result.at(i)));
+            QVERIFY(result.at(i).l >= blackpointL);
+            const QColor expected = space->toQColorRgbBound(result.at(i));
+            const QColor actual = QColor(preview.at(i));
+            QVERIFY(qAbs(actual.red() - expected.red()) <= 2);
+            QVERIFY(qAbs(actual.green() - expected.green()) <= 2);
+            QVERIFY(qAbs(actual.blue() - expected.blue()) <= 2);
+        }
+        QVERIFY(belowBlackpointCount > 0);
+    }
+
+    void testEmpty()
+    {
+        BatchColorEdit edit(m_rgbColorSpace, QVector<LchDouble>());
+        QCOMPARE(edit.count(), 0);
+        edit.preview(BatchColorEdit::Adjustment(), //
+                     BatchColorEdit::GamutMapping::AdjustChroma,
+                     nullptr);
+        QVERIFY(edit.result(BatchColorEdit::Adjustment(), //
+                            BatchColorEdit::GamutMapping::CuspMapping)
+                    .isEmpty());
+    }
+
+    void testSnippet01()
+    {
+        const QVector<LchDouble> result = snippet01();
+        QCOMPARE(result.count(), 2);
+        QCOMPARE(result.at(0).l, 55.0);
+        QCOMPARE(result.at(1).l, 65.0);
+    }
+
+    void benchmarkPreview_data()
+    {
+        testIdentity_data();
+    }
+
+    void benchmarkPreview()
+    {
+        QFETCH(BatchColorEdit::GamutMapping, gamutMapping);
+        BatchColorEdit edit(m_rgbColorSpace, randomInGamutColors(5000));
+        QVector<QRgb> preview(edit.count());
+        BatchColorEdit::Adjustment adjustment;
+        adjustment.chromaScale = 1.5;
+        QBENCHMARK {
+            adjustment.lightnessOffset = adjustment.lightnessOffset + 1;
+            edit.preview(adjustment, gamutMapping, preview.data());
+        }
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestBatchColorEdit)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testbatchcoloredit.moc"
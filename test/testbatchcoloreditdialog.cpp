@@ -0,0 +1,170 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "batchcoloreditdialog.h"
+// Second, the private implementation.
+#include "batchcoloreditdialog_p.h"
+
+#include <QtTest>
+
+#include "rgbcolorspace.h"
+
+#include <QTimer>
+
+namespace PerceptualColor
+{
+class TestBatchColorEditDialog : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestBatchColorEditDialog(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    QSharedPointer<RgbColorSpace> m_rgbColorSpace = RgbColorSpace::createSrgb();
+    const QVector<LchDouble> m_colors {LchDouble {30, 20, 40}, //
+                                       LchDouble {50, 30, 140},
+                                       LchDouble {70, 10, 260}};
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testConstructorAndDestructor()
+    {
+        // This should not crash!
+        BatchColorEditDialog dialog(m_rgbColorSpace, m_colors);
+    }
+
+    void testDefaultAdjustment()
+    {
+        BatchColorEditDialog dialog(m_rgbColorSpace, m_colors);
+        const BatchColorEdit::Adjustment adjustment = dialog.adjustment();
+        QCOMPARE(adjustment.lightnessScale, 1.0);
+        QCOMPARE(adjustment.lightnessOffset, 0.0);
+        QCOMPARE(adjustment.chromaScale, 1.0);
+        QCOMPARE(adjustment.chromaOffset, 0.0);
+        QCOMPARE(adjustment.hueOffset, 0.0);
+        const QVector<LchDouble> edited = dialog.editedColors();
+        QCOMPARE(edited.count(), m_colors.count());
+        for (int i = 0; i < m_colors.count(); ++i) {
+            QVERIFY(qAbs(edited.at(i).l - m_colors.at(i).l) < 1e-6);
+        }
+    }
+
+    void testSliders()
+    {
+        BatchColorEditDialog dialog(m_rgbColorSpace, m_colors);
+        dialog.d_pointer->m_lightnessOffsetSlider->setValue(5);
+        dialog.d_pointer->m_chromaScaleSlider->setValue(50);
+        dialog.d_pointer->m_hueOffsetSlider->setValue(-30);
+        const BatchColorEdit::Adjustment adjustment = dialog.adjustment();
+        QCOMPARE(adjustment.lightnessOffset, 5.0);
+        QCOMPARE(adjustment.chromaScale, 0.5);
+        QCOMPARE(adjustment.hueOffset, -30.0);
+        const QVector<LchDouble> edited = dialog.editedColors();
+        QCOMPARE(edited.at(1).l, 55.0);
+        QCOMPARE(edited.at(1).c, 15.0);
+        QVERIFY(qAbs(edited.at(1).h - 110) < 1e-9);
+    }
+
+    void testGamutMapping()
+    {
+        BatchColorEditDialog dialog(m_rgbColorSpace, m_colors);
+        QCOMPARE(dialog.gamutMapping(), BatchColorEdit::GamutMapping::AdjustChroma);
+        dialog.d_pointer->m_gamutMappingComboBox->setCurrentIndex(1);
+        QCOMPARE(dialog.gamutMapping(), BatchColorEdit::GamutMapping::CuspMapping);
+    }
+
+    void testPreviewUpdates()
+    {
+        BatchColorEditDialog dialog(m_rgbColorSpace, m_colors);
+        // 3 colors need a 2 × 2 image.
+        QCOMPARE(dialog.d_pointer->m_previewImage.size(), QSize(2, 2));
+        const QRgb before = dialog.d_pointer->m_previewImage.pixel(0, 0);
+        // The last pixel is unused.
+        QCOMPARE(qAlpha(dialog.d_pointer->m_previewImage.pixel(1, 1)), 0);
+        dialog.d_pointer->m_lightnessOffsetSlider->setValue(30);
+        const QRgb after = dialog.d_pointer->m_previewImage.pixel(0, 0);
+        QVERIFY(qGray(after) > qGray(before));
+    }
+
+    void testGetColors()
+    {
+        QTimer::singleShot(0, this, []() {
+            BatchColorEditDialog *dialog = qobject_cast<BatchColorEditDialog *>( //
+                QApplication::activeModalWidget());
+            if (dialog != nullptr) {
+                dialog->d_pointer->m_lightnessOffsetSlider->setValue(10);
+                dialog->accept();
+            }
+        });
+        const QVector<LchDouble> edited = //
+            BatchColorEditDialog::getColors(m_rgbColorSpace, m_colors);
+        QCOMPARE(edited.count(), m_colors.count());
+        QCOMPARE(edited.at(0).l, 40.0);
+
+        QTimer::singleShot(0, this, []() {
+            QDialog *dialog = qobject_cast<QDialog *>(QApplication::activeModalWidget());
+            if (dialog != nullptr) {
+                dialog->reject();
+            }
+        });
+        QVERIFY(BatchColorEditDialog::getColors(m_rgbColorSpace, m_colors).isEmpty());
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestBatchColorEditDialog)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testbatchcoloreditdialog.moc"
@@ -309,6 +309,134 @@ private Q_SLOTS:
         myWidget.repaint();
     }
 
+    void testMouseMoveDefersGamutResolution()
+    {
+        ChromaHueDiagram myWidget {m_rgbColorSpace};
+        myWidget.show();
+        myWidget.resize(QSize(400, 400));
+        const QPoint center = myWidget.d_pointer->diagramCenter().toPoint();
+        QTest::mouseClick(&myWidget,
+                          Qt::MouseButton::LeftButton,
+                          Qt::KeyboardModifier::NoModifier,
+                          center);
+        const LchDouble oldColor = myWidget.currentColor();
+        QSignalSpy spy(&myWidget, &ChromaHueDiagram::currentColorChanged);
+        myWidget.d_pointer->m_isMouseEventActive = true;
+        // Move far outside the gamut: The handle follows immediately, while
+        // the color property does not change yet.
+        QMouseEvent moveEvent(QEvent::MouseMove,
+                              QPointF(center.x() + 1000, center.y()),
+                              Qt::NoButton,
+                              Qt::MouseButton::LeftButton,
+                              Qt::KeyboardModifier::NoModifier);
+        QApplication::sendEvent(&myWidget, &moveEvent);
+        QVERIFY(myWidget.d_pointer->m_hasPendingColor);
+        QCOMPARE(spy.count(), 0);
+        QVERIFY(myWidget.currentColor().hasSameCoordinates(oldColor));
+        // After the event loop has run, the color is resolved and the
+        // signal has been emitted exactly once with an in-gamut color.
+        QTRY_COMPARE(spy.count(), 1);
+        QVERIFY(!myWidget.d_pointer->m_hasPendingColor);
+        const LchDouble resolvedColor = spy.at(0).at(0).value<LchDouble>();
+        QVERIFY(resolvedColor.hasSameCoordinates(myWidget.currentColor()));
+        QVERIFY(m_rgbColorSpace->isInGamut(resolvedColor));
+        QVERIFY(myWidget.d_pointer->colorAtHandle().hasSameCoordinates(resolvedColor));
+    }
+
+    void testMouseReleaseResolvesImmediately()
+    {
+        ChromaHueDiagram myWidget {m_rgbColorSpace};
+        myWidget.show();
+        myWidget.resize(QSize(400, 400));
+        const QPoint center = myWidget.d_pointer->diagramCenter().toPoint();
+        QTest::mousePress(&myWidget,
+                          Qt::MouseButton::LeftButton,
+                          Qt::KeyboardModifier::NoModifier,
+                          center);
+        QVERIFY(myWidget.d_pointer->m_hasPendingColor);
+        QTest::mouseRelease(&myWidget,
+                            Qt::MouseButton::LeftButton,
+                            Qt::KeyboardModifier::NoModifier,
+                            center);
+        QVERIFY(!myWidget.d_pointer->m_hasPendingColor);
+        QVERIFY(m_rgbColorSpace->isInGamut(myWidget.currentColor()));
+    }
+
+    void testMouseReleaseUsesFullPrecision()
+    {
+        ChromaHueDiagram myWidget {m_rgbColorSpace};
+        myWidget.show();
+        myWidget.resize(QSize(400, 400));
+        const QPoint center = myWidget.d_pointer->diagramCenter().toPoint();
+        const QPoint outOfGamut = center + QPoint(180, 20);
+        QTest::mousePress(&myWidget,
+                          Qt::MouseButton::LeftButton,
+                          Qt::KeyboardModifier::NoModifier,
+                          center);
+        QMouseEvent moveEvent(QEvent::MouseMove,
+                              outOfGamut,
+                              Qt::NoButton,
+                              Qt::MouseButton::LeftButton,
+                              Qt::KeyboardModifier::NoModifier);
+        QApplication::sendEvent(&myWidget, &moveEvent);
+        QTRY_VERIFY(!myWidget.d_pointer->m_hasPendingColor);
+        // During the drag, the color is in-gamut (but maybe not exact):
+        QVERIFY(m_rgbColorSpace->isInGamut(myWidget.currentColor()));
+        QTest::mouseRelease(&myWidget,
+                            Qt::MouseButton::LeftButton,
+                            Qt::KeyboardModifier::NoModifier,
+                            outOfGamut);
+        // After releasing, the color is the exact result:
+        const LchDouble expected = m_rgbColorSpace->nearestInGamutColorByAdjustingChroma( //
+            m_rgbColorSpace->toLch(myWidget.d_pointer->fromWidgetPixelPositionToLab(outOfGamut)));
+        QVERIFY(myWidget.currentColor().hasSameCoordinates(expected));
+    }
+
+    void testGamutOutline()
+    {
+        ChromaHueDiagram myWidget {m_rgbColorSpace};
+        myWidget.setCurrentColor(LchDouble {50, 10, 0});
+        const QPainterPath outline = myWidget.d_pointer->gamutOutline();
+        QVERIFY(!outline.isEmpty());
+        // In-gamut colors are within the outline…
+        QVERIFY(outline.contains(PolarPointF(10, 0).toCartesian()));
+        QVERIFY(outline.contains(PolarPointF(10, 250).toCartesian()));
+        // … out-of-gamut colors are not.
+        QVERIFY(!m_rgbColorSpace->isInGamut(LchDouble {50, 100, 250}));
+        QVERIFY(!outline.contains(PolarPointF(100, 250).toCartesian()));
+        // The outline is cached for the current lightness…
+        QCOMPARE(myWidget.d_pointer->m_gamutOutlineLightness, 50.0);
+        // … and is updated when the lightness changes.
+        myWidget.setCurrentColor(LchDouble {80, 10, 0});
+        myWidget.d_pointer->gamutOutline();
+        QCOMPARE(myWidget.d_pointer->m_gamutOutlineLightness, 80.0);
+    }
+
+    void testResizeDefersGamutRendering()
+    {
+        ChromaHueDiagram myWidget {m_rgbColorSpace};
+        myWidget.show();
+        myWidget.resize(QSize(300, 300));
+        myWidget.repaint();
+        QVERIFY(!myWidget.d_pointer->m_lastGamutImage.isNull());
+        QVERIFY(!myWidget.d_pointer->m_fillTimer.isActive());
+        const qint64 oldImageKey = myWidget.d_pointer->m_lastGamutImage.cacheKey();
+        // After a resize, the previous image is scaled provisionally…
+        myWidget.resize(QSize(350, 350));
+        myWidget.repaint();
+        QCOMPARE(myWidget.d_pointer->m_lastGamutImage.cacheKey(), oldImageKey);
+        QVERIFY(myWidget.d_pointer->m_fillTimer.isActive());
+        // … and the gamut is rendered for the new size later.
+        QTRY_VERIFY(myWidget.d_pointer->m_chromaHueImage.isImageAvailable());
+        myWidget.repaint();
+        QVERIFY(myWidget.d_pointer->m_lastGamutImage.cacheKey() != oldImageKey);
+        QCOMPARE(myWidget.d_pointer->m_lastGamutImage.width(), myWidget.maximumPhysicalSquareSize());
+        // Other changes than the geometry are rendered immediately.
+        myWidget.setCurrentColor(LchDouble {30, 10, 0});
+        myWidget.repaint();
+        QVERIFY(myWidget.d_pointer->m_chromaHueImage.isImageAvailable());
+    }
+
     void testOutOfGamutColors()
     {
         ChromaHueDiagram myWidget {m_rgbColorSpace};
@@ -206,6 +206,27 @@ private Q_SLOTS:
                  " if the value that was set is the same than before.");
     }
 
+    void testVariantCache()
+    {
+        ChromaHueImage test(colorSpace);
+        test.setImageSize(50);
+        test.setDevicePixelRatioF(1);
+        const qint64 keyOne = test.getImage().cacheKey();
+        // Simulate moving the window to a monitor with another scale factor…
+        test.setImageSize(100);
+        test.setDevicePixelRatioF(2);
+        QCOMPARE(test.getImage().size(), QSize(100, 100));
+        // … and back again.
+        test.setImageSize(50);
+        test.setDevicePixelRatioF(1);
+        QCOMPARE(test.getImage().cacheKey(), keyOne);
+        QCOMPARE(test.getImage().devicePixelRatio(), 1);
+        // Changing the lightness discards the variants.
+        test.setLightness(30);
+        QCOMPARE(test.m_variants.size(), 0);
+        QVERIFY(test.getImage().cacheKey() != keyOne);
+    }
+
     void testCornerCases()
     {
         ChromaHueImage test(colorSpace);
@@ -373,6 +373,135 @@ private Q_SLOTS:
         QVERIFY(color.c > 25);
     }
 
+    void testMouseMoveDefersGamutResolution()
+    {
+        ChromaLightnessDiagram myWidget {m_rgbColorSpace};
+        myWidget.show();
+        constexpr int size = 100;
+        myWidget.resize(size, size);
+        QTest::mouseClick(&myWidget,
+                          Qt::MouseButton::LeftButton,
+                          Qt::KeyboardModifier::NoModifier,
+                          QPoint(size * 10 / 100, size * 50 / 100));
+        const LchDouble oldColor = myWidget.currentColor();
+        QSignalSpy spy(&myWidget, &ChromaLightnessDiagram::currentColorChanged);
+        // Move far outside the gamut: The handle follows immediately, while
+        // the color property does not change yet.
+        QMouseEvent moveEvent(QEvent::MouseMove,
+                              QPointF(size * 10, size * 50 / 100),
+                              Qt::NoButton,
+                              Qt::MouseButton::LeftButton,
+                              Qt::KeyboardModifier::NoModifier);
+        QApplication::sendEvent(&myWidget, &moveEvent);
+        QVERIFY(myWidget.d_pointer->m_hasPendingColor);
+        QCOMPARE(spy.count(), 0);
+        QVERIFY(myWidget.currentColor().hasSameCoordinates(oldColor));
+        QVERIFY(myWidget.d_pointer->colorAtHandle().c > oldColor.c);
+        // After the event loop has run, the color is resolved and the
+        // signal has been emitted exactly once with an in-gamut color.
+        QTRY_COMPARE(spy.count(), 1);
+        QVERIFY(!myWidget.d_pointer->m_hasPendingColor);
+        const LchDouble resolvedColor = spy.at(0).at(0).value<LchDouble>();
+        QVERIFY(resolvedColor.hasSameCoordinates(myWidget.currentColor()));
+        QVERIFY(m_rgbColorSpace->isInGamut(resolvedColor));
+        QVERIFY(myWidget.d_pointer->colorAtHandle().hasSameCoordinates(resolvedColor));
+    }
+
+    void testMouseReleaseResolvesImmediately()
+    {
+        ChromaLightnessDiagram myWidget {m_rgbColorSpace};
+        myWidget.show();
+        constexpr int size = 100;
+        myWidget.resize(size, size);
+        QTest::mousePress(&myWidget,
+                          Qt::MouseButton::LeftButton,
+                          Qt::KeyboardModifier::NoModifier,
+                          QPoint(size * 10 / 100, size * 50 / 100));
+        QVERIFY(myWidget.d_pointer->m_hasPendingColor);
+        QTest::mouseRelease(&myWidget,
+                            Qt::MouseButton::LeftButton,
+                            Qt::KeyboardModifier::NoModifier,
+                            QPoint(size * 10 / 100, size * 50 / 100));
+        QVERIFY(!myWidget.d_pointer->m_hasPendingColor);
+        QVERIFY(m_rgbColorSpace->isInGamut(myWidget.currentColor()));
+    }
+
+    void testInputLatencyOfScriptedDrag()
+    {
+        ChromaLightnessDiagram myWidget {m_rgbColorSpace};
+        myWidget.show();
+        constexpr int size = 300;
+        myWidget.resize(size, size);
+        QVERIFY(QTest::qWaitForWindowExposed(&myWidget));
+        myWidget.resetInputLatency();
+        // Scripted drag from the left to the right border, with a paint
+        // event after each step. This works also on the offscreen platform.
+        QTest::mousePress(&myWidget,
+                          Qt::MouseButton::LeftButton,
+                          Qt::KeyboardModifier::NoModifier,
+                          QPoint(0, size / 2));
+        constexpr int stepCount = 20;
+        for (int i = 1; i <= stepCount; ++i) {
+            QMouseEvent moveEvent(QEvent::MouseMove,
+                                  QPointF(size * i / stepCount, size / 2),
+                                  Qt::NoButton,
+                                  Qt::MouseButton::LeftButton,
+                                  Qt::KeyboardModifier::NoModifier);
+            QApplication::sendEvent(&myWidget, &moveEvent);
+            myWidget.repaint();
+        }
+        QTest::mouseRelease(&myWidget,
+                            Qt::MouseButton::LeftButton,
+                            Qt::KeyboardModifier::NoModifier,
+                            QPoint(size, size / 2));
+        myWidget.repaint();
+        // Press, moves and release
+        QCOMPARE(myWidget.inputLatencySampleCount(), stepCount + 2);
+        QVERIFY(myWidget.inputLatencyPercentile(50) <= myWidget.inputLatencyPercentile(99));
+        // Latency budget in milliseconds. It is generous because test
+        // machines are often slow and busy.
+        constexpr qreal budget = 500;
+        QVERIFY(myWidget.inputLatencyPercentile(99) < budget);
+    }
+
+    void testGamutOutline()
+    {
+        ChromaLightnessDiagram myWidget {m_rgbColorSpace};
+        myWidget.setCurrentColor(LchDouble {50, 10, 250});
+        const QPainterPath outline = myWidget.d_pointer->gamutOutline();
+        QVERIFY(!outline.isEmpty());
+        // The outline spans the gray axis…
+        const QRectF bounds = outline.boundingRect();
+        QVERIFY(bounds.top() < 1);
+        QVERIFY(bounds.bottom() > 99);
+        // … in-gamut colors are within the outline…
+        QVERIFY(outline.contains(QPointF(10, 50)));
+        // … out-of-gamut colors are not.
+        QVERIFY(!m_rgbColorSpace->isInGamut(LchDouble {50, 100, 250}));
+        QVERIFY(!outline.contains(QPointF(100, 50)));
+        QCOMPARE(myWidget.d_pointer->m_gamutOutlineHue, 250.0);
+    }
+
+    void testResizeDefersGamutRendering()
+    {
+        ChromaLightnessDiagram myWidget {m_rgbColorSpace};
+        myWidget.show();
+        myWidget.resize(QSize(300, 200));
+        myWidget.repaint();
+        QVERIFY(!myWidget.d_pointer->m_lastGamutImage.isNull());
+        QVERIFY(!myWidget.d_pointer->m_fillTimer.isActive());
+        const qint64 oldImageKey = myWidget.d_pointer->m_lastGamutImage.cacheKey();
+        // After a resize, the previous image is scaled provisionally…
+        myWidget.resize(QSize(350, 250));
+        myWidget.repaint();
+        QCOMPARE(myWidget.d_pointer->m_lastGamutImage.cacheKey(), oldImageKey);
+        QVERIFY(myWidget.d_pointer->m_fillTimer.isActive());
+        // … and the gamut is rendered for the new size later.
+        QTRY_VERIFY(myWidget.d_pointer->m_chromaLightnessImage.isImageAvailable());
+        myWidget.repaint();
+        QCOMPARE(myWidget.d_pointer->m_lastGamutImage.size(), myWidget.d_pointer->calculateImageSizePhysical());
+    }
+
     void testPaintEventNormalSize()
     {
         ChromaLightnessDiagram myWidget {m_rgbColorSpace};
@@ -33,6 +33,8 @@
 
 #include "PerceptualColor/rgbcolorspacefactory.h"
 #include "helper.h"
+#include "lchvalues.h"
+#include "rgbcolorspace.h"
 
 #include <QtTest>
 
@@ -154,6 +156,32 @@ private Q_SLOTS:
                  " if the value that was set is the same than before.");
     }
 
+    void testRowConversionWithoutCache()
+    {
+        // The rows are converted in batch. Without the gamut cache, each
+        // pixel must be identical to the exact single-value conversion.
+        ChromaLightnessImage test(m_rgbColorSpace);
+        test.setGamutCacheEnabled(false);
+        test.setImageSize(QSize(40, 20));
+        test.setHue(30);
+        const QImage image = test.getImage();
+        const QColor background = m_rgbColorSpace->toQColorRgbBound(LchValues::neutralGray());
+        LchDouble lch;
+        lch.h = 30;
+        for (int y = 0; y < image.height(); ++y) {
+            lch.l = 100 - (y + 0.5) * 100.0 / image.height();
+            for (int x = 0; x < image.width(); ++x) {
+                lch.c = (x + 0.5) * 100.0 / image.height();
+                const QColor exact = m_rgbColorSpace->toQColorRgbUnbound(lch);
+                const QColor actual = image.pixelColor(x, y);
+                const QColor expected = exact.isValid() ? exact : background;
+                QVERIFY(qAbs(actual.red() - expected.red()) <= 1);
+                QVERIFY(qAbs(actual.green() - expected.green()) <= 1);
+                QVERIFY(qAbs(actual.blue() - expected.blue()) <= 1);
+            }
+        }
+    }
+
     void testSetHue_data()
     {
         QTest::addColumn<qreal>("hue");
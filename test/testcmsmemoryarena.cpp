@@ -0,0 +1,181 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "cmsmemoryarena.h"
+
+#include <QtTest>
+
+#include <cstring>
+
+#include <lcms2.h>
+#include <lcms2_plugin.h>
+
+namespace PerceptualColor
+{
+class TestCmsMemoryArena : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestCmsMemoryArena(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testConstructor()
+    {
+        CmsMemoryArena myArena;
+        QCOMPARE(myArena.allocationCount(), 0);
+        QCOMPARE(myArena.reservedBytes(), static_cast<std::size_t>(0));
+    }
+
+    void testCreateContext()
+    {
+        CmsMemoryArena myArena;
+        cmsContext myContext = myArena.createContext();
+        QVERIFY(myContext != nullptr);
+        QCOMPARE(cmsGetContextUserData(myContext), static_cast<void *>(&myArena));
+        cmsDeleteContext(myContext);
+    }
+
+    void testAllocateAndFree()
+    {
+        CmsMemoryArena myArena;
+        cmsContext myContext = myArena.createContext();
+        const int countBefore = myArena.allocationCount();
+        void *memory = _cmsMalloc(myContext, 100);
+        QVERIFY(memory != nullptr);
+        QCOMPARE(myArena.allocationCount(), countBefore + 1);
+        std::memset(memory, 1, 100);
+        _cmsFree(myContext, memory);
+        // An allocation of the same size should reuse the freed memory.
+        void *memory2 = _cmsMalloc(myContext, 100);
+        QCOMPARE(memory2, memory);
+        _cmsFree(myContext, memory2);
+        cmsDeleteContext(myContext);
+    }
+
+    void testAlignment()
+    {
+        CmsMemoryArena myArena;
+        cmsContext myContext = myArena.createContext();
+        for (cmsUInt32Number size = 1; size < 100; ++size) {
+            void *memory = _cmsMalloc(myContext, size);
+            QVERIFY(reinterpret_cast<quintptr>(memory) % alignof(std::max_align_t) == 0);
+        }
+        cmsDeleteContext(myContext);
+    }
+
+    void testRealloc()
+    {
+        CmsMemoryArena myArena;
+        cmsContext myContext = myArena.createContext();
+        char *memory = static_cast<char *>(_cmsMalloc(myContext, 10));
+        for (int i = 0; i < 10; ++i) {
+            memory[i] = static_cast<char>(i);
+        }
+        memory = static_cast<char *>(_cmsRealloc(myContext, memory, 1000));
+        QVERIFY(memory != nullptr);
+        for (int i = 0; i < 10; ++i) {
+            QCOMPARE(memory[i], static_cast<char>(i));
+        }
+        _cmsFree(myContext, memory);
+        cmsDeleteContext(myContext);
+    }
+
+    void testBigAllocation()
+    {
+        CmsMemoryArena myArena;
+        cmsContext myContext = myArena.createContext();
+        const cmsUInt32Number size = CmsMemoryArena::blockSize * 2;
+        char *memory = static_cast<char *>(_cmsMalloc(myContext, size));
+        QVERIFY(memory != nullptr);
+        std::memset(memory, 1, size);
+        QVERIFY(myArena.reservedBytes() >= size);
+        _cmsFree(myContext, memory);
+        cmsDeleteContext(myContext);
+    }
+
+    void testTransform()
+    {
+        // A complete life cycle of LittleCMS objects within the context.
+        CmsMemoryArena myArena;
+        cmsContext myContext = myArena.createContext();
+        cmsHPROFILE labProfileHandle = cmsCreateLab4ProfileTHR(myContext, nullptr);
+        cmsHPROFILE rgbProfileHandle = cmsCreate_sRGBProfileTHR(myContext);
+        cmsHTRANSFORM myTransform = cmsCreateTransformTHR( //
+            myContext,
+            rgbProfileHandle,
+            TYPE_RGB_DBL,
+            labProfileHandle,
+            TYPE_Lab_DBL,
+            INTENT_ABSOLUTE_COLORIMETRIC,
+            cmsFLAGS_NOCACHE);
+        cmsCloseProfile(labProfileHandle);
+        cmsCloseProfile(rgbProfileHandle);
+        QVERIFY(myTransform != nullptr);
+        QVERIFY(myArena.allocationCount() > 0);
+        const cmsFloat64Number rgb[3] = {1, 1, 1};
+        cmsCIELab lab;
+        cmsDoTransform(myTransform, rgb, &lab, 1);
+        QVERIFY(lab.L > 99);
+        cmsDeleteTransform(myTransform);
+        cmsDeleteContext(myContext);
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestCmsMemoryArena)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testcmsmemoryarena.moc"
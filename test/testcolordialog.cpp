@@ -35,6 +35,7 @@
 
 #include <QPointer>
 #include <QScopedPointer>
+#include <QTimer>
 #include <QtTest>
 
 #include "PerceptualColor/multispinbox.h"
@@ -1035,6 +1036,65 @@ private Q_SLOTS:
         QCOMPARE(myDialog->d_pointer->m_currentOpaqueColor.toLch().l, 60);
     }
 
+    void testDisplayColorSpace()
+    {
+        QScopedPointer<ColorDialog> myDialog(new PerceptualColor::ColorDialog(m_srgbBuildinColorSpace));
+        QVERIFY(myDialog->displayColorSpace().isNull());
+        const QSharedPointer<RgbColorSpace> display = RgbColorSpace::createSrgb();
+        myDialog->setDisplayColorSpace(display);
+        QCOMPARE(myDialog->displayColorSpace(), display);
+        // Forwarded to the diagrams and to the color patch
+        QCOMPARE(myDialog->d_pointer->m_chromaHueDiagram->displayColorSpace(), display);
+        QCOMPARE(myDialog->d_pointer->m_wheelColorPicker->displayColorSpace(), display);
+        QCOMPARE(myDialog->d_pointer->m_colorPatch->displayColorSpace(), display);
+        myDialog->setDisplayColorSpace(nullptr);
+        QVERIFY(myDialog->displayColorSpace().isNull());
+        QVERIFY(myDialog->d_pointer->m_colorPatch->displayColorSpace().isNull());
+    }
+
+    void testLightnessDrag()
+    {
+        QScopedPointer<ColorDialog> myDialog(new PerceptualColor::ColorDialog(m_srgbBuildinColorSpace));
+        myDialog->show();
+        const LchDouble startColor {50, 60, 30};
+        myDialog->setCurrentColor(m_srgbBuildinColorSpace->toQColorRgbBound(startColor));
+        const LchDouble dialogStartColor = myDialog->d_pointer->m_currentOpaqueColor.toLch();
+        GradientSlider *slider = myDialog->d_pointer->m_lchLightnessSelector;
+        QVector<qreal> sliderValues;
+        connect(slider, &GradientSlider::valueChanged, this, [&sliderValues](qreal value) {
+            sliderValues.append(value);
+        });
+        QTest::mousePress(slider, Qt::MouseButton::LeftButton);
+        QVERIFY(myDialog->d_pointer->m_isLightnessDragActive);
+        // Intermediate steps of the drag: First to a lightness where the
+        // chroma must be reduced, and then back to lightnesses where the
+        // original chroma would fit again.
+        slider->setValue(0.95);
+        slider->setValue(0.8);
+        slider->setValue(0.7);
+        QTest::mouseRelease(slider, Qt::MouseButton::LeftButton);
+        QTRY_VERIFY(!myDialog->d_pointer->m_isLightnessDragActive);
+        QVERIFY(sliderValues.count() >= 4);
+
+        // Baseline: The exact search for each single step, each starting
+        // from the result of the previous step (like without a drag).
+        LchDouble expected = dialogStartColor;
+        for (const qreal value : qAsConst(sliderValues)) {
+            expected.l = value * 100;
+            expected = m_srgbBuildinColorSpace->nearestInGamutColorByAdjustingChroma(expected);
+        }
+        // The release needs only two exact searches. The step that
+        // limits the chroma has been chosen with the coarse precision.
+        const LchDouble result = myDialog->d_pointer->m_currentOpaqueColor.toLch();
+        QCOMPARE(result.l, expected.l);
+        QCOMPARE(result.h, expected.h);
+        QVERIFY(qAbs(result.c - expected.c) <= interactiveGamutPrecision);
+        QVERIFY(m_srgbBuildinColorSpace->isInGamut(result));
+        // The chroma has been reduced by the step at 95 % lightness and
+        // is not restored afterwards.
+        QVERIFY(result.c < dialogStartColor.c);
+    }
+
     void testReadHlcNumericValues()
     {
         QScopedPointer<ColorDialog> myDialog(new PerceptualColor::ColorDialog(m_srgbBuildinColorSpace));
@@ -1465,6 +1525,149 @@ private Q_SLOTS:
         mySnippets.testSnippet05();
     }
 
+    void testGetColorReusesPooledDialog()
+    {
+        PerceptualColor::ColorDialog::clearDialogPool();
+        auto &pool = PerceptualColor::ColorDialog::ColorDialogPrivate::dialogPool();
+        QPointer<PerceptualColor::ColorDialog> firstDialog;
+        QTimer::singleShot(0, this, [&firstDialog]() {
+            firstDialog = qobject_cast<PerceptualColor::ColorDialog *>( //
+                QApplication::activeModalWidget());
+            if (!firstDialog.isNull()) {
+                firstDialog->accept();
+            }
+        });
+        QColor result = PerceptualColor::ColorDialog::getColor( //
+            m_srgbBuildinColorSpace,
+            Qt::red,
+            nullptr,
+            QStringLiteral("Custom title"));
+        QVERIFY(!firstDialog.isNull());
+        QCOMPARE(result.name(), QColor(Qt::red).name());
+        QCOMPARE(pool.count(), 1);
+        QVERIFY(!firstDialog->isVisible());
+        QCOMPARE(firstDialog->windowTitle(), QStringLiteral("Custom title"));
+
+        // Change the state of the pooled dialog. The next call of
+        // getColor() has to reset it.
+        firstDialog->d_pointer->m_tabWidget->setCurrentIndex(1);
+        QPointer<PerceptualColor::ColorDialog> secondDialog;
+        QString secondTitle;
+        int secondTabIndex = -1;
+        QTimer::singleShot(0, this, [&]() {
+            secondDialog = qobject_cast<PerceptualColor::ColorDialog *>( //
+                QApplication::activeModalWidget());
+            if (!secondDialog.isNull()) {
+                secondTitle = secondDialog->windowTitle();
+                secondTabIndex = //
+                    secondDialog->d_pointer->m_tabWidget->currentIndex();
+                secondDialog->accept();
+            }
+        });
+        result = PerceptualColor::ColorDialog::getColor( //
+            m_srgbBuildinColorSpace,
+            Qt::blue);
+        QCOMPARE(secondDialog.data(), firstDialog.data());
+        QCOMPARE(result.name(), QColor(Qt::blue).name());
+        QCOMPARE(secondTitle, QColorDialog::tr("Select Color"));
+        QCOMPARE(secondTabIndex, 0);
+        QCOMPARE(pool.count(), 1);
+
+        // Other options need another dialog.
+        QPointer<PerceptualColor::ColorDialog> thirdDialog;
+        QTimer::singleShot(0, this, [&thirdDialog]() {
+            thirdDialog = qobject_cast<PerceptualColor::ColorDialog *>( //
+                QApplication::activeModalWidget());
+            if (!thirdDialog.isNull()) {
+                thirdDialog->reject();
+            }
+        });
+        result = PerceptualColor::ColorDialog::getColor( //
+            m_srgbBuildinColorSpace,
+            Qt::blue,
+            nullptr,
+            QString(),
+            QColorDialog::ColorDialogOption::ShowAlphaChannel);
+        QVERIFY(!thirdDialog.isNull());
+        QVERIFY(thirdDialog.data() != firstDialog.data());
+        QVERIFY(!result.isValid());
+        QCOMPARE(pool.count(), 2);
+
+        PerceptualColor::ColorDialog::clearDialogPool();
+        QCOMPARE(pool.count(), 0);
+        QVERIFY(firstDialog.isNull());
+        QVERIFY(thirdDialog.isNull());
+    }
+
+    void testGetColorPoolIsBounded()
+    {
+        PerceptualColor::ColorDialog::clearDialogPool();
+        auto &pool = PerceptualColor::ColorDialog::ColorDialogPrivate::dialogPool();
+        const QList<QColorDialog::ColorDialogOptions> optionsList = {
+            QColorDialog::ColorDialogOptions(),
+            QColorDialog::ColorDialogOption::ShowAlphaChannel,
+            QColorDialog::ColorDialogOption::NoButtons,
+            QColorDialog::ColorDialogOption::ShowAlphaChannel //
+                | QColorDialog::ColorDialogOption::NoButtons};
+        QList<QPointer<PerceptualColor::ColorDialog>> dialogs;
+        for (const auto &options : optionsList) {
+            QTimer::singleShot(0, this, [&dialogs]() {
+                QPointer<PerceptualColor::ColorDialog> dialog = //
+                    qobject_cast<PerceptualColor::ColorDialog *>( //
+                        QApplication::activeModalWidget());
+                dialogs.append(dialog);
+                if (!dialog.isNull()) {
+                    dialog->reject();
+                }
+            });
+            PerceptualColor::ColorDialog::getColor( //
+                m_srgbBuildinColorSpace,
+                Qt::red,
+                nullptr,
+                QString(),
+                options);
+        }
+        const int capacity = //
+            PerceptualColor::ColorDialog::ColorDialogPrivate::dialogPoolCapacity;
+        QVERIFY(optionsList.count() > capacity);
+        QCOMPARE(dialogs.count(), optionsList.count());
+        QCOMPARE(pool.count(), capacity);
+        // The least recently used dialog has been deleted.
+        QVERIFY(dialogs.at(0).isNull());
+        for (int i = 1; i < dialogs.count(); ++i) {
+            QVERIFY(!dialogs.at(i).isNull());
+        }
+        // The most recently used dialog is at the front of the pool.
+        QCOMPARE(pool.first().second.data(), dialogs.last().data());
+
+        PerceptualColor::ColorDialog::clearDialogPool();
+        QCOMPARE(pool.count(), 0);
+    }
+
+    void testGetColorPooledDialogSurvivesParent()
+    {
+        PerceptualColor::ColorDialog::clearDialogPool();
+        QScopedPointer<QWidget> parentWidget(new QWidget);
+        QPointer<PerceptualColor::ColorDialog> dialog;
+        QTimer::singleShot(0, this, [&dialog]() {
+            dialog = qobject_cast<PerceptualColor::ColorDialog *>( //
+                QApplication::activeModalWidget());
+            if (!dialog.isNull()) {
+                dialog->accept();
+            }
+        });
+        PerceptualColor::ColorDialog::getColor( //
+            m_srgbBuildinColorSpace,
+            Qt::red,
+            parentWidget.data());
+        QVERIFY(!dialog.isNull());
+        QCOMPARE(dialog->parentWidget(), nullptr);
+        parentWidget.reset();
+        QVERIFY(!dialog.isNull());
+        PerceptualColor::ColorDialog::clearDialogPool();
+        QVERIFY(dialog.isNull());
+    }
+
     void benchmarkCreateAndShowPerceptualDialog()
     {
         m_perceptualDialog.reset(nullptr);
@@ -35,6 +35,15 @@
 
 #include <QtTest>
 
+#include "displaytransform.h"
+#include "rgbcolorspace.h"
+#include "rgbdouble.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <lcms2.h>
+
 static void snippet01()
 {
     //! [ColorPatch Create widget]
@@ -203,6 +212,85 @@ private Q_SLOTS:
         QCOMPARE(m_color, QColor());
     }
 
+    void testColorVisionDeficiency()
+    {
+        PerceptualColor::ColorPatch thePatch;
+        thePatch.setColor(Qt::red);
+        QSignalSpy spy(&thePatch, &PerceptualColor::ColorPatch::colorVisionDeficiencyChanged);
+        thePatch.setColorVisionDeficiency(PerceptualColor::AbstractDiagram::ColorVisionDeficiency::protanopia);
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(thePatch.colorVisionDeficiency(), //
+                 PerceptualColor::AbstractDiagram::ColorVisionDeficiency::protanopia);
+        // The simulation affects only the rendering, not the property value.
+        QCOMPARE(thePatch.color(), QColor(Qt::red));
+        // Painting with a simulation does not crash.
+        thePatch.show();
+        thePatch.repaint();
+    }
+
+    void testColorVisionDeficiencyInWorkingColorSpace()
+    {
+        // The simulation uses the color space that has been passed
+        // to the constructor. Without, it falls back to sRGB.
+        const QSharedPointer<PerceptualColor::RgbColorSpace> colorSpace = //
+            PerceptualColor::RgbColorSpace::createSrgb();
+        PerceptualColor::ColorPatch thePatch(colorSpace);
+        QCOMPARE(thePatch.d_pointer->m_rgbColorSpace, colorSpace);
+        PerceptualColor::ColorPatch defaultPatch;
+        QVERIFY(defaultPatch.d_pointer->m_rgbColorSpace.isNull());
+        defaultPatch.setColor(Qt::red);
+        defaultPatch.setColorVisionDeficiency(PerceptualColor::AbstractDiagram::ColorVisionDeficiency::protanopia);
+        defaultPatch.show();
+        defaultPatch.repaint();
+        QVERIFY(!defaultPatch.d_pointer->m_rgbColorSpace.isNull());
+    }
+
+    void testDisplayColorSpace()
+    {
+        // A display color space with Rec. 2020 primaries
+        QTemporaryDir temporaryDir;
+        QVERIFY(temporaryDir.isValid());
+        cmsCIExyY whitePoint;
+        cmsWhitePointFromTemp(&whitePoint, 6504);
+        const cmsCIExyYTRIPLE primaries {{0.708, 0.292, 1}, // red
+                                         {0.170, 0.797, 1}, // green
+                                         {0.131, 0.046, 1}}; // blue
+        cmsToneCurve *gamma = cmsBuildGamma(nullptr, 2.2);
+        cmsToneCurve *curves[3] {gamma, gamma, gamma};
+        cmsHPROFILE profile = cmsCreateRGBProfile(&whitePoint, &primaries, curves);
+        cmsFreeToneCurve(gamma);
+        const QString fileName = temporaryDir.filePath(QStringLiteral("widegamut.icc"));
+        cmsSaveProfileToFile(profile, QFile::encodeName(fileName).constData());
+        cmsCloseProfile(profile);
+        const QSharedPointer<RgbColorSpace> display = RgbColorSpace::createFromFile(fileName);
+        QVERIFY(!display.isNull());
+
+        const QSharedPointer<RgbColorSpace> working = RgbColorSpace::createSrgb();
+        ColorPatch thePatch(working);
+        QVERIFY(thePatch.displayColorSpace().isNull());
+        QSignalSpy spy(&thePatch, &ColorPatch::displayColorSpaceChanged);
+        thePatch.setDisplayColorSpace(display);
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(thePatch.displayColorSpace(), display);
+        // Setting the same value again does not emit a signal.
+        thePatch.setDisplayColorSpace(display);
+        QCOMPARE(spy.count(), 1);
+
+        // The working-space color is converted to the display color space.
+        thePatch.setColor(Qt::red);
+        thePatch.resize(40, 40);
+        const QImage image = thePatch.grab().toImage();
+        const RgbDouble workingRed {1, 0, 0};
+        QRgb expected = qRgb(0, 0, 0);
+        DisplayTransform::create(working, display)->toDisplayQRgb(&workingRed, &expected, 1);
+        QVERIFY(expected != qRgb(255, 0, 0));
+        QCOMPARE(image.pixel(image.width() / 2, image.height() / 2), expected);
+
+        thePatch.setDisplayColorSpace(nullptr);
+        QCOMPARE(spy.count(), 2);
+        QVERIFY(thePatch.d_pointer->m_displayTransform.isNull());
+    }
+
     void testVerySmallWidgetSizes()
     {
         // Also very small widget sizes should not crash the widget.
@@ -0,0 +1,234 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "colorquantizer.h"
+
+#include <QtTest>
+
+#include "rgbcolorspace.h"
+
+static QList<PerceptualColor::LchDouble> snippet01()
+{
+    //! [Use ColorQuantizer]
+    QImage image(100, 100, QImage::Format_ARGB32);
+    image.fill(Qt::darkCyan);
+    QSharedPointer<PerceptualColor::RgbColorSpace> colorSpace = PerceptualColor::RgbColorSpace::createSrgb();
+    // Get (up to) 8 representative colors:
+    QList<PerceptualColor::LchDouble> palette = PerceptualColor::ColorQuantizer::quantize(image, colorSpace, 8);
+    //! [Use ColorQuantizer]
+    return palette;
+}
+
+namespace PerceptualColor
+{
+class TestColorQuantizer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestColorQuantizer(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    QSharedPointer<RgbColorSpace> m_colorSpace;
+
+    /** @brief Image with two colors: red on 3/4 of the surface,
+     * blue on 1/4 of the surface. */
+    static QImage twoColorImage()
+    {
+        QImage image(200, 200, QImage::Format_ARGB32);
+        image.fill(QColor(Qt::red));
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width() / 4; ++x) {
+                image.setPixelColor(x, y, QColor(Qt::blue));
+            }
+        }
+        return image;
+    }
+
+    static bool isNear(const LchDouble &first, const LchDouble &second)
+    {
+        return (qAbs(first.l - second.l) < 1) //
+            && (qAbs(first.c - second.c) < 1) //
+            && (qAbs(first.h - second.h) < 1);
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+        m_colorSpace = RgbColorSpace::createSrgb();
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testInvalidInput()
+    {
+        QCOMPARE(ColorQuantizer::quantize(QImage(), m_colorSpace, 5).count(), 0);
+        QCOMPARE(ColorQuantizer::quantize(twoColorImage(), QSharedPointer<RgbColorSpace>(), 5).count(), 0);
+        QCOMPARE(ColorQuantizer::quantize(twoColorImage(), m_colorSpace, 0).count(), 0);
+        QCOMPARE(ColorQuantizer::quantize(twoColorImage(), m_colorSpace, -1).count(), 0);
+    }
+
+    void testTwoColors()
+    {
+        const QList<LchDouble> palette = ColorQuantizer::quantize(twoColorImage(), m_colorSpace, 2);
+        QCOMPARE(palette.count(), 2);
+        // The most frequent color comes first.
+        QVERIFY(isNear(palette.at(0), m_colorSpace->toLch(QColor(Qt::red))));
+        QVERIFY(isNear(palette.at(1), m_colorSpace->toLch(QColor(Qt::blue))));
+    }
+
+    void testLessColorsThanRequested()
+    {
+        const QList<LchDouble> palette = ColorQuantizer::quantize(twoColorImage(), m_colorSpace, 16);
+        QCOMPARE(palette.count(), 2);
+    }
+
+    void testSingleColor()
+    {
+        const QList<LchDouble> palette = ColorQuantizer::quantize(twoColorImage(), m_colorSpace, 1);
+        QCOMPARE(palette.count(), 1);
+    }
+
+    void testTransparentPixelsAreIgnored()
+    {
+        QImage image(100, 100, QImage::Format_ARGB32);
+        image.fill(Qt::transparent);
+        QCOMPARE(ColorQuantizer::quantize(image, m_colorSpace, 4).count(), 0);
+        image.setPixelColor(50, 50, QColor(Qt::green));
+        const QList<LchDouble> palette = ColorQuantizer::quantize(image, m_colorSpace, 4);
+        QCOMPARE(palette.count(), 1);
+        QVERIFY(isNear(palette.at(0), m_colorSpace->toLch(QColor(Qt::green))));
+    }
+
+    void testResultIsInGamut()
+    {
+        QImage image(256, 256, QImage::Format_RGB32);
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width(); ++x) {
+                image.setPixel(x, y, qRgb(x, y, 255 - x));
+            }
+        }
+        const QList<LchDouble> palette = ColorQuantizer::quantize(image, m_colorSpace, 12);
+        QCOMPARE(palette.count(), 12);
+        for (const LchDouble &color : palette) {
+            QVERIFY(m_colorSpace->isInGamut(color));
+        }
+    }
+
+    void testParallelForCoversAllItems()
+    {
+        const int count = 100000;
+        std::vector<int> visited(count, 0);
+        ColorQuantizer::parallelFor(count, 1000, [&visited](int, int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                ++visited[static_cast<std::size_t>(i)];
+            }
+        });
+        for (const int value : visited) {
+            QCOMPARE(value, 1);
+        }
+    }
+
+    void testMedianCut()
+    {
+        ColorQuantizer::Samples samples;
+        const double lightness[] = {10, 11, 90, 91};
+        samples.lab.resize(4);
+        for (int i = 0; i < 4; ++i) {
+            samples.lab.l()[i] = lightness[i];
+        }
+        samples.weight = {1, 1, 1, 1};
+        const std::vector<int> assignment = ColorQuantizer::medianCut(samples, 2);
+        QCOMPARE(static_cast<int>(assignment.size()), 4);
+        QCOMPARE(assignment.at(0), assignment.at(1));
+        QCOMPARE(assignment.at(2), assignment.at(3));
+        QVERIFY(assignment.at(0) != assignment.at(2));
+    }
+
+    void testSnippet01()
+    {
+        const QList<LchDouble> palette = snippet01();
+        QCOMPARE(palette.count(), 1);
+    }
+
+    void benchmarkQuantize()
+    {
+        QImage image(1000, 1000, QImage::Format_RGB32);
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width(); ++x) {
+                image.setPixel(x, y, qRgb(x % 256, y % 256, (x + y) % 256));
+            }
+        }
+        QBENCHMARK {
+            ColorQuantizer::quantize(image, m_colorSpace, 16);
+        }
+    }
+
+    void benchmarkQuantize12Megapixel()
+    {
+        // A photo-sized image with many distinct colors, so that the
+        // k-means assignment step dominates.
+        QImage image(4000, 3000, QImage::Format_RGB32);
+        for (int y = 0; y < image.height(); ++y) {
+            QRgb *const line = reinterpret_cast<QRgb *>(image.scanLine(y));
+            for (int x = 0; x < image.width(); ++x) {
+                line[x] = qRgb(x % 256, y % 256, (x / 256 + y / 256 * 16) % 256);
+            }
+        }
+        QBENCHMARK {
+            ColorQuantizer::quantize(image, m_colorSpace, 16);
+        }
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestColorQuantizer)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testcolorquantizer.moc"
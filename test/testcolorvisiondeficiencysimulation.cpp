@@ -0,0 +1,319 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "colorvisiondeficiencysimulation.h"
+
+#include <QtMath>
+#include <QtTest>
+
+#include "labbuffer.h"
+#include "rgbcolorspace.h"
+#include "rgbdouble.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <lcms2.h>
+
+static QColor snippet01()
+{
+    //! [Use ColorVisionDeficiencySimulation]
+    const QSharedPointer<PerceptualColor::RgbColorSpace> colorSpace = //
+        PerceptualColor::RgbColorSpace::createSrgb();
+    const QColor original(255, 0, 0);
+    // How is pure red perceived by people with protanopia?
+    const QColor simulated = PerceptualColor::ColorVisionDeficiencySimulation::simulate( //
+        PerceptualColor::AbstractDiagram::ColorVisionDeficiency::protanopia,
+        *colorSpace,
+        original);
+    //! [Use ColorVisionDeficiencySimulation]
+    return simulated;
+}
+
+namespace PerceptualColor
+{
+class TestColorVisionDeficiencySimulation : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestColorVisionDeficiencySimulation(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    /** @brief Euclidean distance of two colors in 8-bit RGB */
+    static double distance(const QColor &first, const QColor &second)
+    {
+        return qSqrt(qPow(first.red() - second.red(), 2) //
+                     + qPow(first.green() - second.green(), 2) //
+                     + qPow(first.blue() - second.blue(), 2));
+    }
+
+    /** @brief The sRGB color space, shared by the tests */
+    static const RgbColorSpace &srgb()
+    {
+        static const QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpace::createSrgb();
+        return *colorSpace;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testNoneIsIdentity()
+    {
+        const QColor color(12, 200, 99, 150);
+        QCOMPARE(ColorVisionDeficiencySimulation::simulate(AbstractDiagram::ColorVisionDeficiency::none, srgb(), color), color);
+    }
+
+    void testInvalidColor()
+    {
+        const QColor result = ColorVisionDeficiencySimulation::simulate( //
+            AbstractDiagram::ColorVisionDeficiency::protanopia,
+            srgb(),
+            QColor());
+        QVERIFY(!result.isValid());
+    }
+
+    void testGrayStaysGray_data()
+    {
+        QTest::addColumn<AbstractDiagram::ColorVisionDeficiency>("deficiency");
+        QTest::newRow("protanopia") << AbstractDiagram::ColorVisionDeficiency::protanopia;
+        QTest::newRow("deuteranopia") << AbstractDiagram::ColorVisionDeficiency::deuteranopia;
+        QTest::newRow("tritanopia") << AbstractDiagram::ColorVisionDeficiency::tritanopia;
+    }
+
+    void testGrayStaysGray()
+    {
+        QFETCH(AbstractDiagram::ColorVisionDeficiency, deficiency);
+        for (int i = 0; i < 256; i += 15) {
+            const QColor gray(i, i, i);
+            QVERIFY(distance(ColorVisionDeficiencySimulation::simulate(deficiency, srgb(), gray), gray) <= 2);
+        }
+    }
+
+    void testAlphaIsPreserved()
+    {
+        const QColor color(200, 30, 40, 77);
+        const QColor result = ColorVisionDeficiencySimulation::simulate( //
+            AbstractDiagram::ColorVisionDeficiency::deuteranopia,
+            srgb(),
+            color);
+        QCOMPARE(result.alpha(), 77);
+    }
+
+    void testRedGreenConfusion()
+    {
+        const QColor red(200, 60, 40);
+        const QColor green(90, 150, 40);
+        const double originalDistance = distance(red, green);
+        const double protanopiaDistance = distance( //
+            ColorVisionDeficiencySimulation::simulate(AbstractDiagram::ColorVisionDeficiency::protanopia, srgb(), red),
+            ColorVisionDeficiencySimulation::simulate(AbstractDiagram::ColorVisionDeficiency::protanopia, srgb(), green));
+        const double deuteranopiaDistance = distance( //
+            ColorVisionDeficiencySimulation::simulate(AbstractDiagram::ColorVisionDeficiency::deuteranopia, srgb(), red),
+            ColorVisionDeficiencySimulation::simulate(AbstractDiagram::ColorVisionDeficiency::deuteranopia, srgb(), green));
+        QVERIFY(protanopiaDistance < originalDistance);
+        QVERIFY(deuteranopiaDistance < originalDistance);
+    }
+
+    void testMatchesReference_data()
+    {
+        testGrayStaysGray_data();
+    }
+
+    void testMatchesReference()
+    {
+        // For sRGB, the table-based simulation gives the same result as
+        // the analytic sRGB transfer functions.
+        QFETCH(AbstractDiagram::ColorVisionDeficiency, deficiency);
+        const auto decode = [](double value) {
+            return (value <= 0.04045) ? value / 12.92 : qPow((value + 0.055) / 1.055, 2.4);
+        };
+        const auto encode = [](double value) {
+            value = qBound<double>(0, value, 1);
+            const double result = (value <= 0.0031308) ? value * 12.92 : 1.055 * qPow(value, 1 / 2.4) - 0.055;
+            return qRound(result * 255);
+        };
+        const ColorVisionDeficiencySimulation::Matrix &m = ColorVisionDeficiencySimulation::matrix(deficiency);
+        const QVector<QColor> colors {QColor(200, 60, 40), //
+                                      QColor(90, 150, 40),
+                                      QColor(20, 30, 240),
+                                      QColor(3, 2, 1),
+                                      QColor(255, 255, 255)};
+        QVector<QRgb> rgb;
+        for (const QColor &color : colors) {
+            rgb.append(color.rgb());
+        }
+        ColorVisionDeficiencySimulation::simulate(deficiency, srgb(), rgb.data(), rgb.count());
+        for (int i = 0; i < colors.count(); ++i) {
+            const double red = decode(colors.at(i).redF());
+            const double green = decode(colors.at(i).greenF());
+            const double blue = decode(colors.at(i).blueF());
+            const QColor expected(encode(m[0] * red + m[1] * green + m[2] * blue),
+                                  encode(m[3] * red + m[4] * green + m[5] * blue),
+                                  encode(m[6] * red + m[7] * green + m[8] * blue));
+            QVERIFY(distance(QColor(rgb.at(i)), expected) <= 2);
+            // The single-color function uses the same path.
+            QCOMPARE(ColorVisionDeficiencySimulation::simulate(deficiency, srgb(), colors.at(i)), //
+                     QColor(rgb.at(i)));
+        }
+    }
+
+    void testUsesWorkingColorSpace()
+    {
+        // A profile with a linear tone curve: The simulation matrix is
+        // applied directly on the 8-bit values, without the sRGB
+        // transfer functions.
+        QTemporaryDir temporaryDir;
+        QVERIFY(temporaryDir.isValid());
+        cmsCIExyY whitePoint;
+        cmsWhitePointFromTemp(&whitePoint, 6504);
+        const cmsCIExyYTRIPLE primaries {{0.64, 0.33, 1}, // red
+                                         {0.30, 0.60, 1}, // green
+                                         {0.15, 0.06, 1}}; // blue
+        cmsToneCurve *gamma = cmsBuildGamma(nullptr, 1.0);
+        cmsToneCurve *curves[3] {gamma, gamma, gamma};
+        cmsHPROFILE profile = cmsCreateRGBProfile(&whitePoint, &primaries, curves);
+        cmsFreeToneCurve(gamma);
+        const QString fileName = temporaryDir.filePath(QStringLiteral("linear.icc"));
+        cmsSaveProfileToFile(profile, QFile::encodeName(fileName).constData());
+        cmsCloseProfile(profile);
+        QSharedPointer<RgbColorSpace> linear = RgbColorSpace::createFromFile(fileName);
+        QVERIFY(!linear.isNull());
+        const ColorVisionDeficiencySimulation::Matrix &m = //
+            ColorVisionDeficiencySimulation::matrix(AbstractDiagram::ColorVisionDeficiency::protanopia);
+        const QColor color(200, 60, 40);
+        const auto expectedChannel = [](double value) {
+            return qBound(0, qRound(value), 255);
+        };
+        const QColor expected(expectedChannel(m[0] * 200 + m[1] * 60 + m[2] * 40),
+                              expectedChannel(m[3] * 200 + m[4] * 60 + m[5] * 40),
+                              expectedChannel(m[6] * 200 + m[7] * 60 + m[8] * 40));
+        const QColor actual = ColorVisionDeficiencySimulation::simulate( //
+            AbstractDiagram::ColorVisionDeficiency::protanopia,
+            *linear,
+            color);
+        QVERIFY(distance(actual, expected) <= 1);
+        // The result differs from the sRGB interpretation of the same
+        // 8-bit values.
+        const QColor srgbResult = ColorVisionDeficiencySimulation::simulate( //
+            AbstractDiagram::ColorVisionDeficiency::protanopia,
+            srgb(),
+            color);
+        QVERIFY(distance(actual, srgbResult) > 2);
+    }
+
+    void testSimulateRow()
+    {
+        LabBuffer lab(3);
+        lab.set(0, cmsCIELab {50, 40, 30});
+        lab.set(1, cmsCIELab {50, 0, 0});
+        lab.set(2, cmsCIELab {60, -40, 30});
+        QVector<QRgb> original(lab.count());
+        srgb().toQRgbUnbound(lab.view(), original.data());
+        // The second color is marked as out-of-gamut.
+        original[1] = 0;
+        QVector<RgbDouble> workingRgb(lab.count());
+
+        // No simulation: Nothing changes.
+        QVector<QRgb> rgb = original;
+        ColorVisionDeficiencySimulation::simulateRow(AbstractDiagram::ColorVisionDeficiency::none, //
+                                                     srgb(),
+                                                     nullptr,
+                                                     rgb.data(),
+                                                     workingRgb.data(),
+                                                     rgb.count());
+        QCOMPARE(rgb, original);
+
+        rgb = original;
+        ColorVisionDeficiencySimulation::simulateRow(AbstractDiagram::ColorVisionDeficiency::protanopia, //
+                                                     srgb(),
+                                                     nullptr,
+                                                     rgb.data(),
+                                                     workingRgb.data(),
+                                                     rgb.count());
+        QCOMPARE(rgb.at(1), static_cast<QRgb>(0));
+        for (int i : {0, 2}) {
+            const QColor expected = ColorVisionDeficiencySimulation::simulate( //
+                AbstractDiagram::ColorVisionDeficiency::protanopia,
+                srgb(),
+                QColor(original.at(i)));
+            QCOMPARE(qAlpha(rgb.at(i)), 255);
+            QCOMPARE(QColor(rgb.at(i)), expected);
+        }
+    }
+
+    void testSnippet01()
+    {
+        const QColor simulated = snippet01();
+        QVERIFY(simulated.isValid());
+        QVERIFY(simulated != QColor(255, 0, 0));
+    }
+
+    void benchmarkSimulate()
+    {
+        QBENCHMARK {
+            for (int i = 0; i < 256; ++i) {
+                ColorVisionDeficiencySimulation::simulate( //
+                    AbstractDiagram::ColorVisionDeficiency::protanopia,
+                    srgb(),
+                    QColor(i, 255 - i, i / 2));
+            }
+        }
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestColorVisionDeficiencySimulation)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testcolorvisiondeficiencysimulation.moc"
@@ -172,6 +172,37 @@ private Q_SLOTS:
         QVERIFY2(myColorWheel.d_pointer->innerDiameter() < myColorWheel.size().height(), "innerDiameter() is smaller than the widget’s height.");
     }
 
+    void testAnnulusRegion()
+    {
+        ColorWheel myColorWheel(m_rgbColorSpace);
+        myColorWheel.resize(300, 300);
+        const QRegion annulus = myColorWheel.d_pointer->annulusRegion();
+        const qreal center = myColorWheel.maximumWidgetSquareSize() / 2.0;
+        // The center of the wheel is not painted.
+        QVERIFY(!annulus.contains(QPoint(qRound(center), qRound(center))));
+        // The wheel ribbon is painted.
+        const int ribbonX = qRound(myColorWheel.d_pointer->border() + myColorWheel.gradientThickness() / 2.0);
+        QVERIFY(annulus.contains(QPoint(ribbonX, qRound(center))));
+        // The inner border of the ribbon is painted (anti-aliasing).
+        const int innerBorderX = qRound(center - myColorWheel.d_pointer->innerDiameter() / 2.0);
+        QVERIFY(annulus.contains(QPoint(innerBorderX, qRound(center))));
+        // The corners are painted (focus indicator).
+        QVERIFY(annulus.contains(QPoint(0, 0)));
+    }
+
+    void testPaintBufferIsReused()
+    {
+        ColorWheel myColorWheel(m_rgbColorSpace);
+        myColorWheel.resize(300, 300);
+        // Render the widget (this calls paintEvent()):
+        myColorWheel.grab();
+        QVERIFY(!myColorWheel.d_pointer->m_paintBuffer.isNull());
+        const uchar *bits = myColorWheel.d_pointer->m_paintBuffer.constBits();
+        myColorWheel.grab();
+        // The buffer has not been reallocated:
+        QCOMPARE(myColorWheel.d_pointer->m_paintBuffer.constBits(), bits);
+    }
+
     void testVerySmallWidgetSizes()
     {
         // Also very small widget sizes should not crash the widget.
@@ -0,0 +1,347 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "contrastmatrix.h"
+
+#include <QtTest>
+
+#include "rgbcolorspace.h"
+
+#include <QRandomGenerator>
+
+Q_DECLARE_METATYPE(PerceptualColor::ContrastMatrix::Metric)
+
+static int snippet01()
+{
+    //! [Use ContrastMatrix]
+    QSharedPointer<PerceptualColor::RgbColorSpace> colorSpace = PerceptualColor::RgbColorSpace::createSrgb();
+    QVector<PerceptualColor::LchDouble> palette;
+    palette.append(PerceptualColor::LchDouble {20, 30, 250});
+    palette.append(PerceptualColor::LchDouble {25, 40, 120});
+    palette.append(PerceptualColor::LchDouble {90, 10, 80});
+    // Find all pairs that do not reach the WCAG contrast ratio 4.5:
+    int lowContrastCount = 0;
+    PerceptualColor::ContrastMatrix::lowContrastPairs( //
+        palette,
+        colorSpace,
+        PerceptualColor::ContrastMatrix::Metric::WcagContrastRatio,
+        4.5,
+        [&lowContrastCount](int first, int second, double contrastRatio) {
+            Q_UNUSED(first)
+            Q_UNUSED(second)
+            Q_UNUSED(contrastRatio)
+            ++lowContrastCount;
+        });
+    //! [Use ContrastMatrix]
+    return lowContrastCount;
+}
+
+namespace PerceptualColor
+{
+class TestContrastMatrix : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestContrastMatrix(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    QSharedPointer<RgbColorSpace> m_rgbColorSpace = RgbColorSpace::createSrgb();
+
+    /** @brief A palette of random colors. */
+    static QVector<LchDouble> randomPalette(int count)
+    {
+        QRandomGenerator random(count);
+        QVector<LchDouble> result;
+        result.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            result.append(LchDouble {random.generateDouble() * 100, //
+                                     random.generateDouble() * 100,
+                                     random.generateDouble() * 360});
+        }
+        return result;
+    }
+
+    /** @brief A palette with black and white. */
+    static QVector<LchDouble> blackAndWhite()
+    {
+        return QVector<LchDouble> {LchDouble {0, 0, 0}, LchDouble {100, 0, 0}};
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testWcagContrastRatio()
+    {
+        QCOMPARE(ContrastMatrix::wcagContrastRatio(1, 0), 21.0);
+        QCOMPARE(ContrastMatrix::wcagContrastRatio(0, 1), 21.0);
+        QCOMPARE(ContrastMatrix::wcagContrastRatio(0.5, 0.5), 1.0);
+    }
+
+    void testApcaLightnessContrast()
+    {
+        // Reference values of APCA-W3 0.0.98G-4g for #000000 and #ffffff
+        QVERIFY(qAbs(ContrastMatrix::apcaLightnessContrast(0, 1) - 106.04) < 0.01);
+        QVERIFY(qAbs(ContrastMatrix::apcaLightnessContrast(1, 0) + 107.88) < 0.01);
+        QCOMPARE(ContrastMatrix::apcaLightnessContrast(0.5, 0.5), 0.0);
+    }
+
+    void testRelativeLuminance()
+    {
+        const std::vector<double> luminance = //
+            ContrastMatrix::relativeLuminance(blackAndWhite(), m_rgbColorSpace);
+        QCOMPARE(static_cast<int>(luminance.size()), 2);
+        QVERIFY(luminance.at(0) < 0.001);
+        QVERIFY(luminance.at(1) > 0.999);
+    }
+
+    void testEmptyPalette()
+    {
+        const QVector<LchDouble> palette;
+        QVERIFY(ContrastMatrix::contrastMatrix( //
+                    palette,
+                    m_rgbColorSpace,
+                    ContrastMatrix::Metric::WcagContrastRatio)
+                    .empty());
+        bool isCalled = false;
+        ContrastMatrix::lowContrastPairs( //
+            palette,
+            m_rgbColorSpace,
+            ContrastMatrix::Metric::WcagContrastRatio,
+            21,
+            [&isCalled](int, int, double) {
+                isCalled = true;
+            });
+        QVERIFY(!isCalled);
+    }
+
+    void testBlackAndWhite()
+    {
+        const std::vector<float> wcag = ContrastMatrix::contrastMatrix( //
+            blackAndWhite(),
+            m_rgbColorSpace,
+            ContrastMatrix::Metric::WcagContrastRatio);
+        QCOMPARE(static_cast<int>(wcag.size()), 4);
+        QVERIFY(qAbs(wcag.at(0) - 1) < 0.001);
+        QVERIFY(qAbs(wcag.at(1) - 21) < 0.01);
+        QVERIFY(qAbs(wcag.at(2) - 21) < 0.01);
+        QVERIFY(qAbs(wcag.at(3) - 1) < 0.001);
+        const std::vector<float> apca = ContrastMatrix::contrastMatrix( //
+            blackAndWhite(),
+            m_rgbColorSpace,
+            ContrastMatrix::Metric::ApcaLightnessContrast);
+        QCOMPARE(static_cast<int>(apca.size()), 4);
+        QCOMPARE(apca.at(0), 0.0f);
+        // Black text on white background
+        QVERIFY(qAbs(apca.at(1) - 106.04) < 0.1);
+        // White text on black background
+        QVERIFY(qAbs(apca.at(2) + 107.88) < 0.1);
+        QCOMPARE(apca.at(3), 0.0f);
+    }
+
+    void testMatrixMatchesReference()
+    {
+        // More colors than ContrastMatrix::blockSize, so that
+        // the cache blocking and the threads are involved.
+        const int count = ContrastMatrix::blockSize * 2 + 7;
+        const QVector<LchDouble> palette = randomPalette(count);
+        std::vector<double> wcagLuminance;
+        std::vector<double> apcaLuminance;
+        ContrastMatrix::rgbLuminance(palette, m_rgbColorSpace, &wcagLuminance, &apcaLuminance);
+        const std::vector<float> wcag = ContrastMatrix::contrastMatrix( //
+            palette,
+            m_rgbColorSpace,
+            ContrastMatrix::Metric::WcagContrastRatio);
+        const std::vector<float> apca = ContrastMatrix::contrastMatrix( //
+            palette,
+            m_rgbColorSpace,
+            ContrastMatrix::Metric::ApcaLightnessContrast);
+        for (int row = 0; row < count; row += 13) {
+            for (int column = 0; column < count; column += 7) {
+                const std::size_t index = static_cast<std::size_t>(row * count + column);
+                const std::size_t rowIndex = static_cast<std::size_t>(row);
+                const std::size_t columnIndex = static_cast<std::size_t>(column);
+                const double expectedWcag = ContrastMatrix::wcagContrastRatio( //
+                    wcagLuminance.at(rowIndex),
+                    wcagLuminance.at(columnIndex));
+                QVERIFY(qAbs(wcag.at(index) - expectedWcag) < expectedWcag * 1e-4);
+                const double expectedApca = ContrastMatrix::apcaLightnessContrast( //
+                    apcaLuminance.at(rowIndex),
+                    apcaLuminance.at(columnIndex));
+                QVERIFY(qAbs(apca.at(index) - expectedApca) < 0.01);
+            }
+        }
+    }
+
+    void testCalculateRowsUpperTriangle()
+    {
+        // More colors than ContrastMatrix::blockSize, and rows beyond the
+        // first block, so that whole blocks are skipped.
+        const int count = ContrastMatrix::blockSize * 2 + 7;
+        const QVector<LchDouble> palette = randomPalette(count);
+        const ContrastMatrix::Terms terms = //
+            ContrastMatrix::terms(palette, m_rgbColorSpace);
+        const int rowBegin = ContrastMatrix::blockSize + 3;
+        const int rowEnd = rowBegin + 20;
+        const std::size_t size = static_cast<std::size_t>((rowEnd - rowBegin) * count);
+        std::vector<float> full(size);
+        ContrastMatrix::calculateRows( //
+            terms,
+            ContrastMatrix::Metric::WcagContrastRatio,
+            rowBegin,
+            rowEnd,
+            false,
+            full.data());
+        constexpr float untouched = -1;
+        std::vector<float> triangle(size, untouched);
+        ContrastMatrix::calculateRows( //
+            terms,
+            ContrastMatrix::Metric::WcagContrastRatio,
+            rowBegin,
+            rowEnd,
+            true,
+            triangle.data());
+        for (int row = rowBegin; row < rowEnd; ++row) {
+            for (int column = 0; column < count; ++column) {
+                const std::size_t index = static_cast<std::size_t>((row - rowBegin) * count + column);
+                if (column > row) {
+                    QCOMPARE(triangle.at(index), full.at(index));
+                } else {
+                    QCOMPARE(triangle.at(index), untouched);
+                }
+            }
+        }
+    }
+
+    void testLowContrastPairs_data()
+    {
+        QTest::addColumn<ContrastMatrix::Metric>("metric");
+        QTest::addColumn<double>("threshold");
+        QTest::newRow("WCAG") << ContrastMatrix::Metric::WcagContrastRatio << 3.0;
+        QTest::newRow("APCA") << ContrastMatrix::Metric::ApcaLightnessContrast << 45.0;
+    }
+
+    void testLowContrastPairs()
+    {
+        QFETCH(ContrastMatrix::Metric, metric);
+        QFETCH(double, threshold);
+        // More colors than ContrastMatrix::rowsPerRound
+        const int count = ContrastMatrix::rowsPerRound * 3 + 5;
+        const QVector<LchDouble> palette = randomPalette(count);
+        const std::vector<float> matrix = //
+            ContrastMatrix::contrastMatrix(palette, m_rgbColorSpace, metric);
+        const bool isSymmetric = (metric == ContrastMatrix::Metric::WcagContrastRatio);
+        QVector<QPair<int, int>> expected;
+        for (int row = 0; row < count; ++row) {
+            for (int column = isSymmetric ? row + 1 : 0; column < count; ++column) {
+                const float contrast = matrix.at(static_cast<std::size_t>(row * count + column));
+                if ((column != row) && (qAbs(contrast) < static_cast<float>(threshold))) {
+                    expected.append(QPair<int, int>(row, column));
+                }
+            }
+        }
+        QVector<QPair<int, int>> actual;
+        ContrastMatrix::lowContrastPairs( //
+            palette,
+            m_rgbColorSpace,
+            metric,
+            threshold,
+            [&](int text, int background, double contrast) {
+                actual.append(QPair<int, int>(text, background));
+                QCOMPARE(static_cast<float>(contrast), //
+                         matrix.at(static_cast<std::size_t>(text * count + background)));
+            });
+        QVERIFY(!expected.isEmpty());
+        QCOMPARE(actual, expected);
+    }
+
+    void testSnippet01()
+    {
+        // Only the two dark colors do not have enough contrast to each other.
+        QCOMPARE(snippet01(), 1);
+    }
+
+    void benchmarkContrastMatrix()
+    {
+        const QVector<LchDouble> palette = randomPalette(2000);
+        QBENCHMARK {
+            ContrastMatrix::contrastMatrix( //
+                palette,
+                m_rgbColorSpace,
+                ContrastMatrix::Metric::ApcaLightnessContrast);
+        }
+    }
+
+    void benchmarkLowContrastPairs()
+    {
+        const QVector<LchDouble> palette = randomPalette(2000);
+        int pairCount = 0;
+        QBENCHMARK {
+            ContrastMatrix::lowContrastPairs( //
+                palette,
+                m_rgbColorSpace,
+                ContrastMatrix::Metric::WcagContrastRatio,
+                1.5,
+                [&pairCount](int, int, double) {
+                    ++pairCount;
+                });
+        }
+        QVERIFY(pairCount > 0);
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestContrastMatrix)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testcontrastmatrix.moc"
@@ -0,0 +1,283 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "displaytransform.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "labbuffer.h"
+#include "rgbcolorspace.h"
+
+static QColor snippet01(const QSharedPointer<PerceptualColor::RgbColorSpace> &workingColorSpace, const cmsCIELab &lab)
+{
+    //! [Use DisplayTransform]
+    QSharedPointer<PerceptualColor::RgbColorSpace> displayColorSpace = PerceptualColor::RgbColorSpace::createSrgb();
+    QSharedPointer<PerceptualColor::DisplayTransform> transform = PerceptualColor::DisplayTransform::create(workingColorSpace, displayColorSpace);
+    // The gamut decision is made in the working color space…
+    QColor color = workingColorSpace->toQColorRgbUnbound(lab);
+    // …but the display gets the values for its own color space.
+    if (color.isValid() && !transform.isNull()) {
+        color = transform->toDisplayColor(lab);
+    }
+    //! [Use DisplayTransform]
+    return color;
+}
+
+namespace PerceptualColor
+{
+class TestDisplayTransform : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestDisplayTransform(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    QTemporaryDir m_temporaryDir;
+    QSharedPointer<RgbColorSpace> m_srgb;
+    QSharedPointer<RgbColorSpace> m_wideGamut;
+
+    /** @brief Creates a color space with Rec. 2020 primaries.
+     *
+     * @returns A color space that is considerably wider than sRGB. */
+    QSharedPointer<RgbColorSpace> createWideGamutColorSpace()
+    {
+        cmsCIExyY whitePoint;
+        cmsWhitePointFromTemp(&whitePoint, 6504);
+        const cmsCIExyYTRIPLE primaries {{0.708, 0.292, 1}, // red
+                                         {0.170, 0.797, 1}, // green
+                                         {0.131, 0.046, 1}}; // blue
+        cmsToneCurve *gamma = cmsBuildGamma(nullptr, 2.2);
+        cmsToneCurve *curves[3] {gamma, gamma, gamma};
+        cmsHPROFILE profile = cmsCreateRGBProfile(&whitePoint, &primaries, curves);
+        cmsFreeToneCurve(gamma);
+        const QString fileName = m_temporaryDir.filePath(QStringLiteral("widegamut.icc"));
+        cmsSaveProfileToFile(profile, QFile::encodeName(fileName).constData());
+        cmsCloseProfile(profile);
+        return RgbColorSpace::createFromFile(fileName);
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+        QVERIFY(m_temporaryDir.isValid());
+        m_srgb = RgbColorSpace::createSrgb();
+        m_wideGamut = createWideGamutColorSpace();
+        QVERIFY(!m_wideGamut.isNull());
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testNoTransformNecessary()
+    {
+        QVERIFY(DisplayTransform::create(m_srgb, nullptr).isNull());
+        QVERIFY(DisplayTransform::create(m_wideGamut, nullptr).isNull());
+        // Identical profiles do not need a transform:
+        QVERIFY(DisplayTransform::create(m_srgb, RgbColorSpace::createSrgb()).isNull());
+    }
+
+    void testTransformIsCreated()
+    {
+        QVERIFY(!DisplayTransform::create(m_wideGamut, m_srgb).isNull());
+        QVERIFY(!DisplayTransform::create(m_srgb, m_wideGamut).isNull());
+    }
+
+    void testToDisplayColor_data()
+    {
+        QTest::addColumn<double>("l");
+        QTest::addColumn<double>("a");
+        QTest::addColumn<double>("b");
+        QTest::newRow("gray") << 50.0 << 0.0 << 0.0;
+        QTest::newRow("orange") << 60.0 << 30.0 << 40.0;
+        QTest::newRow("blue") << 40.0 << 10.0 << -40.0;
+        QTest::newRow("green") << 70.0 << -30.0 << 20.0;
+    }
+
+    void testToDisplayColor()
+    {
+        // For colors that are within both gamuts, the fused transform
+        // gives the same result as converting directly to sRGB.
+        QFETCH(double, l);
+        QFETCH(double, a);
+        QFETCH(double, b);
+        cmsCIELab lab;
+        lab.L = l;
+        lab.a = a;
+        lab.b = b;
+        QVERIFY(m_wideGamut->isInGamut(lab));
+        const QColor expected = m_srgb->toQColorRgbUnbound(lab);
+        QVERIFY(expected.isValid());
+        const QSharedPointer<DisplayTransform> transform = DisplayTransform::create(m_wideGamut, m_srgb);
+        const QColor actual = transform->toDisplayColor(lab);
+        QVERIFY(qAbs(actual.red() - expected.red()) <= 1);
+        QVERIFY(qAbs(actual.green() - expected.green()) <= 1);
+        QVERIFY(qAbs(actual.blue() - expected.blue()) <= 1);
+        QCOMPARE(actual.alpha(), 255);
+    }
+
+    void testToDisplayColorLch()
+    {
+        const QSharedPointer<DisplayTransform> transform = DisplayTransform::create(m_wideGamut, m_srgb);
+        LchDouble lch;
+        lch.l = 60;
+        lch.c = 50;
+        lch.h = 53.13010235415598; // atan2(40, 30)
+        cmsCIELab lab;
+        lab.L = 60;
+        lab.a = 30;
+        lab.b = 40;
+        QCOMPARE(transform->toDisplayColor(lch), transform->toDisplayColor(lab));
+    }
+
+    void testClipping()
+    {
+        // A color within the wide gamut, but outside of sRGB, is clipped.
+        const QSharedPointer<DisplayTransform> transform = DisplayTransform::create(m_wideGamut, m_srgb);
+        LchDouble lch;
+        lch.l = 60;
+        lch.c = 100;
+        lch.h = 150;
+        QVERIFY(m_wideGamut->isInGamut(lch));
+        QVERIFY(!m_srgb->isInGamut(lch));
+        QVERIFY(transform->toDisplayColor(lch).isValid());
+    }
+
+    void testToDisplayQRgbFromLab()
+    {
+        const QSharedPointer<DisplayTransform> transform = DisplayTransform::create(m_wideGamut, m_srgb);
+        LabBuffer lab(3);
+        lab.set(0, cmsCIELab {60, 30, 40});
+        lab.set(1, cmsCIELab {50, 0, 0});
+        lab.set(2, cmsCIELab {40, 10, -40});
+        // The second color is marked as out-of-gamut of the working color
+        // space, so it must stay unchanged.
+        QVector<QRgb> rgb {qRgb(1, 2, 3), 0, qRgb(4, 5, 6)};
+        transform->toDisplayQRgb(lab.view(), rgb.data());
+        QCOMPARE(rgb.at(1), static_cast<QRgb>(0));
+        for (int i : {0, 2}) {
+            const QColor expected = transform->toDisplayColor(lab.at(i));
+            QCOMPARE(qAlpha(rgb.at(i)), 255);
+            QVERIFY(qAbs(qRed(rgb.at(i)) - expected.red()) <= 1);
+            QVERIFY(qAbs(qGreen(rgb.at(i)) - expected.green()) <= 1);
+            QVERIFY(qAbs(qBlue(rgb.at(i)) - expected.blue()) <= 1);
+        }
+    }
+
+    void testToDisplayQRgbFromWorkingRgb()
+    {
+        const QSharedPointer<DisplayTransform> transform = DisplayTransform::create(m_wideGamut, m_srgb);
+        LabBuffer lab(3);
+        lab.set(0, cmsCIELab {60, 30, 40});
+        lab.set(1, cmsCIELab {50, 0, 0});
+        lab.set(2, cmsCIELab {70, -30, 20});
+        QVector<RgbDouble> workingRgb(lab.count());
+        m_wideGamut->toRgbDoubleBound(lab.view(), workingRgb.data());
+        // The second color is marked as out-of-gamut of the working color
+        // space, so it must stay unchanged.
+        QVector<QRgb> rgb {qRgb(1, 2, 3), 0, qRgb(4, 5, 6)};
+        transform->toDisplayQRgb(workingRgb.constData(), rgb.data(), rgb.count());
+        QCOMPARE(rgb.at(1), static_cast<QRgb>(0));
+        // For colors within both gamuts, this is the same as the direct
+        // transform from Lab.
+        for (int i : {0, 2}) {
+            const QColor expected = transform->toDisplayColor(lab.at(i));
+            QCOMPARE(qAlpha(rgb.at(i)), 255);
+            QVERIFY(qAbs(qRed(rgb.at(i)) - expected.red()) <= 1);
+            QVERIFY(qAbs(qGreen(rgb.at(i)) - expected.green()) <= 1);
+            QVERIFY(qAbs(qBlue(rgb.at(i)) - expected.blue()) <= 1);
+        }
+    }
+
+    void testContextOfWorkingColorSpace()
+    {
+        // The transform keeps the working color space (and therefore the
+        // LittleCMS context of its transforms) alive.
+        QSharedPointer<RgbColorSpace> workingColorSpace = createWideGamutColorSpace();
+        const QSharedPointer<DisplayTransform> transform = DisplayTransform::create(workingColorSpace, m_srgb);
+        QVERIFY(!transform.isNull());
+        QCOMPARE(transform->m_workingColorSpace, workingColorSpace);
+        workingColorSpace.reset();
+        QVERIFY(transform->toDisplayColor(cmsCIELab {50, 10, 10}).isValid());
+    }
+
+    void testSnippet01()
+    {
+        cmsCIELab lab;
+        lab.L = 50;
+        lab.a = 20;
+        lab.b = 20;
+        const QColor expected = m_srgb->toQColorRgbUnbound(lab);
+        const QColor actual = snippet01(m_wideGamut, lab);
+        QVERIFY(qAbs(actual.red() - expected.red()) <= 1);
+        QVERIFY(qAbs(actual.green() - expected.green()) <= 1);
+        QVERIFY(qAbs(actual.blue() - expected.blue()) <= 1);
+    }
+
+    void benchmarkToDisplayColor()
+    {
+        const QSharedPointer<DisplayTransform> transform = DisplayTransform::create(m_wideGamut, m_srgb);
+        cmsCIELab lab;
+        lab.L = 50;
+        lab.b = 10;
+        QBENCHMARK {
+            for (int i = -100; i < 100; ++i) {
+                lab.a = i;
+                transform->toDisplayColor(lab);
+            }
+        }
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestDisplayTransform)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testdisplaytransform.moc"
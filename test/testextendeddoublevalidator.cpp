@@ -141,6 +141,34 @@ private Q_SLOTS:
         // On simple cases of valid input, the position should not change.
         QCOMPARE(myPos, originalPos);
     }
+
+    void testValidateWithoutPrefixAndSuffix()
+    {
+        ExtendedDoubleValidator myValidator;
+        myValidator.setRange(0, 1000);
+        QString myInput = QStringLiteral("123");
+        int myPos = 2;
+        QCOMPARE(myValidator.validate(myInput, myPos), QValidator::State::Acceptable);
+        QCOMPARE(myInput, QStringLiteral("123"));
+        QCOMPARE(myPos, 2);
+        myInput = QString();
+        myPos = 0;
+        QCOMPARE(myValidator.validate(myInput, myPos), QValidator::State::Intermediate);
+        QCOMPARE(myPos, 0);
+    }
+
+    void benchmarkValidate()
+    {
+        ExtendedDoubleValidator myValidator;
+        myValidator.setPrefix(QStringLiteral("abc"));
+        myValidator.setSuffix(QStringLiteral("def"));
+        myValidator.setRange(0, 1000);
+        QString myInput = QStringLiteral("abc123def");
+        int myPos = 5;
+        QBENCHMARK {
+            myValidator.validate(myInput, myPos);
+        }
+    }
 };
 
 } // namespace PerceptualColor
@@ -0,0 +1,190 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "gamutboundary.h"
+
+#include <QtTest>
+
+#include "PerceptualColor/lchdouble.h"
+#include "PerceptualColor/rgbcolorspacefactory.h"
+#include "lchbuffer.h"
+#include "rgbcolorspace.h"
+
+namespace PerceptualColor
+{
+class TestGamutBoundary : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestGamutBoundary(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    QSharedPointer<RgbColorSpace> m_colorSpace;
+    static LchDouble lch(qreal l, qreal c, qreal h)
+    {
+        LchDouble result;
+        result.l = l;
+        result.c = c;
+        result.h = h;
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+        m_colorSpace = RgbColorSpaceFactory::createSrgb();
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+        m_colorSpace.reset();
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testGridPoints()
+    {
+        // On the grid points, the table values are exact (within
+        // the precision of the bisection).
+        GamutBoundary myBoundary(m_colorSpace.data(), 0, 100);
+        for (int l = 5; l < 100; l += 10) {
+            for (int h = 0; h < 360; h += 15) {
+                const qreal chroma = myBoundary.maximumChroma(l, h);
+                QVERIFY(chroma > 0);
+                QVERIFY(m_colorSpace->isInGamut(lch(l, chroma, h)));
+                QVERIFY(!m_colorSpace->isInGamut(lch(l, chroma + 0.01, h)));
+            }
+        }
+    }
+
+    void testInterpolation()
+    {
+        GamutBoundary myBoundary(m_colorSpace.data(), 0, 100);
+        for (qreal l = 2.3; l < 100; l += 7.7) {
+            for (qreal h = 0.4; h < 360; h += 13.1) {
+                const qreal estimate = myBoundary.maximumChroma(l, h);
+                const qreal exact = myBoundary.maximumChroma(l, h, 0.001);
+                // Next to the cusp, the interpolation error is bigger.
+                QVERIFY(qAbs(estimate - exact) < 3);
+            }
+        }
+    }
+
+    void testRefinement()
+    {
+        GamutBoundary myBoundary(m_colorSpace.data(), 0, 100);
+        const qreal chroma = myBoundary.maximumChroma(53.7, 41.3, 0.001);
+        QVERIFY(m_colorSpace->isInGamut(lch(53.7, chroma, 41.3)));
+        QVERIFY(!m_colorSpace->isInGamut(lch(53.7, chroma + 0.002, 41.3)));
+    }
+
+    void testOutOfRangeLightness()
+    {
+        GamutBoundary myBoundary(m_colorSpace.data(), 0.5, 99.5);
+        QCOMPARE(myBoundary.maximumChroma(0.2, 0), 0.);
+        QCOMPARE(myBoundary.maximumChroma(99.8, 0), 0.);
+        QCOMPARE(myBoundary.maximumChroma(-5, 0), 0.);
+        QCOMPARE(myBoundary.maximumChroma(105, 0, 0.001), 0.);
+    }
+
+    void testHueWrapAround()
+    {
+        GamutBoundary myBoundary(m_colorSpace.data(), 0, 100);
+        QCOMPARE(myBoundary.maximumChroma(50, 370), myBoundary.maximumChroma(50, 10));
+        QCOMPARE(myBoundary.maximumChroma(50, -0.5), myBoundary.maximumChroma(50, 359.5));
+    }
+
+    void testLightnessRange()
+    {
+        GamutBoundary myBoundary(m_colorSpace.data(), 0.5, 99.5);
+        const QPair<qreal, qreal> gray = myBoundary.lightnessRange(0, 0);
+        QCOMPARE(gray.first, 0.5);
+        QCOMPARE(gray.second, 99.5);
+
+        const QPair<qreal, qreal> range = myBoundary.lightnessRange(30, 20);
+        QVERIFY(range.first < range.second);
+        QVERIFY(m_colorSpace->isInGamut(lch(range.first + 0.5, 20, 30)));
+        QVERIFY(m_colorSpace->isInGamut(lch(range.second - 0.5, 20, 30)));
+        QVERIFY(!m_colorSpace->isInGamut(lch(range.first - 0.5, 20, 30)));
+        QVERIFY(!m_colorSpace->isInGamut(lch(range.second + 0.5, 20, 30)));
+
+        // Beyond the cusp
+        const QPair<qreal, qreal> empty = myBoundary.lightnessRange(30, 190);
+        QVERIFY(qIsNaN(empty.first));
+        QVERIFY(qIsNaN(empty.second));
+    }
+
+    void testBatch()
+    {
+        GamutBoundary myBoundary(m_colorSpace.data(), 0, 100);
+        const QVector<LchDouble> queries {lch(50, 0, 30), //
+                                          lch(20.5, 0, 200.5),
+                                          lch(90, 0, 100)};
+        LchBuffer buffer = LchBuffer::fromVector(queries);
+        myBoundary.maximumChroma(buffer.view());
+        for (int i = 0; i < queries.count(); ++i) {
+            QCOMPARE(buffer.c()[i], myBoundary.maximumChroma(queries.at(i).l, queries.at(i).h));
+        }
+
+        for (int i = 0; i < queries.count(); ++i) {
+            buffer.c()[i] = 10;
+        }
+        QVector<double> minimum(queries.count());
+        QVector<double> maximum(queries.count());
+        myBoundary.lightnessRange(buffer.view(), minimum.data(), maximum.data());
+        for (int i = 0; i < queries.count(); ++i) {
+            const QPair<qreal, qreal> range = myBoundary.lightnessRange(queries.at(i).h, 10);
+            QCOMPARE(minimum.at(i), range.first);
+            QCOMPARE(maximum.at(i), range.second);
+        }
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestGamutBoundary)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testgamutboundary.moc"
@@ -0,0 +1,293 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "gamutcache.h"
+
+#include <QtTest>
+
+#include "PerceptualColor/rgbcolorspacefactory.h"
+#include "chromahueimage.h"
+#include "chromalightnessimage.h"
+#include "lchbuffer.h"
+#include "rgbcolorspace.h"
+
+namespace PerceptualColor
+{
+class TestGamutCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestGamutCache(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    static LchDouble lch(qreal l, qreal c, qreal h)
+    {
+        LchDouble result;
+        result.l = l;
+        result.c = c;
+        result.h = h;
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testConstructor()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        GamutCache myCache(colorSpace.data());
+        QCOMPARE(myCache.populatedTileCount(), 0);
+    }
+
+    void testGamutCacheOfColorSpace()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        // Always the same object
+        QCOMPARE(&colorSpace->gamutCache(), &colorSpace->gamutCache());
+    }
+
+    void testLazyPopulation()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        GamutCache myCache(colorSpace.data());
+        // All neighboring grid points of this color are within
+        // the same tile.
+        myCache.toQRgbUnbound(lch(50.5, 10.5, 42.5));
+        QCOMPARE(myCache.populatedTileCount(), 1);
+        // The second lookup within the same tile does not calculate
+        // anything.
+        myCache.toQRgbUnbound(lch(51.5, 11.5, 43.5));
+        QCOMPARE(myCache.populatedTileCount(), 1);
+        // A lookup at the border of the tile needs the neighbor tile.
+        myCache.toQRgbUnbound(lch(55.5, 10.5, 42.5));
+        QCOMPARE(myCache.populatedTileCount(), 2);
+    }
+
+    void testAgreementWithColorSpace()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        GamutCache myCache(colorSpace.data());
+        int testedColors = 0;
+        for (qreal l = 5.3; l < 100; l += 9.7) {
+            for (qreal c = 0.4; c < 150; c += 7.9) {
+                for (qreal h = 0.6; h < 360; h += 23.3) {
+                    // Only test colors that are not close to the gamut
+                    // boundary. Close to the boundary, the cache is only
+                    // an approximation.
+                    if (!colorSpace->isInGamut(lch(l, c + 2, h)) //
+                        || !colorSpace->isInGamut(lch(l + 2, c, h)) //
+                        || !colorSpace->isInGamut(lch(l - 2, c, h)) //
+                        || !colorSpace->isInGamut(lch(l, c, h + 2)) //
+                        || !colorSpace->isInGamut(lch(l, c, h - 2))) {
+                        continue;
+                    }
+                    const QColor exact = colorSpace->toQColorRgbUnbound(lch(l, c, h));
+                    QVERIFY(exact.isValid());
+                    const QRgb cached = myCache.toQRgbUnbound(lch(l, c, h));
+                    QVERIFY(cached != 0);
+                    QVERIFY(qAbs(qRed(cached) - exact.red()) <= 2);
+                    QVERIFY(qAbs(qGreen(cached) - exact.green()) <= 2);
+                    QVERIFY(qAbs(qBlue(cached) - exact.blue()) <= 2);
+                    ++testedColors;
+                }
+            }
+        }
+        QVERIFY(testedColors > 100);
+    }
+
+    void testAccuracyReport()
+    {
+        // Compares the cache with the exact values on a dense sample,
+        // including colors close to the gamut boundary.
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        GamutCache myCache(colorSpace.data());
+        int sampleCount = 0;
+        int misclassifications = 0;
+        int worstError = 0;
+        for (qreal l = 0.7; l < 100; l += 2.3) {
+            for (qreal c = 0.3; c < 150; c += 1.7) {
+                for (qreal h = 0.2; h < 360; h += 7.1) {
+                    const QColor exact = colorSpace->toQColorRgbUnbound(lch(l, c, h));
+                    const QRgb cached = myCache.toQRgbUnbound(lch(l, c, h));
+                    ++sampleCount;
+                    if (exact.isValid() != (cached != 0)) {
+                        ++misclassifications;
+                        continue;
+                    }
+                    if (exact.isValid()) {
+                        worstError = qMax(worstError, qAbs(qRed(cached) - exact.red()));
+                        worstError = qMax(worstError, qAbs(qGreen(cached) - exact.green()));
+                        worstError = qMax(worstError, qAbs(qBlue(cached) - exact.blue()));
+                    }
+                }
+            }
+        }
+        qDebug() << "Samples:" << sampleCount //
+                 << "Misclassifications:" << misclassifications //
+                 << "Worst error (8 bit):" << worstError;
+        // Colors close to the boundary are calculated exactly, so
+        // misclassifications are very rare.
+        QVERIFY(misclassifications * 1000 < sampleCount);
+        QVERIFY(worstError <= 2);
+    }
+
+    void testBoundaryIsExact()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        GamutCache myCache(colorSpace.data());
+        for (qreal h = 5; h < 360; h += 30) {
+            const qreal maximum = colorSpace->maximumInGamutChroma(50.5, h, 0.0001);
+            QVERIFY(myCache.toQRgbUnbound(lch(50.5, maximum - 0.01, h)) != 0);
+            QCOMPARE(myCache.toQRgbUnbound(lch(50.5, maximum + 0.01, h)), static_cast<QRgb>(0));
+        }
+    }
+
+    void testPopulate()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        GamutCache myCache(colorSpace.data());
+        myCache.populate(50, 50, 100);
+        const int tileCount = myCache.populatedTileCount();
+        // All hues, the chroma range [0, 100] (plus the upper neighbor)
+        // and the lightness 50 (plus the upper neighbor):
+        const int chromaTiles = 101 / GamutCache::tileSize + 1;
+        const int hueTiles = 360 / GamutCache::tileSize;
+        QCOMPARE(tileCount, chromaTiles * hueTiles);
+        // Lookups within the populated range do not calculate anything.
+        for (qreal h = 0; h < 360; h += 3.3) {
+            myCache.toQRgbUnbound(lch(50, 99.5, h));
+            myCache.toQRgbUnbound(lch(50.5, 3, h));
+        }
+        QCOMPARE(myCache.populatedTileCount(), tileCount);
+        // Populating again does nothing.
+        myCache.populate(50, 50, 100);
+        QCOMPARE(myCache.populatedTileCount(), tileCount);
+    }
+
+    void testOutOfGamut()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        GamutCache myCache(colorSpace.data());
+        QCOMPARE(myCache.toQRgbUnbound(lch(50, 180, 0)), static_cast<QRgb>(0));
+        // Beyond the range of the cache
+        QCOMPARE(myCache.toQRgbUnbound(lch(150, 0, 0)), static_cast<QRgb>(0));
+        QCOMPARE(myCache.toQRgbUnbound(lch(-1, 0, 0)), static_cast<QRgb>(0));
+        QCOMPARE(myCache.toQRgbUnbound(lch(50, 1000, 0)), static_cast<QRgb>(0));
+    }
+
+    void testHueWrapAround()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        GamutCache myCache(colorSpace.data());
+        QCOMPARE(myCache.toQRgbUnbound(lch(50, 20, 359.5)), //
+                 myCache.toQRgbUnbound(lch(50, 20, -0.5)));
+        QCOMPARE(myCache.toQRgbUnbound(lch(50, 20, 10)), //
+                 myCache.toQRgbUnbound(lch(50, 20, 370)));
+    }
+
+    void testBatch()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        GamutCache myCache(colorSpace.data());
+        const QVector<LchDouble> colors {lch(50, 20, 30), //
+                                         lch(70.5, 40.5, 200.5),
+                                         lch(50, 180, 0)};
+        const LchBuffer buffer = LchBuffer::fromVector(colors);
+        QVector<QRgb> rgb(colors.count());
+        myCache.toQRgbUnboundFromLch(buffer.view(), rgb.data());
+        for (int i = 0; i < colors.count(); ++i) {
+            QCOMPARE(rgb.at(i), myCache.toQRgbUnbound(colors.at(i)));
+        }
+    }
+
+    void testNoCalculationAfterWarmUp()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        ChromaHueImage myImage(colorSpace);
+        myImage.setImageSize(100);
+        myImage.setLightness(50);
+        myImage.getImage();
+        const int tileCount = colorSpace->gamutCache().populatedTileCount();
+        QVERIFY(tileCount > 0);
+        // Another lightness within the same tiles: Rendering is
+        // possible without further calculations.
+        myImage.setLightness(50.5);
+        myImage.getImage();
+        QCOMPARE(colorSpace->gamutCache().populatedTileCount(), tileCount);
+    }
+
+    void testSharedBetweenImages()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        ChromaLightnessImage myImage(colorSpace);
+        myImage.setImageSize(QSize(100, 100));
+        myImage.setHue(20);
+        myImage.getImage();
+        const int tileCount = colorSpace->gamutCache().populatedTileCount();
+        QVERIFY(tileCount > 0);
+        // The exact rendering does not use the cache.
+        ChromaLightnessImage exactImage(colorSpace);
+        exactImage.setGamutCacheEnabled(false);
+        exactImage.setImageSize(QSize(100, 100));
+        exactImage.setHue(30);
+        exactImage.getImage();
+        QCOMPARE(colorSpace->gamutCache().populatedTileCount(), tileCount);
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestGamutCache)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testgamutcache.moc"
@@ -0,0 +1,384 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QtTest>
+
+#include "PerceptualColor/lchdouble.h"
+#include "rgbcolorspace.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QTemporaryDir>
+#include <QtMath>
+
+#include <limits>
+
+#include <lcms2.h>
+
+namespace PerceptualColor
+{
+/** @brief Regression tests for the worst-case latency of the gamut
+ * functions of @ref RgbColorSpace.
+ *
+ * The data rows are inputs that are known to be slow: Inputs that hit
+ * the fallback branches of
+ * @ref RgbColorSpace::nearestInGamutColorByAdjustingChroma() or make
+ * @ref RgbColorSpace::nearestInGamutColorByAdjustingChromaLightness()
+ * scan its whole search image. New rows can be found with the program
+ * <tt>fuzzgamut</tt> (see tools/fuzzgamut.cpp), which writes them in
+ * exactly the format used here; append them at the end of
+ * @ref provideGamutData().
+ *
+ * Besides the built-in sRGB color space, the rows use profiles that are
+ * generated at test time: “clut17” is a LUT-based profile with a 17³
+ * CLUT, and “liftedblack” is a matrix-shaper profile with a black point
+ * of 2 % luminance.
+ *
+ * Each row has a latency ceiling in microseconds, which is enforced by
+ * default. The ceilings have a headroom of about four times the
+ * expected latency of an optimized build: Rows that are out-of-gamut
+ * need a scan of the whole 801 × 400 search image, the others return
+ * early. For slow builds (debug builds, sanitizers, Valgrind), set the
+ * environment variable <tt>PERCEPTUALCOLOR_LATENCY_CEILING_FACTOR</tt>
+ * to a factor for all ceilings, or to <tt>0</tt> to skip the
+ * ceilings. */
+class TestGamutLatency : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestGamutLatency(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    /** @brief Number of measurements for each row. The minimum counts. */
+    static constexpr int repetitions = 5;
+
+    /** @brief Ceiling for rows that return early, in microseconds. */
+    static constexpr qint64 earlyReturnCeiling = 1000;
+
+    /** @brief Ceiling for rows that scan the whole search image, in
+     * microseconds. */
+    static constexpr qint64 fullScanCeiling = 20000;
+
+    /** @brief Color spaces that have yet been loaded, by name. */
+    QHash<QString, QSharedPointer<RgbColorSpace>> m_colorSpaces;
+
+    /** @brief Directory for the generated profiles. */
+    QTemporaryDir m_profileDirectory;
+
+    /** @brief Provides the color space of a data row.
+     *
+     * @param name Either “srgb” for the built-in sRGB color space, the
+     *        name of a generated profile, or the file name of an
+     *        ICC profile.
+     * @returns The color space, or a null pointer if the file is
+     *          not available on this system. */
+    QSharedPointer<RgbColorSpace> colorSpace(const QString &name)
+    {
+        if (!m_colorSpaces.contains(name)) {
+            QSharedPointer<RgbColorSpace> space;
+            const QString generatedFileName = //
+                m_profileDirectory.filePath(name + QStringLiteral(".icc"));
+            if (name == QStringLiteral("srgb")) {
+                space = RgbColorSpace::createSrgb();
+            } else if (QFileInfo::exists(generatedFileName)) {
+                space = RgbColorSpace::createFromFile(generatedFileName);
+            } else if (QFileInfo::exists(name)) {
+                space = RgbColorSpace::createFromFile(name);
+            }
+            m_colorSpaces.insert(name, space);
+        }
+        return m_colorSpaces.value(name);
+    }
+
+    /** @brief Sampler for <tt>cmsStageSampleCLut16bit()</tt>.
+     *
+     * @param in Input values
+     * @param out Output values
+     * @param cargo The transform that is sampled
+     * @returns Always <tt>TRUE</tt>, to continue sampling. */
+    static cmsInt32Number sampleTransform(const cmsUInt16Number in[], cmsUInt16Number out[], void *cargo)
+    {
+        cmsDoTransform(static_cast<cmsHTRANSFORM>(cargo), in, out, 1);
+        return TRUE;
+    }
+
+    /** @brief Creates a pipeline with a 17³ CLUT that samples
+     * a transform.
+     *
+     * @returns The pipeline. The caller has to free it with
+     * <tt>cmsPipelineFree()</tt>. */
+    static cmsPipeline *createClutPipeline(cmsHTRANSFORM transform)
+    {
+        cmsPipeline *result = cmsPipelineAlloc(nullptr, 3, 3);
+        cmsStage *clut = cmsStageAllocCLut16bit(nullptr, 17, 3, 3, nullptr);
+        cmsStageSampleCLut16bit(clut, &sampleTransform, transform, 0);
+        cmsPipelineInsertStage(result, cmsAT_END, clut);
+        return result;
+    }
+
+    /** @brief Creates a LUT-based profile that samples sRGB.
+     *
+     * @returns The profile. The caller has to close it with
+     * <tt>cmsCloseProfile()</tt>. */
+    static cmsHPROFILE createClutProfile()
+    {
+        cmsHPROFILE source = cmsCreate_sRGBProfile();
+        cmsHPROFILE lab = cmsCreateLab4Profile(nullptr);
+        cmsHTRANSFORM toLab = cmsCreateTransform( //
+            source,
+            TYPE_RGB_16,
+            lab,
+            TYPE_Lab_16,
+            INTENT_RELATIVE_COLORIMETRIC,
+            cmsFLAGS_NOCACHE);
+        cmsHTRANSFORM toRgb = cmsCreateTransform( //
+            lab,
+            TYPE_Lab_16,
+            source,
+            TYPE_RGB_16,
+            INTENT_RELATIVE_COLORIMETRIC,
+            cmsFLAGS_NOCACHE);
+        cmsHPROFILE result = cmsCreateProfilePlaceholder(nullptr);
+        cmsSetProfileVersion(result, 4.3);
+        cmsSetDeviceClass(result, cmsSigDisplayClass);
+        cmsSetColorSpace(result, cmsSigRgbData);
+        cmsSetPCS(result, cmsSigLabData);
+        cmsWriteTag(result, cmsSigMediaWhitePointTag, cmsD50_XYZ());
+        cmsPipeline *aToB = createClutPipeline(toLab);
+        cmsWriteTag(result, cmsSigAToB0Tag, aToB);
+        cmsPipelineFree(aToB);
+        cmsPipeline *bToA = createClutPipeline(toRgb);
+        cmsWriteTag(result, cmsSigBToA0Tag, bToA);
+        cmsPipelineFree(bToA);
+        cmsDeleteTransform(toRgb);
+        cmsDeleteTransform(toLab);
+        cmsCloseProfile(lab);
+        cmsCloseProfile(source);
+        return result;
+    }
+
+    /** @brief Creates a matrix-shaper profile with sRGB primaries and
+     * a black point of 2 % luminance.
+     *
+     * @returns The profile. The caller has to close it with
+     * <tt>cmsCloseProfile()</tt>. */
+    static cmsHPROFILE createLiftedBlackProfile()
+    {
+        // The sRGB curve, scaled to the range between black level and 1.
+        // Type 5: Y = (aX + b)^g + e for X ≥ d; Y = cX + f for X < d
+        const double blackLevel = 0.02;
+        const double range = 1 - blackLevel;
+        const double gamma = 2.4;
+        const double scale = qPow(range, 1 / gamma);
+        const double parameters[7] = {gamma,
+                                      scale / 1.055,
+                                      scale * 0.055 / 1.055,
+                                      range / 12.92,
+                                      0.04045,
+                                      blackLevel,
+                                      blackLevel};
+        cmsToneCurve *curve = cmsBuildParametricToneCurve(nullptr, 5, parameters);
+        cmsToneCurve *curves[3] = {curve, curve, curve};
+        cmsCIExyY whitePoint;
+        cmsWhitePointFromTemp(&whitePoint, 6504);
+        const cmsCIExyYTRIPLE primaries = {{0.6400, 0.3300, 1}, //
+                                           {0.3000, 0.6000, 1},
+                                           {0.1500, 0.0600, 1}};
+        cmsHPROFILE result = cmsCreateRGBProfile(&whitePoint, &primaries, curves);
+        cmsFreeToneCurve(curve);
+        return result;
+    }
+
+    /** @brief Writes a generated profile to @ref m_profileDirectory.
+     *
+     * @param name The name of the profile
+     * @param handle The profile. It is closed by this function.
+     * @returns <tt>true</tt> on success. */
+    bool writeProfile(const QString &name, cmsHPROFILE handle) const
+    {
+        if (handle == nullptr) {
+            return false;
+        }
+        const QString fileName = m_profileDirectory.filePath(name + QStringLiteral(".icc"));
+        const bool result = cmsSaveProfileToFile(handle, QFile::encodeName(fileName).constData());
+        cmsCloseProfile(handle);
+        return result;
+    }
+
+    /** @brief Runs the gamut functions once.
+     *
+     * @returns Chroma of both results, so that the compiler cannot
+     * optimize the calls away. */
+    static qreal runGamutFunctions(RgbColorSpace &space, const LchDouble &color)
+    {
+        return space.nearestInGamutColorByAdjustingChroma(color).c //
+            + space.nearestInGamutColorByAdjustingChromaLightness(color).c;
+    }
+
+    /** @brief Data rows for the tests and benchmarks. */
+    static void provideGamutData()
+    {
+        QTest::addColumn<QString>("profile");
+        QTest::addColumn<LchDouble>("color");
+        QTest::addColumn<qint64>("ceilingMicroseconds");
+
+        // Known corner cases
+        QTest::newRow("srgb high chroma") << QStringLiteral("srgb") << LchDouble {50, 200, 250} << fullScanCeiling;
+        QTest::newRow("srgb below blackpoint") << QStringLiteral("srgb") << LchDouble {-1, 50, 0} << fullScanCeiling;
+        QTest::newRow("srgb above whitepoint") << QStringLiteral("srgb") << LchDouble {101, 50, 0} << fullScanCeiling;
+        QTest::newRow("srgb blue cusp") << QStringLiteral("srgb") << LchDouble {32.3, 134, 306.3} << fullScanCeiling;
+        QTest::newRow("srgb white maximum chroma") << QStringLiteral("srgb") << LchDouble {99.9, 250, 720} << fullScanCeiling;
+        QTest::newRow("srgb negative chroma") << QStringLiteral("srgb") << LchDouble {50, -10, 90} << earlyReturnCeiling;
+
+        // Fallback branch of nearestInGamutColorByAdjustingChroma(): Even
+        // chroma 0 is out-of-gamut.
+        QTest::newRow("srgb just above whitepoint") << QStringLiteral("srgb") << LchDouble {100.001, 120, 110} << fullScanCeiling;
+        QTest::newRow("srgb just below blackpoint") << QStringLiteral("srgb") << LchDouble {-0.001, 120, 290} << fullScanCeiling;
+
+        // Far away from the gamut at hues where the gamut is narrow: The
+        // nearest neighbor search of
+        // nearestInGamutColorByAdjustingChromaLightness() has to scan
+        // most of its search image.
+        QTest::newRow("srgb bright blue far out") << QStringLiteral("srgb") << LchDouble {100, 250, 306.3} << fullScanCeiling;
+        QTest::newRow("srgb dark yellow far out") << QStringLiteral("srgb") << LchDouble {0, 250, 102.9} << fullScanCeiling;
+        QTest::newRow("srgb dark cyan far out") << QStringLiteral("srgb") << LchDouble {0, 250, 196.4} << fullScanCeiling;
+        QTest::newRow("srgb bright red far out") << QStringLiteral("srgb") << LchDouble {100, 250, 40} << fullScanCeiling;
+
+        // The CLUT profile clips out-of-gamut colors, so each in-gamut
+        // test needs a round trip through both CLUTs.
+        QTest::newRow("clut17 high chroma") << QStringLiteral("clut17") << LchDouble {50, 200, 250} << fullScanCeiling;
+        QTest::newRow("clut17 blue cusp") << QStringLiteral("clut17") << LchDouble {32.3, 134, 306.3} << fullScanCeiling;
+        QTest::newRow("clut17 just above whitepoint") << QStringLiteral("clut17") << LchDouble {100.001, 120, 110} << fullScanCeiling;
+        QTest::newRow("clut17 gray") << QStringLiteral("clut17") << LchDouble {50, -10, 90} << earlyReturnCeiling;
+
+        // With a lifted black point, a wide range of dark colors is
+        // out-of-gamut even at chroma 0.
+        QTest::newRow("liftedblack below blackpoint") << QStringLiteral("liftedblack") << LchDouble {10, 0, 0} << fullScanCeiling;
+        QTest::newRow("liftedblack dark blue") << QStringLiteral("liftedblack") << LchDouble {5, 80, 306.3} << fullScanCeiling;
+        QTest::newRow("liftedblack gray") << QStringLiteral("liftedblack") << LchDouble {50, 0, 0} << earlyReturnCeiling;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+        QVERIFY(m_profileDirectory.isValid());
+        QVERIFY(writeProfile(QStringLiteral("clut17"), createClutProfile()));
+        QVERIFY(writeProfile(QStringLiteral("liftedblack"), createLiftedBlackProfile()));
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testLatencyCeiling_data()
+    {
+        provideGamutData();
+    }
+
+    void testLatencyCeiling()
+    {
+        QFETCH(QString, profile);
+        QFETCH(LchDouble, color);
+        QFETCH(qint64, ceilingMicroseconds);
+        double factor = 1;
+        if (qEnvironmentVariableIsSet("PERCEPTUALCOLOR_LATENCY_CEILING_FACTOR")) {
+            bool ok = false;
+            factor = qEnvironmentVariable("PERCEPTUALCOLOR_LATENCY_CEILING_FACTOR").toDouble(&ok);
+            QVERIFY2(ok && (factor >= 0), "Invalid PERCEPTUALCOLOR_LATENCY_CEILING_FACTOR");
+        }
+        if (factor == 0) {
+            QSKIP("PERCEPTUALCOLOR_LATENCY_CEILING_FACTOR is 0.");
+        }
+        const qint64 ceiling = qRound64(ceilingMicroseconds * factor);
+        QSharedPointer<RgbColorSpace> space = colorSpace(profile);
+        if (space.isNull()) {
+            QSKIP("The profile is not available on this system.");
+        }
+
+        // Warm-up: Renders the search image for this hue.
+        runGamutFunctions(*space, color);
+
+        qint64 fastest = std::numeric_limits<qint64>::max();
+        QElapsedTimer timer;
+        for (int i = 0; i < repetitions; ++i) {
+            timer.start();
+            const qreal result = runGamutFunctions(*space, color);
+            fastest = qMin(fastest, timer.nsecsElapsed() / 1000);
+            QVERIFY(!qIsNaN(result));
+        }
+        QVERIFY2(fastest <= ceiling, //
+                 qPrintable(QStringLiteral("%1 µs exceeds the ceiling of %2 µs.") //
+                                .arg(fastest)
+                                .arg(ceiling)));
+    }
+
+    void benchmarkGamutFunctions_data()
+    {
+        provideGamutData();
+    }
+
+    void benchmarkGamutFunctions()
+    {
+        QFETCH(QString, profile);
+        QFETCH(LchDouble, color);
+        QSharedPointer<RgbColorSpace> space = colorSpace(profile);
+        if (space.isNull()) {
+            QSKIP("The profile is not available on this system.");
+        }
+        runGamutFunctions(*space, color);
+        QBENCHMARK {
+            runGamutFunctions(*space, color);
+        }
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestGamutLatency)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testgamutlatency.moc"
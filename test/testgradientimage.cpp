@@ -44,6 +44,44 @@ public:
         : QWidget(parent)
     {
     }
+    void testSetOrientation()
+    {
+        GradientImage myGradient(m_rgbColorSpace);
+        myGradient.setFirstColor(LchaDouble(20, 0, 0, 1));
+        myGradient.setSecondColor(LchaDouble(80, 0, 0, 1));
+        myGradient.setGradientLength(20);
+        myGradient.setGradientThickness(10);
+        const QImage horizontal = myGradient.getImage();
+        QCOMPARE(horizontal.size(), QSize(20, 10));
+        myGradient.setOrientation(Qt::Orientation::Vertical);
+        QCOMPARE(myGradient.m_image.isNull(), true);
+        const QImage vertical = myGradient.getImage();
+        QCOMPARE(vertical.size(), QSize(10, 20));
+        // The first color is at the bottom, the second color at the top.
+        QCOMPARE(vertical.pixel(0, 19), horizontal.pixel(0, 0));
+        QCOMPARE(vertical.pixel(0, 0), horizontal.pixel(19, 0));
+        // Changing back uses the variant cache and does not render.
+        myGradient.setOrientation(Qt::Orientation::Horizontal);
+        QCOMPARE(myGradient.getImage().cacheKey(), horizontal.cacheKey());
+    }
+
+    void testSetLayoutDirection()
+    {
+        GradientImage myGradient(m_rgbColorSpace);
+        myGradient.setFirstColor(LchaDouble(20, 0, 0, 1));
+        myGradient.setSecondColor(LchaDouble(80, 0, 0, 1));
+        myGradient.setGradientLength(20);
+        myGradient.setGradientThickness(10);
+        const QImage leftToRight = myGradient.getImage();
+        myGradient.setLayoutDirection(Qt::LayoutDirection::RightToLeft);
+        QCOMPARE(myGradient.m_image.isNull(), true);
+        const QImage rightToLeft = myGradient.getImage();
+        QCOMPARE(rightToLeft.size(), leftToRight.size());
+        // The image is mirrored.
+        QCOMPARE(rightToLeft.pixel(19, 0), leftToRight.pixel(0, 0));
+        QCOMPARE(rightToLeft.pixel(0, 0), leftToRight.pixel(19, 0));
+    }
+
     void testSnippet01()
     {
         //! [GradientImage HiDPI usage]
@@ -375,6 +375,20 @@ private Q_SLOTS:
         testSlider.repaint();
     }
 
+    void testPaintEventUsesCachedImage()
+    {
+        GradientSlider testSlider(m_rgbColorSpace, Qt::Vertical);
+        testSlider.show();
+        testSlider.repaint();
+        const QImage cached = testSlider.d_pointer->m_gradientImageCache.getImage();
+        // The cache is rendered in the final orientation…
+        QCOMPARE(cached.size(), testSlider.physicalPixelSize());
+        // … and painting neither renders nor detaches it.
+        testSlider.repaint();
+        testSlider.repaint();
+        QCOMPARE(testSlider.d_pointer->m_gradientImageCache.getImage().cacheKey(), cached.cacheKey());
+    }
+
     void testVerySmallWidgetSizes()
     {
         // Also very small widget sizes should not crash the widget.
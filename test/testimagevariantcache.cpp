@@ -0,0 +1,188 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "imagevariantcache.h"
+
+#include <QtTest>
+
+namespace PerceptualColor
+{
+class TestImageVariantCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestImageVariantCache(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    const QSizeF widgetSize {10, 10};
+
+    static QImage testImage(const int size)
+    {
+        QImage result(size, size, QImage::Format_ARGB32_Premultiplied);
+        result.fill(Qt::red);
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testConstructor()
+    {
+        ImageVariantCache<int> test;
+        QCOMPARE(test.size(), 0);
+    }
+
+    void testInsertAndValue()
+    {
+        ImageVariantCache<int> test;
+        const QImage imageOne = testImage(10);
+        const QImage imageTwo = testImage(20);
+        test.insert(1, imageOne, widgetSize);
+        test.insert(2, imageTwo, widgetSize);
+        QCOMPARE(test.size(), 2);
+        // The very same (implicitly shared) image is returned.
+        QCOMPARE(test.value(1).cacheKey(), imageOne.cacheKey());
+        QCOMPARE(test.value(2).cacheKey(), imageTwo.cacheKey());
+        // Unknown keys return a null image.
+        QVERIFY(test.value(3).isNull());
+    }
+
+    void testInsertReplaces()
+    {
+        ImageVariantCache<int> test;
+        test.insert(1, testImage(10), widgetSize);
+        const QImage newImage = testImage(10);
+        test.insert(1, newImage, widgetSize);
+        QCOMPARE(test.size(), 1);
+        QCOMPARE(test.value(1).cacheKey(), newImage.cacheKey());
+    }
+
+    void testInsertNullImage()
+    {
+        ImageVariantCache<int> test;
+        test.insert(1, QImage(), widgetSize);
+        QCOMPARE(test.size(), 0);
+    }
+
+    void testClear()
+    {
+        ImageVariantCache<int> test;
+        test.insert(1, testImage(10), widgetSize);
+        test.insert(2, testImage(10), widgetSize);
+        test.clear();
+        QCOMPARE(test.size(), 0);
+        QVERIFY(test.value(1).isNull());
+    }
+
+    void testDropsOtherWidgetSizes()
+    {
+        ImageVariantCache<int> test;
+        // Variants of the same widget for two monitors
+        test.insert(100, testImage(100), QSizeF(100, 100));
+        test.insert(200, testImage(200), QSizeF(100, 100));
+        QCOMPARE(test.size(), 2);
+        // Physical sizes are rounded, so widget sizes that differ by less
+        // than one pixel are considered equal.
+        test.insert(125, testImage(125), QSizeF(100.4, 100.4));
+        QCOMPARE(test.size(), 3);
+        // Resizing the widget: The variants of the old widget size are
+        // stale and dropped.
+        test.insert(110, testImage(110), QSizeF(110, 100));
+        QCOMPARE(test.size(), 1);
+        QVERIFY(test.value(100).isNull());
+        QVERIFY(test.value(200).isNull());
+        QVERIFY(test.value(125).isNull());
+        QVERIFY(!test.value(110).isNull());
+        // Interactive resizing does not let the cache grow.
+        for (int size = 120; size < 200; ++size) {
+            test.insert(size, testImage(10), QSizeF(size, size));
+        }
+        QCOMPARE(test.size(), 1);
+    }
+
+    void testBudget()
+    {
+        ImageVariantCache<int> test;
+        // Each image has 10 × 10 × 4 = 400 bytes.
+        test.setBudget(1000);
+        test.insert(1, testImage(10), widgetSize);
+        test.insert(2, testImage(10), widgetSize);
+        QCOMPARE(test.size(), 2);
+        // Use variant 1, so variant 2 becomes the least recently used one.
+        Q_UNUSED(test.value(1));
+        test.insert(3, testImage(10), widgetSize);
+        QCOMPARE(test.size(), 2);
+        QVERIFY(!test.value(1).isNull());
+        QVERIFY(test.value(2).isNull());
+        QVERIFY(!test.value(3).isNull());
+    }
+
+    void testBudgetKeepsNewest()
+    {
+        ImageVariantCache<int> test;
+        test.setBudget(10);
+        // An image that alone exceeds the budget is nevertheless kept.
+        test.insert(1, testImage(10), widgetSize);
+        QCOMPARE(test.size(), 1);
+        test.insert(2, testImage(10), widgetSize);
+        QCOMPARE(test.size(), 1);
+        QVERIFY(!test.value(2).isNull());
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestImageVariantCache)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testimagevariantcache.moc"
@@ -0,0 +1,138 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "labbuffer.h"
+
+#include <QtTest>
+
+#include "lchbuffer.h"
+
+namespace PerceptualColor
+{
+class TestLabBuffer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestLabBuffer(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testVectorRoundTrip()
+    {
+        QVector<cmsCIELab> colors(2);
+        colors[0].L = 10;
+        colors[0].a = -20;
+        colors[0].b = 30;
+        colors[1].L = 90;
+        colors[1].a = 5;
+        colors[1].b = -6;
+        const LabBuffer buffer = LabBuffer::fromVector(colors);
+        QCOMPARE(buffer.count(), 2);
+        QCOMPARE(buffer.a()[0], -20.0);
+        QCOMPARE(buffer.b()[1], -6.0);
+        const QVector<cmsCIELab> result = buffer.toVector();
+        QCOMPARE(result.count(), 2);
+        QCOMPARE(result.at(1).L, 90.0);
+        QCOMPARE(result.at(1).a, 5.0);
+        QCOMPARE(result.at(0).b, 30.0);
+    }
+
+    void testFromLch()
+    {
+        LchBuffer lch(3);
+        lch.set(0, LchDouble {50, 10, 0});
+        lch.set(1, LchDouble {60, 10, 90});
+        lch.set(2, LchDouble {70, 10, 180});
+        const LabBuffer lab = LabBuffer::fromLch(lch.view());
+        QCOMPARE(lab.l()[2], 70.0);
+        QVERIFY(qAbs(lab.a()[0] - 10) < 0.000001);
+        QVERIFY(qAbs(lab.b()[0]) < 0.000001);
+        QVERIFY(qAbs(lab.a()[1]) < 0.000001);
+        QVERIFY(qAbs(lab.b()[1] - 10) < 0.000001);
+        QVERIFY(qAbs(lab.a()[2] + 10) < 0.000001);
+    }
+
+    void testFromLchSlice()
+    {
+        LchBuffer lch(20);
+        lch.set(12, LchDouble {33, 0, 0});
+        const LabBuffer lab = LabBuffer::fromLch(lch.view().slice(10, 5));
+        QCOMPARE(lab.count(), 5);
+        QCOMPARE(lab.l()[2], 33.0);
+    }
+
+    void testFromLchIntoView()
+    {
+        LchBuffer lch(3);
+        lch.set(0, LchDouble {50, 10, 0});
+        lch.set(2, LchDouble {70, 20, 90});
+        // Write into a slice, to test that the plane stride is respected.
+        LabBuffer target(10);
+        LabBuffer::fromLch(lch.view(), target.view().slice(5, lch.count()));
+        const LabBuffer expected = LabBuffer::fromLch(lch.view());
+        for (int i = 0; i < lch.count(); ++i) {
+            QCOMPARE(target.l()[i + 5], expected.l()[i]);
+            QCOMPARE(target.a()[i + 5], expected.a()[i]);
+            QCOMPARE(target.b()[i + 5], expected.b()[i]);
+        }
+        QCOMPARE(target.l()[0], 0.0);
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestLabBuffer)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testlabbuffer.moc"
@@ -0,0 +1,145 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "latencyhistogram.h"
+
+#include <QtTest>
+
+#include <limits>
+
+namespace PerceptualColor
+{
+class TestLatencyHistogram : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestLatencyHistogram(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testEmpty()
+    {
+        LatencyHistogram histogram;
+        QCOMPARE(histogram.count(), 0);
+        QCOMPARE(histogram.maximum(), 0);
+        QCOMPARE(histogram.percentile(50), 0);
+    }
+
+    void testBucketBounds()
+    {
+        // Each value must be counted in a bucket whose upper bound is
+        // not smaller than the value, while the upper bound of the
+        // previous bucket is smaller than the value.
+        for (qint64 value = 0; value < 100000; ++value) {
+            const int index = LatencyHistogram::bucketIndex(value);
+            QVERIFY(LatencyHistogram::bucketUpperBound(index) >= value);
+            if (index > 0) {
+                QVERIFY(LatencyHistogram::bucketUpperBound(index - 1) < value);
+            }
+        }
+        QCOMPARE(LatencyHistogram::bucketIndex(-5), 0);
+        QCOMPARE(LatencyHistogram::bucketIndex(std::numeric_limits<qint64>::max()), //
+                 LatencyHistogram::bucketCount - 1);
+    }
+
+    void testPercentile()
+    {
+        LatencyHistogram histogram;
+        for (int i = 1; i <= 100; ++i) {
+            histogram.addSample(i * 1000);
+        }
+        QCOMPARE(histogram.count(), 100);
+        QCOMPARE(histogram.maximum(), 100000);
+        // The result is never smaller than the exact value, and at most
+        // 12.5 % bigger.
+        const QList<int> percentiles {1, 50, 95, 99};
+        for (const int percentile : percentiles) {
+            const qint64 exact = percentile * 1000;
+            QVERIFY(histogram.percentile(percentile) >= exact);
+            QVERIFY(histogram.percentile(percentile) <= exact * 1.125);
+        }
+        QCOMPARE(histogram.percentile(100), 100000);
+        // Out-of-range percentiles are bounded
+        QCOMPARE(histogram.percentile(200), 100000);
+        QVERIFY(histogram.percentile(-1) <= 1000 * 1.125);
+    }
+
+    void testClear()
+    {
+        LatencyHistogram histogram;
+        histogram.addSample(5);
+        histogram.addSample(50000);
+        histogram.clear();
+        QCOMPARE(histogram.count(), 0);
+        QCOMPARE(histogram.maximum(), 0);
+        QCOMPARE(histogram.percentile(99), 0);
+    }
+
+    void benchmarkAddSample()
+    {
+        LatencyHistogram histogram;
+        qint64 value = 0;
+        QBENCHMARK {
+            histogram.addSample(value);
+            value = (value + 7919) % 1000000;
+        }
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestLatencyHistogram)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testlatencyhistogram.moc"
@@ -0,0 +1,141 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "lchbuffer.h"
+
+#include <QtTest>
+
+#include "helper.h"
+#include "labbuffer.h"
+
+static QVector<PerceptualColor::LchDouble> snippet01()
+{
+    //! [Use LchBuffer]
+    QVector<PerceptualColor::LchDouble> colors {{50, 20, 30}, {70, 10, 200}};
+    PerceptualColor::LchBuffer buffer = PerceptualColor::LchBuffer::fromVector(colors);
+    // Work on a single channel:
+    double *lightness = buffer.l();
+    for (int i = 0; i < buffer.count(); ++i) {
+        lightness[i] += 5;
+    }
+    // Convert back:
+    colors = buffer.toVector();
+    //! [Use LchBuffer]
+    return colors;
+}
+
+namespace PerceptualColor
+{
+class TestLchBuffer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestLchBuffer(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testVectorRoundTrip()
+    {
+        const QVector<LchDouble> colors {{10, 20, 30}, {40, 50, 60}, {70, 80, 90}};
+        const LchBuffer buffer = LchBuffer::fromVector(colors);
+        QCOMPARE(buffer.count(), 3);
+        QCOMPARE(buffer.l()[1], 40.0);
+        QCOMPARE(buffer.c()[1], 50.0);
+        QCOMPARE(buffer.h()[1], 60.0);
+        const QVector<LchDouble> result = buffer.toVector();
+        QCOMPARE(result.count(), colors.count());
+        for (int i = 0; i < colors.count(); ++i) {
+            QVERIFY(result.at(i).hasSameCoordinates(colors.at(i)));
+        }
+    }
+
+    void testSetAndAt()
+    {
+        LchBuffer buffer(2);
+        buffer.set(1, LchDouble {1, 2, 3});
+        QVERIFY(buffer.at(1).hasSameCoordinates(LchDouble {1, 2, 3}));
+        QVERIFY(buffer.at(0).hasSameCoordinates(LchDouble {0, 0, 0}));
+    }
+
+    void testFromLab()
+    {
+        const QVector<LchDouble> colors {{50, 20, 30}, {60, 0, 0}, {70, 40, 200}, {80, 10, 359}};
+        const LabBuffer lab = LabBuffer::fromLch(LchBuffer::fromVector(colors).view());
+        const LchBuffer lch = LchBuffer::fromLab(lab.view());
+        QCOMPARE(lch.count(), colors.count());
+        for (int i = 0; i < colors.count(); ++i) {
+            QVERIFY(qAbs(lch.l()[i] - colors.at(i).l) < 0.000001);
+            QVERIFY(qAbs(lch.c()[i] - colors.at(i).c) < 0.000001);
+            if (colors.at(i).c > 0) {
+                QVERIFY(qAbs(lch.h()[i] - colors.at(i).h) < 0.000001);
+            }
+            QVERIFY(isInRange<double>(0, lch.h()[i], 360));
+        }
+    }
+
+    void testSnippet01()
+    {
+        const QVector<LchDouble> colors = snippet01();
+        QCOMPARE(colors.count(), 2);
+        QCOMPARE(colors.at(0).l, 55.0);
+        QCOMPARE(colors.at(1).h, 200.0);
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestLchBuffer)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testlchbuffer.moc"
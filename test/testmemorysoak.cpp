@@ -0,0 +1,319 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QtTest>
+
+#include "PerceptualColor/colordialog.h"
+#include "PerceptualColor/rgbcolorspacefactory.h"
+#include "rgbcolorspace.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <QFile>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Replacement of the global allocation functions. It counts the live
+// allocations of this process, including those of the library. (The
+// default implementations of the array, nothrow and sized variants call
+// these functions, so they are counted too.) Memory that is allocated
+// directly with malloc() – for example by QImage and by LittleCMS – is
+// not counted here; it is covered by heapBytesInUse() instead.
+namespace
+{
+std::atomic<qint64> liveAllocationCount {0};
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    void *result = std::malloc(size == 0 ? 1 : size);
+    if (result == nullptr) {
+        throw std::bad_alloc();
+    }
+    ++liveAllocationCount;
+    return result;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    if (pointer == nullptr) {
+        return;
+    }
+    --liveAllocationCount;
+    std::free(pointer);
+}
+
+// The aligned variants (used by PlanarBuffer) do not call the functions
+// above, so they are replaced separately.
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    const std::size_t alignmentSize = static_cast<std::size_t>(alignment);
+    // aligned_alloc() requires the size to be a multiple of the alignment.
+    const std::size_t roundedSize = //
+        ((size == 0 ? 1 : size) + alignmentSize - 1) / alignmentSize * alignmentSize;
+#if defined(_MSC_VER)
+    void *result = _aligned_malloc(roundedSize, alignmentSize);
+#else
+    void *result = std::aligned_alloc(alignmentSize, roundedSize);
+#endif
+    if (result == nullptr) {
+        throw std::bad_alloc();
+    }
+    ++liveAllocationCount;
+    return result;
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    if (pointer == nullptr) {
+        return;
+    }
+    --liveAllocationCount;
+#if defined(_MSC_VER)
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+namespace PerceptualColor
+{
+/** @brief Soak tests that create and destroy many objects and check
+ * that memory usage does not grow. */
+class TestMemorySoak : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestMemorySoak(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    /** @brief Number of iterations before the measurement starts.
+     *
+     * Allows lazily initialized static data and caches of Qt and of
+     * this library to reach their final size. */
+    static constexpr int warmUpIterations = 20;
+    /** @brief Tolerance for the growth of the number of live allocations.
+     *
+     * Independent of the number of iterations: Caches that have reached
+     * their final size during the warm-up might still fluctuate by a few
+     * entries, but any leak per iteration exceeds this limit. */
+    static constexpr qint64 allocationTolerance = 8;
+    /** @brief Tolerance for the growth of the heap memory in use,
+     * measured in bytes.
+     *
+     * Independent of the number of iterations. Covers also memory that
+     * is allocated directly with <tt>malloc()</tt>. */
+    static constexpr qint64 heapTolerance = 16 * 1024;
+    /** @brief Tolerance for the growth of the resident set size.
+     *
+     * The allocator does not necessarily return freed memory to the
+     * operating system, and fragmentation may vary a little. Therefore,
+     * this is only a coarse check for platforms where
+     * @ref heapBytesInUse() is not available. */
+    static constexpr qint64 rssTolerance = 2 * 1024 * 1024;
+
+    /** @brief Heap memory in use by this process.
+     *
+     * Includes memory allocated with <tt>malloc()</tt> directly, for
+     * example by QImage and by LittleCMS.
+     *
+     * @returns The number of bytes in use, or -1 if not available on
+     * this platform. */
+    static qint64 heapBytesInUse()
+    {
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 33)))
+        const struct mallinfo2 info = mallinfo2();
+        // Allocated chunks plus chunks that have been allocated with mmap()
+        return static_cast<qint64>(info.uordblks + info.hblkhd);
+#else
+        return -1;
+#endif
+    }
+
+    /** @brief Resident set size of this process.
+     *
+     * @returns The resident set size in bytes, or -1 if not available
+     * on this platform. */
+    static qint64 residentSetSize()
+    {
+        QFile status(QStringLiteral("/proc/self/status"));
+        if (!status.open(QIODevice::ReadOnly)) {
+            return -1;
+        }
+        const QByteArray prefix = QByteArrayLiteral("VmRSS:");
+        while (!status.atEnd()) {
+            const QByteArray line = status.readLine();
+            if (line.startsWith(prefix)) {
+                // The line has the form “VmRSS:     1234 kB”
+                const QList<QByteArray> fields = line.mid(prefix.size()).simplified().split(' ');
+                bool ok = false;
+                const qint64 kibibytes = fields.value(0).toLongLong(&ok);
+                return ok ? kibibytes * 1024 : -1;
+            }
+        }
+        return -1;
+    }
+
+    /** @brief Destroys objects that have been scheduled for deletion. */
+    static void processDeferredDeletes()
+    {
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        QCoreApplication::processEvents();
+    }
+
+    /** @brief Creates and destroys a color space. */
+    static void createAndDestroyColorSpace()
+    {
+        QSharedPointer<RgbColorSpace> colorSpace = RgbColorSpaceFactory::createSrgb();
+        // Out-of-gamut color, so that the nearest-neighbor search
+        // image is actually rendered.
+        colorSpace->nearestInGamutColorByAdjustingChromaLightness( //
+            LchDouble {50, 150, 30});
+    }
+
+    /** @brief Creates and destroys a color dialog with its own color
+     * space. */
+    static void createAndDestroyDialog()
+    {
+        ColorDialog *dialog = new ColorDialog(RgbColorSpaceFactory::createSrgb());
+        dialog->show();
+        QCoreApplication::processEvents();
+        delete dialog;
+        processDeferredDeletes();
+    }
+
+    /** @brief Runs a function many times and checks that memory
+     * usage does not grow.
+     *
+     * @param function The function to run
+     * @param iterations Number of iterations for the measurement */
+    template<typename T>
+    static void checkNoGrowth(T function, int iterations)
+    {
+        for (int i = 0; i < warmUpIterations; ++i) {
+            function();
+        }
+        processDeferredDeletes();
+        const qint64 allocationsBefore = liveAllocationCount;
+        const qint64 heapBefore = heapBytesInUse();
+        const qint64 rssBefore = residentSetSize();
+        for (int i = 0; i < iterations; ++i) {
+            function();
+        }
+        processDeferredDeletes();
+        const qint64 allocationGrowth = liveAllocationCount - allocationsBefore;
+        const qint64 heapGrowth = heapBytesInUse() - heapBefore;
+        const qint64 rssGrowth = residentSetSize() - rssBefore;
+        QVERIFY2(allocationGrowth <= allocationTolerance,
+                 qPrintable(QStringLiteral("Live allocations grew by %1.").arg(allocationGrowth)));
+        if (heapBefore >= 0) {
+            QVERIFY2(heapGrowth <= heapTolerance, //
+                     qPrintable(QStringLiteral("Heap memory in use grew by %1 bytes.").arg(heapGrowth)));
+        } else if (rssBefore >= 0) {
+            QVERIFY2(rssGrowth < rssTolerance, //
+                     qPrintable(QStringLiteral("Resident set size grew by %1 bytes.").arg(rssGrowth)));
+        }
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testAllocationCounter()
+    {
+        // Make sure that the counter works, otherwise the other
+        // tests would pass without testing anything.
+        const qint64 before = liveAllocationCount;
+        // Explicit calls, because the compiler is allowed to optimize
+        // away new-expressions.
+        void *const pointer = ::operator new(16);
+        QVERIFY(liveAllocationCount - before == 1);
+        ::operator delete(pointer);
+        QVERIFY(liveAllocationCount - before == 0);
+        void *const alignedPointer = ::operator new(16, std::align_val_t(64));
+        QVERIFY(liveAllocationCount - before == 1);
+        ::operator delete(alignedPointer, std::align_val_t(64));
+        QVERIFY(liveAllocationCount - before == 0);
+    }
+
+    void testHeapBytesInUse()
+    {
+        const qint64 before = heapBytesInUse();
+        if (before < 0) {
+            QSKIP("Not available on this platform.");
+        }
+        constexpr qint64 size = 1024 * 1024;
+        void *const pointer = std::malloc(size);
+        QVERIFY(pointer != nullptr);
+        QVERIFY(heapBytesInUse() - before >= size);
+        std::free(pointer);
+    }
+
+    void testColorSpaceSoak()
+    {
+        checkNoGrowth(&TestMemorySoak::createAndDestroyColorSpace, 2000);
+    }
+
+    void testColorDialogSoak()
+    {
+        checkNoGrowth(&TestMemorySoak::createAndDestroyDialog, 200);
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestMemorySoak)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testmemorysoak.moc"
@@ -394,6 +394,31 @@ private Q_SLOTS:
         QCOMPARE(myMulti.minimumSizeHint(), myMulti.sizeHint());
     }
 
+    void testSizeHintCache()
+    {
+        PerceptualColor::MultiSpinBox myMulti;
+        const QSize referenceSize = myMulti.sizeHint();
+        QVERIFY(myMulti.d_pointer->m_contentSizeHint.isValid());
+        // Changing the section configuration discards the cache.
+        QList<MultiSpinBoxSectionConfiguration> config;
+        MultiSpinBoxSectionConfiguration section;
+        section.setPrefix(QStringLiteral(u"abcdefghij"));
+        config.append(section);
+        myMulti.setSectionConfigurations(config);
+        QVERIFY(!myMulti.d_pointer->m_contentSizeHint.isValid());
+        QVERIFY(myMulti.sizeHint().width() > referenceSize.width());
+        // Changing the font discards the cache.
+        const int widthWithPrefix = myMulti.sizeHint().width();
+        QFont font = myMulti.font();
+        font.setPointSize(font.pointSize() * 2);
+        myMulti.setFont(font);
+        QVERIFY(!myMulti.d_pointer->m_contentSizeHint.isValid());
+        QVERIFY(myMulti.sizeHint().width() > widthWithPrefix);
+        // Changing the locale discards the cache.
+        myMulti.setLocale(QLocale(QLocale::German, QLocale::Germany));
+        QVERIFY(!myMulti.d_pointer->m_contentSizeHint.isValid());
+    }
+
     void testSizeHint()
     {
         PerceptualColor::MultiSpinBox myMulti;
@@ -1808,6 +1833,68 @@ private Q_SLOTS:
     {
         snippet02();
     }
+
+    void testSetCurrentSectionValueWithoutFurtherUpdating()
+    {
+        MultiSpinBox myMulti;
+        QList<MultiSpinBoxSectionConfiguration> myConfigurations = exampleConfigurations;
+        myConfigurations[0].setWrapping(true);
+        myMulti.setSectionConfigurations(myConfigurations);
+        QSignalSpy spy(&myMulti, &MultiSpinBox::sectionValuesChanged);
+        myMulti.d_pointer->setCurrentIndexWithoutUpdatingText(0);
+        // The first section is now wrapping between 0 and 360.
+        myMulti.d_pointer->setCurrentSectionValueWithoutFurtherUpdating(370);
+        QCOMPARE(myMulti.d_pointer->m_sectionValues.at(0), 10);
+        QCOMPARE(spy.count(), 1);
+        // Setting the same value again should not emit a signal.
+        myMulti.d_pointer->setCurrentSectionValueWithoutFurtherUpdating(10);
+        QCOMPARE(spy.count(), 1);
+        // The second section is not wrapping and bound between 0 and 100.
+        myMulti.d_pointer->setCurrentIndexWithoutUpdatingText(1);
+        myMulti.d_pointer->setCurrentSectionValueWithoutFurtherUpdating(150);
+        QCOMPARE(myMulti.d_pointer->m_sectionValues.at(1), 100);
+        QCOMPARE(myMulti.d_pointer->m_sectionValues.at(0), 10);
+        QCOMPARE(spy.count(), 2);
+    }
+
+    void testStepByUpdatesText()
+    {
+        MultiSpinBox myMulti;
+        myMulti.setSectionConfigurations(exampleConfigurations);
+        myMulti.d_pointer->setCurrentIndexAndUpdateTextAndSelectValue(1);
+        myMulti.stepBy(5);
+        QCOMPARE(myMulti.sectionValues().at(1), 5);
+        QCOMPARE(myMulti.lineEdit()->text(), QStringLiteral(u"0°  5%  0"));
+        myMulti.d_pointer->setCurrentIndexAndUpdateTextAndSelectValue(0);
+        myMulti.stepBy(359);
+        QCOMPARE(myMulti.sectionValues().at(0), 359);
+        QCOMPARE(myMulti.lineEdit()->text(), QStringLiteral(u"359°  5%  0"));
+    }
+
+    void benchmarkUpdateCurrentValueFromText()
+    {
+        MultiSpinBox myMulti;
+        myMulti.setSectionConfigurations(exampleConfigurations);
+        myMulti.d_pointer->setCurrentIndexAndUpdateTextAndSelectValue(0);
+        // Simulates sustained typing within the first section.
+        const QString text1 = QStringLiteral(u"45°  0%  0");
+        const QString text2 = QStringLiteral(u"46°  0%  0");
+        QBENCHMARK {
+            myMulti.d_pointer->updateCurrentValueFromText(text1);
+            myMulti.d_pointer->updateCurrentValueFromText(text2);
+        }
+    }
+
+    void benchmarkStepBy()
+    {
+        MultiSpinBox myMulti;
+        myMulti.setSectionConfigurations(exampleConfigurations);
+        myMulti.d_pointer->setCurrentIndexAndUpdateTextAndSelectValue(0);
+        // Simulates auto-repeat of the step-up button.
+        QBENCHMARK {
+            myMulti.stepBy(1);
+        }
+    }
 };
 
 } // namespace PerceptualColor
@@ -0,0 +1,180 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+// First included header is the public header of the class we are testing;
+// this forces the header to be self-contained.
+#include "planarbuffer.h"
+
+#include <QtTest>
+
+#include <cstdint>
+
+namespace PerceptualColor
+{
+class TestPlanarBuffer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestPlanarBuffer(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    static bool isAligned(const double *pointer)
+    {
+        return (reinterpret_cast<std::uintptr_t>(pointer) % PlanarBuffer::alignment) == 0;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testEmpty()
+    {
+        PlanarBuffer buffer;
+        QCOMPARE(buffer.count(), 0);
+        QCOMPARE(buffer.planeStride(), 0);
+        QCOMPARE(buffer.view().count(), 0);
+        PlanarBuffer negative(-5);
+        QCOMPARE(negative.count(), 0);
+    }
+
+    void testAlignment_data()
+    {
+        QTest::addColumn<int>("count");
+        QTest::newRow("1") << 1;
+        QTest::newRow("7") << 7;
+        QTest::newRow("8") << 8;
+        QTest::newRow("9") << 9;
+        QTest::newRow("1000") << 1000;
+    }
+
+    void testAlignment()
+    {
+        QFETCH(int, count);
+        PlanarBuffer buffer(count);
+        QCOMPARE(buffer.count(), count);
+        QVERIFY(buffer.planeStride() >= count);
+        QCOMPARE(buffer.planeStride() % 8, 0);
+        for (int i = 0; i < PlanarBuffer::planeCount; ++i) {
+            QVERIFY(isAligned(buffer.plane(i)));
+            for (int j = 0; j < count; ++j) {
+                QCOMPARE(buffer.plane(i)[j], 0.0);
+            }
+        }
+    }
+
+    void testCopyAndMove()
+    {
+        PlanarBuffer buffer(3);
+        buffer.plane(0)[2] = 1;
+        buffer.plane(2)[0] = 2;
+        PlanarBuffer copy(buffer);
+        QCOMPARE(copy.count(), 3);
+        QCOMPARE(copy.plane(0)[2], 1.0);
+        QCOMPARE(copy.plane(2)[0], 2.0);
+        // The copy is deep:
+        copy.plane(0)[2] = 5;
+        QCOMPARE(buffer.plane(0)[2], 1.0);
+        PlanarBuffer moved(std::move(copy));
+        QCOMPARE(moved.plane(0)[2], 5.0);
+        QCOMPARE(copy.count(), 0);
+        PlanarBuffer assigned;
+        assigned = moved;
+        QCOMPARE(assigned.plane(2)[0], 2.0);
+    }
+
+    void testResize()
+    {
+        PlanarBuffer buffer(4);
+        for (int i = 0; i < 4; ++i) {
+            buffer.plane(0)[i] = i;
+            buffer.plane(1)[i] = 10 + i;
+            buffer.plane(2)[i] = 20 + i;
+        }
+        buffer.resize(20);
+        QCOMPARE(buffer.count(), 20);
+        for (int i = 0; i < 4; ++i) {
+            QCOMPARE(buffer.plane(0)[i], static_cast<double>(i));
+            QCOMPARE(buffer.plane(1)[i], static_cast<double>(10 + i));
+            QCOMPARE(buffer.plane(2)[i], static_cast<double>(20 + i));
+        }
+        QCOMPARE(buffer.plane(1)[19], 0.0);
+        buffer.resize(2);
+        QCOMPARE(buffer.count(), 2);
+        QCOMPARE(buffer.plane(2)[1], 21.0);
+    }
+
+    void testSlice()
+    {
+        PlanarBuffer buffer(10);
+        for (int i = 0; i < 10; ++i) {
+            buffer.plane(1)[i] = i;
+        }
+        const PlanarView<double> slice = buffer.view().slice(3, 4);
+        QCOMPARE(slice.count(), 4);
+        QCOMPARE(slice.planeStride(), buffer.planeStride());
+        QCOMPARE(slice.plane(1)[0], 3.0);
+        slice.plane(1)[0] = 42;
+        QCOMPARE(buffer.plane(1)[3], 42.0);
+        // Out-of-range values are bound:
+        QCOMPARE(buffer.view().slice(8, 5).count(), 2);
+        QCOMPARE(buffer.view().slice(-3, 2).plane(1)[0], 0.0);
+        QCOMPARE(buffer.view().slice(20, 2).count(), 0);
+        // Modifiable views convert to read-only views:
+        const PlanarView<const double> constSlice = slice;
+        QCOMPARE(constSlice.plane(1)[0], 42.0);
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestPlanarBuffer)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testplanarbuffer.moc"
@@ -33,9 +33,13 @@
 // Second, the private implementation.
 #include "rgbcolorspace_p.h"
 
+#include <QFile>
+#include <QTemporaryDir>
 #include <QtTest>
 
 #include "PerceptualColor/rgbcolorspacefactory.h"
+#include "labbuffer.h"
+#include "lchbuffer.h"
 
 namespace PerceptualColor
 {
@@ -97,6 +101,352 @@ private Q_SLOTS:
         QCOMPARE(nearestInGamutColor.c, 0);
         QCOMPARE(nearestInGamutColor.h, 10);
     }
+
+    void testCuspTable()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        const LchDouble myCusp = myColorSpace->d_pointer->cusp(40);
+        QCOMPARE(myColorSpace->d_pointer->m_cuspTable.count(), 360 * RgbColorSpace::RgbColorSpacePrivate::cuspTableResolution);
+        QCOMPARE(myCusp.h, 40);
+        QVERIFY(myCusp.c > 0);
+        // The cusp is at the boundary of the gamut:
+        QVERIFY(myColorSpace->isInGamut(LchDouble {myCusp.l, myCusp.c * 0.95, myCusp.h}));
+        QVERIFY(!myColorSpace->isInGamut(LchDouble {myCusp.l, myCusp.c * 1.05, myCusp.h}));
+        // Hue values are normalized:
+        const LchDouble myNormalizedCusp = myColorSpace->d_pointer->cusp(400);
+        QCOMPARE(myNormalizedCusp.h, 40);
+        QCOMPARE(myNormalizedCusp.l, myCusp.l);
+        QCOMPARE(myNormalizedCusp.c, myCusp.c);
+    }
+
+    void testNearestInGamutColorByCuspMapping()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        // In-gamut colors do not change:
+        const LchDouble inGamut {50, 10, 30};
+        const LchDouble unchanged = myColorSpace->nearestInGamutColorByCuspMapping(inGamut);
+        QCOMPARE(unchanged.l, inGamut.l);
+        QCOMPARE(unchanged.c, inGamut.c);
+        QCOMPARE(unchanged.h, inGamut.h);
+        // Out-of-gamut colors are mapped into the gamut, preserving the hue:
+        const QList<LchDouble> outOfGamut { //
+            LchDouble {50, 150, 30},
+            LchDouble {95, 100, 250},
+            LchDouble {5, 100, 120},
+            LchDouble {120, 20, 0},
+            LchDouble {-20, 20, 0}};
+        for (const LchDouble &color : outOfGamut) {
+            const LchDouble mapped = myColorSpace->nearestInGamutColorByCuspMapping(color);
+            QVERIFY(myColorSpace->isInGamut(mapped));
+            QCOMPARE(mapped.h, color.h);
+            QVERIFY(mapped.c <= color.c);
+        }
+    }
+
+    void testNearestInGamutColorByAdjustingChromaPrecision()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        const LchDouble outOfGamut {50, 150, 30};
+        const LchDouble exact = myColorSpace->nearestInGamutColorByAdjustingChroma(outOfGamut);
+        const LchDouble coarse = myColorSpace->nearestInGamutColorByAdjustingChroma( //
+            outOfGamut,
+            interactiveGamutPrecision);
+        // Both are in-gamut; the coarse result is at most
+        // interactiveGamutPrecision below the exact one.
+        QVERIFY(myColorSpace->isInGamut(exact));
+        QVERIFY(myColorSpace->isInGamut(coarse));
+        QCOMPARE(coarse.l, exact.l);
+        QCOMPARE(coarse.h, exact.h);
+        QVERIFY(coarse.c <= exact.c + gamutPrecision);
+        QVERIFY(exact.c - coarse.c <= interactiveGamutPrecision + gamutPrecision);
+    }
+
+    void testGamutBoundaryQueries()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        // Public cusp and private cusp agree:
+        const LchDouble myCusp = myColorSpace->cusp(40);
+        QCOMPARE(myCusp.l, myColorSpace->d_pointer->cusp(40).l);
+        QCOMPARE(myCusp.c, myColorSpace->d_pointer->cusp(40).c);
+        // Batch cusp:
+        LchBuffer myBuffer = LchBuffer::fromVector({LchDouble {0, 0, 40}, LchDouble {0, 0, 400}});
+        myColorSpace->cusp(myBuffer.view());
+        for (int i = 0; i < 2; ++i) {
+            QCOMPARE(myBuffer.l()[i], myCusp.l);
+            QCOMPARE(myBuffer.c()[i], myCusp.c);
+            QCOMPARE(myBuffer.h()[i], 40.);
+        }
+        // Maximum chroma:
+        const qreal exact = myColorSpace->maximumInGamutChroma(50, 30, gamutPrecision);
+        QVERIFY(myColorSpace->isInGamut(LchDouble {50, exact, 30}));
+        QVERIFY(!myColorSpace->isInGamut(LchDouble {50, exact + 2 * gamutPrecision, 30}));
+        QVERIFY(qAbs(myColorSpace->maximumInGamutChroma(50, 30) - exact) < 1);
+        // Lightness range:
+        const QPair<qreal, qreal> myRange = myColorSpace->lightnessRange(30, exact - 5);
+        QVERIFY(myRange.first < 50);
+        QVERIFY(myRange.second > 50);
+    }
+
+    void benchmarkMaximumInGamutChroma()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        // Build the table before measuring:
+        myColorSpace->maximumInGamutChroma(50, 0);
+        LchBuffer myBuffer(1000);
+        for (int i = 0; i < myBuffer.count(); ++i) {
+            myBuffer.l()[i] = (i % 97) + 1.5;
+            myBuffer.h()[i] = i * 0.37;
+        }
+        QBENCHMARK {
+            myColorSpace->maximumInGamutChroma(myBuffer.view());
+        }
+    }
+
+    void testRenderingIntent()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        const LchDouble myColor {50, 30, 120};
+        // The default rendering intent uses the default transforms:
+        QCOMPARE(myColorSpace->toQColorRgbBound(myColor, RenderingIntent()), //
+                 myColorSpace->toQColorRgbBound(myColor));
+        QCOMPARE(myColorSpace->d_pointer->m_intentTransforms.count(), 0);
+
+        // Transforms are created on first use…
+        RenderingIntent myPerceptual;
+        myPerceptual.intent = INTENT_PERCEPTUAL;
+        const QColor myRgb = myColorSpace->toQColorRgbBound(myColor, myPerceptual);
+        QVERIFY(myRgb.isValid());
+        QCOMPARE(myColorSpace->d_pointer->m_intentTransforms.count(), 1);
+        const cmsHTRANSFORM myHandle = myColorSpace->d_pointer->intentTransforms(myPerceptual).labToRgb16Handle;
+        QVERIFY(myHandle != nullptr);
+        QVERIFY(myHandle != myColorSpace->d_pointer->m_transformLabToRgb16Handle);
+
+        // …and reused afterwards:
+        RenderingIntent myRelativeBpc;
+        myRelativeBpc.intent = INTENT_RELATIVE_COLORIMETRIC;
+        myRelativeBpc.blackPointCompensation = true;
+        myColorSpace->toQColorRgbBound(myColor, myRelativeBpc);
+        myColorSpace->toQColorRgbBound(myColor, myPerceptual);
+        myColorSpace->toLch(myRgb, myPerceptual);
+        QCOMPARE(myColorSpace->d_pointer->m_intentTransforms.count(), 2);
+        QCOMPARE(myColorSpace->d_pointer->intentTransforms(myPerceptual).labToRgb16Handle, myHandle);
+
+        // Round trip
+        const LchDouble myRoundTrip = myColorSpace->toLch(myRgb, myPerceptual);
+        QVERIFY(qAbs(myRoundTrip.l - myColor.l) < 1);
+        QVERIFY(qAbs(myRoundTrip.c - myColor.c) < 1);
+        QVERIFY(qAbs(myRoundTrip.h - myColor.h) < 1);
+    }
+
+    void benchmarkNearestInGamutColorByCuspMapping()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        // Build the cusp table before measuring:
+        myColorSpace->nearestInGamutColorByCuspMapping(LchDouble {50, 150, 0});
+        qreal hue = 0;
+        QBENCHMARK {
+            myColorSpace->nearestInGamutColorByCuspMapping(LchDouble {70, 150, hue});
+            hue += 7;
+        }
+    }
+
+    void testMemoryArena()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        // The color space should have its own context…
+        QVERIFY(myColorSpace->d_pointer->m_context != nullptr);
+        // … which allocates its memory from the arena.
+        QVERIFY(myColorSpace->d_pointer->m_memoryArena.allocationCount() > 0);
+        QVERIFY(myColorSpace->d_pointer->m_memoryArena.reservedBytes() > 0);
+    }
+
+    void testProfileData()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        const QByteArray data = myColorSpace->profileData();
+        QVERIFY(!data.isEmpty());
+        // The data is a valid ICC profile…
+        cmsHPROFILE profile = cmsOpenProfileFromMem(data.constData(), static_cast<cmsUInt32Number>(data.size()));
+        QVERIFY(profile != nullptr);
+        QCOMPARE(cmsGetColorSpace(profile), cmsSigRgbData);
+        cmsCloseProfile(profile);
+        // … and identical for identical color spaces.
+        QCOMPARE(RgbColorSpace::createSrgb()->profileData(), data);
+    }
+
+    void testToQRgbUnboundBatch()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        LchBuffer lch(50);
+        for (int i = 0; i < lch.count(); ++i) {
+            lch.set(i, LchDouble {50, static_cast<double>(i * 3), static_cast<double>(i * 7)});
+        }
+        const LabBuffer lab = LabBuffer::fromLch(lch.view());
+        QVector<QRgb> fromLab(lab.count());
+        QVector<QRgb> fromLch(lch.count());
+        myColorSpace->toQRgbUnbound(lab.view(), fromLab.data());
+        // The scratch buffer may be bigger than needed.
+        LabBuffer scratch(lch.count() + 10);
+        myColorSpace->toQRgbUnboundFromLch(lch.view(), scratch.view(), fromLch.data());
+        for (int i = 0; i < lch.count(); ++i) {
+            QCOMPARE(fromLch.at(i), fromLab.at(i));
+            // The scratch buffer receives the Lab values.
+            QCOMPARE(scratch.l()[i], lab.l()[i]);
+            QCOMPARE(scratch.a()[i], lab.a()[i]);
+            QCOMPARE(scratch.b()[i], lab.b()[i]);
+            const QColor single = myColorSpace->toQColorRgbUnbound(lch.at(i));
+            if (single.isValid()) {
+                QCOMPARE(qAlpha(fromLab.at(i)), 255);
+                QVERIFY(qAbs(qRed(fromLab.at(i)) - single.red()) <= 1);
+                QVERIFY(qAbs(qGreen(fromLab.at(i)) - single.green()) <= 1);
+                QVERIFY(qAbs(qBlue(fromLab.at(i)) - single.blue()) <= 1);
+            } else {
+                QCOMPARE(fromLab.at(i), static_cast<QRgb>(0));
+            }
+        }
+    }
+
+    void testIsInGamutBatch()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        // The sRGB transforms are unbounded, so no round trip is needed.
+        QCOMPARE(myColorSpace->d_pointer->m_isLabToRgbBounded, false);
+        LchBuffer lch(50);
+        for (int i = 0; i < lch.count(); ++i) {
+            lch.set(i, LchDouble {static_cast<double>(i * 2), static_cast<double>(i * 3), static_cast<double>(i * 7)});
+        }
+        const LabBuffer lab = LabBuffer::fromLch(lch.view());
+        QVector<RgbDouble> rgb(lab.count());
+        myColorSpace->toRgbDoubleUnbound(lab.view(), rgb.data());
+        QVector<bool> batch(lab.count());
+        myColorSpace->isInGamut(lab.view(), rgb.constData(), batch.data());
+        for (int i = 0; i < lch.count(); ++i) {
+            QCOMPARE(batch.at(i), myColorSpace->isInGamut(lch.at(i)));
+        }
+    }
+
+    void testToRgbDoubleBoundBatch()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        LchBuffer lch(50);
+        for (int i = 0; i < lch.count(); ++i) {
+            lch.set(i, LchDouble {static_cast<double>(i * 2), static_cast<double>(i * 3), static_cast<double>(i * 7)});
+        }
+        const LabBuffer lab = LabBuffer::fromLch(lch.view());
+        QVector<RgbDouble> rgb(lab.count());
+        myColorSpace->toRgbDoubleBound(lab.view(), rgb.data());
+        for (int i = 0; i < lch.count(); ++i) {
+            // Same clipping as the single-value function:
+            const QColor single = myColorSpace->toQColorRgbBound(lch.at(i));
+            QVERIFY(qAbs(rgb.at(i).red - single.redF()) < 0.001);
+            QVERIFY(qAbs(rgb.at(i).green - single.greenF()) < 0.001);
+            QVERIFY(qAbs(rgb.at(i).blue - single.blueF()) < 0.001);
+        }
+    }
+
+    void testLinearRgb()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        const QVector<QRgb> rgb {qRgb(0, 128, 255), qRgb(5, 51, 204)};
+        QVector<RgbDouble> linear(rgb.count());
+        myColorSpace->toLinearRgb(rgb.constData(), linear.data(), rgb.count());
+        // Values of the sRGB transfer function
+        QVERIFY(qAbs(linear.at(0).red - 0) < 0.001);
+        QVERIFY(qAbs(linear.at(0).green - 0.216) < 0.001);
+        QVERIFY(qAbs(linear.at(0).blue - 1) < 0.001);
+        QVERIFY(qAbs(linear.at(1).red - 5 / 255.0 / 12.92) < 0.001);
+        QVector<QRgb> roundTrip(rgb.count());
+        myColorSpace->fromLinearRgb(linear.constData(), roundTrip.data(), rgb.count());
+        QCOMPARE(roundTrip, rgb);
+    }
+
+    void testLinearRgbRoundTrip()
+    {
+        // The tables are precise enough for an exact round trip
+        // of all 8-bit values.
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        QVector<QRgb> rgb;
+        for (int i = 0; i < 256; ++i) {
+            rgb.append(qRgb(i, 255 - i, i));
+        }
+        QVector<RgbDouble> linear(rgb.count());
+        myColorSpace->toLinearRgb(rgb.constData(), linear.data(), rgb.count());
+        QVector<QRgb> roundTrip(rgb.count());
+        myColorSpace->fromLinearRgb(linear.constData(), roundTrip.data(), rgb.count());
+        QCOMPARE(roundTrip, rgb);
+    }
+
+    void testLinearRgbOfProfile()
+    {
+        // A profile with a linear tone curve: The transfer function of
+        // the profile is used, and not the one of sRGB.
+        QTemporaryDir temporaryDir;
+        QVERIFY(temporaryDir.isValid());
+        cmsCIExyY whitePoint;
+        cmsWhitePointFromTemp(&whitePoint, 6504);
+        const cmsCIExyYTRIPLE primaries {{0.64, 0.33, 1}, // red
+                                         {0.30, 0.60, 1}, // green
+                                         {0.15, 0.06, 1}}; // blue
+        cmsToneCurve *gamma = cmsBuildGamma(nullptr, 1.0);
+        cmsToneCurve *curves[3] {gamma, gamma, gamma};
+        cmsHPROFILE profile = cmsCreateRGBProfile(&whitePoint, &primaries, curves);
+        cmsFreeToneCurve(gamma);
+        const QString fileName = temporaryDir.filePath(QStringLiteral("linear.icc"));
+        cmsSaveProfileToFile(profile, QFile::encodeName(fileName).constData());
+        cmsCloseProfile(profile);
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createFromFile(fileName);
+        QVERIFY(!myColorSpace.isNull());
+        const QRgb rgb = qRgb(25, 128, 230);
+        RgbDouble linear;
+        myColorSpace->toLinearRgb(&rgb, &linear, 1);
+        QVERIFY(qAbs(linear.red - 25 / 255.0) < 0.001);
+        QVERIFY(qAbs(linear.green - 128 / 255.0) < 0.001);
+        QVERIFY(qAbs(linear.blue - 230 / 255.0) < 0.001);
+    }
+
+    void testToCielabPlanar()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        QVector<RgbDouble> rgb(20);
+        for (int i = 0; i < rgb.count(); ++i) {
+            rgb[i].red = i / 20.0;
+            rgb[i].green = 1 - i / 20.0;
+            rgb[i].blue = 0.5;
+        }
+        QVector<cmsCIELab> expected(rgb.count());
+        myColorSpace->toCielab(rgb.constData(), expected.data(), rgb.count());
+        // Write into a slice, to test that the plane stride is respected.
+        LabBuffer lab(rgb.count() + 10);
+        myColorSpace->toCielab(rgb.constData(), lab.view().slice(10, rgb.count()));
+        for (int i = 0; i < rgb.count(); ++i) {
+            QVERIFY(qAbs(lab.l()[i + 10] - expected.at(i).L) < 0.0001);
+            QVERIFY(qAbs(lab.a()[i + 10] - expected.at(i).a) < 0.0001);
+            QVERIFY(qAbs(lab.b()[i + 10] - expected.at(i).b) < 0.0001);
+        }
+        QCOMPARE(lab.l()[0], 0.0);
+    }
+
+    void benchmarkToQRgbUnboundBatch()
+    {
+        QSharedPointer<PerceptualColor::RgbColorSpace> myColorSpace = RgbColorSpace::createSrgb();
+        LabBuffer lab(1000);
+        for (int i = 0; i < lab.count(); ++i) {
+            lab.l()[i] = 50;
+            lab.a()[i] = i / 10.0 - 50;
+            lab.b()[i] = 20;
+        }
+        QVector<QRgb> rgb(lab.count());
+        QBENCHMARK {
+            myColorSpace->toQRgbUnbound(lab.view(), rgb.data());
+        }
+    }
+
+    void benchmarkCreateSrgb()
+    {
+        QBENCHMARK {
+            RgbColorSpace::createSrgb();
+        }
+    }
 };
 
 } // namespace PerceptualColor
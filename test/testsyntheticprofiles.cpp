@@ -0,0 +1,466 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include <QtTest>
+
+#include "PerceptualColor/lchdouble.h"
+#include "PerceptualColor/rgbcolorspacefactory.h"
+#include "chromalightnessimage.h"
+#include "labbuffer.h"
+#include "rgbcolorspace.h"
+#include "rgbdouble.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QVector>
+#include <QtMath>
+
+#include <lcms2.h>
+
+namespace PerceptualColor
+{
+/** @brief Tests and benchmarks on a corpus of synthetic ICC profiles.
+ *
+ * The performance of LittleCMS differs greatly between matrix/TRC
+ * profiles and LUT-based profiles (A2B/B2A). The corpus is generated at
+ * test time with LittleCMS, so the tests run offline and do not depend on
+ * the profiles installed on the system. It contains:
+ *
+ * - Matrix-shaper profiles with a simple gamma curve, with a parametric
+ *   curve (like sRGB) and with a tabulated curve.
+ * - LUT-based profiles with 17³ and 33³ CLUTs, sampled from a
+ *   matrix-shaper profile.
+ * - Each of them with a black point at zero and with a lifted black
+ *   point. */
+class TestSyntheticProfiles : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestSyntheticProfiles(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private:
+    /** @brief The kind of the tone curves or of the LUT. */
+    enum class Kind {
+        Gamma, /**< Matrix-shaper with a gamma curve */
+        Parametric, /**< Matrix-shaper with a parametric curve */
+        Tabulated, /**< Matrix-shaper with a tabulated curve */
+        Clut /**< LUT-based with A2B0 and B2A0 */
+    };
+
+    /** @brief Description of a profile of the corpus. */
+    struct ProfileDescription {
+        /** @brief Name of the profile, also used as file name. */
+        QString name;
+        /** @brief Kind of the profile. */
+        Kind kind;
+        /** @brief Number of grid points per dimension (only for
+         * @ref Kind::Clut). */
+        int gridPoints;
+        /** @brief Relative luminance of RGB black. 0 means a black point
+         * at zero. */
+        double blackLevel;
+    };
+
+    /** @brief Relative luminance of the lifted black points. */
+    static constexpr double liftedBlackLevel = 0.02;
+
+    /** @brief Directory that contains the corpus. */
+    QTemporaryDir m_corpusDirectory;
+
+    /** @brief The profiles of the corpus. */
+    static QVector<ProfileDescription> corpus()
+    {
+        QVector<ProfileDescription> result;
+        for (const double blackLevel : {0.0, liftedBlackLevel}) {
+            const QString suffix = (blackLevel > 0) //
+                ? QStringLiteral("-liftedblack")
+                : QString();
+            result.append({QStringLiteral("gamma") + suffix, Kind::Gamma, 0, blackLevel});
+            result.append({QStringLiteral("parametric") + suffix, Kind::Parametric, 0, blackLevel});
+            result.append({QStringLiteral("tabulated") + suffix, Kind::Tabulated, 0, blackLevel});
+            result.append({QStringLiteral("clut17") + suffix, Kind::Clut, 17, blackLevel});
+            result.append({QStringLiteral("clut33") + suffix, Kind::Clut, 33, blackLevel});
+        }
+        return result;
+    }
+
+    /** @brief File name of a profile of the corpus. */
+    QString fileName(const ProfileDescription &profile) const
+    {
+        return m_corpusDirectory.filePath(profile.name + QStringLiteral(".icc"));
+    }
+
+    /** @brief Creates a tone curve.
+     *
+     * All curves map 0 to the black level and 1 to 1.
+     *
+     * @param kind The kind of the curve. @ref Kind::Clut is treated like
+     *        @ref Kind::Parametric.
+     * @param blackLevel The black level
+     * @returns The curve. The caller has to free it with
+     * <tt>cmsFreeToneCurve()</tt>. */
+    static cmsToneCurve *createToneCurve(Kind kind, double blackLevel)
+    {
+        const double range = 1 - blackLevel;
+        switch (kind) {
+        case Kind::Gamma: {
+            // Type 5: Y = (aX + b)^g + e for X ≥ d; Y = cX + f for X < d
+            const double gamma = 2.2;
+            const double parameters[7] = {gamma, qPow(range, 1 / gamma), 0, 0, 0, blackLevel, blackLevel};
+            return cmsBuildParametricToneCurve(nullptr, 5, parameters);
+        }
+        case Kind::Tabulated: {
+            QVector<cmsUInt16Number> table(1024);
+            for (int i = 0; i < table.count(); ++i) {
+                const double x = static_cast<double>(i) / (table.count() - 1);
+                const double y = blackLevel + range * qPow(x, 2.2);
+                table[i] = static_cast<cmsUInt16Number>(qRound(y * 65535));
+            }
+            return cmsBuildTabulatedToneCurve16(nullptr, table.count(), table.constData());
+        }
+        case Kind::Parametric:
+        case Kind::Clut:
+            break;
+        }
+        // The sRGB curve, scaled to the range between black level and 1.
+        const double gamma = 2.4;
+        const double scale = qPow(range, 1 / gamma);
+        const double parameters[7] = {gamma,
+                                      scale / 1.055,
+                                      scale * 0.055 / 1.055,
+                                      range / 12.92,
+                                      0.04045,
+                                      blackLevel,
+                                      blackLevel};
+        return cmsBuildParametricToneCurve(nullptr, 5, parameters);
+    }
+
+    /** @brief Creates a matrix-shaper profile with sRGB primaries.
+     *
+     * @returns The profile. The caller has to close it with
+     * <tt>cmsCloseProfile()</tt>. */
+    static cmsHPROFILE createMatrixShaperProfile(Kind kind, double blackLevel)
+    {
+        cmsCIExyY whitePoint;
+        cmsWhitePointFromTemp(&whitePoint, 6504);
+        const cmsCIExyYTRIPLE primaries = {{0.6400, 0.3300, 1}, //
+                                           {0.3000, 0.6000, 1},
+                                           {0.1500, 0.0600, 1}};
+        cmsToneCurve *curve = createToneCurve(kind, blackLevel);
+        cmsToneCurve *curves[3] = {curve, curve, curve};
+        cmsHPROFILE result = cmsCreateRGBProfile(&whitePoint, &primaries, curves);
+        cmsFreeToneCurve(curve);
+        return result;
+    }
+
+    /** @brief Sampler for <tt>cmsStageSampleCLut16bit()</tt>.
+     *
+     * @param in Input values
+     * @param out Output values
+     * @param cargo The transform that is sampled
+     * @returns Always <tt>TRUE</tt>, to continue sampling. */
+    static cmsInt32Number sampleTransform(const cmsUInt16Number in[], cmsUInt16Number out[], void *cargo)
+    {
+        cmsDoTransform(static_cast<cmsHTRANSFORM>(cargo), in, out, 1);
+        return TRUE;
+    }
+
+    /** @brief Creates a pipeline with a CLUT that samples a transform.
+     *
+     * @returns The pipeline. The caller has to free it with
+     * <tt>cmsPipelineFree()</tt>. */
+    static cmsPipeline *createClutPipeline(cmsHTRANSFORM transform, int gridPoints)
+    {
+        cmsPipeline *result = cmsPipelineAlloc(nullptr, 3, 3);
+        cmsStage *clut = cmsStageAllocCLut16bit( //
+            nullptr,
+            static_cast<cmsUInt32Number>(gridPoints),
+            3,
+            3,
+            nullptr);
+        cmsStageSampleCLut16bit(clut, &sampleTransform, transform, 0);
+        cmsPipelineInsertStage(result, cmsAT_END, clut);
+        return result;
+    }
+
+    /** @brief Creates a LUT-based profile.
+     *
+     * The A2B0 and B2A0 tables sample a matrix-shaper profile with a
+     * parametric curve.
+     *
+     * @returns The profile. The caller has to close it with
+     * <tt>cmsCloseProfile()</tt>. */
+    static cmsHPROFILE createClutProfile(int gridPoints, double blackLevel)
+    {
+        cmsHPROFILE source = createMatrixShaperProfile(Kind::Parametric, blackLevel);
+        cmsHPROFILE lab = cmsCreateLab4Profile(nullptr);
+        cmsHTRANSFORM toLab = cmsCreateTransform( //
+            source,
+            TYPE_RGB_16,
+            lab,
+            TYPE_Lab_16,
+            INTENT_RELATIVE_COLORIMETRIC,
+            cmsFLAGS_NOCACHE);
+        cmsHTRANSFORM toRgb = cmsCreateTransform( //
+            lab,
+            TYPE_Lab_16,
+            source,
+            TYPE_RGB_16,
+            INTENT_RELATIVE_COLORIMETRIC,
+            cmsFLAGS_NOCACHE);
+
+        cmsHPROFILE result = cmsCreateProfilePlaceholder(nullptr);
+        cmsSetProfileVersion(result, 4.3);
+        cmsSetDeviceClass(result, cmsSigDisplayClass);
+        cmsSetColorSpace(result, cmsSigRgbData);
+        cmsSetPCS(result, cmsSigLabData);
+        cmsWriteTag(result, cmsSigMediaWhitePointTag, cmsD50_XYZ());
+        cmsPipeline *aToB = createClutPipeline(toLab, gridPoints);
+        cmsWriteTag(result, cmsSigAToB0Tag, aToB);
+        cmsPipelineFree(aToB);
+        cmsPipeline *bToA = createClutPipeline(toRgb, gridPoints);
+        cmsWriteTag(result, cmsSigBToA0Tag, bToA);
+        cmsPipelineFree(bToA);
+
+        cmsDeleteTransform(toRgb);
+        cmsDeleteTransform(toLab);
+        cmsCloseProfile(lab);
+        cmsCloseProfile(source);
+        return result;
+    }
+
+    /** @brief Writes a profile of the corpus to the corpus directory.
+     *
+     * @returns <tt>true</tt> on success. */
+    bool writeProfile(const ProfileDescription &profile) const
+    {
+        cmsHPROFILE handle = (profile.kind == Kind::Clut) //
+            ? createClutProfile(profile.gridPoints, profile.blackLevel)
+            : createMatrixShaperProfile(profile.kind, profile.blackLevel);
+        if (handle == nullptr) {
+            return false;
+        }
+        cmsMLU *description = cmsMLUalloc(nullptr, 1);
+        cmsMLUsetASCII(description, "en", "US", profile.name.toUtf8().constData());
+        cmsWriteTag(handle, cmsSigProfileDescriptionTag, description);
+        cmsMLUfree(description);
+        const bool result = cmsSaveProfileToFile( //
+            handle,
+            QFile::encodeName(fileName(profile)).constData());
+        cmsCloseProfile(handle);
+        return result;
+    }
+
+    /** @brief Data rows: One for each profile of the corpus. */
+    static void provideCorpusData()
+    {
+        QTest::addColumn<QString>("name");
+        QTest::addColumn<bool>("isLiftedBlack");
+        for (const ProfileDescription &profile : corpus()) {
+            QTest::newRow(profile.name.toUtf8().constData()) //
+                << profile.name << (profile.blackLevel > 0);
+        }
+    }
+
+    /** @brief File name of the profile of the current data row. */
+    QString currentFileName() const
+    {
+        return m_corpusDirectory.filePath( //
+            QString::fromUtf8(QTest::currentDataTag()) + QStringLiteral(".icc"));
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Called before the first test function is executed
+        QVERIFY(m_corpusDirectory.isValid());
+        for (const ProfileDescription &profile : corpus()) {
+            QVERIFY2(writeProfile(profile), qPrintable(profile.name));
+        }
+    }
+
+    void cleanupTestCase()
+    {
+        // Called after the last test function was executed
+    }
+
+    void init()
+    {
+        // Called before each test function is executed
+    }
+
+    void cleanup()
+    {
+        // Called after every test function
+    }
+
+    void testCorpus_data()
+    {
+        provideCorpusData();
+    }
+
+    void testCorpus()
+    {
+        QFETCH(QString, name);
+        QFETCH(bool, isLiftedBlack);
+        QSharedPointer<RgbColorSpace> space = //
+            RgbColorSpaceFactory::createFromFile(currentFileName());
+        QVERIFY(!space.isNull());
+        QCOMPARE(space->profileInfoDescription(), name);
+        // Neutral gray is in-gamut for all profiles.
+        QVERIFY(space->isInGamut(LchDouble {50, 0, 0}));
+        // Highly saturated colors are out-of-gamut for all profiles. The
+        // 16-bit CLUTs clip out-of-gamut colors silently, so for the CLUT
+        // profiles, this relies on the round trip check of RgbColorSpace.
+        QVERIFY(!space->isInGamut(LchDouble {50, 150, 0}));
+        // A black level of 2 % corresponds to a lightness of about 18.
+        const qreal blackpointLightness = space->lightnessRange(0, 0).first;
+        if (isLiftedBlack) {
+            QVERIFY(blackpointLightness > 10);
+        } else {
+            QVERIFY(blackpointLightness < 5);
+        }
+    }
+
+    void testInGamutColors_data()
+    {
+        provideCorpusData();
+    }
+
+    void testInGamutColors()
+    {
+        // Colors that have been converted from RGB to Lab are in-gamut by
+        // definition. For the CLUT profiles, the round trip through the
+        // interpolated CLUTs is not exact, so this checks that the round
+        // trip tolerance of RgbColorSpace is big enough. The grid differs
+        // from the one that RgbColorSpace uses to derive the tolerance.
+        // It avoids the exact limits 0 and 1, because rounding errors of
+        // the unbounded matrix-shaper transforms might leave the range.
+        QSharedPointer<RgbColorSpace> space = //
+            RgbColorSpaceFactory::createFromFile(currentFileName());
+        QVERIFY(!space.isNull());
+        constexpr int gridPoints = 12;
+        QVector<RgbDouble> rgb;
+        for (int red = 0; red < gridPoints; ++red) {
+            for (int green = 0; green < gridPoints; ++green) {
+                for (int blue = 0; blue < gridPoints; ++blue) {
+                    rgb.append(RgbDouble {(red + 0.5) / gridPoints, //
+                                          (green + 0.5) / gridPoints,
+                                          (blue + 0.5) / gridPoints});
+                }
+            }
+        }
+        LabBuffer lab(rgb.count());
+        space->toCielab(rgb.constData(), lab.view());
+        const LabBuffer &constLab = lab;
+        QVector<RgbDouble> roundTrip(rgb.count());
+        space->toRgbDoubleUnbound(constLab.view(), roundTrip.data());
+        QVector<bool> isInGamut(rgb.count());
+        space->isInGamut(constLab.view(), roundTrip.constData(), isInGamut.data());
+        for (int i = 0; i < rgb.count(); ++i) {
+            const cmsCIELab value {lab.l()[i], lab.a()[i], lab.b()[i]};
+            const QByteArray message = QByteArrayLiteral("RGB ") //
+                + QByteArray::number(rgb.at(i).red) + ' ' //
+                + QByteArray::number(rgb.at(i).green) + ' ' //
+                + QByteArray::number(rgb.at(i).blue);
+            QVERIFY2(isInGamut.at(i), message.constData());
+            QVERIFY2(space->isInGamut(value), message.constData());
+        }
+    }
+
+    void benchmarkCreateFromFile_data()
+    {
+        provideCorpusData();
+    }
+
+    void benchmarkCreateFromFile()
+    {
+        const QString fileName = currentFileName();
+        QBENCHMARK {
+            QSharedPointer<RgbColorSpace> space = //
+                RgbColorSpaceFactory::createFromFile(fileName);
+            QVERIFY(!space.isNull());
+        }
+    }
+
+    void benchmarkGamutSearch_data()
+    {
+        provideCorpusData();
+    }
+
+    void benchmarkGamutSearch()
+    {
+        QSharedPointer<RgbColorSpace> space = //
+            RgbColorSpaceFactory::createFromFile(currentFileName());
+        QVERIFY(!space.isNull());
+        QBENCHMARK {
+            for (int hue = 0; hue < 360; hue += 10) {
+                space->nearestInGamutColorByAdjustingChroma( //
+                    LchDouble {50, 150, static_cast<qreal>(hue)});
+            }
+        }
+    }
+
+    void benchmarkImageRendering_data()
+    {
+        provideCorpusData();
+    }
+
+    void benchmarkImageRendering()
+    {
+        QSharedPointer<RgbColorSpace> space = //
+            RgbColorSpaceFactory::createFromFile(currentFileName());
+        QVERIFY(!space.isNull());
+        ChromaLightnessImage image(space);
+        // Measure the rendering itself, not the lookup of the shared
+        // gamut cache.
+        image.setGamutCacheEnabled(false);
+        image.setImageSize(QSize(200, 200));
+        int hue = 0;
+        QBENCHMARK {
+            // A new hue in each iteration, so that no cached image
+            // is used.
+            hue = (hue + 37) % 360;
+            image.setHue(hue);
+            image.getImage();
+        }
+    }
+};
+
+} // namespace PerceptualColor
+
+QTEST_MAIN(PerceptualColor::TestSyntheticProfiles)
+
+// The following “include” is necessary because we do not use a header file:
+#include "testsyntheticprofiles.moc"
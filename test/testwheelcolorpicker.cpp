@@ -119,6 +119,20 @@ private Q_SLOTS:
         QVERIFY(test.minimumSizeHint().height() <= test.sizeHint().height());
     }
 
+    void testMinimumSizeHintCache()
+    {
+        WheelColorPicker test {m_rgbColorSpace};
+        const QSize hint = test.minimumSizeHint();
+        QCOMPARE(test.d_pointer->m_minimumSizeHint, hint);
+        QCOMPARE(test.minimumSizeHint(), hint);
+        // A font change discards the cache.
+        QFont font = test.font();
+        font.setPointSize(font.pointSize() + 5);
+        test.setFont(font);
+        QVERIFY(!test.d_pointer->m_minimumSizeHint.isValid());
+        QVERIFY(test.minimumSizeHint().isValid());
+    }
+
     void testVerySmallWidgetSizes()
     {
         // Also very small widget sizes should not crash the widget.
@@ -0,0 +1,498 @@
+﻿// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2020 Lukas Sommer sommerluk@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PerceptualColor/perceptualcolorglobal.h"
+#include "perceptualcolorinternal.h"
+
+#include "PerceptualColor/lchdouble.h"
+#include "rgbcolorspace.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSharedPointer>
+#include <QTextStream>
+#include <QVector>
+#include <QtMath>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+// Searches for the inputs that make the gamut functions of RgbColorSpace
+// slow. There are two ways to use this program:
+//
+// 1. As a standalone program (default). It runs a time-guided search:
+//    A population of the slowest inputs found so far is mutated, and
+//    mutants that are slower than the fastest member of the population
+//    replace this member. At the end, the slowest inputs are written as
+//    data rows for test/testgamutlatency.cpp, together with a latency
+//    ceiling.
+//
+//        fuzzgamut --iterations 100000 --output rows.txt a.icc b.icc
+//
+// 2. As a libFuzzer target, if built with the CMake option
+//    PERCEPTUALCOLOR_LIBFUZZER (needs Clang). libFuzzer provides the
+//    coverage guidance. The timing feedback is provided by extra
+//    counters: Each latency bucket (powers of two of nanoseconds) is
+//    a counter of its own, so an input that is slower than all previous
+//    inputs looks like new coverage to libFuzzer and is kept in the
+//    corpus. Each new slowest input is printed as a data row.
+//
+//        PERCEPTUALCOLOR_FUZZ_PROFILES=a.icc:b.icc fuzzgamut corpus/ tools/fuzzgamut-corpus/
+//
+//    tools/fuzzgamut-corpus/ is the seed corpus: The seeds of the
+//    standalone search (see seeds()), encoded for the first two color
+//    spaces. libFuzzer writes new inputs to the first directory only,
+//    so the seed corpus stays unchanged.
+
+using namespace PerceptualColor;
+
+namespace
+{
+/** @brief Size of an encoded input, in bytes. */
+constexpr int encodedSize = 3 * 4 + 2;
+
+/** @brief Snap flags of an input.
+ *
+ * The fallback branches of the gamut functions are taken only for
+ * very special values, which random values would practically never
+ * hit. Therefore, the input can snap its values to such special
+ * values. */
+enum Snap : quint8 {
+    SnapLightnessToBlackpoint = 1 << 0, /**< Lightness at the black point */
+    SnapLightnessToWhitepoint = 1 << 1, /**< Lightness at the white point */
+    SnapLightnessToCusp = 1 << 2, /**< Lightness of the cusp of the hue */
+    SnapChromaToBoundary = 1 << 3, /**< Chroma just beyond the gamut */
+    SnapHueToPrimary = 1 << 4, /**< Hue of a primary or secondary color */
+    SnapLightnessBeyondRange = 1 << 5 /**< Lightness below 0 or above 100 */
+};
+
+/** @brief A decoded input. */
+struct FuzzCase {
+    /** @brief Index of the color space */
+    int profile = 0;
+    /** @brief The color, before snapping */
+    LchDouble color {50, 0, 0};
+    /** @brief Combination of @ref Snap flags */
+    quint8 snap = 0;
+};
+
+/** @brief Maps a 32-bit value linearly to a range. */
+double toRange(quint32 value, double minimum, double maximum)
+{
+    return minimum + (maximum - minimum) * value / 4294967295.0;
+}
+
+/** @brief Reads a little-endian 32-bit value. */
+quint32 readUInt32(const quint8 *data)
+{
+    return static_cast<quint32>(data[0]) //
+        | (static_cast<quint32>(data[1]) << 8) //
+        | (static_cast<quint32>(data[2]) << 16) //
+        | (static_cast<quint32>(data[3]) << 24);
+}
+
+/** @brief Decodes an input.
+ *
+ * Missing bytes are treated as 0, so every byte sequence is valid.
+ * The ranges deliberately exceed the valid ranges a little, because
+ * callers do not always normalize their values. */
+FuzzCase decode(const quint8 *data, size_t size, int profileCount)
+{
+    quint8 buffer[encodedSize] = {};
+    std::memcpy(buffer, data, qMin<size_t>(size, encodedSize));
+    FuzzCase result;
+    result.color.l = toRange(readUInt32(buffer), 0, 100);
+    result.color.c = toRange(readUInt32(buffer + 4), -10, 250);
+    result.color.h = toRange(readUInt32(buffer + 8), -360, 720);
+    result.snap = buffer[12];
+    result.profile = buffer[13] % qMax(profileCount, 1);
+    return result;
+}
+
+/** @brief Encodes an input.
+ *
+ * Inverse of @ref decode(). */
+QByteArray encode(const FuzzCase &fuzzCase)
+{
+    QByteArray result(encodedSize, 0);
+    const auto write = [&result](int offset, double value, double minimum, double maximum) {
+        const double normalized = qBound(0.0, (value - minimum) / (maximum - minimum), 1.0);
+        const quint32 encoded = static_cast<quint32>(qRound64(normalized * 4294967295.0));
+        for (int i = 0; i < 4; ++i) {
+            result[offset + i] = static_cast<char>((encoded >> (8 * i)) & 0xFF);
+        }
+    };
+    write(0, fuzzCase.color.l, 0, 100);
+    write(4, fuzzCase.color.c, -10, 250);
+    write(8, fuzzCase.color.h, -360, 720);
+    result[12] = static_cast<char>(fuzzCase.snap);
+    result[13] = static_cast<char>(fuzzCase.profile);
+    return result;
+}
+
+/** @brief Applies the @ref Snap flags.
+ *
+ * @param fuzzCase The input
+ * @param colorSpace The color space of the input
+ * @returns The color that is actually passed to the gamut functions. */
+LchDouble resolve(const FuzzCase &fuzzCase, const RgbColorSpace &colorSpace)
+{
+    constexpr double primaryHues[] = {40, 103, 136, 196, 306, 328};
+    LchDouble result = fuzzCase.color;
+    if (fuzzCase.snap & SnapHueToPrimary) {
+        const int index = qAbs(qRound(result.h)) % static_cast<int>(std::size(primaryHues));
+        result.h = primaryHues[index];
+    }
+    const QPair<qreal, qreal> range = colorSpace.lightnessRange(result.h, 0);
+    if (fuzzCase.snap & SnapLightnessToBlackpoint) {
+        result.l = range.first;
+    } else if (fuzzCase.snap & SnapLightnessToWhitepoint) {
+        result.l = range.second;
+    } else if (fuzzCase.snap & SnapLightnessToCusp) {
+        result.l = colorSpace.cusp(result.h).l;
+    }
+    if (fuzzCase.snap & SnapLightnessBeyondRange) {
+        result.l = (result.l < 50) ? -result.l - 1 : 200 - result.l + 1;
+    }
+    if (fuzzCase.snap & SnapChromaToBoundary) {
+        // Just beyond the boundary: The bisection has to go down
+        // to the finest level.
+        const qreal boundary = colorSpace.maximumInGamutChroma( //
+            qBound<qreal>(0, result.l, 100),
+            result.h);
+        result.c = boundary + 0.5 * gamutPrecision;
+    }
+    return result;
+}
+
+/** @brief Measures the gamut functions for a single color.
+ *
+ * @param colorSpace The color space
+ * @param color The color
+ * @param repetitions Number of measurements. The minimum is returned,
+ *        which is the most robust estimation against noise.
+ * @returns The time that the gamut functions need together, in
+ * nanoseconds. */
+qint64 measure(RgbColorSpace &colorSpace, const LchDouble &color, int repetitions)
+{
+    qint64 result = std::numeric_limits<qint64>::max();
+    QElapsedTimer timer;
+    for (int i = 0; i < repetitions; ++i) {
+        timer.start();
+        const LchDouble byChroma = //
+            colorSpace.nearestInGamutColorByAdjustingChroma(color);
+        const LchDouble byChromaLightness = //
+            colorSpace.nearestInGamutColorByAdjustingChromaLightness(color);
+        const qint64 elapsed = timer.nsecsElapsed();
+        // Make sure the compiler does not optimize the calls away.
+        if (qIsNaN(byChroma.c + byChromaLightness.c)) {
+            return -1;
+        }
+        result = qMin(result, elapsed);
+    }
+    return result;
+}
+
+/** @brief A latency ceiling for a measured latency.
+ *
+ * Uses the same headroom as the existing rows of
+ * test/testgamutlatency.cpp: Generous enough to not fail on a busy
+ * machine, but tight enough to catch a regression by an order of
+ * magnitude.
+ *
+ * @param nanoseconds The measured latency
+ * @returns The ceiling in microseconds */
+qint64 ceiling(qint64 nanoseconds)
+{
+    // At least 1 ms, otherwise 4 times the measured value, rounded
+    // up to full milliseconds.
+    const qint64 microseconds = qMax<qint64>(1000, nanoseconds * 4 / 1000);
+    return (microseconds + 999) / 1000 * 1000;
+}
+
+/** @brief Formats a data row for test/testgamutlatency.cpp. */
+QString dataRow(const FuzzCase &fuzzCase, const QString &profileName, const LchDouble &color, qint64 nanoseconds)
+{
+    const QString hex = QString::fromLatin1(encode(fuzzCase).toHex());
+    return QStringLiteral("QTest::newRow(\"%1 %2\") << QStringLiteral(\"%1\") << LchDouble {%3, %4, %5} << qint64 {%6};") //
+        .arg(profileName, hex)
+        .arg(color.l, 0, 'g', 17)
+        .arg(color.c, 0, 'g', 17)
+        .arg(color.h, 0, 'g', 17)
+        .arg(ceiling(nanoseconds));
+}
+
+/** @brief The color spaces under test, and their names. */
+struct ColorSpaces {
+    QVector<QSharedPointer<RgbColorSpace>> spaces;
+    QStringList names;
+
+    void load(const QStringList &fileNames)
+    {
+        spaces.append(RgbColorSpace::createSrgb());
+        names.append(QStringLiteral("srgb"));
+        for (const QString &fileName : fileNames) {
+            if (fileName.isEmpty()) {
+                continue;
+            }
+            QSharedPointer<RgbColorSpace> space = RgbColorSpace::createFromFile(fileName);
+            if (space.isNull()) {
+                QTextStream(stderr) << "Could not load " << fileName << "\n";
+                continue;
+            }
+            spaces.append(space);
+            names.append(fileName);
+        }
+    }
+};
+
+/** @brief Input with its measured latency. */
+struct Candidate {
+    FuzzCase fuzzCase;
+    qint64 nanoseconds = 0;
+};
+
+/** @brief Mutates an input. */
+FuzzCase mutate(const FuzzCase &original, QRandomGenerator &random, int profileCount)
+{
+    FuzzCase result = original;
+    switch (random.bounded(6)) {
+    case 0:
+        result.color.l = qBound(0.0, result.color.l + random.generateDouble() * 2 - 1, 100.0);
+        break;
+    case 1:
+        result.color.c = qBound(-10.0, result.color.c + random.generateDouble() * 4 - 2, 250.0);
+        break;
+    case 2:
+        result.color.h = qBound(-360.0, result.color.h + random.generateDouble() * 4 - 2, 720.0);
+        break;
+    case 3:
+        result.snap ^= static_cast<quint8>(1 << random.bounded(6));
+        break;
+    case 4:
+        result.profile = random.bounded(profileCount);
+        break;
+    default:
+        // Completely new input, to escape local maxima.
+        result.color.l = random.generateDouble() * 100;
+        result.color.c = random.generateDouble() * 260 - 10;
+        result.color.h = random.generateDouble() * 1080 - 360;
+        result.snap = static_cast<quint8>(random.bounded(64));
+        break;
+    }
+    return result;
+}
+
+/** @brief Seeds for the search: The known corner cases. */
+QVector<FuzzCase> seeds(int profileCount)
+{
+    QVector<FuzzCase> result;
+    for (int profile = 0; profile < profileCount; ++profile) {
+        for (quint8 snap : {quint8(0),
+                            quint8(SnapLightnessToBlackpoint),
+                            quint8(SnapLightnessToWhitepoint),
+                            quint8(SnapLightnessToCusp | SnapChromaToBoundary | SnapHueToPrimary),
+                            quint8(SnapLightnessBeyondRange),
+                            quint8(SnapChromaToBoundary)}) {
+            FuzzCase fuzzCase;
+            fuzzCase.profile = profile;
+            fuzzCase.color = LchDouble {50, 200, 250};
+            fuzzCase.snap = snap;
+            result.append(fuzzCase);
+        }
+    }
+    return result;
+}
+
+/** @brief The time-guided search of the standalone program.
+ *
+ * @returns The exit code of the program */
+int runSearch(ColorSpaces &colorSpaces, int iterations, quint32 seed, const QString &outputFileName, int populationSize)
+{
+    QRandomGenerator random(seed);
+    const int profileCount = colorSpaces.spaces.count();
+    const auto evaluate = [&colorSpaces](const FuzzCase &fuzzCase) {
+        RgbColorSpace &space = *colorSpaces.spaces.at(fuzzCase.profile);
+        return Candidate {fuzzCase, measure(space, resolve(fuzzCase, space), 3)};
+    };
+    const auto isSlower = [](const Candidate &a, const Candidate &b) {
+        return a.nanoseconds > b.nanoseconds;
+    };
+
+    QVector<Candidate> population;
+    for (const FuzzCase &fuzzCase : seeds(profileCount)) {
+        population.append(evaluate(fuzzCase));
+    }
+    std::sort(population.begin(), population.end(), isSlower);
+    population.resize(qMin(population.count(), populationSize));
+
+    for (int i = 0; i < iterations; ++i) {
+        const Candidate &parent = population.at(random.bounded(population.count()));
+        const Candidate child = evaluate(mutate(parent.fuzzCase, random, profileCount));
+        if (population.count() < populationSize) {
+            population.append(child);
+        } else if (child.nanoseconds > population.last().nanoseconds) {
+            population.last() = child;
+        } else {
+            continue;
+        }
+        std::sort(population.begin(), population.end(), isSlower);
+    }
+
+    // Measure again, more precisely, because a single lucky
+    // measurement is not a good basis for a ceiling.
+    for (Candidate &candidate : population) {
+        RgbColorSpace &space = *colorSpaces.spaces.at(candidate.fuzzCase.profile);
+        candidate.nanoseconds = measure(space, resolve(candidate.fuzzCase, space), 20);
+    }
+    std::sort(population.begin(), population.end(), isSlower);
+
+    QFile outputFile;
+    if (outputFileName.isEmpty()) {
+        if (!outputFile.open(stdout, QIODevice::WriteOnly)) {
+            return 1;
+        }
+    } else {
+        outputFile.setFileName(outputFileName);
+        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QTextStream(stderr) << "Could not write " << outputFileName << "\n";
+            return 1;
+        }
+    }
+    QTextStream output(&outputFile);
+    for (const Candidate &candidate : qAsConst(population)) {
+        RgbColorSpace &space = *colorSpaces.spaces.at(candidate.fuzzCase.profile);
+        output << dataRow(candidate.fuzzCase, //
+                          colorSpaces.names.at(candidate.fuzzCase.profile),
+                          resolve(candidate.fuzzCase, space),
+                          candidate.nanoseconds)
+               << "\n";
+    }
+    return 0;
+}
+
+} // namespace
+
+#ifdef PERCEPTUALCOLOR_LIBFUZZER
+
+/** @brief Number of latency buckets for the timing feedback. */
+constexpr int latencyBucketCount = 48;
+
+// Extra counters for libFuzzer. libFuzzer treats them like coverage
+// counters. (Supported on Linux.)
+__attribute__((used, section("__libfuzzer_extra_counters"))) static quint8 latencyCounters[latencyBucketCount];
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size)
+{
+    static int argc = 1;
+    static char applicationName[] = "fuzzgamut";
+    static char *argv[] = {applicationName, nullptr};
+    static QCoreApplication application(argc, argv);
+    static ColorSpaces colorSpaces = []() {
+        ColorSpaces result;
+        const QString fileNames = qEnvironmentVariable("PERCEPTUALCOLOR_FUZZ_PROFILES");
+        result.load(fileNames.split(QLatin1Char(':')));
+        return result;
+    }();
+    static qint64 slowest = 0;
+
+    const FuzzCase fuzzCase = decode(data, size, colorSpaces.spaces.count());
+    RgbColorSpace &space = *colorSpaces.spaces.at(fuzzCase.profile);
+    const LchDouble color = resolve(fuzzCase, space);
+    const qint64 nanoseconds = measure(space, color, 1);
+
+    // Timing feedback
+    int bucket = 0;
+    while ((bucket < latencyBucketCount - 1) && ((qint64 {1} << (bucket + 1)) <= nanoseconds)) {
+        ++bucket;
+    }
+    latencyCounters[bucket] = 1;
+
+    if (nanoseconds > slowest) {
+        slowest = nanoseconds;
+        QTextStream(stderr) //
+            << dataRow(fuzzCase, colorSpaces.names.at(fuzzCase.profile), color, nanoseconds) //
+            << "\n";
+    }
+    return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("fuzzgamut"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription( //
+        QStringLiteral("Searches the slowest inputs of the gamut functions."));
+    parser.addHelpOption();
+    const QCommandLineOption iterationsOption( //
+        QStringLiteral("iterations"),
+        QStringLiteral("Number of mutations to try."),
+        QStringLiteral("count"),
+        QStringLiteral("10000"));
+    const QCommandLineOption populationOption( //
+        QStringLiteral("population"),
+        QStringLiteral("Number of slowest inputs to keep and report."),
+        QStringLiteral("count"),
+        QStringLiteral("16"));
+    const QCommandLineOption seedOption( //
+        QStringLiteral("seed"),
+        QStringLiteral("Seed for the random generator."),
+        QStringLiteral("seed"),
+        QStringLiteral("1"));
+    const QCommandLineOption outputOption( //
+        QStringLiteral("output"),
+        QStringLiteral("File for the data rows (default: standard output)."),
+        QStringLiteral("file"));
+    parser.addOption(iterationsOption);
+    parser.addOption(populationOption);
+    parser.addOption(seedOption);
+    parser.addOption(outputOption);
+    parser.addPositionalArgument( //
+        QStringLiteral("profiles"),
+        QStringLiteral("ICC profiles to test in addition to the built-in sRGB."),
+        QStringLiteral("[profile.icc...]"));
+    parser.process(app);
+
+    ColorSpaces colorSpaces;
+    colorSpaces.load(parser.positionalArguments());
+    return runSearch(colorSpaces,
+                     qMax(0, parser.value(iterationsOption).toInt()),
+                     parser.value(seedOption).toUInt(),
+                     parser.value(outputOption),
+                     qMax(1, parser.value(populationOption).toInt()));
+}
+
+#endif
@@ -106,6 +106,8 @@ int main(int argc, char *argv[])
             // QStringLiteral("/usr/share/color/icc/ECI-RGB.V1.0.icc") //
             ) //
     );
+    // The screen expects sRGB values, not WideGamutRGB values:
+    m_colorDialog.setDisplayColorSpace(PerceptualColor::RgbColorSpaceFactory::createSrgb());
     // m_colorDialog.setOption(QColorDialog::ColorDialogOption::ShowAlphaChannel, true);
     QColor myColor = QColor(Qt::yellow);
     myColor.setAlphaF(0.5);